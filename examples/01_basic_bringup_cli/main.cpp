@@ -527,6 +527,7 @@ void printHelp() {
   cli::printHelpItem("pintest", "Test pin toggle (MCU bus control)");
   cli::printHelpItem("clocktest", "Generate clock pulses and verify");
   cli::printHelpItem("sniff", "Toggle sniffer on/off");
+  cli::printHelpItem("sniff trig <src> [post N]", "Capture around nack|pec|stretch <us>|ctrl <hex> [mask <hex>]");
   cli::printHelpItem("timing", "Try different clock frequencies");
   cli::printHelpItem("busreset", "Send 9 clocks to recover stuck bus");
   cli::printHelpItem("tx <hex>", "Test transaction with control byte");
@@ -1452,6 +1453,15 @@ void processCommand(const String& cmd) {
     e2diag::testPinToggle(deviceCfg);
   } else if (trimmed == "clocktest") {
     e2diag::testClockPulses(deviceCfg, 10);
+  } else if (trimmed.startsWith("sniff trig")) {
+    String spec = trimmed.substring(10);
+    spec.trim();
+    e2diag::TriggerConfig trigger;
+    if (!e2diag::parseTriggerSpec(spec.c_str(), trigger)) {
+      LOGW("Usage: sniff trig nack|pec|stretch <us>|ctrl <hex> [mask <hex>] [post N]");
+    } else {
+      e2diag::sniffer().arm(&deviceCfg, trigger);
+    }
   } else if (trimmed == "sniff") {
     // Toggle
     if (e2diag::sniffer().isActive()) {
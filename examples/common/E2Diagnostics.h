@@ -6,6 +6,7 @@
 #include <Arduino.h>
 #include "EE871/CommandTable.h"
 #include "EE871/Config.h"
+#include "E2TriggerCapture.h"
 #include "E2Transport.h"
 #include "Log.h"
 
@@ -883,6 +884,75 @@ inline void snifferCallback(bool scl, bool sda) {
   s.lastSda = sda;
 }
 
+// ============================================================================
+// Triggered Capture (pre/post-trigger window, printed once)
+// ============================================================================
+
+/// Edges kept by the triggered sniffer (8 bytes each; one frame is ~110 edges).
+static constexpr size_t SNIFF_CAPTURE_EDGES = 1024;
+
+inline TriggerCapture<SNIFF_CAPTURE_EDGES>& triggerCapture() {
+  static TriggerCapture<SNIFF_CAPTURE_EDGES> capture;
+  return capture;
+}
+
+/// Callback invoked by transport while a trigger is armed; no output here
+inline void triggerSnifferCallback(bool scl, bool sda) {
+  triggerCapture().sample(scl, sda, micros());
+}
+
+/// Print trigger source names separated by '|'
+inline void printTriggerSources(uint8_t sources) {
+  const char* sep = "";
+  if (sources & trig::NACK) { Serial.printf("%sNACK", sep); sep = "|"; }
+  if (sources & trig::PEC_MISMATCH) { Serial.printf("%sPEC", sep); sep = "|"; }
+  if (sources & trig::STRETCH) { Serial.printf("%sSTRETCH", sep); sep = "|"; }
+  if (sources & trig::CONTROL_BYTE) { Serial.printf("%sCTRL", sep); }
+}
+
+/// Print one decoded event of a frozen window, time relative to the trigger
+inline void printCaptureEvent(const E2Event& ev, void* user) {
+  const uint32_t triggerUs = *static_cast<const uint32_t*>(user);
+  const long relUs = static_cast<long>(static_cast<int32_t>(ev.tUs - triggerUs));
+  Serial.printf("%+9ld us  ", relUs);
+  if (ev.kind == E2Event::Kind::START) {
+    Serial.print("START");
+  } else if (ev.kind == E2Event::Kind::STOP) {
+    Serial.print("STOP");
+  } else if (ev.index == 0) {
+    Serial.printf("[0x%02X %s a%d] %s",
+                  ev.value,
+                  getCmdName((ev.value >> 4) & 0x0F, ev.read),
+                  (ev.value >> 1) & 0x07,
+                  ev.ack ? "ACK" : "NAK");
+  } else if (ev.isPec) {
+    Serial.printf("pec=0x%02X %s %s", ev.value, ev.pecOk ? "ok" : "BAD", ev.ack ? "ACK" : "NAK");
+  } else {
+    Serial.printf("0x%02X %s", ev.value, ev.ack ? "ACK" : "NAK");
+  }
+  if (ev.trigger) {
+    Serial.printf(" %s<<< TRIGGER%s", LOG_COLOR_YELLOW, LOG_COLOR_RESET);
+  }
+  Serial.println();
+}
+
+/// Decode and print the frozen capture window
+inline void printCaptureWindow() {
+  const auto& cap = triggerCapture();
+  const size_t n = cap.size();
+  const size_t triggerPos = cap.triggerEdge() - cap.firstEdge();
+  uint32_t triggerUs = cap.edge(triggerPos).tUs;
+  Serial.printf("\n%s=== Sniffer Trigger: ", LOG_COLOR_CYAN);
+  printTriggerSources(cap.firedBy());
+  Serial.printf(" ===%s\n", LOG_COLOR_RESET);
+  Serial.printf("Window: %lu edges (%lu pre, %lu post), %lu us\n",
+                static_cast<unsigned long>(n),
+                static_cast<unsigned long>(triggerPos),
+                static_cast<unsigned long>(n - 1 - triggerPos),
+                static_cast<unsigned long>(cap.edge(n - 1).tUs - cap.edge(0).tUs));
+  cap.decode(printCaptureEvent, &triggerUs);
+}
+
 /// Sniffer control class
 class BusSniffer {
 public:
@@ -905,7 +975,28 @@ public:
     Serial.println("[SNIFF] ON - 'sniff 0' to stop");
   }
   
+  /// Arm a triggered capture: edges are buffered silently and tick() prints
+  /// the window around the first trigger, then disarms.
+  void arm(const EE871::Config* cfg, const TriggerConfig& trigger) {
+    stop();
+    triggerCapture().arm(trigger, cfg->readScl(cfg->busUser), cfg->readSda(cfg->busUser), micros());
+    _armed = true;
+    transport::setSnifferCallback(triggerSnifferCallback);
+
+    Serial.print("[SNIFF] ARMED on ");
+    printTriggerSources(trigger.sources);
+    Serial.printf(", %u post edges - 'sniff' to disarm\n",
+                  static_cast<unsigned>(trigger.postEdges));
+  }
+
   void stop() {
+    if (_armed) {
+      _armed = false;
+      transport::setSnifferCallback(nullptr);
+      triggerCapture().disarm();
+      Serial.printf("[SNIFF] DISARMED (%lu edges, no trigger)\n",
+                    static_cast<unsigned long>(triggerCapture().edgesSeen()));
+    }
     auto& s = snifferState();
     if (s.active) {
       s.active = false;
@@ -917,9 +1008,21 @@ public:
     }
   }
   
-  bool isActive() const { return snifferState().active; }
+  bool isActive() const { return snifferState().active || _armed; }
+  bool isArmed() const { return _armed; }
   
-  void tick() {}
+  void tick() {
+    if (!_armed || !triggerCapture().frozen()) {
+      return;
+    }
+    _armed = false;
+    transport::setSnifferCallback(nullptr);
+    triggerCapture().disarm();
+    printCaptureWindow();
+  }
+
+private:
+  bool _armed = false;
 };
 
 /// Global sniffer instance for use in examples
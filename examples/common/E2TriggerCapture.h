@@ -0,0 +1,392 @@
+/// @file E2TriggerCapture.h
+/// @brief Logic-analyzer style pre/post-trigger capture of E2 line edges
+/// @note NOT part of the library - examples only. No Arduino dependency, so
+///       the capture can be fed from any transport tap or a native test.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace e2diag {
+
+/// Trigger sources; combine as a bit mask in TriggerConfig::sources.
+namespace trig {
+static constexpr uint8_t NACK = 0x01;          ///< Byte not acknowledged (except the read PEC NAK).
+static constexpr uint8_t PEC_MISMATCH = 0x02;  ///< PEC byte differs from the frame checksum.
+static constexpr uint8_t STRETCH = 0x04;       ///< SCL held low longer than stretchUs.
+static constexpr uint8_t CONTROL_BYTE = 0x08;  ///< Control byte matches controlByte/controlMask.
+} // namespace trig
+
+/// Capture trigger settings.
+struct TriggerConfig {
+  uint8_t sources = trig::NACK | trig::PEC_MISMATCH;
+  uint32_t stretchUs = 1000;   ///< STRETCH threshold; normal low time is clockLowUs.
+  uint8_t controlByte = 0;     ///< CONTROL_BYTE value.
+  uint8_t controlMask = 0xFF;  ///< CONTROL_BYTE compared bits (0xF0 matches any address/direction).
+  uint16_t postEdges = 64;     ///< Edges recorded after the trigger before the buffer freezes.
+};
+
+/// One recorded line change.
+struct CaptureEdge {
+  uint32_t tUs = 0;
+  bool scl = true;
+  bool sda = true;
+};
+
+/// Protocol event decoded from line edges.
+struct E2Event {
+  enum class Kind : uint8_t { START, STOP, BYTE };
+  Kind kind = Kind::START;
+  uint32_t tUs = 0;       ///< Time of the edge that completed the event.
+  uint32_t edge = 0;      ///< Capture index of that edge.
+  uint8_t value = 0;      ///< BYTE: byte value.
+  uint8_t index = 0;      ///< BYTE: position in the frame (0 = control byte).
+  bool ack = false;       ///< BYTE: ACK bit was low.
+  bool read = false;      ///< BYTE: frame is a read (control byte bit 0).
+  bool isPec = false;     ///< BYTE: PEC position (2 for reads, 3 for writes).
+  bool pecOk = true;      ///< BYTE: PEC matches the sum of the preceding bytes.
+  bool trigger = false;   ///< Set by TriggerCapture::decode() for the triggering event.
+};
+
+/// @brief Incremental E2 frame decoder; one call per line change.
+///
+/// Same rules as the live sniffer: START/STOP are SDA edges while SCL is high,
+/// data and ACK bits are sampled on SCL rising edges. Edges before the first
+/// START are ignored, so decoding can begin in the middle of a frame.
+class E2EdgeDecoder {
+public:
+  void reset() {
+    _inFrame = false;
+    _bits = 0;
+    _byte = 0;
+    _index = 0;
+    _sum = 0;
+    _read = false;
+  }
+
+  /// Decode the change from (prevScl, prevSda) to (scl, sda).
+  /// @return true when @p out holds a START, STOP or completed BYTE event.
+  bool feed(bool prevScl, bool prevSda, bool scl, bool sda, E2Event& out) {
+    if (prevScl && scl && prevSda != sda) {
+      out.kind = sda ? E2Event::Kind::STOP : E2Event::Kind::START;
+      _inFrame = !sda;
+      _bits = 0;
+      _byte = 0;
+      _index = 0;
+      _sum = 0;
+      return true;
+    }
+    if (!_inFrame || prevScl || !scl) {
+      return false;
+    }
+    if (_bits < 8) {
+      _byte = static_cast<uint8_t>((_byte << 1) | (sda ? 1 : 0));
+      ++_bits;
+      return false;
+    }
+
+    // Ninth clock: ACK bit of the completed byte.
+    if (_index == 0) {
+      _read = (_byte & 0x01) != 0;
+    }
+    out.kind = E2Event::Kind::BYTE;
+    out.value = _byte;
+    out.index = _index;
+    out.ack = !sda;
+    out.read = _read;
+    out.isPec = (_index == (_read ? 2 : 3));
+    out.pecOk = !out.isPec || _byte == _sum;
+    _sum = static_cast<uint8_t>(_sum + _byte);
+    if (_index < 0xFF) {
+      ++_index;
+    }
+    _bits = 0;
+    _byte = 0;
+    return true;
+  }
+
+private:
+  bool _inFrame = false;
+  bool _read = false;
+  uint8_t _bits = 0;
+  uint8_t _byte = 0;
+  uint8_t _index = 0;
+  uint8_t _sum = 0;
+};
+
+/// Receives decoded events from TriggerCapture::decode().
+using E2EventSink = void (*)(const E2Event& event, void* user);
+
+/// @brief Circular edge buffer that freezes a window around a trigger event.
+///
+/// sample() is called from the transport tap with the current line levels.
+/// Only changes are stored; each change is decoded immediately and checked
+/// against the armed trigger sources, so the cost per call is constant and no
+/// output is produced while waiting. After the trigger, postEdges more edges are
+/// recorded and the buffer freezes; the older part of the ring is the
+/// pre-trigger history. Not thread-safe; feed it from one context.
+///
+/// @tparam N Ring size in edges (one E2 bit is about four edges).
+template <size_t N>
+class TriggerCapture {
+  static_assert(N >= 2, "TriggerCapture needs at least two edges");
+
+public:
+  /// Clear the buffer and wait for a trigger.
+  /// @param cfg Trigger sources and post-trigger length; postEdges is limited to N - 1.
+  /// @param scl Current SCL level.
+  /// @param sda Current SDA level.
+  /// @param nowUs Current time in microseconds.
+  void arm(const TriggerConfig& cfg, bool scl, bool sda, uint32_t nowUs) {
+    _cfg = cfg;
+    if (_cfg.postEdges > N - 1) {
+      _cfg.postEdges = static_cast<uint16_t>(N - 1);
+    }
+    _decoder.reset();
+    _edges = 0;
+    _triggerEdge = 0;
+    _firedBy = 0;
+    _frozen = false;
+    _lastScl = scl;
+    _lastSda = sda;
+    _armEdge.tUs = nowUs;
+    _armEdge.scl = scl;
+    _armEdge.sda = sda;
+    _sclLowSinceUs = nowUs;
+    _stretchChecked = scl;
+    _armed = true;
+  }
+
+  /// Stop recording; a frozen window stays readable.
+  void disarm() { _armed = false; }
+
+  /// Feed the current line levels.
+  void sample(bool scl, bool sda, uint32_t nowUs) {
+    if (!_armed || _frozen) {
+      return;
+    }
+    // Checked on every call while SCL is low and on the rising edge that ends
+    // the low phase; a stretch belongs to the SCL falling edge that started it.
+    if (!_stretchChecked && !_lastScl && (_cfg.sources & trig::STRETCH) != 0 &&
+        static_cast<uint32_t>(nowUs - _sclLowSinceUs) > _cfg.stretchUs) {
+      _stretchChecked = true;
+      _fire(trig::STRETCH, (_edges == 0) ? 0 : _edges - 1);
+    }
+    if (scl != _lastScl || sda != _lastSda) {
+      CaptureEdge& e = _ring[_edges % N];
+      e.tUs = nowUs;
+      e.scl = scl;
+      e.sda = sda;
+      E2Event ev;
+      if (_decoder.feed(_lastScl, _lastSda, scl, sda, ev)) {
+        _checkEvent(ev);
+      }
+      if (_lastScl && !scl) {
+        _sclLowSinceUs = nowUs;
+        _stretchChecked = false;
+      }
+      _lastScl = scl;
+      _lastSda = sda;
+      ++_edges;
+    }
+    if (_firedBy != 0 && _edges > _triggerEdge && _edges - 1 - _triggerEdge >= _cfg.postEdges) {
+      _frozen = true;
+    }
+  }
+
+  bool armed() const { return _armed; }
+  bool triggered() const { return _firedBy != 0; }
+  /// Check whether the post-trigger edges are complete and the window is fixed.
+  bool frozen() const { return _frozen; }
+  /// trig:: source that fired, 0 before the trigger.
+  uint8_t firedBy() const { return _firedBy; }
+  /// Edges recorded since arm(), including those overwritten in the ring.
+  uint32_t edgesSeen() const { return _edges; }
+
+  /// Number of edges in the window.
+  size_t size() const { return (_edges < N) ? _edges : N; }
+  /// Capture index of the oldest edge in the window.
+  uint32_t firstEdge() const { return _edges - static_cast<uint32_t>(size()); }
+  /// Capture index of the edge on which the trigger fired.
+  uint32_t triggerEdge() const { return _triggerEdge; }
+  /// Window edge @p i, oldest first.
+  const CaptureEdge& edge(size_t i) const { return _ring[(firstEdge() + i) % N]; }
+
+  /// Decode the window and pass every event to @p sink; the first event
+  /// completed on or after the trigger edge has E2Event::trigger set (for
+  /// STRETCH the trigger edge is the falling SCL edge that began the stretch,
+  /// so the mark lands on the event that edge belongs to). Frames cut at the
+  /// start of the window are skipped until the next START.
+  void decode(E2EventSink sink, void* user) const {
+    if (sink == nullptr || size() == 0) {
+      return;
+    }
+    // Until the ring wraps, the levels seen by arm() precede the first edge.
+    E2EdgeDecoder decoder;
+    const bool wrapped = firstEdge() != 0;
+    const CaptureEdge* prev = wrapped ? &edge(0) : &_armEdge;
+    bool marked = false;
+    for (size_t i = wrapped ? 1 : 0; i < size(); ++i) {
+      const CaptureEdge& e = edge(i);
+      E2Event ev;
+      if (decoder.feed(prev->scl, prev->sda, e.scl, e.sda, ev)) {
+        ev.tUs = e.tUs;
+        ev.edge = firstEdge() + static_cast<uint32_t>(i);
+        ev.trigger = (_firedBy != 0 && !marked && ev.edge >= _triggerEdge);
+        marked = marked || ev.trigger;
+        sink(ev, user);
+      }
+      prev = &e;
+    }
+  }
+
+private:
+  // Called before the edge is counted, so _edges is the current edge index.
+  void _checkEvent(const E2Event& ev) {
+    if (ev.kind != E2Event::Kind::BYTE) {
+      return;
+    }
+    // The master NAKs the PEC of a read to end the frame; that is not a fault.
+    const bool expectedNak = ev.read && ev.isPec;
+    if ((_cfg.sources & trig::NACK) != 0 && !ev.ack && !expectedNak) {
+      _fire(trig::NACK, _edges);
+    } else if ((_cfg.sources & trig::PEC_MISMATCH) != 0 && !ev.pecOk) {
+      _fire(trig::PEC_MISMATCH, _edges);
+    } else if ((_cfg.sources & trig::CONTROL_BYTE) != 0 && ev.index == 0 &&
+               ((ev.value ^ _cfg.controlByte) & _cfg.controlMask) == 0) {
+      _fire(trig::CONTROL_BYTE, _edges);
+    }
+  }
+
+  void _fire(uint8_t source, uint32_t edge) {
+    if (_firedBy == 0) {
+      _firedBy = source;
+      _triggerEdge = edge;
+    }
+  }
+
+  CaptureEdge _ring[N];
+  CaptureEdge _armEdge;
+  TriggerConfig _cfg;
+  E2EdgeDecoder _decoder;
+  uint32_t _edges = 0;
+  uint32_t _triggerEdge = 0;
+  uint32_t _sclLowSinceUs = 0;
+  uint8_t _firedBy = 0;
+  bool _armed = false;
+  bool _frozen = false;
+  bool _lastScl = true;
+  bool _lastSda = true;
+  bool _stretchChecked = true;
+};
+
+/// Parse the number after a spec keyword: one or more spaces, then digits in
+/// @p base up to @p max. No sign, prefix, or other whitespace is accepted.
+/// @param[in,out] p Points at the end of the keyword; advanced past the digits.
+/// @return false when the spaces or digits are missing or the value exceeds @p max.
+inline bool parseSpecNumber(const char*& p, uint8_t base, uint32_t max, uint32_t& out) {
+  const char* q = p;
+  if (*q != ' ') {
+    return false;
+  }
+  while (*q == ' ') {
+    ++q;
+  }
+  uint32_t value = 0;
+  const char* digits = q;
+  for (;; ++q) {
+    uint32_t d = 0;
+    if (*q >= '0' && *q <= '9') {
+      d = static_cast<uint32_t>(*q - '0');
+    } else if (base == 16 && *q >= 'a' && *q <= 'f') {
+      d = static_cast<uint32_t>(*q - 'a' + 10);
+    } else if (base == 16 && *q >= 'A' && *q <= 'F') {
+      d = static_cast<uint32_t>(*q - 'A' + 10);
+    } else {
+      break;
+    }
+    if (d >= base || value > (max - d) / base) {
+      return false;
+    }
+    value = value * base + d;
+  }
+  if (q == digits) {
+    return false;
+  }
+  out = value;
+  p = q;
+  return true;
+}
+
+/// Parse a trigger spec of the form "nack", "pec", "stretch <us>",
+/// "ctrl <hex> [mask <hex>]", optionally followed by "post <edges>".
+/// @return false for an unknown or incomplete spec; @p out is then unchanged.
+inline bool parseTriggerSpec(const char* spec, TriggerConfig& out) {
+  if (spec == nullptr) {
+    return false;
+  }
+  TriggerConfig cfg;
+  const char* p = spec;
+  while (*p == ' ') {
+    ++p;
+  }
+  if (std::strncmp(p, "nack", 4) == 0) {
+    cfg.sources = trig::NACK;
+    p += 4;
+  } else if (std::strncmp(p, "pec", 3) == 0) {
+    cfg.sources = trig::PEC_MISMATCH;
+    p += 3;
+  } else if (std::strncmp(p, "stretch", 7) == 0) {
+    uint32_t us = 0;
+    p += 7;
+    if (!parseSpecNumber(p, 10, UINT32_MAX, us) || us == 0) {
+      return false;
+    }
+    cfg.sources = trig::STRETCH;
+    cfg.stretchUs = us;
+  } else if (std::strncmp(p, "ctrl", 4) == 0) {
+    uint32_t value = 0;
+    p += 4;
+    if (!parseSpecNumber(p, 16, 0xFF, value)) {
+      return false;
+    }
+    cfg.sources = trig::CONTROL_BYTE;
+    cfg.controlByte = static_cast<uint8_t>(value);
+    while (*p == ' ') {
+      ++p;
+    }
+    if (std::strncmp(p, "mask", 4) == 0) {
+      uint32_t mask = 0;
+      p += 4;
+      if (!parseSpecNumber(p, 16, 0xFF, mask)) {
+        return false;
+      }
+      cfg.controlMask = static_cast<uint8_t>(mask);
+    }
+  } else {
+    return false;
+  }
+
+  while (*p == ' ') {
+    ++p;
+  }
+  if (std::strncmp(p, "post", 4) == 0) {
+    uint32_t edges = 0;
+    p += 4;
+    if (!parseSpecNumber(p, 10, 0xFFFF, edges)) {
+      return false;
+    }
+    cfg.postEdges = static_cast<uint16_t>(edges);
+    while (*p == ' ') {
+      ++p;
+    }
+  }
+  if (*p != '\0') {
+    return false;
+  }
+  out = cfg;
+  return true;
+}
+
+} // namespace e2diag
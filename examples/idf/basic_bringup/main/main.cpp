@@ -13,6 +13,8 @@
 #include <unistd.h>
 
 #include "E2GpioTransport.h"
+#include "E2PmLock.h"
+#include "E2TriggerCapture.h"
 #include "EE871/EE871.h"
 
 #include "esp_err.h"
@@ -50,7 +52,8 @@ static constexpr uint32_t E2_INTERVAL_WRITE_DELAY_MS = 300;
 
 EE871::EE871 device;
 EE871::Config deviceCfg;
-ee871_idf::E2GpioBus e2Bus;
+EE871_DRAM_ATTR ee871_idf::E2GpioBus e2Bus;
+ee871_idf::PmBusLock pmLock;
 bool verboseMode = false;
 
 uint32_t nowMs() {
@@ -556,6 +559,11 @@ void printDriverHealth() {
       std::printf("  Error msg: %s\n", lastErr.msg);
     }
   }
+  std::printf("  PM locks: %s, held %lu ms/h (%lu transactions, %lu ms unlocked commit waits)\n",
+              pmLock.locking() ? "on" : "off (CONFIG_PM_ENABLE)",
+              static_cast<unsigned long>(pmLock.heldMsPerHour()),
+              static_cast<unsigned long>(pmLock.acquisitions()),
+              static_cast<unsigned long>(pmLock.waitedMs()));
   printPersistentDirtyFields(settings);
 }
 
@@ -644,6 +652,7 @@ void printHelp() {
   printHelpItem("pintest", "Test pin toggle (MCU bus control)");
   printHelpItem("clocktest", "Generate clock pulses and verify");
   printHelpItem("sniff", "Toggle sniffer on/off");
+  printHelpItem("sniff trig <src> [post N]", "Capture around nack|pec|stretch <us>|ctrl <hex> [mask <hex>]");
   printHelpItem("timing", "Try different clock frequencies");
   printHelpItem("busreset", "Send 9 clocks to recover stuck bus");
   printHelpItem("tx <hex>", "Test transaction with control byte");
@@ -1282,7 +1291,66 @@ bool isMatchingHighByte(uint8_t lowCmd, uint8_t highCmd) {
   return false;
 }
 
+// Triggered capture: edges are buffered without output, the window around the
+// first trigger is printed once by BusSniffer::tick().
+static constexpr size_t SNIFF_CAPTURE_EDGES = 1024;
+
+e2diag::TriggerCapture<SNIFF_CAPTURE_EDGES>& triggerCapture() {
+  static e2diag::TriggerCapture<SNIFF_CAPTURE_EDGES> capture;
+  return capture;
+}
+
+void printTriggerSources(uint8_t sources) {
+  const char* sep = "";
+  if (sources & e2diag::trig::NACK) { std::printf("%sNACK", sep); sep = "|"; }
+  if (sources & e2diag::trig::PEC_MISMATCH) { std::printf("%sPEC", sep); sep = "|"; }
+  if (sources & e2diag::trig::STRETCH) { std::printf("%sSTRETCH", sep); sep = "|"; }
+  if (sources & e2diag::trig::CONTROL_BYTE) { std::printf("%sCTRL", sep); }
+}
+
+void printCaptureEvent(const e2diag::E2Event& ev, void* user) {
+  const uint32_t triggerUs = *static_cast<const uint32_t*>(user);
+  const long relUs = static_cast<long>(static_cast<int32_t>(ev.tUs - triggerUs));
+  std::printf("%+9ld us  ", relUs);
+  if (ev.kind == e2diag::E2Event::Kind::START) {
+    std::printf("START");
+  } else if (ev.kind == e2diag::E2Event::Kind::STOP) {
+    std::printf("STOP");
+  } else if (ev.index == 0) {
+    std::printf("[0x%02X %s a%d] %s",
+                ev.value,
+                getCmdName((ev.value >> 4) & 0x0F, ev.read),
+                (ev.value >> 1) & 0x07,
+                ev.ack ? "ACK" : "NAK");
+  } else if (ev.isPec) {
+    std::printf("pec=0x%02X %s %s", ev.value, ev.pecOk ? "ok" : "BAD", ev.ack ? "ACK" : "NAK");
+  } else {
+    std::printf("0x%02X %s", ev.value, ev.ack ? "ACK" : "NAK");
+  }
+  if (ev.trigger) {
+    std::printf(" %s<<< TRIGGER%s", LOG_COLOR_YELLOW, LOG_COLOR_RESET);
+  }
+  std::printf("\n");
+}
+
+void printCaptureWindow() {
+  const auto& cap = triggerCapture();
+  const size_t n = cap.size();
+  const size_t triggerPos = cap.triggerEdge() - cap.firstEdge();
+  uint32_t triggerUs = cap.edge(triggerPos).tUs;
+  std::printf("\n%s=== Sniffer Trigger: ", LOG_COLOR_CYAN);
+  printTriggerSources(cap.firedBy());
+  std::printf(" ===%s\n", LOG_COLOR_RESET);
+  std::printf("Window: %lu edges (%lu pre, %lu post), %lu us\n",
+              static_cast<unsigned long>(n),
+              static_cast<unsigned long>(triggerPos),
+              static_cast<unsigned long>(n - 1 - triggerPos),
+              static_cast<unsigned long>(cap.edge(n - 1).tUs - cap.edge(0).tUs));
+  cap.decode(printCaptureEvent, &triggerUs);
+}
+
 void onLineSample(bool scl, bool sda) {
+  triggerCapture().sample(scl, sda, nowUs());
   auto& s = snifferState();
   if (!s.active) {
     s.lastScl = scl;
@@ -1374,7 +1442,22 @@ public:
     std::printf("[SNIFF] ON - 'sniff 0' to stop\n");
   }
 
+  void arm(const EE871::Config* cfg, const e2diag::TriggerConfig& trigger) {
+    stop();
+    triggerCapture().arm(trigger, cfg->readScl(cfg->busUser), cfg->readSda(cfg->busUser), nowUs());
+    _armed = true;
+    std::printf("[SNIFF] ARMED on ");
+    printTriggerSources(trigger.sources);
+    std::printf(", %u post edges - 'sniff' to disarm\n", static_cast<unsigned>(trigger.postEdges));
+  }
+
   void stop() {
+    if (_armed) {
+      _armed = false;
+      triggerCapture().disarm();
+      std::printf("[SNIFF] DISARMED (%lu edges, no trigger)\n",
+                  static_cast<unsigned long>(triggerCapture().edgesSeen()));
+    }
     auto& s = snifferState();
     if (s.active) {
       s.active = false;
@@ -1386,7 +1469,7 @@ public:
   }
 
   bool isActive() const {
-    return snifferState().active;
+    return snifferState().active || _armed;
   }
 
   void tick(const EE871::Config& cfg) {
@@ -1394,7 +1477,15 @@ public:
       return;
     }
     onLineSample(ee871_idf::readScl(cfg.busUser), ee871_idf::readSda(cfg.busUser));
+    if (_armed && triggerCapture().frozen()) {
+      _armed = false;
+      triggerCapture().disarm();
+      printCaptureWindow();
+    }
   }
+
+private:
+  bool _armed = false;
 };
 
 BusSniffer& sniffer() {
@@ -2348,6 +2439,13 @@ void processCommand(const char* input) {
     diag::testPinToggle(deviceCfg);
   } else if (std::strcmp(trimmed, "clocktest") == 0) {
     diag::testClockPulses(deviceCfg, 10);
+  } else if (std::strncmp(trimmed, "sniff trig", 10) == 0) {
+    e2diag::TriggerConfig trigger;
+    if (!e2diag::parseTriggerSpec(trimmed + 10, trigger)) {
+      logWarn("Usage: sniff trig nack|pec|stretch <us>|ctrl <hex> [mask <hex>] [post N]");
+    } else {
+      diag::sniffer().arm(&deviceCfg, trigger);
+    }
   } else if (std::strcmp(trimmed, "sniff") == 0) {
     if (diag::sniffer().isActive()) {
       diag::sniffer().stop();
@@ -2472,11 +2570,21 @@ bool pollLine(char* out, size_t outCap) {
 }
 
 void configureDevice() {
+#if defined(EE871_IRAM_BIT_ENGINE)
+  // The trace and sniffer wrappers run from flash; keep the bit engine's
+  // callbacks IRAM-resident so flash-cache stalls cannot stretch bit timing.
+  deviceCfg.setScl = ee871_idf::setScl;
+  deviceCfg.setSda = ee871_idf::setSda;
+  deviceCfg.readScl = ee871_idf::readScl;
+  deviceCfg.readSda = ee871_idf::readSda;
+  deviceCfg.delayUs = ee871_idf::delayUs;
+#else
   deviceCfg.setScl = trace::setScl;
   deviceCfg.setSda = trace::setSda;
   deviceCfg.readScl = trace::readScl;
   deviceCfg.readSda = trace::readSda;
   deviceCfg.delayUs = trace::delayUs;
+#endif
   deviceCfg.busUser = &e2Bus;
   deviceCfg.deviceAddress = EE871_ADDRESS;
   deviceCfg.clockLowUs = E2_CLOCK_LOW_US;
@@ -2486,6 +2594,8 @@ void configureDevice() {
   deviceCfg.writeDelayMs = E2_WRITE_DELAY_MS;
   deviceCfg.intervalWriteDelayMs = E2_INTERVAL_WRITE_DELAY_MS;
   deviceCfg.offlineThreshold = 5;
+  // PM locks only around transactions; commit waits yield and allow light sleep.
+  pmLock.attach(deviceCfg);
 }
 
 extern "C" void app_main(void) {
@@ -2504,6 +2614,9 @@ extern "C" void app_main(void) {
               static_cast<int>(E2_SDA),
               static_cast<int>(E2_SCL));
 
+  if (!pmLock.begin()) {
+    std::printf("[I] PM locks unavailable (CONFIG_PM_ENABLE off); bus timing unaffected\n");
+  }
   configureDevice();
 
   auto st = device.begin(deviceCfg);
@@ -1,14 +1,24 @@
 /// @file E2GpioTransport.h
 /// @brief ESP-IDF GPIO adapter for the EE871 E2 callback contract.
+///
+/// The line callbacks carry EE871_IRAM_ATTR so they stay callable from the
+/// IRAM-resident bit engine (CONFIG_EE871_IRAM_BIT_ENGINE). The E2GpioBus they
+/// read must then live in internal RAM, not in PSRAM or const flash data.
 #pragma once
 
 #include <cstdint>
 
 #include "EE871/EE871.h"
+#include "EE871/Placement.h"
 
 #include "driver/gpio.h"
 #include "esp_err.h"
 #include "esp_rom_sys.h"
+#include "sdkconfig.h"
+
+#if defined(EE871_IRAM_BIT_ENGINE) && !defined(CONFIG_GPIO_CTRL_FUNC_IN_IRAM)
+#warning "EE871_IRAM_BIT_ENGINE without CONFIG_GPIO_CTRL_FUNC_IN_IRAM: gpio_set_level/gpio_get_level still run from flash"
+#endif
 
 namespace ee871_idf {
 
@@ -45,33 +55,33 @@ inline esp_err_t init(E2GpioBus& bus, gpio_num_t scl, gpio_num_t sda,
   return gpio_set_level(sda, 1);
 }
 
-inline void setScl(bool level, void* user) {
+inline EE871_IRAM_ATTR void setScl(bool level, void* user) {
   auto* bus = static_cast<E2GpioBus*>(user);
   if (bus != nullptr && bus->scl != GPIO_NUM_NC) {
     (void)gpio_set_level(bus->scl, level ? 1 : 0);
   }
 }
 
-inline void setSda(bool level, void* user) {
+inline EE871_IRAM_ATTR void setSda(bool level, void* user) {
   auto* bus = static_cast<E2GpioBus*>(user);
   if (bus != nullptr && bus->sda != GPIO_NUM_NC) {
     (void)gpio_set_level(bus->sda, level ? 1 : 0);
   }
 }
 
-inline bool readScl(void* user) {
+inline EE871_IRAM_ATTR bool readScl(void* user) {
   auto* bus = static_cast<E2GpioBus*>(user);
   return (bus != nullptr && bus->scl != GPIO_NUM_NC) ? (gpio_get_level(bus->scl) != 0)
                                                      : false;
 }
 
-inline bool readSda(void* user) {
+inline EE871_IRAM_ATTR bool readSda(void* user) {
   auto* bus = static_cast<E2GpioBus*>(user);
   return (bus != nullptr && bus->sda != GPIO_NUM_NC) ? (gpio_get_level(bus->sda) != 0)
                                                      : false;
 }
 
-inline void delayUs(uint32_t us, void*) {
+inline EE871_IRAM_ATTR void delayUs(uint32_t us, void*) {
   esp_rom_delay_us(us);
 }
 
@@ -0,0 +1,194 @@
+/// @file E2PmLock.h
+/// @brief ESP-IDF power-management lock adapter for the EE871 bus-activity hooks.
+///
+/// Holds an ESP_PM_CPU_FREQ_MAX and an ESP_PM_NO_LIGHT_SLEEP lock only while
+/// the driver drives the E2 lines (Config::busActivity), so automatic light
+/// sleep and DFS can run between transactions without breaking bit timing.
+/// Flash-commit waits (Config::waitMs) run unlocked as yielding task delays.
+///
+/// The adapter is a template over the PM API so host tests can substitute a
+/// mock; EspPmApi and PmBusLock are only defined when building with ESP-IDF.
+#pragma once
+
+#include <cstdint>
+
+#include "EE871/Config.h"
+
+#if defined(ESP_PLATFORM)
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+namespace ee871_idf {
+
+/// Lock kinds requested from the PM API.
+enum class PmLockKind : uint8_t { CPU_FREQ_MAX, NO_LIGHT_SLEEP };
+
+/// @brief Bus-activity PM locking with hold-time accounting.
+///
+/// @tparam Api Provides `Handle`, `static bool create(PmLockKind, const char*,
+/// Handle&)`, `static void destroy(Handle)`, `static void acquire(Handle)`,
+/// `static void release(Handle)`, `static uint64_t nowUs()`, and
+/// `static void sleepMs(uint32_t)`.
+///
+/// When lock creation fails (e.g. CONFIG_PM_ENABLE is off), the hooks still
+/// run and commit waits still yield; no locks are taken. Not thread-safe; use
+/// one instance per E2 bus from the task that owns the driver.
+template <typename Api>
+class BasicPmBusLock {
+public:
+  BasicPmBusLock() = default;
+  BasicPmBusLock(const BasicPmBusLock&) = delete;
+  BasicPmBusLock& operator=(const BasicPmBusLock&) = delete;
+  ~BasicPmBusLock() { end(); }
+
+  /// Create the PM locks and start the statistics window.
+  /// @return true when both locks exist; false leaves locking disabled.
+  bool begin() {
+    end();
+    _haveCpu = Api::create(PmLockKind::CPU_FREQ_MAX, "ee871_cpu", _cpu);
+    _haveSleep = Api::create(PmLockKind::NO_LIGHT_SLEEP, "ee871_sleep", _sleep);
+    if (!_haveCpu || !_haveSleep) {
+      end();
+    }
+    resetStats();
+    return _haveCpu && _haveSleep;
+  }
+
+  /// Release a held lock and delete both locks.
+  void end() {
+    if (_depth > 0) {
+      _depth = 1;
+      _activity(false);
+    }
+    if (_haveCpu) {
+      Api::destroy(_cpu);
+    }
+    if (_haveSleep) {
+      Api::destroy(_sleep);
+    }
+    _haveCpu = false;
+    _haveSleep = false;
+  }
+
+  /// Install the hooks into @p cfg; call before EE871::begin().
+  void attach(EE871::Config& cfg) {
+    cfg.busActivity = &BasicPmBusLock::_activityThunk;
+    cfg.waitMs = &BasicPmBusLock::_waitMsThunk;
+    cfg.powerUser = this;
+  }
+
+  /// Restart the statistics window.
+  void resetStats() {
+    _sinceUs = Api::nowUs();
+    _heldUs = 0;
+    _acquisitions = 0;
+    _waitedMs = 0;
+    if (_depth > 0) {
+      _heldSinceUs = _sinceUs;
+    }
+  }
+
+  bool locking() const { return _haveCpu && _haveSleep; }
+  bool held() const { return _depth > 0; }
+  /// Transactions that took the locks since resetStats().
+  uint32_t acquisitions() const { return _acquisitions; }
+  /// Milliseconds spent in unlocked flash-commit waits since resetStats().
+  uint32_t waitedMs() const { return _waitedMs; }
+
+  /// Lock hold time since resetStats(), including a hold in progress.
+  uint64_t heldUs() const {
+    return _heldUs + (_depth > 0 ? (Api::nowUs() - _heldSinceUs) : 0U);
+  }
+
+  /// Time since resetStats().
+  uint64_t windowUs() const { return Api::nowUs() - _sinceUs; }
+
+  /// Lock hold time scaled to one hour of the statistics window.
+  /// @return Milliseconds held per hour; 0 before any time has passed.
+  uint32_t heldMsPerHour() const {
+    const uint64_t window = windowUs();
+    if (window == 0) {
+      return 0;
+    }
+    return static_cast<uint32_t>(heldUs() * 3600000ULL / window);
+  }
+
+private:
+  static void _activityThunk(bool active, void* user) {
+    static_cast<BasicPmBusLock*>(user)->_activity(active);
+  }
+
+  static void _waitMsThunk(uint32_t ms, void* user) {
+    static_cast<BasicPmBusLock*>(user)->_waitedMs += ms;
+    Api::sleepMs(ms);
+  }
+
+  void _activity(bool active) {
+    if (active) {
+      if (_depth++ == 0) {
+        if (locking()) {
+          Api::acquire(_cpu);
+          Api::acquire(_sleep);
+        }
+        _heldSinceUs = Api::nowUs();
+        ++_acquisitions;
+      }
+      return;
+    }
+    if (_depth == 0 || --_depth > 0) {
+      return;
+    }
+    _heldUs += Api::nowUs() - _heldSinceUs;
+    if (locking()) {
+      Api::release(_sleep);
+      Api::release(_cpu);
+    }
+  }
+
+  typename Api::Handle _cpu{};
+  typename Api::Handle _sleep{};
+  bool _haveCpu = false;
+  bool _haveSleep = false;
+  uint8_t _depth = 0;
+  uint64_t _sinceUs = 0;
+  uint64_t _heldSinceUs = 0;
+  uint64_t _heldUs = 0;
+  uint32_t _acquisitions = 0;
+  uint32_t _waitedMs = 0;
+};
+
+#if defined(ESP_PLATFORM)
+
+/// esp_pm / esp_timer / FreeRTOS binding for BasicPmBusLock.
+struct EspPmApi {
+  using Handle = esp_pm_lock_handle_t;
+
+  static bool create(PmLockKind kind, const char* name, Handle& out) {
+    const esp_pm_lock_type_t type =
+        (kind == PmLockKind::CPU_FREQ_MAX) ? ESP_PM_CPU_FREQ_MAX : ESP_PM_NO_LIGHT_SLEEP;
+    return esp_pm_lock_create(type, 0, name, &out) == ESP_OK;
+  }
+
+  static void destroy(Handle h) { (void)esp_pm_lock_delete(h); }
+  static void acquire(Handle h) { (void)esp_pm_lock_acquire(h); }
+  static void release(Handle h) { (void)esp_pm_lock_release(h); }
+  static uint64_t nowUs() { return static_cast<uint64_t>(esp_timer_get_time()); }
+
+  /// Yielding wait. Rounded up to whole ticks plus one, because the first
+  /// tick of vTaskDelay() may be partial and the commit time must be honored.
+  static void sleepMs(uint32_t ms) {
+    if (ms == 0) {
+      return;
+    }
+    vTaskDelay(static_cast<TickType_t>((ms + portTICK_PERIOD_MS - 1U) / portTICK_PERIOD_MS + 1U));
+  }
+};
+
+using PmBusLock = BasicPmBusLock<EspPmApi>;
+
+#endif
+
+}  // namespace ee871_idf
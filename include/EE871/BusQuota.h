@@ -0,0 +1,133 @@
+/// @file BusQuota.h
+/// @brief Per-client bus-time token buckets in front of one shared EE871
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/EE871.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Maximum number of clients one BusQuota tracks.
+static constexpr uint8_t QUOTA_CLIENTS_MAX = 8;
+
+/// @brief Bus-time allowance of one client.
+struct QuotaPolicy {
+  uint32_t rateUsPerSecond = 0; ///< Bus time credited per second; 0 means unlimited.
+  uint32_t burstUs = 0;         ///< Bucket capacity and starting balance.
+  uint32_t maxCacheAgeMs = 0;   ///< Over quota, serve a cached measurement this fresh; 0 never.
+};
+
+/// @brief Published consumption of one client.
+struct QuotaStats {
+  uint32_t admitted = 0;    ///< Calls that reached the bus.
+  uint32_t deferred = 0;    ///< Calls refused with BUSY.
+  uint32_t cacheHits = 0;   ///< Measurements served from cache instead of the bus.
+  uint64_t consumedUs = 0;  ///< Bus time charged, from lastOpInfo().busUs or the estimate.
+  int64_t balanceUs = 0;    ///< Tokens after the last refill or charge; negative is debt.
+};
+
+/// @brief Token-bucket admission for application modules sharing one EE871.
+///
+/// Tokens are bus microseconds. Each client's bucket refills at its policy
+/// rate up to its burst size; a call is admitted when the balance covers the
+/// call's estimated cost (a bucket that is full always admits, so an
+/// estimate above the burst size cannot starve a client). After the call the
+/// bucket is charged the bus time the driver actually spent, so a call that
+/// ran short of its estimate costs only what it used. A call that reached the
+/// bus but reports no bus time is charged its estimate instead.
+///
+/// A client over quota gets BUSY with the milliseconds until its estimate is
+/// covered in detail, or, for readMeasurement(), the last good measurement
+/// any client read through this gate when it is within the client's
+/// maxCacheAgeMs. Unlimited clients (rate 0) are always admitted and only
+/// counted, which suits the control loop next to rate-limited diagnostics and
+/// UI clients.
+///
+/// The gate only decides admission; serialization of concurrent callers
+/// remains the application's job. Not thread-safe; the driver must outlive
+/// the gate.
+class BusQuota {
+public:
+  BusQuota() = default;
+  BusQuota(const BusQuota&) = delete;
+  BusQuota& operator=(const BusQuota&) = delete;
+
+  /// Attach the shared driver and drop all clients.
+  /// @param device Initialized driver.
+  /// @param nowMs Current timestamp; buckets refill from here.
+  /// @return NOT_INITIALIZED for an uninitialized driver.
+  Status begin(EE871& device, uint32_t nowMs);
+
+  void end();
+
+  bool isInitialized() const { return _device != nullptr; }
+
+  /// Register a client with a full bucket.
+  /// @param policy Rate, burst, and cache allowance.
+  /// @param[out] client Handle for the other calls.
+  /// @return OUT_OF_RANGE when QUOTA_CLIENTS_MAX clients exist, INVALID_PARAM
+  /// for a limited policy with zero burst.
+  Status addClient(const QuotaPolicy& policy, uint8_t& client);
+
+  /// Refill @p client and check whether it may spend @p estimateUs now.
+  /// @return Ok, BUSY with the wait in ms in detail, or INVALID_PARAM.
+  Status admit(uint8_t client, uint32_t estimateUs, uint32_t nowMs);
+
+  /// Charge @p busUs of bus time to an admitted call of @p client.
+  void charge(uint8_t client, uint32_t busUs);
+
+  /// Quota-gated readMeasurement(); successful reads also refresh the shared cache.
+  /// @param[out] fromCache Optional; set when @p frame came from the cache.
+  /// @return The driver's result, Ok for a cache hit, or BUSY as admit().
+  Status readMeasurement(uint8_t client, uint32_t nowMs, MeasurementFrame& frame,
+                         bool* fromCache = nullptr);
+
+  /// Run any driver call under @p client's quota.
+  /// @param estimateUs Admission estimate, e.g. from measurementCostUs().
+  /// @param op Callable taking EE871& and returning Status.
+  /// @return BUSY as admit(), otherwise the result of @p op.
+  template <typename Op>
+  Status run(uint8_t client, uint32_t nowMs, uint32_t estimateUs, Op&& op) {
+    const Status st = admit(client, estimateUs, nowMs);
+    if (!st.ok()) {
+      return st;
+    }
+    const Status result = op(*_device);
+    _chargeLastOp(client, estimateUs);
+    return result;
+  }
+
+  /// Worst-case bus time of readMeasurement() with the driver's timing,
+  /// including the chained error-code read when the device supports it.
+  uint32_t measurementEstimateUs() const;
+
+  uint8_t clientCount() const { return _clientCount; }
+
+  /// Consumption of @p client; balanceUs is as of its last admit() or charge().
+  const QuotaStats& stats(uint8_t client) const;
+
+private:
+  struct Client {
+    QuotaPolicy policy;
+    QuotaStats stats;
+    uint32_t refillMs = 0;
+    uint32_t creditRemainder = 0;  ///< Sub-microsecond refill carried over, in us/1000.
+  };
+
+  void _refill(Client& c, uint32_t nowMs);
+  /// Charge the driver's last call, falling back to @p estimateUs when it ran
+  /// transactions without reporting bus time.
+  void _chargeLastOp(uint8_t client, uint32_t estimateUs);
+
+  EE871* _device = nullptr;
+  Client _clients[QUOTA_CLIENTS_MAX];
+  uint8_t _clientCount = 0;
+  MeasurementFrame _cache;
+  uint32_t _cacheMs = 0;
+  bool _cacheValid = false;
+};
+
+} // namespace EE871
@@ -153,6 +153,8 @@ static constexpr uint8_t BUS_ADDRESS_MIN = 0;           ///< Minimum persistent
 static constexpr uint8_t BUS_ADDRESS_MAX = 7;           ///< Maximum persistent bus address.
 
 static constexpr uint8_t BUS_RESET_CLOCKS = 9; ///< Minimum clocks with SDA high to reset slave state machine.
+static constexpr uint32_t DATA_SETUP_US = 10;  ///< Data setup time before SCL rises.
+static constexpr uint32_t POLL_STEP_US = 5;    ///< Clock-stretch polling step.
 
 static constexpr uint32_t WRITE_DELAY_MAX_MS = 5000; ///< Maximum accepted 0x10/0x50 write delay configuration.
 static constexpr uint32_t INTERVAL_WRITE_DELAY_MAX_MS = 5000; ///< Maximum accepted interval write delay configuration.
@@ -35,6 +35,69 @@ using E2ReadLineFn = bool (*)(void* user);
 /// @param user User context pointer passed through from Config.
 using E2DelayUsFn = void (*)(uint32_t us, void* user);
 
+/// @brief Optional byte-level E2 read-frame callback signature.
+///
+/// Runs one complete read transaction (START, control byte, slave ACK, data
+/// byte, master ACK, PEC byte, master NACK, STOP) in a single call, e.g. on a
+/// hardware-offloaded engine or a native fake. The driver still checks the PEC.
+/// Failures must use the same codes and messages as the line engine: NACK
+/// "Control byte NACK", TIMEOUT "Clock stretch timeout" or "Byte timeout".
+/// @param controlByte Read control byte to send.
+/// @param data Receives the data byte.
+/// @param pec Receives the PEC byte as sent by the slave.
+/// @param user User context pointer passed through from Config.
+/// @return Status::Ok() when all bytes were transferred.
+using E2ReadFrameFn = Status (*)(uint8_t controlByte, uint8_t& data, uint8_t& pec, void* user);
+
+/// @brief Optional byte-level E2 write-frame callback signature.
+///
+/// Runs one complete write transaction (START, control, address, data and PEC
+/// bytes each followed by a slave ACK, STOP). Failures must use the line
+/// engine's codes and messages: NACK "Control byte NACK", "Address byte NACK",
+/// "Data byte NACK", "PEC NACK", or the TIMEOUT messages above.
+/// @param controlByte Write control byte.
+/// @param addressByte Address byte.
+/// @param dataByte Data byte.
+/// @param pec PEC byte computed by the driver.
+/// @param accepted Set true once the slave ACKed the PEC byte, even if STOP then fails.
+/// @param user User context pointer passed through from Config.
+/// @return Status::Ok() when the transaction completed.
+using E2WriteFrameFn = Status (*)(uint8_t controlByte, uint8_t addressByte, uint8_t dataByte,
+                                  uint8_t pec, bool& accepted, void* user);
+
+/// @brief Optional bus-activity notification signature.
+///
+/// Called with active = true immediately before the driver drives the lines
+/// for one transaction (or a bus-reset sequence) and with active = false right
+/// after it, so platforms can hold power-management locks only while bit
+/// timing matters. Flash-commit waits happen outside these windows. Must be
+/// bounded and must not call back into the driver.
+/// @param active true at the start, false at the end of the activity.
+/// @param user Config::powerUser (MultiBusConfig::powerUser for the engine).
+using E2BusActivityFn = void (*)(bool active, void* user);
+
+/// @brief Optional millisecond wait signature for flash-commit waits.
+///
+/// Replaces the default of 1000 us delayUs() steps per millisecond, e.g. with a
+/// yielding RTOS sleep. Must wait at least @p ms milliseconds.
+/// @param ms Milliseconds to wait.
+/// @param user Config::powerUser.
+using E2WaitMsFn = void (*)(uint32_t ms, void* user);
+
+/// @brief Optional radio-coordination signature.
+///
+/// Called with start = true before each transaction (or bus-reset sequence),
+/// ahead of busActivity, and with start = false after it. @p expectedUs is
+/// the nominal line time from deriveTiming() without clock stretching, the
+/// same value both times. The start call may block until the radio is quiet,
+/// e.g. wait out an ongoing burst and hold queued transmissions for
+/// @p expectedUs; the end call releases them. Must not call back into the
+/// driver.
+/// @param start true before, false after the transaction.
+/// @param expectedUs Nominal duration of the transaction.
+/// @param user Config::radioUser (MultiBusConfig::radioUser for the engine).
+using E2QuietWindowFn = void (*)(bool start, uint32_t expectedUs, void* user);
+
 /// @brief Configuration for EE871 driver.
 ///
 /// The transport callbacks implement GPIO-style open-drain E2 line control.
@@ -55,9 +118,38 @@ struct Config {
   E2DelayUsFn delayUs = nullptr;  ///< Delay for bit timing
   void* busUser = nullptr;        ///< User context for callbacks
 
+  // === Byte-Level Transport (optional) ===
+  // When both are set, register transfers use these instead of bit-banging the
+  // line callbacks above; bus reset and idle checks still use the lines.
+  E2ReadFrameFn readFrame = nullptr;   ///< Whole read transaction, set together with writeFrame
+  E2WriteFrameFn writeFrame = nullptr; ///< Whole write transaction, set together with readFrame
+
+  // === Power Management (optional) ===
+  E2BusActivityFn busActivity = nullptr; ///< Transaction start/end notification
+  E2WaitMsFn waitMs = nullptr;           ///< Flash-commit wait; default is delayUs(1000) steps
+  void* powerUser = nullptr;             ///< User context for busActivity and waitMs
+
+  // === Radio Coordination (optional) ===
+  E2QuietWindowFn quietWindow = nullptr; ///< Quiet-window request around each transaction
+  void* radioUser = nullptr;             ///< User context for quietWindow
+
   // === Device Settings ===
   uint8_t deviceAddress = 0;      ///< E2 protocol device address (0-7), not a hardware I2C address.
 
+  /// Remember the custom-memory pointer after 0x50 writes and 0x51 reads and
+  /// skip the pointer write when it already points at the requested address.
+  /// Only enable when nothing else on the bus talks to this device.
+  bool trackCustomPointer = false;
+
+  /// Reduced-traffic MV4 reads: readCo2Average() reads the high byte at
+  /// least every N reads and otherwise only when the low byte moved by more
+  /// than co2ElisionMaxStep or across a 256 ppm boundary. 0 or 1 reads both
+  /// bytes every time. A real change of 256 ppm or more that lands within
+  /// co2ElisionMaxStep of the old low byte is missed until the next refresh,
+  /// so only enable for slowly varying CO2.
+  uint8_t co2HighByteRefresh = 0;
+  uint8_t co2ElisionMaxStep = 64; ///< Largest low-byte step (ppm) elision accepts, 1..127.
+
   // === Timing (E2 spec) ===
   uint16_t clockLowUs = 100;      ///< Minimum CLK low time, must be >= 100 us.
   uint16_t clockHighUs = 100;     ///< Minimum CLK high time, must be >= 100 us.
@@ -0,0 +1,249 @@
+/// @file ConfigBuilder.h
+/// @brief Constexpr E2 timing validation, derived bit-engine timing, and Config builder
+#pragma once
+
+#include <cstdint>
+
+#include "EE871/CommandTable.h"
+#include "EE871/Config.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Timing and flash-delay fields of Config in a constant-expression form.
+///
+/// Defaults match Config. validateTiming() applies the same rules and messages
+/// as begin(), so a TimingConfig that passes a static_assert also passes begin().
+struct TimingConfig {
+  uint16_t clockLowUs = 100;           ///< Minimum CLK low time, must be >= 100 us.
+  uint16_t clockHighUs = 100;          ///< Minimum CLK high time, must be >= 100 us.
+  uint16_t startHoldUs = 100;          ///< START hold time, must be >= 4 us.
+  uint16_t stopHoldUs = 100;           ///< STOP hold time, must be >= 4 us.
+  uint32_t bitTimeoutUs = 25000;       ///< Clock-stretch timeout per bit, must be > 0.
+  uint32_t byteTimeoutUs = 35000;      ///< Clock-stretch timeout per byte, must be >= bitTimeoutUs.
+  uint32_t writeDelayMs = 150;         ///< Flash write delay, max cmd::WRITE_DELAY_MAX_MS.
+  uint32_t intervalWriteDelayMs = 300; ///< Interval write delay, max cmd::INTERVAL_WRITE_DELAY_MAX_MS.
+};
+
+/// Copy the timing fields of a Config.
+/// @param cfg Source configuration.
+/// @return Timing fields of @p cfg.
+constexpr TimingConfig timingOf(const Config& cfg) {
+  TimingConfig t;
+  t.clockLowUs = cfg.clockLowUs;
+  t.clockHighUs = cfg.clockHighUs;
+  t.startHoldUs = cfg.startHoldUs;
+  t.stopHoldUs = cfg.stopHoldUs;
+  t.bitTimeoutUs = cfg.bitTimeoutUs;
+  t.byteTimeoutUs = cfg.byteTimeoutUs;
+  t.writeDelayMs = cfg.writeDelayMs;
+  t.intervalWriteDelayMs = cfg.intervalWriteDelayMs;
+  return t;
+}
+
+/// Store timing fields into a Config; the inverse of timingOf().
+/// @param cfg Configuration to update.
+/// @param t Timing to copy in.
+constexpr void applyTiming(Config& cfg, const TimingConfig& t) {
+  cfg.clockLowUs = t.clockLowUs;
+  cfg.clockHighUs = t.clockHighUs;
+  cfg.startHoldUs = t.startHoldUs;
+  cfg.stopHoldUs = t.stopHoldUs;
+  cfg.bitTimeoutUs = t.bitTimeoutUs;
+  cfg.byteTimeoutUs = t.byteTimeoutUs;
+  cfg.writeDelayMs = t.writeDelayMs;
+  cfg.intervalWriteDelayMs = t.intervalWriteDelayMs;
+}
+
+/// Check timing against E2 specification minima and driver safety maxima.
+/// @param t Timing to check.
+/// @return Status::Ok(), or INVALID_CONFIG with the message begin() would report.
+constexpr Status validateTiming(const TimingConfig& t) {
+  if (t.clockLowUs < 100 || t.clockHighUs < 100) {
+    return Status::Error(Err::INVALID_CONFIG, "Clock timing below spec");
+  }
+  if (t.startHoldUs < 4 || t.stopHoldUs < 4) {
+    return Status::Error(Err::INVALID_CONFIG, "Start/stop hold below spec");
+  }
+  if (t.bitTimeoutUs == 0 || t.byteTimeoutUs == 0) {
+    return Status::Error(Err::INVALID_CONFIG, "Timeouts must be non-zero");
+  }
+  if (t.byteTimeoutUs < t.bitTimeoutUs) {
+    return Status::Error(Err::INVALID_CONFIG, "byteTimeoutUs must be >= bitTimeoutUs");
+  }
+  if (t.writeDelayMs > cmd::WRITE_DELAY_MAX_MS) {
+    return Status::Error(Err::INVALID_CONFIG, "writeDelayMs exceeds safe limit");
+  }
+  if (t.intervalWriteDelayMs > cmd::INTERVAL_WRITE_DELAY_MAX_MS) {
+    return Status::Error(Err::INVALID_CONFIG, "intervalWriteDelayMs exceeds safe limit");
+  }
+  return Status::Ok();
+}
+
+/// @brief Bit-engine delays and nominal transaction times derived once from TimingConfig.
+///
+/// The frame times assume no clock stretching and match the delays the line
+/// engine requests for a complete read (3 bytes) or write (4 bytes) transaction.
+struct DerivedTiming {
+  uint16_t clockLowUs = 0;    ///< SCL low time after each falling edge.
+  uint16_t clockHighUs = 0;   ///< SCL high time of master-driven bits.
+  uint16_t sampleUs = 0;      ///< SCL high time before sampling SDA (clockHighUs / 2).
+  uint16_t sampleRestUs = 0;  ///< SCL high time after sampling SDA.
+  uint16_t startHoldUs = 0;   ///< Delay before and after the START SDA edge.
+  uint16_t stopHoldUs = 0;    ///< Delay before and after the STOP SDA edge.
+  uint32_t bitTimeoutUs = 0;  ///< Clock-stretch timeout per bit.
+  uint32_t byteTimeoutUs = 0; ///< Clock-stretch timeout per byte.
+  uint32_t bitUs = 0;         ///< One data or ACK bit: data setup + high + low.
+  uint32_t readFrameUs = 0;   ///< Nominal read transaction time.
+  uint32_t writeFrameUs = 0;  ///< Nominal write transaction time.
+  uint32_t resetUs = 0;       ///< Nominal bus-reset sequence time.
+};
+
+/// Derive bit-engine delays and nominal frame times.
+/// @param t Timing, normally already accepted by validateTiming().
+/// @return Derived values.
+constexpr DerivedTiming deriveTiming(const TimingConfig& t) {
+  DerivedTiming d;
+  d.clockLowUs = t.clockLowUs;
+  d.clockHighUs = t.clockHighUs;
+  d.sampleUs = static_cast<uint16_t>(t.clockHighUs / 2);
+  d.sampleRestUs = static_cast<uint16_t>(t.clockHighUs - d.sampleUs);
+  d.startHoldUs = t.startHoldUs;
+  d.stopHoldUs = t.stopHoldUs;
+  d.bitTimeoutUs = t.bitTimeoutUs;
+  d.byteTimeoutUs = t.byteTimeoutUs;
+  d.bitUs = cmd::DATA_SETUP_US + static_cast<uint32_t>(t.clockHighUs) + t.clockLowUs;
+  const uint32_t startUs = 2U * t.startHoldUs + static_cast<uint32_t>(t.clockLowUs);
+  const uint32_t stopUs = cmd::DATA_SETUP_US + 2U * static_cast<uint32_t>(t.stopHoldUs);
+  d.readFrameUs = startUs + 27U * d.bitUs + stopUs;
+  d.writeFrameUs = startUs + 36U * d.bitUs + stopUs;
+  d.resetUs = cmd::BUS_RESET_CLOCKS * (static_cast<uint32_t>(t.clockLowUs) + t.clockHighUs) +
+              t.clockLowUs + stopUs;
+  return d;
+}
+
+/// Nominal bus time of one readMeasurement(): status byte plus MV4 low and high.
+/// @param withErrorCode Add the chained 0xC1 error-code read (pointer write + read).
+constexpr uint32_t measurementCostUs(const DerivedTiming& d, bool withErrorCode = false) {
+  return 3U * d.readFrameUs + (withErrorCode ? (d.writeFrameUs + d.readFrameUs) : 0U);
+}
+
+/// @brief Constexpr builder for the non-callback part of Config.
+///
+/// Each setter returns a modified copy, so a whole configuration can be a
+/// constant and checked at build time:
+/// @code
+///   constexpr auto kE2 = EE871::ConfigBuilder().clockUs(120, 120).writeDelaysMs(200, 300);
+///   static_assert(kE2.valid(), "EE871 E2 timing out of spec");
+///   EE871::Config cfg = kE2.build(transportCallbacks);
+/// @endcode
+class ConfigBuilder {
+public:
+  constexpr ConfigBuilder() = default;
+
+  /// Set minimum SCL low and high times.
+  constexpr ConfigBuilder clockUs(uint16_t lowUs, uint16_t highUs) const {
+    ConfigBuilder b = *this;
+    b._timing.clockLowUs = lowUs;
+    b._timing.clockHighUs = highUs;
+    return b;
+  }
+
+  /// Set START and STOP hold times.
+  constexpr ConfigBuilder holdUs(uint16_t startUs, uint16_t stopUs) const {
+    ConfigBuilder b = *this;
+    b._timing.startHoldUs = startUs;
+    b._timing.stopHoldUs = stopUs;
+    return b;
+  }
+
+  /// Set per-bit and per-byte clock-stretch timeouts.
+  constexpr ConfigBuilder timeoutsUs(uint32_t bitUs, uint32_t byteUs) const {
+    ConfigBuilder b = *this;
+    b._timing.bitTimeoutUs = bitUs;
+    b._timing.byteTimeoutUs = byteUs;
+    return b;
+  }
+
+  /// Set flash write delays for custom writes and the interval pair.
+  constexpr ConfigBuilder writeDelaysMs(uint32_t writeMs, uint32_t intervalMs) const {
+    ConfigBuilder b = *this;
+    b._timing.writeDelayMs = writeMs;
+    b._timing.intervalWriteDelayMs = intervalMs;
+    return b;
+  }
+
+  /// Set the E2 device address (0-7).
+  constexpr ConfigBuilder deviceAddress(uint8_t address) const {
+    ConfigBuilder b = *this;
+    b._deviceAddress = address;
+    return b;
+  }
+
+  /// Set consecutive failures before OFFLINE; zero normalizes to 1.
+  constexpr ConfigBuilder offlineThreshold(uint8_t threshold) const {
+    ConfigBuilder b = *this;
+    b._offlineThreshold = threshold;
+    return b;
+  }
+
+  /// Enable Config::trackCustomPointer.
+  constexpr ConfigBuilder trackCustomPointer(bool enabled) const {
+    ConfigBuilder b = *this;
+    b._trackCustomPointer = enabled;
+    return b;
+  }
+
+  /// Set Config::co2HighByteRefresh and Config::co2ElisionMaxStep.
+  constexpr ConfigBuilder co2HighByteElision(uint8_t refreshEvery, uint8_t maxStep = 64) const {
+    ConfigBuilder b = *this;
+    b._co2HighByteRefresh = refreshEvery;
+    b._co2ElisionMaxStep = maxStep;
+    return b;
+  }
+
+  /// Check the device address, MV4 elision, and timing.
+  /// @return Status::Ok(), or INVALID_CONFIG with the message begin() would report.
+  constexpr Status validate() const {
+    if (_deviceAddress > cmd::DEVICE_ADDRESS_MAX) {
+      return Status::Error(Err::INVALID_CONFIG, "Invalid device address");
+    }
+    if (_co2HighByteRefresh > 1 && (_co2ElisionMaxStep == 0 || _co2ElisionMaxStep > 127)) {
+      return Status::Error(Err::INVALID_CONFIG, "Invalid CO2 elision step");
+    }
+    return validateTiming(_timing);
+  }
+
+  /// @return true when validate() succeeds; intended for static_assert.
+  constexpr bool valid() const { return validate().ok(); }
+
+  constexpr const TimingConfig& timing() const { return _timing; }
+  constexpr DerivedTiming derived() const { return deriveTiming(_timing); }
+
+  /// Build a normalized Config with no transport callbacks.
+  constexpr Config build() const { return build(Config()); }
+
+  /// Build a normalized Config that uses the transport of @p transport.
+  /// @param transport Supplies line callbacks, frame hooks, and busUser.
+  /// @return Copy of @p transport with every builder field applied.
+  constexpr Config build(const Config& transport) const {
+    Config cfg = transport;
+    cfg.deviceAddress = _deviceAddress;
+    cfg.trackCustomPointer = _trackCustomPointer;
+    cfg.co2HighByteRefresh = _co2HighByteRefresh;
+    cfg.co2ElisionMaxStep = _co2ElisionMaxStep;
+    applyTiming(cfg, _timing);
+    cfg.offlineThreshold = (_offlineThreshold == 0) ? 1 : _offlineThreshold;
+    return cfg;
+  }
+
+private:
+  TimingConfig _timing;
+  uint8_t _deviceAddress = 0;
+  uint8_t _offlineThreshold = 5;
+  bool _trackCustomPointer = false;
+  uint8_t _co2HighByteRefresh = 0;
+  uint8_t _co2ElisionMaxStep = 64;
+};
+
+} // namespace EE871
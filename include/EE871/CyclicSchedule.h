@@ -0,0 +1,102 @@
+/// @file CyclicSchedule.h
+/// @brief Static cyclic (time-triggered) poll tables and their executor
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/ConfigBuilder.h"
+#include "EE871/Fleet.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// One table entry: poll store row @p row at @p releaseUs into the major cycle.
+struct CyclicSlot {
+  uint32_t releaseUs = 0;
+  uint16_t row = 0;
+};
+
+/// @brief Major/minor frame table, normally generated by tools/cyclic_schedule.py.
+///
+/// Slots are sorted by release time, never overlap, and each one finishes
+/// inside the minor frame it is released in. The major cycle is a whole
+/// number of milliseconds and of minor frames.
+struct CyclicSchedule {
+  uint32_t minorFrameUs = 0;
+  uint32_t majorCycleUs = 0;
+  const CyclicSlot* slots = nullptr;
+  uint16_t slotCount = 0;
+  uint32_t slotCostUs = 0;  ///< Bus budget reserved for every slot.
+};
+
+/// Check the CyclicSchedule invariants; usable in static_assert.
+constexpr bool scheduleFits(const CyclicSchedule& s) {
+  if (s.minorFrameUs == 0 || s.majorCycleUs == 0 || s.slots == nullptr || s.slotCount == 0 ||
+      s.slotCostUs == 0 || (s.majorCycleUs % s.minorFrameUs) != 0 ||
+      (s.majorCycleUs % 1000U) != 0) {
+    return false;
+  }
+  uint32_t busyUntil = 0;
+  for (uint16_t i = 0; i < s.slotCount; ++i) {
+    const uint32_t release = s.slots[i].releaseUs;
+    const uint32_t frameEnd = (release / s.minorFrameUs + 1U) * s.minorFrameUs;
+    if (release < busyUntil || release >= s.majorCycleUs || s.slotCostUs > frameEnd - release) {
+      return false;
+    }
+    busyUntil = release + s.slotCostUs;
+  }
+  return true;
+}
+
+/// @brief Counters of a CyclicExecutor since begin().
+struct CyclicStats {
+  uint32_t cycles = 0;        ///< Completed major cycles.
+  uint32_t executed = 0;      ///< Slots polled.
+  uint32_t failed = 0;        ///< Polled slots whose readMeasurement() failed.
+  uint32_t skipped = 0;       ///< Slots dropped because their minor frame had ended.
+  uint32_t maxLatenessUs = 0; ///< Worst poll start after the slot release.
+};
+
+/// @brief Runs a CyclicSchedule through a FleetPoller from tick().
+///
+/// Every slot is released at a fixed offset from the start of its major
+/// cycle, so poll times do not depend on how long earlier polls took. A slot
+/// that is still pending when its minor frame ends is dropped and counted
+/// instead of run late, so one slow tick cannot shift the rest of the table.
+/// Call tick() at least once per minor frame, ideally at nextReleaseMs().
+/// Not thread-safe; the schedule table and poller must outlive the executor.
+class CyclicExecutor {
+public:
+  CyclicExecutor() = default;
+  CyclicExecutor(const CyclicExecutor&) = delete;
+  CyclicExecutor& operator=(const CyclicExecutor&) = delete;
+
+  /// @param schedule Table accepted by scheduleFits().
+  /// @param poller Initialized poller whose rows the table refers to.
+  /// @param startMs Start of the first major cycle.
+  /// @return INVALID_PARAM for a bad table, NOT_INITIALIZED for an uninitialized poller.
+  Status begin(const CyclicSchedule& schedule, FleetPoller& poller, uint32_t startMs);
+
+  void end();
+
+  bool isInitialized() const { return _poller != nullptr; }
+
+  /// Poll every slot released up to @p nowMs.
+  /// @return Ok, or E2_ERROR with the number of failed polls in detail.
+  Status tick(uint32_t nowMs);
+
+  /// Release time of the next pending slot, in the caller's millisecond clock (rounded up).
+  uint32_t nextReleaseMs() const;
+
+  const CyclicStats& stats() const { return _stats; }
+
+private:
+  CyclicSchedule _schedule;
+  FleetPoller* _poller = nullptr;
+  uint32_t _cycleStartMs = 0;
+  uint16_t _next = 0;
+  CyclicStats _stats;
+};
+
+} // namespace EE871
@@ -7,6 +7,7 @@
 
 #include "EE871/CommandTable.h"
 #include "EE871/Config.h"
+#include "EE871/ConfigBuilder.h"
 #include "EE871/Status.h"
 #include "EE871/Version.h"
 
@@ -20,6 +21,123 @@ enum class DriverState : uint8_t {
   OFFLINE    ///< consecutiveFailures >= offlineThreshold
 };
 
+/// @brief Cost of the most recent public driver call, see EE871::lastOpInfo().
+///
+/// Each public call that can touch the bus resets the record on entry; nested
+/// public calls made internally (e.g. customWrite() verifying with customRead())
+/// add to the outer call's record. Times come from the delays requested by the
+/// line engine; with Config frame hooks, each transaction adds the nominal
+/// frame time of the configured timing to busUs, stretchUs stays 0, and bytes
+/// are counted only for completed transactions.
+struct OpInfo {
+  uint16_t transactions = 0;     ///< E2 read/write transactions started.
+  uint32_t busUs = 0;            ///< Line time of transactions and busReset(), including stretch.
+  uint32_t stretchUs = 0;        ///< Part of busUs spent waiting for SCL held low by the slave.
+  uint32_t commitWaitUs = 0;     ///< Flash write waits (writeDelayMs, intervalWriteDelayMs).
+  uint16_t bytesTransferred = 0; ///< Bytes fully clocked: control, address, data, and PEC.
+  bool cacheHit = false;         ///< Driver state replaced a bus transfer (custom pointer, MV4 high byte).
+  bool coalesced = false;        ///< Transfer shared with other requested work.
+};
+
+/// @brief Kind of work item in an EE871::execute() batch.
+enum class RequestKind : uint8_t {
+  CONTROL_READ, ///< One control-byte read (status, MV3/MV4 byte, identity byte).
+  CUSTOM_READ,  ///< Custom-memory range read into out[0..len).
+  CUSTOM_WRITE  ///< Custom-memory range write from in[0..len), verified per byte.
+};
+
+/// @brief One work item for EE871::execute(); status is filled in place.
+struct Request {
+  RequestKind kind = RequestKind::CONTROL_READ; ///< Work item kind.
+  uint8_t command = 0;      ///< Main-command nibble (CONTROL_READ) or first custom address.
+  uint8_t* out = nullptr;   ///< Read destination: 1 byte for CONTROL_READ, len bytes for CUSTOM_READ.
+  const uint8_t* in = nullptr; ///< CUSTOM_WRITE source bytes.
+  size_t len = 0;           ///< Byte count for custom requests.
+  Status status;            ///< Result written by execute().
+
+  /// @brief Build a control-byte read request.
+  static Request controlRead(uint8_t mainCommand, uint8_t& data) {
+    Request r;
+    r.command = mainCommand;
+    r.out = &data;
+    r.len = 1;
+    return r;
+  }
+
+  /// @brief Build a custom-memory range read request.
+  static Request customRead(uint8_t address, uint8_t* buf, size_t len) {
+    Request r;
+    r.kind = RequestKind::CUSTOM_READ;
+    r.command = address;
+    r.out = buf;
+    r.len = len;
+    return r;
+  }
+
+  /// @brief Build a custom-memory range write request.
+  static Request customWrite(uint8_t address, const uint8_t* buf, size_t len) {
+    Request r;
+    r.kind = RequestKind::CUSTOM_WRITE;
+    r.command = address;
+    r.in = buf;
+    r.len = len;
+    return r;
+  }
+};
+
+/// @brief Status byte plus the CO2 error code fetched in the same call.
+struct StatusReport {
+  uint8_t status = 0;             ///< Raw status byte.
+  bool co2Error = false;          ///< Status bit3 (CO2 error) is set.
+  bool errorCodeValid = false;    ///< errorCode was read (error bit set and hasErrorCode()).
+  uint8_t errorCode = 0;          ///< Custom memory 0xC1, valid when errorCodeValid.
+  const char* errorCodeName = ""; ///< cmd::co2ErrorCodeName(errorCode) when errorCodeValid.
+};
+
+/// @brief Status, averaged CO2, and chained error code from one call.
+struct MeasurementFrame {
+  StatusReport status;            ///< Status byte and chained error code.
+  uint16_t co2Average = 0;        ///< MV4 CO2 concentration in ppm.
+};
+
+/// @brief Change counters for the sections of SettingsSnapshot.
+///
+/// Each counter increments (wrapping) whenever its section may have changed
+/// and never otherwise, so an unchanged counter means a copy taken earlier is
+/// still current. Counters survive end() and begin(); compare with !=.
+struct SnapshotGenerations {
+  uint32_t health = 0;          ///< State, timestamps, last error, failure/success counters.
+  uint32_t features = 0;        ///< Cached 0x07/0x08/0x09 feature flags.
+  uint32_t persistentDirty = 0; ///< Persistent dirty flag and its error.
+  uint32_t config = 0;          ///< Active configuration.
+  uint32_t measurement = 0;     ///< Successful MV3/MV4 reads (readCo2Fast/Average, readMeasurement).
+};
+
+/// @brief Identity and feature bytes read from a device during bring-up.
+///
+/// begin() reads these itself; beginFromProbe() takes them from a probe
+/// already run on the device's bus, e.g. by beginFleet().
+struct DeviceProbe {
+  uint16_t groupId = 0;             ///< MAIN_TYPE_LO | MAIN_TYPE_HI << 8.
+  bool featuresValid = false;       ///< 0x07..0x09 were read; otherwise all features stay off.
+  uint8_t operatingFunctions = 0;   ///< Custom memory 0x07.
+  uint8_t operatingModeSupport = 0; ///< Custom memory 0x08.
+  uint8_t specialFeatures = 0;      ///< Custom memory 0x09.
+};
+
+/// @brief Health-only part of SettingsSnapshot, without the Config copy.
+struct HealthSnapshot {
+  DriverState state = DriverState::UNINIT; ///< Current coarse health state.
+  bool initialized = false;       ///< True after successful begin().
+  uint32_t lastOkMs = 0;          ///< Last tracked successful E2 operation.
+  uint32_t lastErrorMs = 0;       ///< Last tracked failed E2 operation.
+  Status lastError = Status::Ok(); ///< Last tracked error status.
+  uint8_t consecutiveFailures = 0; ///< Current consecutive tracked failures.
+  uint32_t totalFailures = 0;     ///< Total tracked failures.
+  uint32_t totalSuccess = 0;      ///< Total tracked successes.
+  uint32_t generation = 0;        ///< SnapshotGenerations::health at copy time.
+};
+
 /// @brief Snapshot of current configuration, cached feature flags, and driver health.
 ///
 /// Snapshot access does not touch the E2 bus. The persistent dirty fields mirror
@@ -41,6 +159,7 @@ struct SettingsSnapshot {
   uint32_t totalSuccess = 0;      ///< Total tracked successes.
   bool persistentConfigDirty = false; ///< True when persistent config may be partially applied.
   Status persistentConfigDirtyError = Status::Ok(); ///< First error that marked persistent config dirty.
+  SnapshotGenerations generations; ///< Counters at copy time; nowMs is not covered.
 };
 
 /// @brief Transport-agnostic EE871 CO2 sensor driver for the E2 bus.
@@ -87,6 +206,17 @@ public:
   /// @return Status::Ok() on success, error otherwise.
   Status begin(const Config& config);
 
+  /// Initialize from an identity/feature probe taken elsewhere, without bus traffic.
+  ///
+  /// Validates and normalizes @p config like begin(), then accepts @p probe
+  /// in place of begin()'s own identity and feature reads. The bus-idle check
+  /// and reset are skipped; the prober is responsible for the bus state.
+  /// @param config Configuration including E2 transport callbacks.
+  /// @param probe Bytes read from the device at config.deviceAddress.
+  /// @return Status::Ok() on success, DEVICE_NOT_FOUND for a foreign group id,
+  /// or begin()'s configuration errors.
+  Status beginFromProbe(const Config& config, const DeviceProbe& probe);
+
   /// Record the latest application timestamp for diagnostics.
   ///
   /// The current driver performs synchronous bus operations in public API calls;
@@ -94,6 +224,19 @@ public:
   /// @param nowMs Current timestamp in milliseconds.
   void tick(uint32_t nowMs);
 
+  /// Replace the timing of a running session.
+  ///
+  /// Applies the same validateTiming() rules as begin() and swaps the
+  /// configured and derived timing together, so the next transaction runs
+  /// entirely on the new values. Health counters, cached feature flags, the
+  /// tracked custom pointer, persistent dirty state, and the device itself
+  /// are left alone. No bus traffic; lastOpInfo() is unchanged.
+  /// @param timing New bit timing, timeouts, and flash write delays.
+  /// @return NOT_INITIALIZED before begin(), BUSY when called from inside a
+  /// driver call (e.g. a line or power callback), or begin()'s timing error;
+  /// the old timing stays in effect on any error.
+  Status reconfigureTiming(const TimingConfig& timing);
+
   /// End the driver session and clear runtime/cache state.
   ///
   /// The core driver owns no GPIO or framework resources, so application-owned
@@ -174,6 +317,22 @@ public:
   /// @return Current settings snapshot.
   SettingsSnapshot getSettings() const;
 
+  /// Change counters for the getSettings() sections.
+  ///
+  /// Poll these instead of copying a full snapshot: re-read a section only
+  /// when its counter differs from the one stored with the last copy.
+  /// @return Current counters; access does not touch the E2 bus.
+  const SnapshotGenerations& generations() const { return _generations; }
+
+  /// Copy the health fields only.
+  /// @param out Receives the current health and its generation.
+  /// @return Status::Ok(); snapshot access does not touch the E2 bus.
+  Status getHealth(HealthSnapshot& out) const;
+
+  /// Return the health fields only by value.
+  /// @return Current health snapshot.
+  HealthSnapshot getHealth() const;
+
   // =========================================================================
   // Health Tracking
   // =========================================================================
@@ -221,6 +380,13 @@ public:
   /// @return Stored error status, or Status::Ok() when not dirty.
   Status persistentConfigDirtyError() const { return _persistentConfigDirtyError; }
 
+  /// Cost of the most recent public call that can touch the bus.
+  ///
+  /// State-only accessors do not reset it. Use it to skip, defer, or alarm on
+  /// the next call based on what the previous one actually cost.
+  /// @return Reference valid until the next public call.
+  const OpInfo& lastOpInfo() const { return _opInfo; }
+
   // =========================================================================
   // E2 Protocol Helpers
   // =========================================================================
@@ -262,6 +428,23 @@ public:
   /// @return Status::Ok() when the readback matches.
   Status customWrite(uint8_t address, uint8_t value);
 
+  /// Run a batch of control-byte reads and custom-memory reads/writes.
+  ///
+  /// The batch is validated once up front; if any item is invalid it gets its
+  /// own status, every other item fails with the same code and detail set to
+  /// the first invalid index, and nothing goes on the bus. Writes are barriers
+  /// and run in order through customWrite(); a write failing after part of its
+  /// range was written marks persistent configuration dirty. Between barriers, control reads run first in their
+  /// given order, then custom reads are sorted by address and merged so that
+  /// overlapping, adjacent, or one-byte-apart ranges share one pointer write.
+  /// Read transfers in a segment update health once. The first failing
+  /// transfer stops the batch; items not run get the same error code with
+  /// detail set to the failing item index.
+  /// @param reqs Requests; results and status are written in place.
+  /// @param n Number of requests.
+  /// @return Status of the first failing request in array order, or Ok.
+  Status execute(Request* reqs, size_t n);
+
   /// Write global measurement interval (0xC6/0xC7) and verify
   /// @param intervalDeciSeconds Interval in 0.1 s units
   /// @return Status::Ok() when both interval bytes verify. A failure after the
@@ -512,6 +695,20 @@ public:
   /// @return Status::Ok() when the status byte and PEC verify.
   Status readStatus(uint8_t& status);
 
+  /// Read status byte and, when the CO2 error bit is set and the device
+  /// supports it, the error code (0xC1) in the same call.
+  /// @param[out] report Status byte, error code, and decoded error name.
+  /// @return Status::Ok() when the status byte and any chained error code are read.
+  Status readStatus(StatusReport& report);
+
+  /// Read status byte and MV4, then chain the error code as readStatus(StatusReport&).
+  ///
+  /// The MV4 value is read even when the error bit is set; check
+  /// frame.status.co2Error before using it.
+  /// @param[out] frame Status report and averaged CO2 value.
+  /// @return Status::Ok() when every read succeeds.
+  Status readMeasurement(MeasurementFrame& frame);
+
   /// Check if CO2 error bit is set in a status byte
   /// @param statusByte Value previously read via readStatus()
   /// @return true if bit3 (CO2 error) is set
@@ -530,10 +727,21 @@ public:
   Status readCo2Fast(uint16_t& ppm);
 
   /// Read CO2 averaged value from MV4.
+  ///
+  /// With Config::co2HighByteRefresh set, the high byte may come from the
+  /// previous read instead of the bus (see elidedTransactions()).
   /// @param[out] ppm CO2 concentration in ppm.
-  /// @return Status::Ok() when MV4 low/high reads succeed.
+  /// @return Status::Ok() when the MV4 reads succeed.
   Status readCo2Average(uint16_t& ppm);
 
+  /// MV4 high-byte reads skipped by Config::co2HighByteRefresh since begin().
+  uint32_t elidedTransactions() const { return _mv4Elided; }
+
+  /// High-byte refreshes that found a different high byte than the last
+  /// read although the low byte showed no carry or borrow, i.e. elided
+  /// values since the previous refresh may have been off by 256 ppm or more.
+  uint32_t elisionResyncs() const { return _mv4Resyncs; }
+
   // =========================================================================
   // Bus Safety
   // =========================================================================
@@ -566,6 +774,10 @@ private:
   Status _writeCommandTracked(uint8_t controlByte, uint8_t addressByte, uint8_t dataByte,
                               bool* writeAccepted = nullptr);
   Status _customWriteDirect(uint8_t address, uint8_t value, bool* writeAccepted = nullptr);
+  Status _executeReads(Request* reqs, size_t begin, size_t end, size_t& failed);
+  Status _seekCustomPointer(uint8_t address);
+  bool _customPointerAt(uint8_t address) const;
+  Status _chainErrorCode(StatusReport& report);
 
   // =========================================================================
   // Health Management
@@ -575,7 +787,13 @@ private:
   /// Called ONLY from tracked transport wrappers
   Status _updateHealth(const Status& st);
 
+  /// Scope guard opened by public bus methods; the outermost one resets _opInfo.
+  struct OpScope;
+
+  void _commitWait(uint32_t delayMs);
   void _resetStoppedState();
+  Status _applyConfig(const Config& config);
+  void _finishBegin(const DeviceProbe& probe);
   void _markPersistentConfigDirty(const Status& st);
   void _clearPersistentConfigDirty();
 
@@ -584,6 +802,7 @@ private:
   // =========================================================================
 
   Config _config;
+  DerivedTiming _timing = deriveTiming(TimingConfig()); ///< Bit-engine delays derived in begin()
   bool _initialized = false;
   DriverState _driverState = DriverState::UNINIT;
   uint32_t _nowMs = 0;
@@ -602,6 +821,24 @@ private:
   uint32_t _totalSuccess = 0;
   bool _persistentConfigDirty = false;
   Status _persistentConfigDirtyError = Status::Ok();
+
+  // Custom pointer as last set or auto-incremented (Config::trackCustomPointer)
+  bool _customPtrKnown = false;
+  uint16_t _customPtr = 0;
+
+  // Last MV4 value for high-byte elision (Config::co2HighByteRefresh)
+  bool _mv4Known = false;
+  uint16_t _mv4Last = 0;
+  uint8_t _mv4SinceRefresh = 0;
+  uint32_t _mv4Elided = 0;
+  uint32_t _mv4Resyncs = 0;
+
+  // Per-call cost (see lastOpInfo())
+  OpInfo _opInfo;
+  uint8_t _opDepth = 0;
+
+  // Snapshot change counters (see generations())
+  SnapshotGenerations _generations;
 };
 
 } // namespace EE871
@@ -0,0 +1,210 @@
+/// @file Fleet.h
+/// @brief Structure-of-arrays state for many EE871 sensors and batch kernels over it
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/EE871.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Caller-owned parallel arrays, one entry per sensor row.
+///
+/// All pointers must be non-null and hold at least the row count passed to
+/// FleetStore::begin(). FleetStorage<N> provides a matching static block.
+struct FleetColumns {
+  uint16_t* ppm = nullptr;                ///< Last good MV4 CO2 in ppm.
+  uint32_t* sampleMs = nullptr;           ///< Timestamp of the last good sample.
+  uint8_t* hasSample = nullptr;           ///< 1 once a good sample was stored.
+  uint8_t* statusByte = nullptr;          ///< Status byte of the last successful poll.
+  uint8_t* errorCode = nullptr;           ///< Chained CO2 error code, 0 when none was read.
+  uint8_t* lastResult = nullptr;          ///< Err of the last poll.
+  uint8_t* state = nullptr;               ///< DriverState after the last poll.
+  uint8_t* consecutiveFailures = nullptr; ///< Driver consecutive failures after the last poll.
+  uint32_t* totalFailures = nullptr;      ///< Driver total failures after the last poll.
+};
+
+/// @brief Static backing arrays for a fleet of up to N sensors.
+template <size_t N>
+struct FleetStorage {
+  static_assert(N > 0, "FleetStorage needs at least one row");
+
+  uint16_t ppm[N] = {};
+  uint32_t sampleMs[N] = {};
+  uint8_t hasSample[N] = {};
+  uint8_t statusByte[N] = {};
+  uint8_t errorCode[N] = {};
+  uint8_t lastResult[N] = {};
+  uint8_t state[N] = {};
+  uint8_t consecutiveFailures[N] = {};
+  uint32_t totalFailures[N] = {};
+
+  static constexpr size_t capacity() { return N; }
+
+  FleetColumns columns() {
+    FleetColumns c;
+    c.ppm = ppm;
+    c.sampleMs = sampleMs;
+    c.hasSample = hasSample;
+    c.statusByte = statusByte;
+    c.errorCode = errorCode;
+    c.lastResult = lastResult;
+    c.state = state;
+    c.consecutiveFailures = consecutiveFailures;
+    c.totalFailures = totalFailures;
+    return c;
+  }
+};
+
+/// @brief Latest reading, result, and health of every sensor in a fleet,
+/// stored column-wise so fleet aggregates scan contiguous arrays.
+///
+/// Rows are written by FleetPoller, or directly through the record*()
+/// methods by gateways that receive readings from elsewhere. Not thread-safe.
+class FleetStore {
+public:
+  FleetStore() = default;
+  FleetStore(const FleetStore&) = delete;
+  FleetStore& operator=(const FleetStore&) = delete;
+
+  /// Attach the columns and clear @p rows entries.
+  /// @return INVALID_PARAM for a null column or zero rows.
+  Status begin(const FleetColumns& columns, size_t rows);
+
+  /// Detach the columns.
+  void end();
+
+  /// Reset every row to "no sample, UNINIT".
+  void clear();
+
+  bool isInitialized() const { return _rows != 0; }
+  size_t size() const { return _rows; }
+
+  /// Store a good sample for @p row and mark the poll successful.
+  void recordSample(size_t row, uint32_t nowMs, uint16_t ppm, uint8_t statusByte,
+                    uint8_t errorCode);
+
+  /// Record a successful poll whose status reports a CO2 error. The ppm value
+  /// of such a read is not valid, so the last good sample stays in place.
+  void recordSensorError(size_t row, uint8_t statusByte, uint8_t errorCode);
+
+  /// Record a failed poll; the last good sample stays in place.
+  void recordFailure(size_t row, Err err);
+
+  /// Copy driver health counters into @p row.
+  void recordHealth(size_t row, DriverState state, uint8_t consecutiveFailures,
+                    uint32_t totalFailures);
+
+  const uint16_t* ppm() const { return _c.ppm; }
+  const uint32_t* sampleMs() const { return _c.sampleMs; }
+  const uint8_t* hasSample() const { return _c.hasSample; }
+  const uint8_t* statusByte() const { return _c.statusByte; }
+  const uint8_t* errorCode() const { return _c.errorCode; }
+  const uint8_t* lastResult() const { return _c.lastResult; }
+  const uint8_t* state() const { return _c.state; }
+  const uint8_t* consecutiveFailures() const { return _c.consecutiveFailures; }
+  const uint32_t* totalFailures() const { return _c.totalFailures; }
+
+private:
+  FleetColumns _c;
+  size_t _rows = 0;
+};
+
+/// @brief Polls EE871 instances into a FleetStore, one row per device.
+///
+/// Each poll is one readMeasurement() call; the row receives the sample on
+/// success (only the status and error code while the status reports a CO2
+/// error), the error on failure, and the driver health counters either way.
+/// Not thread-safe; drivers and store must outlive the poller.
+class FleetPoller {
+public:
+  FleetPoller() = default;
+  FleetPoller(const FleetPoller&) = delete;
+  FleetPoller& operator=(const FleetPoller&) = delete;
+
+  /// @param devices Initialized drivers; devices[i] updates store row i.
+  /// @param count Number of devices, at most store.size().
+  /// @param store Initialized store.
+  /// @return INVALID_PARAM for bad arguments, NOT_INITIALIZED for an uninitialized store.
+  Status begin(EE871* const* devices, size_t count, FleetStore& store);
+
+  void end();
+
+  bool isInitialized() const { return _count != 0; }
+
+  /// Poll the device at the cursor and advance it, wrapping after the last one.
+  /// @return Result of that device's readMeasurement().
+  Status pollNext(uint32_t nowMs);
+
+  /// Poll every device once, in order.
+  /// @return Ok, or E2_ERROR with the number of failed devices in detail.
+  Status pollAll(uint32_t nowMs);
+
+  /// Poll one device without moving the cursor, for callers with their own schedule.
+  /// @return Result of that device's readMeasurement(), or INVALID_PARAM for a bad row.
+  Status poll(size_t row, uint32_t nowMs);
+
+  /// Row polled by the next pollNext().
+  size_t cursor() const { return _cursor; }
+
+private:
+  Status _poll(size_t row, uint32_t nowMs);
+
+  EE871* const* _devices = nullptr;
+  FleetStore* _store = nullptr;
+  size_t _count = 0;
+  size_t _cursor = 0;
+};
+
+/// Branch-free batch kernels over FleetStore columns.
+///
+/// Every kernel is a single pass over plain arrays with no early exit, so
+/// compilers vectorize them at -O2/-O3. Masks are one byte per row (0 or 1)
+/// and can be combined with andMask() or passed as the include filter of
+/// ppmStats().
+namespace fleet {
+
+/// @brief Aggregate of the included ppm values.
+struct PpmStats {
+  size_t count = 0;  ///< Included rows.
+  uint16_t min = 0;  ///< 0 when count is 0.
+  uint16_t max = 0;  ///< 0 when count is 0.
+  uint16_t mean = 0; ///< Rounded to the nearest ppm; 0 when count is 0.
+  uint64_t sum = 0;  ///< Sum of the included values.
+};
+
+/// Min/max/mean of @p ppm over rows whose @p include byte is non-zero.
+PpmStats ppmStats(const uint16_t* ppm, const uint8_t* include, size_t rows);
+
+/// out[i] = 1 when ppm[i] >= threshold.
+/// @return Number of rows set.
+size_t thresholdMask(const uint16_t* ppm, size_t rows, uint16_t threshold, uint8_t* out);
+
+/// out[i] = 1 when the row has no sample or its sample is older than maxAgeMs.
+/// Ages use wrapping uint32 arithmetic like the driver's millisecond stamps.
+/// @return Number of stale rows.
+size_t staleMask(const uint32_t* sampleMs, const uint8_t* hasSample, size_t rows,
+                 uint32_t nowMs, uint32_t maxAgeMs, uint8_t* out);
+
+/// out[i] = 1 when state[i] equals @p match.
+/// @return Number of rows set.
+size_t stateMask(const uint8_t* state, size_t rows, DriverState match, uint8_t* out);
+
+/// out[i] = 1 when failures[i] >= minFailures.
+/// @return Number of rows set.
+size_t failureMask(const uint8_t* failures, size_t rows, uint8_t minFailures, uint8_t* out);
+
+/// out[i] = a[i] & b[i]; @p out may alias either input.
+/// @return Number of rows set.
+size_t andMask(const uint8_t* a, const uint8_t* b, size_t rows, uint8_t* out);
+
+/// Fresh rows: has a sample no older than maxAgeMs. Convenience for the
+/// usual ppmStats() include filter.
+/// @return Number of fresh rows.
+size_t freshMask(const FleetStore& store, uint32_t nowMs, uint32_t maxAgeMs, uint8_t* out);
+
+} // namespace fleet
+
+} // namespace EE871
@@ -0,0 +1,63 @@
+/// @file FleetBoot.h
+/// @brief Lockstep bring-up of many EE871 instances across several E2 buses
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/Config.h"
+#include "EE871/EE871.h"
+#include "EE871/MultiBus.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief One sensor to bring up: its driver, the Config for that driver, and
+/// the MultiBusEngine bus that carries the same lines.
+struct FleetMember {
+  EE871* device = nullptr;  ///< Driver to initialize; must not be initialized yet.
+  Config config;            ///< Passed to the driver; deviceAddress selects the sensor.
+  uint8_t bus = 0;          ///< Engine bus number of config's lines.
+};
+
+/// @brief Where the line time of a beginFleet() call went.
+///
+/// All times are line time from the engine's and drivers' own delays, so
+/// they add up to the boot time spent on E2 excluding application overhead.
+struct FleetBootReport {
+  uint16_t members = 0;      ///< Members passed in.
+  uint16_t ready = 0;        ///< Members whose driver is initialized.
+  uint16_t failed = 0;       ///< Members that failed, including skipped ones.
+  uint16_t skipped = 0;      ///< Members failed without traffic because their bus failed first.
+  uint8_t rounds = 0;        ///< Lockstep rounds (the most members on one idle bus).
+  uint32_t identityUs = 0;   ///< Lockstep group-id reads.
+  uint32_t featuresUs = 0;   ///< Lockstep feature-byte reads.
+  uint32_t fallbackUs = 0;   ///< Per-device begin() on buses that were not idle.
+  uint32_t totalUs = 0;      ///< identityUs + featuresUs + fallbackUs.
+  uint32_t serialUs = 0;     ///< Line time the lockstep phases would take one device at a time.
+};
+
+/// Bring up many sensors with the bus traffic of one device per bus.
+///
+/// Members on buses that are idle at entry are probed in lockstep rounds:
+/// round n reads the group id and then the 0x07..0x09 feature bytes of the
+/// n-th member of every such bus at once through @p engine, and each driver is
+/// finished with EE871::beginFromProbe(). Members on a bus that is not idle go
+/// through their own EE871::begin(), which resets the bus first. After a
+/// timeout or stuck bus, the remaining members of that bus fail with the same
+/// error without further traffic, so a dead bus costs its timeouts only once.
+///
+/// The engine and the drivers must drive the same lines (bus n of the engine
+/// is the bus of every member with bus == n) and share the engine's timing.
+/// Like begin(), this is blocking and not thread-safe.
+/// @param engine Initialized lockstep engine covering every member's bus.
+/// @param members Sensors to initialize; order within a bus is probe order.
+/// @param count Number of members.
+/// @param[out] results Per-member begin result, @p count entries.
+/// @param[out] report Boot breakdown.
+/// @return Ok when every member is ready, E2_ERROR with the failed count in
+/// detail otherwise, INVALID_PARAM/NOT_INITIALIZED before any traffic.
+Status beginFleet(MultiBusEngine& engine, const FleetMember* members, size_t count,
+                  Status* results, FleetBootReport& report);
+
+} // namespace EE871
@@ -0,0 +1,215 @@
+/// @file Metrics.h
+/// @brief Registry of named driver and subsystem metrics with binary and text exporters
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/BusQuota.h"
+#include "EE871/CyclicSchedule.h"
+#include "EE871/EE871.h"
+#include "EE871/Status.h"
+
+/// @def EE871_METRICS_TEXT
+/// Build exportMetricsText(). Defaults to 1 on host builds and 0 on
+/// ESP-IDF/Arduino targets, where exportMetricsBinary() is the exporter.
+#ifndef EE871_METRICS_TEXT
+#if defined(ESP_PLATFORM) || defined(ARDUINO)
+#define EE871_METRICS_TEXT 0
+#else
+#define EE871_METRICS_TEXT 1
+#endif
+#endif
+
+namespace EE871 {
+
+/// @brief Maximum finite bucket bounds of one histogram.
+static constexpr uint8_t METRIC_BUCKETS_MAX = 8;
+
+/// @brief Label value meaning "label not set".
+static constexpr uint8_t METRIC_LABEL_NONE = 0xFF;
+
+enum class MetricKind : uint8_t {
+  COUNTER = 0, ///< Monotonic total.
+  GAUGE,       ///< Current value.
+  HISTOGRAM    ///< Bucketed observations with count and sum.
+};
+
+/// @brief Labels of one metric; METRIC_LABEL_NONE leaves a label out.
+struct MetricLabels {
+  uint8_t deviceAddress = METRIC_LABEL_NONE; ///< E2 device address.
+  uint8_t bus = METRIC_LABEL_NONE;           ///< Bus number chosen by the application.
+  uint8_t instance = METRIC_LABEL_NONE;      ///< Sub-index, e.g. a BusQuota client.
+};
+
+/// Reads the current value of a sampled metric.
+/// @param source Object passed at registration.
+/// @param index Index passed at registration.
+using MetricSampleFn = int64_t (*)(const void* source, uint16_t index);
+
+/// @brief One registry slot.
+///
+/// Counters and gauges either own their value (add()/set()) or read it from
+/// a subsystem through @p sample at collection time, so the subsystem keeps
+/// its own counters and pays nothing per operation. Histograms always own
+/// their buckets.
+struct Metric {
+  const char* name = nullptr; ///< OpenMetrics family name; counters get "_total" in text.
+  const char* help = "";      ///< One-line description; text exporter only.
+  MetricKind kind = MetricKind::COUNTER;
+  MetricLabels labels;
+  MetricSampleFn sample = nullptr; ///< Value source; nullptr for owned values.
+  const void* source = nullptr;
+  uint16_t sourceIndex = 0;
+  int64_t value = 0;                        ///< Owned counter/gauge value.
+  const uint32_t* bounds = nullptr;         ///< Ascending upper bounds of a histogram.
+  uint8_t boundCount = 0;                   ///< Finite buckets; one more counts the rest.
+  uint32_t buckets[METRIC_BUCKETS_MAX + 1] = {}; ///< Per-bucket (not cumulative) counts.
+  uint64_t sum = 0;                         ///< Sum of observed values.
+};
+
+/// @brief Static slots for a registry of up to N metrics.
+template <size_t N>
+struct MetricsStorage {
+  static_assert(N > 0, "MetricsStorage needs at least one slot");
+
+  Metric slots[N];
+
+  static constexpr size_t capacity() { return N; }
+};
+
+/// @brief Fixed-capacity list of metrics in caller-owned slots.
+///
+/// Registration appends; nothing is removed short of end(). Ids are slot
+/// indexes in registration order, which is also iteration and export order.
+/// Collection is one pass over the slots calling the sample functions. Not
+/// thread-safe; sampled sources must outlive the registry.
+class MetricsRegistry {
+public:
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  /// @param slots Caller storage, e.g. MetricsStorage<N>::slots.
+  /// @param capacity Number of slots.
+  /// @return INVALID_PARAM for no storage.
+  Status begin(Metric* slots, size_t capacity);
+
+  void end();
+
+  bool isInitialized() const { return _slots != nullptr; }
+
+  /// Register an owned counter or gauge starting at 0.
+  /// @param[out] id Slot for add()/set().
+  /// @return INVALID_PARAM for a bad name or kind, OUT_OF_RANGE when full.
+  Status addValue(MetricKind kind, const char* name, const char* help,
+                  const MetricLabels& labels, uint16_t& id);
+
+  /// Register a counter or gauge read through @p sample at collection time.
+  Status addSampled(MetricKind kind, const char* name, const char* help,
+                    const MetricLabels& labels, MetricSampleFn sample, const void* source,
+                    uint16_t index = 0);
+
+  /// Register a histogram.
+  /// @param bounds Ascending finite upper bounds (inclusive); must outlive the registry.
+  /// @param boundCount 1..METRIC_BUCKETS_MAX.
+  /// @return INVALID_PARAM for a bad name or bounds, OUT_OF_RANGE when full.
+  Status addHistogram(const char* name, const char* help, const MetricLabels& labels,
+                      const uint32_t* bounds, uint8_t boundCount, uint16_t& id);
+
+  /// Add to an owned counter or gauge; ignored for other ids.
+  void add(uint16_t id, int64_t delta = 1);
+  /// Set an owned gauge; ignored for other ids.
+  void set(uint16_t id, int64_t value);
+  /// Record one observation in a histogram; ignored for other ids.
+  void observe(uint16_t id, uint32_t value);
+
+  /// Slots still free, to check before registering a group.
+  size_t remaining() const { return _capacity - _size; }
+
+  size_t size() const { return _size; }
+
+  /// Slot @p i, 0 <= i < size().
+  const Metric& at(size_t i) const { return _slots[i]; }
+
+  /// Current counter/gauge value of slot @p i (sampled or owned), or the
+  /// observation count of a histogram.
+  int64_t value(size_t i) const;
+
+  /// Call fn(const Metric&, int64_t value) for every slot in order.
+  template <typename Fn>
+  void forEach(Fn&& fn) const {
+    for (size_t i = 0; i < _size; ++i) {
+      fn(_slots[i], value(i));
+    }
+  }
+
+private:
+  Status _append(MetricKind kind, const char* name, const char* help, const MetricLabels& labels,
+                 Metric*& slot);
+
+  Metric* _slots = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+};
+
+// ============================================================================
+// Subsystem registration
+// ============================================================================
+
+/// Register the health and traffic metrics of one driver, labelled with its
+/// device address and @p bus: ee871_success, ee871_failures,
+/// ee871_consecutive_failures, ee871_state, ee871_elided_transactions,
+/// ee871_last_op_bus_us. All are sampled from the driver's getters.
+/// @return OUT_OF_RANGE without registering anything when fewer than 6 slots are free.
+Status registerDriverMetrics(MetricsRegistry& registry, const EE871& device, uint8_t bus);
+
+/// Register per-client quota metrics (instance label = client):
+/// ee871_quota_admitted, ee871_quota_deferred, ee871_quota_cache_hits,
+/// ee871_quota_consumed_us, ee871_quota_balance_us. Register after the
+/// clients are added.
+/// @return OUT_OF_RANGE without registering anything when the slots do not fit.
+Status registerQuotaMetrics(MetricsRegistry& registry, const BusQuota& quota, uint8_t bus);
+
+/// Register CyclicExecutor counters: ee871_cyclic_cycles, ee871_cyclic_executed,
+/// ee871_cyclic_failed, ee871_cyclic_skipped, ee871_cyclic_max_lateness_us.
+/// @return OUT_OF_RANGE without registering anything when fewer than 5 slots are free.
+Status registerCyclicMetrics(MetricsRegistry& registry, const CyclicExecutor& executor);
+
+// ============================================================================
+// Exporters
+// ============================================================================
+
+/// @brief Binary metrics frame produced by exportMetricsBinary().
+///
+/// All integers little-endian. Header: 'E', 'M', version, metric count (u16).
+/// Each metric: kind (u8), device, bus, instance labels (u8 each), name
+/// length (u8), name bytes, then for counters and gauges the value (i64), for
+/// histograms the bound count n (u8), n bounds (u32), n + 1 bucket counts
+/// (u32, not cumulative), and the sum (u64). Help text is not included.
+namespace metrics_frame {
+static constexpr uint8_t MAGIC_0 = 'E';
+static constexpr uint8_t MAGIC_1 = 'M';
+static constexpr uint8_t VERSION = 1;
+static constexpr size_t HEADER_BYTES = 5;
+} // namespace metrics_frame
+
+/// Encode every metric into one binary frame.
+/// @param[out] out Destination; may be nullptr with @p capacity 0 to size a frame.
+/// @param[out] written Frame size in bytes, also when it did not fit.
+/// @return OUT_OF_RANGE when the frame is larger than @p capacity,
+/// NOT_INITIALIZED for an unused registry.
+Status exportMetricsBinary(const MetricsRegistry& registry, uint8_t* out, size_t capacity,
+                           size_t& written);
+
+#if EE871_METRICS_TEXT
+/// Render every metric as OpenMetrics text, families grouped by name and
+/// terminated by "# EOF". The output is NUL-terminated when @p capacity > 0.
+/// @param[out] written Text length without the NUL, also when it did not fit.
+/// @return OUT_OF_RANGE when the text and NUL exceed @p capacity,
+/// NOT_INITIALIZED for an unused registry.
+Status exportMetricsText(const MetricsRegistry& registry, char* out, size_t capacity,
+                         size_t& written);
+#endif
+
+} // namespace EE871
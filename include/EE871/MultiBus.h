@@ -0,0 +1,175 @@
+/// @file MultiBus.h
+/// @brief Lockstep bit engine that drives several independent E2 buses together
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/CommandTable.h"
+#include "EE871/Config.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Maximum number of buses one MultiBusEngine can drive (one bit per bus).
+static constexpr uint8_t MULTI_BUS_MAX = 32;
+
+/// @brief Port-wide open-drain set-lines callback signature.
+///
+/// Bit n of @p busMask selects bus n; only selected buses change. Bit n of
+/// @p levels is the new level for bus n: 1 releases the line, 0 drives it low.
+/// The callback should apply all selected buses with one port write where the
+/// hardware allows it, so every bus sees the edge at the same instant.
+/// @param busMask Buses to update.
+/// @param levels Per-bus line levels, 1 = release (HIGH), 0 = drive LOW.
+/// @param user User context pointer passed through from MultiBusConfig.
+using E2PortSetFn = void (*)(uint32_t busMask, uint32_t levels, void* user);
+
+/// @brief Port-wide read-lines callback signature.
+/// @param user User context pointer passed through from MultiBusConfig.
+/// @return Bit n set when the line of bus n is HIGH/released.
+using E2PortReadFn = uint32_t (*)(void* user);
+
+/// @brief Configuration for MultiBusEngine.
+///
+/// Timing fields have the same meaning and limits as the matching Config
+/// fields; one shared delay is applied per phase for all buses. Like the
+/// single-bus driver, the engine owns no GPIO, tasks, or locks.
+struct MultiBusConfig {
+  // === Port Transport (required) ===
+  E2PortSetFn setScl = nullptr;   ///< Set/release clock lines of selected buses
+  E2PortSetFn setSda = nullptr;   ///< Set/release data lines of selected buses
+  E2PortReadFn readScl = nullptr; ///< Read all clock lines
+  E2PortReadFn readSda = nullptr; ///< Read all data lines
+  E2DelayUsFn delayUs = nullptr;  ///< Shared delay for bit timing
+  void* portUser = nullptr;       ///< User context for callbacks
+
+  uint8_t busCount = 0;           ///< Number of buses, 1..MULTI_BUS_MAX; bus n uses mask bit n.
+
+  // === Power Management and Radio Coordination (optional) ===
+  // Same contracts as the Config fields of the same names; one notification
+  // covers a lockstep transaction on all selected buses, and expectedUs is the
+  // deriveTiming() frame time of the timing below.
+  E2BusActivityFn busActivity = nullptr; ///< Transaction start/end notification
+  void* powerUser = nullptr;             ///< User context for busActivity
+  E2QuietWindowFn quietWindow = nullptr; ///< Quiet-window request around each transaction
+  void* radioUser = nullptr;             ///< User context for quietWindow
+
+  // === Timing (E2 spec) ===
+  uint16_t clockLowUs = 100;      ///< Minimum CLK low time, must be >= 100 us.
+  uint16_t clockHighUs = 100;     ///< Minimum CLK high time, must be >= 100 us.
+  uint16_t startHoldUs = 100;     ///< START hold time, must be >= 4 us.
+  uint16_t stopHoldUs = 100;      ///< STOP hold time, must be >= 4 us.
+
+  uint32_t bitTimeoutUs = 25000;  ///< Clock-stretch timeout per bit, must be > 0.
+  uint32_t byteTimeoutUs = 35000; ///< Clock-stretch timeout per byte, must be >= bitTimeoutUs.
+};
+
+/// @brief Runs the same E2 transaction phase on up to MULTI_BUS_MAX buses at once.
+///
+/// Every phase (data setup, SCL rise, sample, SCL fall) is one port-wide write
+/// or read covering all active buses, followed by one shared delay, so a sweep
+/// over N buses costs roughly the bus time of one. Each bus may address a
+/// different device and command. Clock stretching and NACKs are handled per
+/// bus: a bus that times out or NACKs is masked out of the remaining phases,
+/// held with SCL low, and released with a common STOP at the end of the
+/// transaction while the other buses continue.
+///
+/// Transfers are raw: they do not update health counters on any EE871
+/// instance. The engine is not thread-safe and its public methods are blocking
+/// and not ISR-safe. Applications must not run an EE871 instance on a bus while
+/// the engine is driving it.
+class MultiBusEngine {
+public:
+  MultiBusEngine() = default;
+
+  MultiBusEngine(const MultiBusEngine&) = delete;
+  MultiBusEngine& operator=(const MultiBusEngine&) = delete;
+
+  /// Validate and store the port configuration.
+  /// @param config Port callbacks, bus count, and timing.
+  /// @return Status::Ok() on success, INVALID_CONFIG otherwise.
+  Status begin(const MultiBusConfig& config);
+
+  /// Forget the configuration.
+  void end();
+
+  /// Check whether begin() has completed successfully.
+  /// @return true after successful begin() and before end().
+  bool isInitialized() const { return _initialized; }
+
+  /// Active configuration.
+  /// @return Configuration stored by begin(), or defaults before begin().
+  const MultiBusConfig& getConfig() const { return _config; }
+
+  /// Mask with one bit set for every configured bus.
+  /// @return Bits 0..busCount-1 set.
+  uint32_t allBusesMask() const;
+
+  /// Read the port once and report buses whose SCL and SDA are both released.
+  /// @return Idle-bus mask, 0 before begin().
+  uint32_t idleBusesMask();
+
+  /// Line time of all transfers since begin(), summed from the engine's own
+  /// delays (one shared delay per phase, however many buses run). Wraps like
+  /// a uint32 clock; take differences around the calls of interest.
+  uint32_t busUs() const { return _busUs; }
+
+  /// Read one control-byte addressed value on every selected bus.
+  /// @param busMask Buses to run; bits beyond busCount are rejected.
+  /// @param controlBytes Per-bus read control byte, indexed by bus number.
+  /// @param[out] data Per-bus data byte, indexed by bus number.
+  /// @param[out] results Per-bus status, indexed by bus number; unselected entries are untouched.
+  /// @return Status::Ok() when every selected bus succeeded, E2_ERROR with the
+  /// failed-bus mask in detail otherwise, INVALID_PARAM/NOT_INITIALIZED before traffic.
+  Status readControlBytes(uint32_t busMask, const uint8_t* controlBytes,
+                          uint8_t* data, Status* results);
+
+  /// Read the same main command from the given device address on every selected bus.
+  /// @param busMask Buses to run.
+  /// @param mainCommandNibble EE871-supported main-command nibble.
+  /// @param deviceAddresses Per-bus E2 device address, indexed by bus number.
+  /// @param[out] data Per-bus data byte.
+  /// @param[out] results Per-bus status.
+  /// @return As readControlBytes(); NOT_SUPPORTED for EE871-unsupported commands.
+  Status readCommand(uint32_t busMask, uint8_t mainCommandNibble,
+                     const uint8_t* deviceAddresses, uint8_t* data, Status* results);
+
+  /// Read a 16-bit low/high value on every selected bus.
+  ///
+  /// The high byte is only read on buses whose low-byte read succeeded.
+  /// @param busMask Buses to run.
+  /// @param mainCommandLow Low-byte main-command nibble.
+  /// @param mainCommandHigh High-byte main-command nibble.
+  /// @param deviceAddresses Per-bus E2 device address.
+  /// @param[out] values Per-bus little-endian assembled value.
+  /// @param[out] results Per-bus status.
+  /// @return As readControlBytes().
+  Status readU16(uint32_t busMask, uint8_t mainCommandLow, uint8_t mainCommandHigh,
+                 const uint8_t* deviceAddresses, uint16_t* values, Status* results);
+
+  /// Write one control/address/data command on every selected bus.
+  /// @param busMask Buses to run.
+  /// @param controlBytes Per-bus write control byte.
+  /// @param addressBytes Per-bus address byte.
+  /// @param dataBytes Per-bus data byte.
+  /// @param[out] results Per-bus status.
+  /// @param[out] acceptedMask Optional; receives buses that ACKed the PEC byte.
+  /// @return As readControlBytes().
+  Status writeCommands(uint32_t busMask, const uint8_t* controlBytes,
+                       const uint8_t* addressBytes, const uint8_t* dataBytes,
+                       Status* results, uint32_t* acceptedMask = nullptr);
+
+private:
+  struct Lockstep;
+
+  Status _checkCall(uint32_t busMask, const void* a, const void* b, const void* c) const;
+
+  MultiBusConfig _config;
+  uint32_t _readFrameUs = 0;  ///< Nominal read transaction time for quietWindow.
+  uint32_t _writeFrameUs = 0; ///< Nominal write transaction time for quietWindow.
+  uint32_t _busUs = 0;
+  bool _initialized = false;
+};
+
+} // namespace EE871
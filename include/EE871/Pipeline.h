@@ -0,0 +1,404 @@
+/// @file Pipeline.h
+/// @brief Compile-time composed measurement post-processing stages
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "EE871/EE871.h"
+#include "EE871/Fleet.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief One measurement moving through a Pipeline by reference.
+struct PipelineSample {
+  uint32_t timestampMs = 0; ///< When the sample was read.
+  uint16_t source = 0;      ///< Caller tag, e.g. fleet row or bus number.
+  uint16_t ppm = 0;         ///< CO2 in ppm; filter stages rewrite it in place.
+  uint16_t rawPpm = 0;      ///< CO2 as read; stages leave it alone.
+  uint8_t statusByte = 0;   ///< Raw status byte, 0 when not read.
+  bool co2Error = false;    ///< Status bit3 (CO2 error) was set.
+};
+
+/// Sample for a readMeasurement() result.
+inline PipelineSample pipelineSample(const MeasurementFrame& frame, uint32_t nowMs,
+                                     uint16_t source = 0) {
+  PipelineSample s;
+  s.timestampMs = nowMs;
+  s.source = source;
+  s.ppm = frame.co2Average;
+  s.rawPpm = frame.co2Average;
+  s.statusByte = frame.status.status;
+  s.co2Error = frame.status.co2Error;
+  return s;
+}
+
+namespace pipeline_detail {
+
+template <typename Stage, typename = void>
+struct HasBatch : std::false_type {};
+
+template <typename Stage>
+struct HasBatch<Stage, decltype(static_cast<void>(std::declval<Stage&>().processBatch(
+                           static_cast<PipelineSample*>(nullptr), size_t{0})))>
+    : std::true_type {};
+
+/// Run @p stage over a batch, keeping the survivors at the front in order.
+template <typename Stage>
+size_t runBatch(Stage& stage, PipelineSample* samples, size_t count) {
+  if constexpr (HasBatch<Stage>::value) {
+    return stage.processBatch(samples, count);
+  } else {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (stage.process(samples[i])) {
+        if (kept != i) {
+          samples[kept] = samples[i];
+        }
+        ++kept;
+      }
+    }
+    return kept;
+  }
+}
+
+} // namespace pipeline_detail
+
+/// @brief Stages run in order on each sample; the composition is fixed at
+/// compile time, so every call is direct and can be inlined.
+///
+/// A stage is any type with `bool process(PipelineSample&)`, returning false
+/// to drop the sample for the stages after it. A stage may also provide
+/// `size_t processBatch(PipelineSample*, size_t)`, which processes a whole
+/// batch, moves the samples it keeps to the front in order, and returns how
+/// many it kept; stages without it are looped per sample. A StageChain is
+/// itself a stage, so chains nest (e.g. as Fanout branches).
+template <typename... Stages>
+class StageChain;
+
+template <>
+class StageChain<> {
+public:
+  static constexpr size_t kStages = 0;
+  bool process(PipelineSample&) { return true; }
+  size_t processBatch(PipelineSample*, size_t count) { return count; }
+};
+
+template <typename First, typename... Rest>
+class StageChain<First, Rest...> {
+public:
+  static constexpr size_t kStages = 1 + sizeof...(Rest);
+
+  StageChain() = default;
+  /// Construct the stages from their values in order.
+  explicit StageChain(First first, Rest... rest)
+      : _first(std::move(first)), _rest(std::move(rest)...) {}
+
+  bool process(PipelineSample& s) { return _first.process(s) && _rest.process(s); }
+
+  size_t processBatch(PipelineSample* samples, size_t count) {
+    count = pipeline_detail::runBatch(_first, samples, count);
+    return (count == 0) ? 0 : _rest.processBatch(samples, count);
+  }
+
+  /// Stage @p I of the chain, for configuration and results.
+  template <size_t I>
+  auto& stage() {
+    static_assert(I < kStages, "Stage index out of range");
+    if constexpr (I == 0) {
+      return _first;
+    } else {
+      return _rest.template stage<I - 1>();
+    }
+  }
+
+  template <size_t I>
+  const auto& stage() const {
+    static_assert(I < kStages, "Stage index out of range");
+    if constexpr (I == 0) {
+      return _first;
+    } else {
+      return _rest.template stage<I - 1>();
+    }
+  }
+
+private:
+  First _first;
+  StageChain<Rest...> _rest;
+};
+
+/// @brief Counters of a Pipeline.
+struct PipelineStats {
+  uint32_t pushed = 0;    ///< Samples pushed.
+  uint32_t delivered = 0; ///< Samples that passed every stage.
+};
+
+/// @brief Entry point of a stage chain: push samples or batches of samples
+/// and every consumer sees each one in the same pass.
+///
+/// Samples travel by reference; batches are processed stage by stage in the
+/// caller's array. Nothing is allocated and nothing is virtual. Not
+/// thread-safe; stages that keep pointers (callbacks, buffers) require those
+/// to outlive the pipeline.
+template <typename... Stages>
+class Pipeline {
+public:
+  static constexpr size_t kStages = sizeof...(Stages);
+
+  Pipeline() = default;
+  /// Construct the stages from their values in order.
+  explicit Pipeline(Stages... stages) : _chain(std::move(stages)...) {}
+
+  /// Run one sample through the stages.
+  /// @return true when it passed every stage.
+  bool push(PipelineSample& sample) {
+    ++_stats.pushed;
+    const bool delivered = _chain.process(sample);
+    _stats.delivered += delivered ? 1U : 0U;
+    return delivered;
+  }
+
+  /// Run @p count samples through the stages, one stage at a time.
+  /// @return Samples that passed every stage; they are now at the front of
+  /// @p samples in their original order.
+  size_t pushBatch(PipelineSample* samples, size_t count) {
+    if (samples == nullptr) {
+      return 0;
+    }
+    _stats.pushed += static_cast<uint32_t>(count);
+    const size_t delivered = _chain.processBatch(samples, count);
+    _stats.delivered += static_cast<uint32_t>(delivered);
+    return delivered;
+  }
+
+  template <size_t I>
+  auto& stage() {
+    return _chain.template stage<I>();
+  }
+
+  template <size_t I>
+  const auto& stage() const {
+    return _chain.template stage<I>();
+  }
+
+  const PipelineStats& stats() const { return _stats; }
+
+private:
+  StageChain<Stages...> _chain;
+  PipelineStats _stats;
+};
+
+/// Read one measurement and push it through @p pipeline.
+/// @param source Tag stored in the sample.
+/// @param[out] delivered Optional; set when the sample passed every stage.
+/// @return The readMeasurement() result; nothing is pushed when it fails.
+template <typename... Stages>
+Status readIntoPipeline(EE871& device, uint32_t nowMs, uint16_t source,
+                        Pipeline<Stages...>& pipeline, bool* delivered = nullptr) {
+  if (delivered != nullptr) {
+    *delivered = false;
+  }
+  MeasurementFrame frame;
+  const Status st = device.readMeasurement(frame);
+  if (!st.ok()) {
+    return st;
+  }
+  PipelineSample sample = pipelineSample(frame, nowMs, source);
+  const bool passed = pipeline.push(sample);
+  if (delivered != nullptr) {
+    *delivered = passed;
+  }
+  return st;
+}
+
+// ============================================================================
+// Stages
+// ============================================================================
+
+/// @brief Gives every branch the same sample and always passes it on.
+///
+/// Branches run in order on the one sample; a branch that drops it only ends
+/// that branch. A branch that rewrites ppm changes it for the branches after
+/// it, which can still read rawPpm.
+template <typename... Branches>
+class Fanout {
+public:
+  Fanout() = default;
+  explicit Fanout(Branches... branches) : _branches(std::move(branches)...) {}
+
+  bool process(PipelineSample& s) {
+    _each(s, std::index_sequence_for<Branches...>());
+    return true;
+  }
+
+  template <size_t I>
+  auto& branch() {
+    return _branches.template stage<I>();
+  }
+
+private:
+  template <size_t... I>
+  void _each(PipelineSample& s, std::index_sequence<I...>) {
+    (static_cast<void>(_branches.template stage<I>().process(s)), ...);
+  }
+
+  StageChain<Branches...> _branches;
+};
+
+/// @brief Drops samples whose status byte reports a CO2 error.
+class DropCo2Errors {
+public:
+  bool process(PipelineSample& s) {
+    _dropped += s.co2Error ? 1U : 0U;
+    return !s.co2Error;
+  }
+
+  uint32_t dropped() const { return _dropped; }
+
+private:
+  uint32_t _dropped = 0;
+};
+
+/// @brief Exponential moving average of ppm with alpha = 1 / 2^shift.
+///
+/// Fixed point with shift fractional bits; the first sample seeds the
+/// average. One filter state for all samples, so feed it one source.
+class EmaFilter {
+public:
+  /// @param shift Smoothing, 0 (off) .. 8.
+  explicit EmaFilter(uint8_t shift = 2) : _shift((shift > 8) ? 8 : shift) {}
+
+  bool process(PipelineSample& s);
+  size_t processBatch(PipelineSample* samples, size_t count);
+
+  void reset() { _seeded = false; }
+
+private:
+  uint32_t _acc = 0;
+  uint8_t _shift;
+  bool _seeded = false;
+};
+
+/// @brief Running min/max/mean of ppm over everything it saw since reset().
+class PpmStatsStage {
+public:
+  bool process(PipelineSample& s);
+  size_t processBatch(PipelineSample* samples, size_t count);
+
+  /// Aggregate so far, with the mean rounded like fleet::ppmStats().
+  fleet::PpmStats stats() const;
+  void reset() { *this = PpmStatsStage(); }
+
+private:
+  uint64_t _sum = 0;
+  size_t _count = 0;
+  uint16_t _min = 0xFFFF;
+  uint16_t _max = 0;
+};
+
+/// Threshold crossing reported by ThresholdEvents.
+enum class PpmEvent : uint8_t {
+  ABOVE = 0, ///< ppm reached the high threshold.
+  BELOW,     ///< ppm fell to the low threshold after ABOVE.
+};
+
+/// Callback type for ThresholdEvents.
+/// @param event Crossing direction.
+/// @param sample Sample that crossed.
+/// @param user User context pointer.
+using PpmEventFn = void (*)(PpmEvent event, const PipelineSample& sample, void* user);
+
+/// @brief Reports ppm threshold crossings with hysteresis.
+///
+/// ABOVE fires when ppm >= high, BELOW when ppm <= low after an ABOVE; a
+/// value between the two keeps the current side. Samples always pass.
+class ThresholdEvents {
+public:
+  ThresholdEvents() = default;
+  /// @param low Release threshold; must not exceed @p high.
+  /// @param high Trigger threshold.
+  ThresholdEvents(uint16_t low, uint16_t high, PpmEventFn callback, void* user)
+      : _low(low), _high(high), _callback(callback), _user(user) {}
+
+  bool process(PipelineSample& s);
+
+  bool above() const { return _above; }
+  uint32_t events() const { return _events; }
+
+private:
+  uint16_t _low = 0;
+  uint16_t _high = 0xFFFF;
+  PpmEventFn _callback = nullptr;
+  void* _user = nullptr;
+  bool _above = false;
+  uint32_t _events = 0;
+};
+
+/// @brief Appends fixed-size little-endian records to a caller buffer.
+///
+/// Record layout (RECORD_BYTES): timestampMs u32, source u16, ppm u16,
+/// status byte, flags (bit0 CO2 error). When the buffer is full, records are
+/// counted as overflow and samples still pass.
+class RecordEncoder {
+public:
+  static constexpr size_t RECORD_BYTES = 10;
+
+  RecordEncoder() = default;
+  /// @param buffer Output bytes; must outlive the encoder.
+  /// @param capacity Buffer size in bytes.
+  RecordEncoder(uint8_t* buffer, size_t capacity) : _buffer(buffer), _capacity(capacity) {}
+
+  bool process(PipelineSample& s);
+
+  /// Bytes written since construction or clear().
+  size_t size() const { return _size; }
+  uint32_t overflow() const { return _overflow; }
+  void clear() {
+    _size = 0;
+    _overflow = 0;
+  }
+
+private:
+  uint8_t* _buffer = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  uint32_t _overflow = 0;
+};
+
+/// @brief Keeps the last N samples, oldest overwritten first.
+template <size_t N>
+class SampleLog {
+public:
+  static_assert(N > 0, "SampleLog needs at least one entry");
+
+  bool process(PipelineSample& s) {
+    _entries[_head] = s;
+    _head = (_head + 1U == N) ? 0 : _head + 1U;
+    _count += (_count < N) ? 1U : 0U;
+    return true;
+  }
+
+  size_t size() const { return _count; }
+
+  /// Entry @p i, 0 being the oldest kept; @p i must be below size().
+  const PipelineSample& at(size_t i) const {
+    const size_t oldest = (_count < N) ? 0 : _head;
+    const size_t index = oldest + i;
+    return _entries[(index >= N) ? index - N : index];
+  }
+
+  void clear() {
+    _head = 0;
+    _count = 0;
+  }
+
+private:
+  PipelineSample _entries[N];
+  size_t _head = 0;
+  size_t _count = 0;
+};
+
+} // namespace EE871
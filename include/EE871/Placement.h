@@ -0,0 +1,21 @@
+/// @file Placement.h
+/// @brief Optional IRAM/DRAM placement of the timing-critical E2 bit engine
+#pragma once
+
+/// @def EE871_IRAM_ATTR
+/// Marks bit-engine functions that run between START and STOP. With
+/// EE871_IRAM_BIT_ENGINE defined on an ESP-IDF or Arduino-ESP32 build they are
+/// placed in IRAM, so flash cache misses cannot stall a transaction; the
+/// ESP-IDF component sets it from CONFIG_EE871_IRAM_BIT_ENGINE. Everywhere else
+/// the macro is empty.
+///
+/// @def EE871_DRAM_ATTR
+/// Same switch for constant data read during a transaction.
+#if defined(EE871_IRAM_BIT_ENGINE) && defined(ESP_PLATFORM)
+#include "esp_attr.h"
+#define EE871_IRAM_ATTR IRAM_ATTR
+#define EE871_DRAM_ATTR DRAM_ATTR
+#else
+#define EE871_IRAM_ATTR
+#define EE871_DRAM_ATTR
+#endif
@@ -0,0 +1,109 @@
+/// @file SyncMeasurement.h
+/// @brief Time-aligned measurement triggering across several EE871 sensors
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/EE871.h"
+#include "EE871/MultiBus.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Maximum number of members in one SyncMeasurementGroup.
+static constexpr uint8_t SYNC_GROUP_MAX = MULTI_BUS_MAX;
+
+/// @brief Per-member result of a synchronized trigger/collect cycle.
+struct SyncSample {
+  Status status;                ///< Trigger error, or collect result once collected.
+  uint8_t statusByte = 0;       ///< Status byte read by trigger().
+  uint16_t co2Average = 0;      ///< MV4 CO2 in ppm, valid when collected and status is Ok.
+  uint32_t triggerOffsetUs = 0; ///< Bus time from the group trigger start to this member's status read.
+  bool collected = false;       ///< MV4 was read by collect().
+};
+
+/// @brief Triggers a group of sensors as close together as possible, then
+/// reads their measurements after a common conversion window.
+///
+/// In low-power mode an EE871 starts a measurement when its status byte is
+/// read. trigger() issues the status reads back to back: either through the
+/// members' EE871 instances (one or more devices per bus, each read costs one
+/// read frame of bus time) or, across buses, through a MultiBusEngine so all
+/// status reads happen in the same lockstep transaction. collect() returns
+/// IN_PROGRESS without bus traffic until conversionMs have passed since
+/// trigger(), then reads MV4 from every member whose trigger succeeded.
+///
+/// Driver-mode transfers are tracked by each EE871 instance; engine-mode
+/// transfers are raw like all MultiBusEngine transfers. Not thread-safe; the
+/// group, drivers, engine, and sample array must outlive the session.
+class SyncMeasurementGroup {
+public:
+  SyncMeasurementGroup() = default;
+  SyncMeasurementGroup(const SyncMeasurementGroup&) = delete;
+  SyncMeasurementGroup& operator=(const SyncMeasurementGroup&) = delete;
+
+  /// Use initialized EE871 instances as members; trigger order is array order.
+  /// @param devices Member drivers; each must be initialized.
+  /// @param count Number of members, 1..SYNC_GROUP_MAX.
+  /// @param samples Caller-owned results, at least @p count entries.
+  /// @param conversionMs Time from trigger until MV4 holds the new measurement.
+  /// @return INVALID_PARAM for bad arguments, NOT_INITIALIZED for an uninitialized member.
+  Status begin(EE871* const* devices, size_t count, SyncSample* samples, uint32_t conversionMs);
+
+  /// Use one device per bus on a MultiBusEngine; samples are indexed by bus number.
+  /// @param engine Initialized lockstep engine.
+  /// @param busMask Member buses; must be non-zero and within the engine's buses.
+  /// @param deviceAddresses Per-bus E2 device address, indexed by bus number.
+  /// @param samples Caller-owned results, indexed by bus number.
+  /// @param conversionMs Time from trigger until MV4 holds the new measurement.
+  /// @return INVALID_PARAM for bad arguments, NOT_INITIALIZED for an uninitialized engine.
+  Status begin(MultiBusEngine& engine, uint32_t busMask, const uint8_t* deviceAddresses,
+               SyncSample* samples, uint32_t conversionMs);
+
+  /// Forget the members.
+  void end();
+
+  /// Read every member's status byte as tightly as the transport allows.
+  /// @param nowMs Application timestamp of the trigger.
+  /// @return Ok when every member triggered; E2_ERROR with the failed-member
+  /// mask in detail otherwise. Failed members are skipped by collect().
+  Status trigger(uint32_t nowMs);
+
+  /// Read MV4 from triggered members once the conversion window has passed.
+  /// @param nowMs Current application timestamp.
+  /// @return IN_PROGRESS before the window ends, Ok when every triggered
+  /// member was read, E2_ERROR with the failed-member mask otherwise, or
+  /// INVALID_PARAM when no trigger is pending.
+  Status collect(uint32_t nowMs);
+
+  bool isInitialized() const { return _count != 0; }
+  /// Check whether a trigger is waiting for collect().
+  bool pending() const { return _pending; }
+  /// Timestamp from which collect() reads the measurements.
+  uint32_t readyAtMs() const { return _triggerMs + _conversionMs; }
+  /// Bus time between the first and the last successful member trigger.
+  uint32_t triggerSpreadUs() const { return _spreadUs; }
+  /// Members whose last trigger succeeded (bit n = member or bus n).
+  uint32_t triggeredMask() const { return _triggeredMask; }
+
+private:
+  Status _triggerDevices();
+  Status _triggerEngine();
+  Status _collectDevices();
+  Status _collectEngine();
+
+  EE871* const* _devices = nullptr;
+  MultiBusEngine* _engine = nullptr;
+  const uint8_t* _addresses = nullptr;
+  SyncSample* _samples = nullptr;
+  uint32_t _memberMask = 0;
+  uint8_t _count = 0;
+  uint32_t _conversionMs = 0;
+  uint32_t _triggerMs = 0;
+  uint32_t _triggeredMask = 0;
+  uint32_t _spreadUs = 0;
+  bool _pending = false;
+};
+
+} // namespace EE871
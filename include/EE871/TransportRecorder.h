@@ -0,0 +1,162 @@
+/// @file TransportRecorder.h
+/// @brief Record E2 line callbacks on hardware and replay them deterministically
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/Config.h"
+#include "EE871/Status.h"
+
+namespace EE871 {
+
+/// @brief Compact byte encoding shared by TransportRecorder and TransportReplayer.
+///
+/// A recording is a plain byte stream without header:
+/// - 0x00-0x07: line event. Bits 2..1 select setScl (0), setSda (1),
+///   readScl (2) or readSda (3); bit 0 is the level written or read.
+/// - 0x40-0x7F: delay of (byte & 0x3F) microseconds.
+/// - 0x08, v: delay of v microseconds, v as LEB128.
+/// - 0x09, n, v: n (>= 2) consecutive delays of v microseconds, both LEB128.
+namespace rec {
+static constexpr uint8_t LINE_SET_SCL = 0x00;
+static constexpr uint8_t LINE_SET_SDA = 0x02;
+static constexpr uint8_t LINE_READ_SCL = 0x04;
+static constexpr uint8_t LINE_READ_SDA = 0x06;
+static constexpr uint8_t LINE_MAX = 0x07;
+static constexpr uint8_t DELAY = 0x08;
+static constexpr uint8_t DELAY_REPEAT = 0x09;
+static constexpr uint8_t DELAY_SHORT = 0x40;
+static constexpr uint8_t DELAY_SHORT_MAX_US = 0x3F;
+} // namespace rec
+
+/// @brief Wraps the line callbacks of a Config and logs every call.
+///
+/// Every set/read callback result and every delay is appended to a caller
+/// buffer; consecutive equal delays (e.g. flash write waits) are run-length
+/// coded. No heap is used. When the buffer is full, recording stops at a record
+/// boundary and overflowed() is set; the transport keeps working.
+///
+/// Byte-level frame hooks are not recorded: config() clears them so the driver
+/// uses the line engine while recording. It also clears Config::waitMs so
+/// flash-commit waits are recorded as delays; busActivity is kept. Not
+/// thread-safe; the recorder must outlive the EE871 session that uses config().
+class TransportRecorder {
+public:
+  TransportRecorder() = default;
+  TransportRecorder(const TransportRecorder&) = delete;
+  TransportRecorder& operator=(const TransportRecorder&) = delete;
+
+  /// Start recording the callbacks of @p inner into @p buffer.
+  /// @param inner Real transport configuration; its callbacks are forwarded.
+  /// @param buffer Destination, owned by the caller.
+  /// @param capacity Size of @p buffer in bytes.
+  /// @return INVALID_CONFIG for missing callbacks, INVALID_PARAM for no buffer.
+  Status begin(const Config& inner, uint8_t* buffer, size_t capacity);
+
+  /// Stop recording; data() stays valid until the buffer is reused.
+  void end();
+
+  /// Configuration to pass to EE871::begin(); callbacks route through the recorder.
+  /// @return Copy of the inner Config with recorder callbacks, no frame hooks, no waitMs.
+  Config config() const;
+
+  /// Write any pending delay run. Call before reading data()/size().
+  void flush();
+
+  /// Drop the recorded bytes and start again at the beginning of the buffer.
+  void clear();
+
+  const uint8_t* data() const { return _buffer; }
+  size_t size() const { return _size; }
+  bool overflowed() const { return _overflowed; }
+  /// Callbacks seen while recording, including pending and dropped ones.
+  uint32_t events() const { return _events; }
+
+private:
+  static void _setSclThunk(bool level, void* user);
+  static void _setSdaThunk(bool level, void* user);
+  static bool _readSclThunk(void* user);
+  static bool _readSdaThunk(void* user);
+  static void _delayUsThunk(uint32_t us, void* user);
+
+  void _line(uint8_t op, bool level);
+  void _delay(uint32_t us);
+  void _append(const uint8_t* bytes, size_t len);
+
+  Config _inner;
+  uint8_t* _buffer = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  bool _overflowed = false;
+  bool _recording = false;
+  uint32_t _events = 0;
+  uint32_t _pendingUs = 0;
+  uint32_t _pendingCount = 0;
+};
+
+/// @brief Feeds a TransportRecorder stream back to the driver without hardware.
+///
+/// Read callbacks return the recorded results; set and delay callbacks are
+/// checked against the recording and only advance virtual time. A call that
+/// does not match the next record counts as a divergence: a wrong kind is not
+/// consumed (reads then return HIGH), a wrong level or delay is consumed.
+/// After the stream ends, reads return HIGH and exhausted() is set.
+///
+/// For a faithful replay, pass the same timing and device settings that were
+/// used while recording. Not thread-safe.
+class TransportReplayer {
+public:
+  TransportReplayer() = default;
+  TransportReplayer(const TransportReplayer&) = delete;
+  TransportReplayer& operator=(const TransportReplayer&) = delete;
+
+  /// Start replaying @p recording.
+  /// @param base Settings (timing, address, thresholds) for the replayed session.
+  /// @param recording Bytes produced by TransportRecorder.
+  /// @param size Number of recorded bytes.
+  /// @return INVALID_PARAM for a null recording with non-zero size.
+  Status begin(const Config& base, const uint8_t* recording, size_t size);
+
+  /// Configuration to pass to EE871::begin().
+  /// @return Copy of the base Config with replay callbacks and no frame, power, or radio hooks.
+  Config config() const;
+
+  /// Check whether every record has been consumed.
+  bool finished() const { return _pos >= _size && _repeatLeft == 0; }
+  bool exhausted() const { return _exhausted; }
+  size_t position() const { return _pos; }
+  uint32_t divergences() const { return _divergences; }
+  /// Byte offset of the first divergent record, or SIZE_MAX when none.
+  size_t firstDivergenceOffset() const { return _firstDivergence; }
+  /// Sum of replayed delays in microseconds.
+  uint64_t replayedUs() const { return _replayedUs; }
+  /// Records rejected as malformed (stream then ends).
+  bool malformed() const { return _malformed; }
+
+private:
+  static void _setSclThunk(bool level, void* user);
+  static void _setSdaThunk(bool level, void* user);
+  static bool _readSclThunk(void* user);
+  static bool _readSdaThunk(void* user);
+  static void _delayUsThunk(uint32_t us, void* user);
+
+  bool _line(uint8_t op, bool level);
+  void _delay(uint32_t us);
+  bool _readVarint(size_t& pos, uint32_t& value) const;
+  void _diverge(size_t offset);
+
+  Config _base;
+  const uint8_t* _data = nullptr;
+  size_t _size = 0;
+  size_t _pos = 0;
+  uint32_t _repeatLeft = 0;
+  uint32_t _repeatUs = 0;
+  uint32_t _divergences = 0;
+  size_t _firstDivergence = SIZE_MAX;
+  uint64_t _replayedUs = 0;
+  bool _exhausted = false;
+  bool _malformed = false;
+};
+
+} // namespace EE871
@@ -0,0 +1,39 @@
+/// @file ActivityScope.h
+/// @brief Internal RAII notification of one E2 transaction to the activity hooks
+#pragma once
+
+#include <cstdint>
+
+namespace EE871 {
+
+/// Reports one transaction or reset sequence to the quietWindow and
+/// busActivity hooks of @p Cfg (Config or MultiBusConfig); the quiet window
+/// encloses the activity window.
+template <typename Cfg>
+class ActivityScope {
+public:
+  ActivityScope(const Cfg& cfg, uint32_t expectedUs) : _cfg(cfg), _expectedUs(expectedUs) {
+    if (_cfg.quietWindow != nullptr) {
+      _cfg.quietWindow(true, _expectedUs, _cfg.radioUser);
+    }
+    if (_cfg.busActivity != nullptr) {
+      _cfg.busActivity(true, _cfg.powerUser);
+    }
+  }
+  ~ActivityScope() {
+    if (_cfg.busActivity != nullptr) {
+      _cfg.busActivity(false, _cfg.powerUser);
+    }
+    if (_cfg.quietWindow != nullptr) {
+      _cfg.quietWindow(false, _expectedUs, _cfg.radioUser);
+    }
+  }
+  ActivityScope(const ActivityScope&) = delete;
+  ActivityScope& operator=(const ActivityScope&) = delete;
+
+private:
+  const Cfg& _cfg;
+  uint32_t _expectedUs;
+};
+
+} // namespace EE871
@@ -0,0 +1,170 @@
+/// @file BusQuota.cpp
+/// @brief Implementation of the per-client bus-time quota gate
+
+#include "EE871/BusQuota.h"
+
+#include "EE871/ConfigBuilder.h"
+
+namespace EE871 {
+
+Status BusQuota::begin(EE871& device, uint32_t nowMs) {
+  end();
+  if (!device.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
+  }
+  _device = &device;
+  for (Client& c : _clients) {
+    c.refillMs = nowMs;
+  }
+  return Status::Ok();
+}
+
+void BusQuota::end() {
+  _device = nullptr;
+  for (Client& c : _clients) {
+    c = Client();
+  }
+  _clientCount = 0;
+  _cache = MeasurementFrame();
+  _cacheMs = 0;
+  _cacheValid = false;
+}
+
+Status BusQuota::addClient(const QuotaPolicy& policy, uint8_t& client) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Bus quota not initialized");
+  }
+  if (_clientCount >= QUOTA_CLIENTS_MAX) {
+    return Status::Error(Err::OUT_OF_RANGE, "Too many quota clients", QUOTA_CLIENTS_MAX);
+  }
+  if (policy.rateUsPerSecond != 0 && policy.burstUs == 0) {
+    return Status::Error(Err::INVALID_PARAM, "Quota burst must be non-zero");
+  }
+  Client& c = _clients[_clientCount];
+  const uint32_t refillMs = c.refillMs;
+  c = Client();
+  c.policy = policy;
+  c.stats.balanceUs = policy.burstUs;
+  c.refillMs = refillMs;
+  client = _clientCount++;
+  return Status::Ok();
+}
+
+void BusQuota::_refill(Client& c, uint32_t nowMs) {
+  const uint32_t elapsedMs = nowMs - c.refillMs;
+  c.refillMs = nowMs;
+  const int64_t burst = c.policy.burstUs;
+  if (c.stats.balanceUs >= burst) {
+    c.creditRemainder = 0;
+    return;
+  }
+  // rate * ms / 1000 with the remainder carried, so frequent refills lose nothing.
+  const uint64_t credit =
+      static_cast<uint64_t>(elapsedMs) * c.policy.rateUsPerSecond + c.creditRemainder;
+  const uint64_t room = static_cast<uint64_t>(burst - c.stats.balanceUs);
+  const uint64_t whole = credit / 1000U;
+  if (whole >= room) {
+    c.stats.balanceUs = burst;
+    c.creditRemainder = 0;
+    return;
+  }
+  c.stats.balanceUs += static_cast<int64_t>(whole);
+  c.creditRemainder = static_cast<uint32_t>(credit % 1000U);
+}
+
+Status BusQuota::admit(uint8_t client, uint32_t estimateUs, uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Bus quota not initialized");
+  }
+  if (client >= _clientCount) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid quota client", client);
+  }
+  Client& c = _clients[client];
+  if (c.policy.rateUsPerSecond == 0) {
+    ++c.stats.admitted;
+    return Status::Ok();
+  }
+  _refill(c, nowMs);
+  const int64_t need = (estimateUs < c.policy.burstUs) ? estimateUs : c.policy.burstUs;
+  if (c.stats.balanceUs >= need) {
+    ++c.stats.admitted;
+    return Status::Ok();
+  }
+  ++c.stats.deferred;
+  const uint64_t missingUs = static_cast<uint64_t>(need - c.stats.balanceUs);
+  const uint64_t waitMs =
+      (missingUs * 1000U + c.policy.rateUsPerSecond - 1U) / c.policy.rateUsPerSecond;
+  return Status::Error(Err::BUSY, "Bus quota exhausted",
+                       static_cast<int32_t>((waitMs > 0x7FFFFFFF) ? 0x7FFFFFFF : waitMs));
+}
+
+void BusQuota::charge(uint8_t client, uint32_t busUs) {
+  if (client >= _clientCount) {
+    return;
+  }
+  Client& c = _clients[client];
+  c.stats.consumedUs += busUs;
+  if (c.policy.rateUsPerSecond != 0) {
+    c.stats.balanceUs -= busUs;
+  }
+}
+
+void BusQuota::_chargeLastOp(uint8_t client, uint32_t estimateUs) {
+  const OpInfo& info = _device->lastOpInfo();
+  if (info.busUs == 0 && info.transactions != 0) {
+    // Transports that do not report line time would otherwise never deplete.
+    charge(client, estimateUs);
+    return;
+  }
+  charge(client, info.busUs);
+}
+
+Status BusQuota::readMeasurement(uint8_t client, uint32_t nowMs, MeasurementFrame& frame,
+                                 bool* fromCache) {
+  if (fromCache != nullptr) {
+    *fromCache = false;
+  }
+  const Status admitted = admit(client, measurementEstimateUs(), nowMs);
+  if (admitted.code == Err::BUSY) {
+    Client& c = _clients[client];
+    if (_cacheValid && c.policy.maxCacheAgeMs != 0 &&
+        static_cast<uint32_t>(nowMs - _cacheMs) <= c.policy.maxCacheAgeMs) {
+      // Served after all: undo the deferral counted by admit().
+      --c.stats.deferred;
+      ++c.stats.cacheHits;
+      frame = _cache;
+      if (fromCache != nullptr) {
+        *fromCache = true;
+      }
+      return Status::Ok();
+    }
+    return admitted;
+  }
+  if (!admitted.ok()) {
+    return admitted;
+  }
+
+  const Status st = _device->readMeasurement(frame);
+  _chargeLastOp(client, measurementEstimateUs());
+  if (st.ok()) {
+    _cache = frame;
+    _cacheMs = nowMs;
+    _cacheValid = true;
+  }
+  return st;
+}
+
+uint32_t BusQuota::measurementEstimateUs() const {
+  if (!isInitialized()) {
+    return 0;
+  }
+  return measurementCostUs(deriveTiming(timingOf(_device->getConfig())),
+                           _device->hasErrorCode());
+}
+
+const QuotaStats& BusQuota::stats(uint8_t client) const {
+  static const QuotaStats kNone;
+  return (client < _clientCount) ? _clients[client].stats : kNone;
+}
+
+} // namespace EE871
@@ -0,0 +1,110 @@
+/// @file CyclicSchedule.cpp
+/// @brief Implementation of the cyclic schedule executor
+
+#include "EE871/CyclicSchedule.h"
+
+namespace EE871 {
+
+Status CyclicExecutor::begin(const CyclicSchedule& schedule, FleetPoller& poller,
+                             uint32_t startMs) {
+  end();
+  if (!scheduleFits(schedule)) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid cyclic schedule");
+  }
+  if (!poller.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Fleet poller not initialized");
+  }
+  _schedule = schedule;
+  _poller = &poller;
+  _cycleStartMs = startMs;
+  return Status::Ok();
+}
+
+void CyclicExecutor::end() {
+  _schedule = CyclicSchedule();
+  _poller = nullptr;
+  _cycleStartMs = 0;
+  _next = 0;
+  _stats = CyclicStats();
+}
+
+Status CyclicExecutor::tick(uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Cyclic executor not initialized");
+  }
+  const int32_t sinceStart = static_cast<int32_t>(nowMs - _cycleStartMs);
+  if (sinceStart < 0) {
+    return Status::Ok();
+  }
+  const uint64_t majorUs = _schedule.majorCycleUs;
+  const uint32_t majorMs = _schedule.majorCycleUs / 1000U;
+  uint64_t relUs = static_cast<uint64_t>(sinceStart) * 1000ULL;
+
+  // More than a whole cycle behind: everything before the previous cycle is
+  // past its frame, so drop it in one step instead of slot by slot.
+  const uint64_t behind = relUs / majorUs;
+  if (behind >= 2) {
+    const uint64_t drop = behind - 1U;
+    _stats.skipped += static_cast<uint32_t>((_schedule.slotCount - _next) +
+                                            (drop - 1U) * _schedule.slotCount);
+    _stats.cycles += static_cast<uint32_t>(drop);
+    _cycleStartMs += static_cast<uint32_t>(drop * majorMs);
+    relUs -= drop * majorUs;
+    _next = 0;
+  }
+
+  int32_t failed = 0;
+  while (true) {
+    if (_next == _schedule.slotCount) {
+      if (relUs < majorUs) {
+        break;
+      }
+      _next = 0;
+      _cycleStartMs += majorMs;
+      relUs -= majorUs;
+      ++_stats.cycles;
+    }
+    const CyclicSlot& slot = _schedule.slots[_next];
+    if (slot.releaseUs > relUs) {
+      break;
+    }
+    ++_next;
+    const uint64_t frameEndUs =
+        (static_cast<uint64_t>(slot.releaseUs / _schedule.minorFrameUs) + 1U) *
+        _schedule.minorFrameUs;
+    if (relUs >= frameEndUs) {
+      ++_stats.skipped;
+      continue;
+    }
+    const uint32_t lateness = static_cast<uint32_t>(relUs - slot.releaseUs);
+    if (lateness > _stats.maxLatenessUs) {
+      _stats.maxLatenessUs = lateness;
+    }
+    ++_stats.executed;
+    if (!_poller->poll(slot.row, nowMs).ok()) {
+      ++_stats.failed;
+      ++failed;
+    }
+  }
+
+  if (failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Cyclic poll failed", failed);
+  }
+  return Status::Ok();
+}
+
+uint32_t CyclicExecutor::nextReleaseMs() const {
+  if (!isInitialized()) {
+    return 0;
+  }
+  uint32_t base = _cycleStartMs;
+  uint32_t releaseUs = _schedule.slots[0].releaseUs;
+  if (_next == _schedule.slotCount) {
+    base += _schedule.majorCycleUs / 1000U;
+  } else {
+    releaseUs = _schedule.slots[_next].releaseUs;
+  }
+  return base + (releaseUs + 999U) / 1000U;
+}
+
+} // namespace EE871
@@ -2,31 +2,38 @@
 /// @brief Implementation of the EE871 E2 driver
 
 #include "EE871/EE871.h"
+#include "EE871/Placement.h"
+
+#include "ActivityScope.h"
 
 #include <limits>
 
 namespace EE871 {
 namespace {
 
-static constexpr uint32_t kPollStepUs = 5;
+static constexpr uint32_t kPollStepUs = cmd::POLL_STEP_US;
+
+// Custom-read ranges at most this many bytes apart are read through in one
+// run: a 3-byte read frame is cheaper than a 4-byte pointer write frame.
+static constexpr uint16_t kCustomGapBridge = 1;
 
-inline void setScl(const Config& cfg, bool level) {
+inline EE871_IRAM_ATTR void setScl(const Config& cfg, bool level) {
   cfg.setScl(level, cfg.busUser);
 }
 
-inline void setSda(const Config& cfg, bool level) {
+inline EE871_IRAM_ATTR void setSda(const Config& cfg, bool level) {
   cfg.setSda(level, cfg.busUser);
 }
 
-inline bool readScl(const Config& cfg) {
+inline EE871_IRAM_ATTR bool readScl(const Config& cfg) {
   return cfg.readScl(cfg.busUser);
 }
 
-inline bool readSda(const Config& cfg) {
+inline EE871_IRAM_ATTR bool readSda(const Config& cfg) {
   return cfg.readSda(cfg.busUser);
 }
 
-inline void delayUs(const Config& cfg, uint32_t us, uint32_t* elapsedUs) {
+inline EE871_IRAM_ATTR void delayUs(const Config& cfg, uint32_t us, uint32_t* elapsedUs) {
   cfg.delayUs(us, cfg.busUser);
   if (elapsedUs != nullptr) {
     const uint32_t room = std::numeric_limits<uint32_t>::max() - *elapsedUs;
@@ -34,106 +41,141 @@ inline void delayUs(const Config& cfg, uint32_t us, uint32_t* elapsedUs) {
   }
 }
 
-static Status waitSclHigh(const Config& cfg, uint32_t* elapsedUs) {
+/// Line-engine context for one bus operation: the callbacks, the timing
+/// derived in begin(), and the bus-time accounting reported through OpInfo.
+struct Link {
+  Link(const Config& cfgIn, const DerivedTiming& timingIn) : cfg(cfgIn), t(timingIn) {}
+
+  const Config& cfg;
+  const DerivedTiming& t;
+  uint32_t busUs = 0;      ///< All delays spent on the lines.
+  uint32_t stretchUs = 0;  ///< Part of busUs spent polling SCL held low.
+  uint16_t bytes = 0;      ///< Bytes fully clocked in either direction.
+};
+
+inline EE871_IRAM_ATTR void setScl(Link& link, bool level) {
+  setScl(link.cfg, level);
+}
+
+inline EE871_IRAM_ATTR void setSda(Link& link, bool level) {
+  setSda(link.cfg, level);
+}
+
+inline EE871_IRAM_ATTR bool readScl(Link& link) {
+  return readScl(link.cfg);
+}
+
+inline EE871_IRAM_ATTR bool readSda(Link& link) {
+  return readSda(link.cfg);
+}
+
+inline EE871_IRAM_ATTR void delayUs(Link& link, uint32_t us, uint32_t* elapsedUs) {
+  delayUs(link.cfg, us, elapsedUs);
+  const uint32_t room = std::numeric_limits<uint32_t>::max() - link.busUs;
+  link.busUs = (us > room) ? std::numeric_limits<uint32_t>::max() : (link.busUs + us);
+}
+
+static EE871_IRAM_ATTR Status waitSclHigh(Link& link, uint32_t* elapsedUs) {
   uint32_t waitedUs = 0;
-  while (!readScl(cfg)) {
-    if (waitedUs >= cfg.bitTimeoutUs) {
+  while (!readScl(link)) {
+    if (waitedUs >= link.t.bitTimeoutUs) {
       return Status::Error(Err::TIMEOUT, "Clock stretch timeout", static_cast<int32_t>(waitedUs));
     }
     if (elapsedUs != nullptr) {
       const uint32_t remaining =
-          (*elapsedUs < cfg.byteTimeoutUs) ? (cfg.byteTimeoutUs - *elapsedUs) : 0U;
+          (*elapsedUs < link.t.byteTimeoutUs) ? (link.t.byteTimeoutUs - *elapsedUs) : 0U;
       if (remaining < kPollStepUs) {
         return Status::Error(Err::TIMEOUT, "Byte timeout", static_cast<int32_t>(*elapsedUs));
       }
     }
-    delayUs(cfg, kPollStepUs, elapsedUs);
+    delayUs(link, kPollStepUs, elapsedUs);
+    link.stretchUs += kPollStepUs;
     waitedUs += kPollStepUs;
   }
   return Status::Ok();
 }
 
 // Data setup time before SCL rises (minimum per E2 spec)
-static constexpr uint32_t kDataSetupUs = 10;
+static constexpr uint32_t kDataSetupUs = cmd::DATA_SETUP_US;
 
-static Status e2Start(const Config& cfg) {
-  setSda(cfg, true);
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, nullptr);
+static EE871_IRAM_ATTR Status e2Start(Link& link) {
+  setSda(link, true);
+  setScl(link, true);
+  Status st = waitSclHigh(link, nullptr);
   if (!st.ok()) {
     return st;
   }
-  delayUs(cfg, cfg.startHoldUs, nullptr);
-  setSda(cfg, false);
-  delayUs(cfg, cfg.startHoldUs, nullptr);
-  setScl(cfg, false);
-  delayUs(cfg, cfg.clockLowUs, nullptr);
+  delayUs(link, link.t.startHoldUs, nullptr);
+  setSda(link, false);
+  delayUs(link, link.t.startHoldUs, nullptr);
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, nullptr);
   return Status::Ok();
 }
 
-static Status e2Stop(const Config& cfg) {
+static EE871_IRAM_ATTR Status e2Stop(Link& link) {
   // SCL is already low with proper low time from last bit
-  setSda(cfg, false);  // Ensure SDA low before releasing SCL
-  delayUs(cfg, kDataSetupUs, nullptr);
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, nullptr);
+  setSda(link, false);  // Ensure SDA low before releasing SCL
+  delayUs(link, kDataSetupUs, nullptr);
+  setScl(link, true);
+  Status st = waitSclHigh(link, nullptr);
   if (!st.ok()) {
     return st;
   }
-  delayUs(cfg, cfg.stopHoldUs, nullptr);
-  setSda(cfg, true);
-  delayUs(cfg, cfg.stopHoldUs, nullptr);
+  delayUs(link, link.t.stopHoldUs, nullptr);
+  setSda(link, true);
+  delayUs(link, link.t.stopHoldUs, nullptr);
   return Status::Ok();
 }
 
-static Status writeBit(const Config& cfg, bool bit, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status writeBit(Link& link, bool bit, uint32_t* elapsedUs) {
   // SCL is already low from previous bit or START
-  setSda(cfg, bit);
-  delayUs(cfg, kDataSetupUs, elapsedUs);  // Data setup time
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, elapsedUs);
+  setSda(link, bit);
+  delayUs(link, kDataSetupUs, elapsedUs);  // Data setup time
+  setScl(link, true);
+  Status st = waitSclHigh(link, elapsedUs);
   if (!st.ok()) {
     return st;
   }
-  delayUs(cfg, cfg.clockHighUs, elapsedUs);
-  setScl(cfg, false);
-  delayUs(cfg, cfg.clockLowUs, elapsedUs);  // Clock low time AFTER pulling low
+  delayUs(link, link.t.clockHighUs, elapsedUs);
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, elapsedUs);  // Clock low time AFTER pulling low
   return Status::Ok();
 }
 
-static Status readBit(const Config& cfg, bool& bit, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status readBit(Link& link, bool& bit, uint32_t* elapsedUs) {
   // SCL is already low from previous bit
-  setSda(cfg, true);  // Release SDA for slave to drive
-  delayUs(cfg, kDataSetupUs, elapsedUs);  // Setup time
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, elapsedUs);
+  setSda(link, true);  // Release SDA for slave to drive
+  delayUs(link, kDataSetupUs, elapsedUs);  // Setup time
+  setScl(link, true);
+  Status st = waitSclHigh(link, elapsedUs);
   if (!st.ok()) {
     return st;
   }
-  const uint32_t sampleDelay = cfg.clockHighUs / 2;
-  delayUs(cfg, sampleDelay, elapsedUs);
-  bit = readSda(cfg);
-  delayUs(cfg, cfg.clockHighUs - sampleDelay, elapsedUs);
-  setScl(cfg, false);
-  delayUs(cfg, cfg.clockLowUs, elapsedUs);  // Clock low time AFTER pulling low
+  delayUs(link, link.t.sampleUs, elapsedUs);
+  bit = readSda(link);
+  delayUs(link, link.t.sampleRestUs, elapsedUs);
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, elapsedUs);  // Clock low time AFTER pulling low
   return Status::Ok();
 }
 
-static Status writeByte(const Config& cfg, uint8_t value, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status writeByte(Link& link, uint8_t value, uint32_t* elapsedUs) {
   for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
-    Status st = writeBit(cfg, (value & mask) != 0, elapsedUs);
+    Status st = writeBit(link, (value & mask) != 0, elapsedUs);
     if (!st.ok()) {
       return st;
     }
   }
+  ++link.bytes;
   return Status::Ok();
 }
 
-static Status readByte(const Config& cfg, uint8_t& value, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status readByte(Link& link, uint8_t& value, uint32_t* elapsedUs) {
   value = 0;
   for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
     bool bit = false;
-    Status st = readBit(cfg, bit, elapsedUs);
+    Status st = readBit(link, bit, elapsedUs);
     if (!st.ok()) {
       return st;
     }
@@ -141,40 +183,40 @@ static Status readByte(const Config& cfg, uint8_t& value, uint32_t* elapsedUs) {
       value |= mask;
     }
   }
+  ++link.bytes;
   return Status::Ok();
 }
 
-static Status readAck(const Config& cfg, bool& acked, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status readAck(Link& link, bool& acked, uint32_t* elapsedUs) {
   // SCL is already low from last data bit
-  setSda(cfg, true);  // Release SDA for slave to drive ACK
-  delayUs(cfg, kDataSetupUs, elapsedUs);
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, elapsedUs);
+  setSda(link, true);  // Release SDA for slave to drive ACK
+  delayUs(link, kDataSetupUs, elapsedUs);
+  setScl(link, true);
+  Status st = waitSclHigh(link, elapsedUs);
   if (!st.ok()) {
     return st;
   }
-  const uint32_t sampleDelay = cfg.clockHighUs / 2;
-  delayUs(cfg, sampleDelay, elapsedUs);
-  acked = !readSda(cfg);  // ACK = SDA low
-  delayUs(cfg, cfg.clockHighUs - sampleDelay, elapsedUs);
-  setScl(cfg, false);
-  delayUs(cfg, cfg.clockLowUs, elapsedUs);  // Low time for next phase
+  delayUs(link, link.t.sampleUs, elapsedUs);
+  acked = !readSda(link);  // ACK = SDA low
+  delayUs(link, link.t.sampleRestUs, elapsedUs);
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, elapsedUs);  // Low time for next phase
   return Status::Ok();
 }
 
-static Status sendAck(const Config& cfg, bool ack, uint32_t* elapsedUs) {
+static EE871_IRAM_ATTR Status sendAck(Link& link, bool ack, uint32_t* elapsedUs) {
   // SCL is already low from last data bit
-  setSda(cfg, !ack);  // ACK = SDA low, NACK = SDA high
-  delayUs(cfg, kDataSetupUs, elapsedUs);
-  setScl(cfg, true);
-  Status st = waitSclHigh(cfg, elapsedUs);
+  setSda(link, !ack);  // ACK = SDA low, NACK = SDA high
+  delayUs(link, kDataSetupUs, elapsedUs);
+  setScl(link, true);
+  Status st = waitSclHigh(link, elapsedUs);
   if (!st.ok()) {
     return st;
   }
-  delayUs(cfg, cfg.clockHighUs, elapsedUs);
-  setScl(cfg, false);
-  delayUs(cfg, cfg.clockLowUs, elapsedUs);  // Low time for next phase
-  setSda(cfg, true);  // Release SDA
+  delayUs(link, link.t.clockHighUs, elapsedUs);
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, elapsedUs);  // Low time for next phase
+  setSda(link, true);  // Release SDA
   return Status::Ok();
 }
 
@@ -186,20 +228,259 @@ static uint8_t calcPecWrite(uint8_t controlByte, uint8_t addressByte, uint8_t da
   return static_cast<uint8_t>((controlByte + addressByte + dataByte) & 0xFF);
 }
 
+// Clock out reset pulses with SDA high, then STOP; shared by busReset().
+static EE871_IRAM_ATTR Status busResetLines(Link& link) {
+  // Clock out 9+ pulses with SDA high to reset slave state machine
+  setSda(link, true);
+  for (uint8_t i = 0; i < cmd::BUS_RESET_CLOCKS; ++i) {
+    setScl(link, false);
+    delayUs(link, link.t.clockLowUs, nullptr);
+    setScl(link, true);
+    // Wait for clock to rise (slave might stretch)
+    uint32_t waited = 0;
+    while (!readScl(link) && waited < link.t.bitTimeoutUs) {
+      delayUs(link, kPollStepUs, nullptr);
+      link.stretchUs += kPollStepUs;
+      waited += kPollStepUs;
+    }
+    if (waited >= link.t.bitTimeoutUs) {
+      return Status::Error(Err::BUS_STUCK, "SCL stuck during reset");
+    }
+    delayUs(link, link.t.clockHighUs, nullptr);
+  }
+
+  // Generate STOP condition
+  setScl(link, false);
+  delayUs(link, link.t.clockLowUs, nullptr);
+  setSda(link, false);
+  delayUs(link, kDataSetupUs, nullptr);
+  setScl(link, true);
+  delayUs(link, link.t.stopHoldUs, nullptr);
+  setSda(link, true);
+  delayUs(link, link.t.stopHoldUs, nullptr);
+
+  // Verify bus is now idle
+  if (!readScl(link) || !readSda(link)) {
+    return Status::Error(Err::BUS_STUCK, "Bus stuck after reset");
+  }
+
+  return Status::Ok();
+}
+
+static void addLinkCost(OpInfo& info, const Link& link) {
+  const uint32_t busRoom = std::numeric_limits<uint32_t>::max() - info.busUs;
+  info.busUs = (link.busUs > busRoom) ? std::numeric_limits<uint32_t>::max()
+                                      : (info.busUs + link.busUs);
+  const uint32_t stretchRoom = std::numeric_limits<uint32_t>::max() - info.stretchUs;
+  info.stretchUs = (link.stretchUs > stretchRoom) ? std::numeric_limits<uint32_t>::max()
+                                                  : (info.stretchUs + link.stretchUs);
+  info.bytesTransferred = static_cast<uint16_t>(info.bytesTransferred + link.bytes);
+}
+
 static void sleepMs(const Config& cfg, uint32_t delayMs) {
+  if (cfg.waitMs != nullptr) {
+    cfg.waitMs(delayMs, cfg.powerUser);
+    return;
+  }
   for (uint32_t i = 0; i < delayMs; ++i) {
     cfg.delayUs(1000, cfg.busUser);
   }
 }
 
+// One complete read transaction bit-banged on the line callbacks.
+static EE871_IRAM_ATTR Status readFrameLines(Link& link, uint8_t controlByte, uint8_t& data,
+                                             uint8_t& pec) {
+  Status st = e2Start(link);
+  if (!st.ok()) {
+    return st;
+  }
+
+  uint32_t elapsedUs = 0;
+  st = writeByte(link, controlByte, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+
+  bool acked = false;
+  st = readAck(link, acked, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  if (!acked) {
+    e2Stop(link);
+    return Status::Error(Err::NACK, "Control byte NACK");
+  }
+
+  elapsedUs = 0;
+  st = readByte(link, data, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  st = sendAck(link, true, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+
+  elapsedUs = 0;
+  st = readByte(link, pec, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  st = sendAck(link, false, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+
+  return e2Stop(link);
+}
+
+// One complete write transaction bit-banged on the line callbacks.
+static EE871_IRAM_ATTR Status writeFrameLines(Link& link, uint8_t controlByte,
+                                              uint8_t addressByte, uint8_t dataByte,
+                                              uint8_t pec, bool& accepted) {
+  accepted = false;
+
+  Status st = e2Start(link);
+  if (!st.ok()) {
+    return st;
+  }
+
+  uint32_t elapsedUs = 0;
+  st = writeByte(link, controlByte, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  bool acked = false;
+  st = readAck(link, acked, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  if (!acked) {
+    e2Stop(link);
+    return Status::Error(Err::NACK, "Control byte NACK");
+  }
+
+  elapsedUs = 0;
+  st = writeByte(link, addressByte, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  st = readAck(link, acked, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  if (!acked) {
+    e2Stop(link);
+    return Status::Error(Err::NACK, "Address byte NACK");
+  }
+
+  elapsedUs = 0;
+  st = writeByte(link, dataByte, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  st = readAck(link, acked, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  if (!acked) {
+    e2Stop(link);
+    return Status::Error(Err::NACK, "Data byte NACK");
+  }
+
+  elapsedUs = 0;
+  st = writeByte(link, pec, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  st = readAck(link, acked, &elapsedUs);
+  if (!st.ok()) {
+    e2Stop(link);
+    return st;
+  }
+  if (!acked) {
+    e2Stop(link);
+    return Status::Error(Err::NACK, "PEC NACK");
+  }
+
+  accepted = true;
+  return e2Stop(link);
+}
+
+static Status validateRequest(const Request& req) {
+  switch (req.kind) {
+    case RequestKind::CONTROL_READ:
+      if (req.out == nullptr || req.command > 0x0F) {
+        return Status::Error(Err::INVALID_PARAM, "Invalid request");
+      }
+      if (req.command == cmd::MAIN_CUSTOM_PTR) {
+        return Status::Error(Err::INVALID_PARAM, "Use CUSTOM_READ for custom memory");
+      }
+      if (!cmd::isReadMainCommandSupported(req.command)) {
+        return Status::Error(Err::NOT_SUPPORTED, "Unsupported EE871 main command",
+                             req.command);
+      }
+      break;
+    case RequestKind::CUSTOM_READ:
+    case RequestKind::CUSTOM_WRITE: {
+      const bool read = (req.kind == RequestKind::CUSTOM_READ);
+      if ((read ? static_cast<const void*>(req.out) : static_cast<const void*>(req.in)) ==
+              nullptr ||
+          req.len == 0) {
+        return Status::Error(Err::INVALID_PARAM, "Invalid buffer");
+      }
+      const size_t maxLen = static_cast<size_t>(cmd::CUSTOM_MEMORY_SIZE) -
+                            static_cast<size_t>(req.command);
+      if (req.len > maxLen) {
+        return Status::Error(Err::OUT_OF_RANGE, "Request exceeds custom memory map");
+      }
+      break;
+    }
+    default:
+      return Status::Error(Err::INVALID_PARAM, "Invalid request kind");
+  }
+  return Status::Error(Err::IN_PROGRESS, "Pending");
+}
+
+static bool pendingCustomRead(const Request& req) {
+  return req.kind == RequestKind::CUSTOM_READ && req.status.inProgress();
+}
+
 } // namespace
 
-Status EE871::begin(const Config& config) {
-  // Prevent double-init without explicit end()
-  if (_initialized) {
-    return Status::Error(Err::ALREADY_INITIALIZED, "Call end() first");
+struct EE871::OpScope {
+  explicit OpScope(EE871& devIn) : dev(devIn) {
+    if (dev._opDepth++ == 0) {
+      dev._opInfo = OpInfo();
+    }
   }
+  ~OpScope() { --dev._opDepth; }
+
+  OpScope(const OpScope&) = delete;
+  OpScope& operator=(const OpScope&) = delete;
 
+  EE871& dev;
+};
+
+void EE871::_commitWait(uint32_t delayMs) {
+  sleepMs(_config, delayMs);
+  _opInfo.commitWaitUs += delayMs * 1000U;
+}
+
+Status EE871::_applyConfig(const Config& config) {
   _resetStoppedState();
 
   if (config.setScl == nullptr || config.setSda == nullptr ||
@@ -207,26 +488,20 @@ Status EE871::begin(const Config& config) {
       config.delayUs == nullptr) {
     return Status::Error(Err::INVALID_CONFIG, "Missing E2 callbacks");
   }
+  if ((config.readFrame == nullptr) != (config.writeFrame == nullptr)) {
+    return Status::Error(Err::INVALID_CONFIG, "Frame hooks must be set together");
+  }
   if (config.deviceAddress > cmd::DEVICE_ADDRESS_MAX) {
     return Status::Error(Err::INVALID_CONFIG, "Invalid device address");
   }
-  if (config.clockLowUs < 100 || config.clockHighUs < 100) {
-    return Status::Error(Err::INVALID_CONFIG, "Clock timing below spec");
-  }
-  if (config.startHoldUs < 4 || config.stopHoldUs < 4) {
-    return Status::Error(Err::INVALID_CONFIG, "Start/stop hold below spec");
+  if (config.co2HighByteRefresh > 1 &&
+      (config.co2ElisionMaxStep == 0 || config.co2ElisionMaxStep > 127)) {
+    return Status::Error(Err::INVALID_CONFIG, "Invalid CO2 elision step");
   }
-  if (config.bitTimeoutUs == 0 || config.byteTimeoutUs == 0) {
-    return Status::Error(Err::INVALID_CONFIG, "Timeouts must be non-zero");
-  }
-  if (config.byteTimeoutUs < config.bitTimeoutUs) {
-    return Status::Error(Err::INVALID_CONFIG, "byteTimeoutUs must be >= bitTimeoutUs");
-  }
-  if (config.writeDelayMs > cmd::WRITE_DELAY_MAX_MS) {
-    return Status::Error(Err::INVALID_CONFIG, "writeDelayMs exceeds safe limit");
-  }
-  if (config.intervalWriteDelayMs > cmd::INTERVAL_WRITE_DELAY_MAX_MS) {
-    return Status::Error(Err::INVALID_CONFIG, "intervalWriteDelayMs exceeds safe limit");
+  const TimingConfig timing = timingOf(config);
+  const Status timingSt = validateTiming(timing);
+  if (!timingSt.ok()) {
+    return timingSt;
   }
 
   Config normalized = config;
@@ -234,37 +509,45 @@ Status EE871::begin(const Config& config) {
     normalized.offlineThreshold = 1;
   }
   _config = normalized;
+  _timing = deriveTiming(timing);
+  ++_generations.config;
+  return Status::Ok();
+}
+
+void EE871::_finishBegin(const DeviceProbe& probe) {
+  // Without a complete feature read every guard stays closed, also when the
+  // read failed part way and left some bytes set.
+  _operatingFunctions = probe.featuresValid ? probe.operatingFunctions : 0;
+  _operatingModeSupport = probe.featuresValid ? probe.operatingModeSupport : 0;
+  _specialFeatures = probe.featuresValid ? probe.specialFeatures : 0;
+  ++_generations.features;
 
-  // Check bus is idle before probing
+  _initialized = true;
+  _driverState = DriverState::READY;
+  ++_generations.health;
+}
+
+Status EE871::begin(const Config& config) {
+  OpScope op(*this);
+  // Prevent double-init without explicit end()
+  if (_initialized) {
+    return Status::Error(Err::ALREADY_INITIALIZED, "Call end() first");
+  }
+  const Status configSt = _applyConfig(config);
+  if (!configSt.ok()) {
+    return configSt;
+  }
+
+  // Check bus is idle before probing; a reset that hits a held SCL gives up
+  // on the first stuck clock instead of waiting out every pulse.
   if (!readScl(_config) || !readSda(_config)) {
-    // Attempt bus reset - clock out pulses with SDA high
-    setSda(_config, true);
-    for (uint8_t i = 0; i < cmd::BUS_RESET_CLOCKS; ++i) {
-      setScl(_config, false);
-      delayUs(_config, _config.clockLowUs, nullptr);
-      setScl(_config, true);
-      // Wait for SCL to actually rise (handle clock stretching)
-      uint32_t waited = 0;
-      while (!readScl(_config) && waited < _config.bitTimeoutUs) {
-        delayUs(_config, kPollStepUs, nullptr);
-        waited += kPollStepUs;
-      }
-      delayUs(_config, _config.clockHighUs, nullptr);
-    }
-    // Generate STOP condition to leave bus in known state
-    setScl(_config, false);
-    delayUs(_config, _config.clockLowUs, nullptr);
-    setSda(_config, false);
-    delayUs(_config, kDataSetupUs, nullptr);
-    setScl(_config, true);
-    delayUs(_config, _config.stopHoldUs, nullptr);
-    setSda(_config, true);
-    delayUs(_config, _config.stopHoldUs, nullptr);
-    // Check again
-    if (!readScl(_config) || !readSda(_config)) {
-      Status err = Status::Error(Err::BUS_STUCK, "Bus stuck after reset");
+    ActivityScope<Config> activity(_config, _timing.resetUs);
+    Link link(_config, _timing);
+    const Status resetSt = busResetLines(link);
+    addLinkCost(_opInfo, link);
+    if (!resetSt.ok()) {
       _resetStoppedState();
-      return err;
+      return resetSt;
     }
   }
 
@@ -293,9 +576,8 @@ Status EE871::begin(const Config& config) {
 
   // Cache feature flags for guards
   // Use raw reads since we're not fully initialized yet
-  _operatingFunctions = 0;
-  _operatingModeSupport = 0;
-  _specialFeatures = 0;
+  DeviceProbe probe;
+  probe.groupId = group;
 
   // Set pointer to 0x07
   const uint8_t ptrControl = cmd::makeControlWrite(cmd::MAIN_CUSTOM_PTR, _config.deviceAddress);
@@ -303,19 +585,37 @@ Status EE871::begin(const Config& config) {
   if (st.ok()) {
     const uint8_t readControl = cmd::makeControlRead(cmd::MAIN_CUSTOM_PTR, _config.deviceAddress);
     // Read 0x07, 0x08, 0x09 in sequence (auto-increment)
-    st = _readControlByteRaw(readControl, _operatingFunctions);
+    st = _readControlByteRaw(readControl, probe.operatingFunctions);
     if (st.ok()) {
-      st = _readControlByteRaw(readControl, _operatingModeSupport);
+      st = _readControlByteRaw(readControl, probe.operatingModeSupport);
     }
     if (st.ok()) {
-      st = _readControlByteRaw(readControl, _specialFeatures);
+      st = _readControlByteRaw(readControl, probe.specialFeatures);
     }
   }
   // If feature read fails, continue with defaults (all features disabled)
   // This is non-fatal - the device still works, just with guards active
+  probe.featuresValid = st.ok();
+  _finishBegin(probe);
+  return Status::Ok();
+}
 
-  _initialized = true;
-  _driverState = DriverState::READY;
+Status EE871::beginFromProbe(const Config& config, const DeviceProbe& probe) {
+  OpScope op(*this);
+  if (_initialized) {
+    return Status::Error(Err::ALREADY_INITIALIZED, "Call end() first");
+  }
+  const Status configSt = _applyConfig(config);
+  if (!configSt.ok()) {
+    return configSt;
+  }
+  if (probe.groupId != cmd::SENSOR_GROUP_ID) {
+    const Status err =
+        Status::Error(Err::DEVICE_NOT_FOUND, "Unexpected group id", probe.groupId);
+    _resetStoppedState();
+    return err;
+  }
+  _finishBegin(probe);
   return Status::Ok();
 }
 
@@ -327,6 +627,24 @@ void EE871::end() {
   _resetStoppedState();
 }
 
+Status EE871::reconfigureTiming(const TimingConfig& timing) {
+  if (!_initialized) {
+    return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
+  }
+  // A transaction in progress holds references to the active timing.
+  if (_opDepth != 0) {
+    return Status::Error(Err::BUSY, "Driver call in progress");
+  }
+  const Status st = validateTiming(timing);
+  if (!st.ok()) {
+    return st;
+  }
+  applyTiming(_config, timing);
+  _timing = deriveTiming(timing);
+  ++_generations.config;
+  return Status::Ok();
+}
+
 Status EE871::getSettings(SettingsSnapshot& out) const {
   out.config = _config;
   out.state = _driverState;
@@ -343,6 +661,7 @@ Status EE871::getSettings(SettingsSnapshot& out) const {
   out.totalSuccess = _totalSuccess;
   out.persistentConfigDirty = _persistentConfigDirty;
   out.persistentConfigDirtyError = _persistentConfigDirtyError;
+  out.generations = _generations;
   return Status::Ok();
 }
 
@@ -352,6 +671,25 @@ SettingsSnapshot EE871::getSettings() const {
   return out;
 }
 
+Status EE871::getHealth(HealthSnapshot& out) const {
+  out.state = _driverState;
+  out.initialized = _initialized;
+  out.lastOkMs = _lastOkMs;
+  out.lastErrorMs = _lastErrorMs;
+  out.lastError = _lastError;
+  out.consecutiveFailures = _consecutiveFailures;
+  out.totalFailures = _totalFailures;
+  out.totalSuccess = _totalSuccess;
+  out.generation = _generations.health;
+  return Status::Ok();
+}
+
+HealthSnapshot EE871::getHealth() const {
+  HealthSnapshot out;
+  (void)getHealth(out);
+  return out;
+}
+
 void EE871::_resetStoppedState() {
   _config = Config{};
   _initialized = false;
@@ -366,21 +704,35 @@ void EE871::_resetStoppedState() {
   _consecutiveFailures = 0;
   _totalFailures = 0;
   _totalSuccess = 0;
+  _customPtrKnown = false;
+  _mv4Known = false;
+  _mv4SinceRefresh = 0;
+  _mv4Elided = 0;
+  _mv4Resyncs = 0;
+  _timing = deriveTiming(TimingConfig());
+  ++_generations.health;
+  ++_generations.features;
+  ++_generations.config;
 }
 
 void EE871::_markPersistentConfigDirty(const Status& st) {
   if (!_persistentConfigDirty) {
     _persistentConfigDirty = true;
     _persistentConfigDirtyError = st;
+    ++_generations.persistentDirty;
   }
 }
 
 void EE871::_clearPersistentConfigDirty() {
+  if (_persistentConfigDirty) {
+    ++_generations.persistentDirty;
+  }
   _persistentConfigDirty = false;
   _persistentConfigDirtyError = Status::Ok();
 }
 
 Status EE871::probe() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -407,6 +759,7 @@ Status EE871::probe() {
 }
 
 Status EE871::recover() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -425,6 +778,7 @@ Status EE871::recover() {
 }
 
 Status EE871::resyncPersistentConfig() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -464,6 +818,7 @@ Status EE871::resyncPersistentConfig() {
 }
 
 Status EE871::readControlByte(uint8_t mainCommandNibble, uint8_t& data) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -479,6 +834,7 @@ Status EE871::readControlByte(uint8_t mainCommandNibble, uint8_t& data) {
 }
 
 Status EE871::readU16(uint8_t mainCommandLow, uint8_t mainCommandHigh, uint16_t& value) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -505,6 +861,7 @@ Status EE871::readU16(uint8_t mainCommandLow, uint8_t mainCommandHigh, uint16_t&
 }
 
 Status EE871::setCustomPointer(uint16_t address) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -518,11 +875,25 @@ Status EE871::setCustomPointer(uint16_t address) {
   return _writeCommandTracked(control, addrHigh, addrLow);
 }
 
+bool EE871::_customPointerAt(uint8_t address) const {
+  return _config.trackCustomPointer && _customPtrKnown && _customPtr == address;
+}
+
+Status EE871::_seekCustomPointer(uint8_t address) {
+  if (_customPointerAt(address)) {
+    _opInfo.cacheHit = true;
+    return Status::Ok();
+  }
+  return setCustomPointer(address);
+}
+
 Status EE871::customRead(uint8_t address, uint8_t& data) {
+  OpScope op(*this);
   return customRead(address, &data, 1);
 }
 
 Status EE871::customRead(uint8_t address, uint8_t* buf, size_t len) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -534,7 +905,7 @@ Status EE871::customRead(uint8_t address, uint8_t* buf, size_t len) {
   if (len > maxLen) {
     return Status::Error(Err::OUT_OF_RANGE, "Read exceeds custom memory map");
   }
-  Status st = setCustomPointer(address);
+  Status st = _seekCustomPointer(address);
   if (!st.ok()) {
     return st;
   }
@@ -549,6 +920,7 @@ Status EE871::customRead(uint8_t address, uint8_t* buf, size_t len) {
 }
 
 Status EE871::customWrite(uint8_t address, uint8_t value) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -586,7 +958,7 @@ Status EE871::_customWriteDirect(uint8_t address, uint8_t value, bool* writeAcce
     return st;
   }
 
-  sleepMs(_config, _config.writeDelayMs);
+  _commitWait(_config.writeDelayMs);
 
   uint8_t verify = 0;
   st = customRead(address, verify);
@@ -600,6 +972,7 @@ Status EE871::_customWriteDirect(uint8_t address, uint8_t value, bool* writeAcce
 }
 
 Status EE871::writeMeasurementInterval(uint16_t intervalDeciSeconds) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -632,7 +1005,7 @@ Status EE871::writeMeasurementInterval(uint16_t intervalDeciSeconds) {
     return st;
   }
 
-  sleepMs(_config, _config.intervalWriteDelayMs);
+  _commitWait(_config.intervalWriteDelayMs);
 
   uint8_t verifyLow = 0;
   uint8_t verifyHigh = 0;
@@ -656,7 +1029,205 @@ Status EE871::writeMeasurementInterval(uint16_t intervalDeciSeconds) {
   return Status::Ok();
 }
 
+// ============================================================================
+// Batch Requests
+// ============================================================================
+
+Status EE871::execute(Request* reqs, size_t n) {
+  OpScope op(*this);
+  if (reqs == nullptr && n > 0) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid request list");
+  }
+  if (!_initialized) {
+    const Status err = Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
+    for (size_t i = 0; i < n; ++i) {
+      reqs[i].status = err;
+    }
+    return err;
+  }
+
+  // Validate the whole batch before the first transfer; one invalid item
+  // rejects the batch so no write runs from a partially valid list.
+  size_t invalid = n;
+  for (size_t i = 0; i < n; ++i) {
+    reqs[i].status = validateRequest(reqs[i]);
+    if (invalid == n && !reqs[i].status.inProgress()) {
+      invalid = i;
+    }
+  }
+  if (invalid < n) {
+    const Status rejected = Status::Error(reqs[invalid].status.code,
+                                          "Not executed after invalid request",
+                                          static_cast<int32_t>(invalid));
+    for (size_t i = 0; i < n; ++i) {
+      if (reqs[i].status.inProgress()) {
+        reqs[i].status = rejected;
+      }
+    }
+    return reqs[invalid].status;
+  }
+
+  size_t failed = n;
+  size_t segment = 0;
+  for (size_t i = 0; i <= n && failed == n; ++i) {
+    if (i < n && reqs[i].kind != RequestKind::CUSTOM_WRITE) {
+      continue;
+    }
+    if (!_executeReads(reqs, segment, i, failed).ok() || i == n) {
+      break;
+    }
+    segment = i + 1;
+
+    Request& write = reqs[i];
+    if (!write.status.inProgress()) {
+      continue;
+    }
+    Status st = Status::Ok();
+    bool accepted = false;
+    size_t k = 0;
+    while (k < write.len) {
+      const uint8_t address = static_cast<uint8_t>(write.command + k);
+      size_t step = 1;
+      if (address == cmd::CUSTOM_INTERVAL_L && k + 1 < write.len) {
+        // Both interval bytes in one request: write them as one value.
+        const uint16_t interval = static_cast<uint16_t>(write.in[k]) |
+                                  (static_cast<uint16_t>(write.in[k + 1]) << 8);
+        st = writeMeasurementInterval(interval);
+        step = 2;
+      } else if (address == cmd::CUSTOM_INTERVAL_L || address == cmd::CUSTOM_INTERVAL_H) {
+        st = customWrite(address, write.in[k]);
+      } else {
+        st = _customWriteDirect(address, write.in[k], &accepted);
+      }
+      if (!st.ok()) {
+        break;
+      }
+      k += step;
+    }
+    write.status = st;
+    if (!st.ok()) {
+      // Bytes already written (or a first byte the device took) leave the
+      // range half-updated, as in writePartName().
+      if (k > 0 || accepted) {
+        _markPersistentConfigDirty(st);
+      }
+      failed = i;
+    }
+  }
+
+  if (failed < n) {
+    const Status skipped = Status::Error(reqs[failed].status.code,
+                                         "Not executed after batch failure",
+                                         static_cast<int32_t>(failed));
+    for (size_t i = 0; i < n; ++i) {
+      if (reqs[i].status.inProgress()) {
+        reqs[i].status = skipped;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    if (!reqs[i].status.ok()) {
+      return reqs[i].status;
+    }
+  }
+  return Status::Ok();
+}
+
+Status EE871::_executeReads(Request* reqs, size_t begin, size_t end, size_t& failed) {
+  bool transferred = false;
+
+  for (size_t i = begin; i < end; ++i) {
+    Request& req = reqs[i];
+    if (req.kind != RequestKind::CONTROL_READ || !req.status.inProgress()) {
+      continue;
+    }
+    const uint8_t control = cmd::makeControlRead(req.command, _config.deviceAddress);
+    req.status = _readControlByteRaw(control, *req.out);
+    transferred = true;
+    if (!req.status.ok()) {
+      failed = i;
+      return _updateHealth(req.status);
+    }
+  }
+
+  for (;;) {
+    size_t first = end;
+    for (size_t i = begin; i < end; ++i) {
+      if (pendingCustomRead(reqs[i]) &&
+          (first == end || reqs[i].command < reqs[first].command)) {
+        first = i;
+      }
+    }
+    if (first == end) {
+      break;
+    }
+
+    // Grow the run from the lowest pending address until no range touches it.
+    const uint16_t start = reqs[first].command;
+    uint16_t stop = static_cast<uint16_t>(start + reqs[first].len);
+    bool grew = true;
+    while (grew) {
+      grew = false;
+      for (size_t i = begin; i < end; ++i) {
+        const Request& req = reqs[i];
+        const uint16_t reqEnd = static_cast<uint16_t>(req.command + req.len);
+        if (pendingCustomRead(req) && req.command <= stop + kCustomGapBridge &&
+            reqEnd > stop) {
+          stop = reqEnd;
+          grew = true;
+        }
+      }
+    }
+
+    Status st = Status::Ok();
+    if (_customPointerAt(static_cast<uint8_t>(start))) {
+      _opInfo.cacheHit = true;
+    } else {
+      st = _writeCommandRaw(cmd::makeControlWrite(cmd::MAIN_CUSTOM_PTR, _config.deviceAddress),
+                            0, static_cast<uint8_t>(start));
+      transferred = true;
+    }
+    const uint8_t control = cmd::makeControlRead(cmd::MAIN_CUSTOM_PTR, _config.deviceAddress);
+    for (uint16_t address = start; address < stop && st.ok(); ++address) {
+      uint8_t data = 0;
+      st = _readControlByteRaw(control, data);
+      transferred = true;
+      for (size_t i = begin; i < end && st.ok(); ++i) {
+        Request& req = reqs[i];
+        if (pendingCustomRead(req) && address >= req.command &&
+            address < req.command + req.len) {
+          req.out[address - req.command] = data;
+        }
+      }
+    }
+
+    size_t members = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (pendingCustomRead(reqs[i]) && reqs[i].command < stop) {
+        if (members++ == 0 && !st.ok()) {
+          failed = i;
+        }
+        reqs[i].status = st;
+      }
+    }
+    if (!st.ok()) {
+      return _updateHealth(st);
+    }
+    if (members > 1) {
+      _opInfo.coalesced = true;
+    }
+  }
+
+  return transferred ? _updateHealth(Status::Ok()) : Status::Ok();
+}
+
+// ============================================================================
+// Identification
+// ============================================================================
+
 Status EE871::readGroup(uint16_t& group) {
+  OpScope op(*this);
   Status st = readU16(cmd::MAIN_TYPE_LO, cmd::MAIN_TYPE_HI, group);
   if (!st.ok()) {
     return st;
@@ -668,6 +1239,7 @@ Status EE871::readGroup(uint16_t& group) {
 }
 
 Status EE871::readSubgroup(uint8_t& subgroup) {
+  OpScope op(*this);
   Status st = readControlByte(cmd::MAIN_TYPE_SUB, subgroup);
   if (!st.ok()) {
     return st;
@@ -679,14 +1251,59 @@ Status EE871::readSubgroup(uint8_t& subgroup) {
 }
 
 Status EE871::readAvailableMeasurements(uint8_t& bits) {
+  OpScope op(*this);
   return readControlByte(cmd::MAIN_AVAIL_MEAS, bits);
 }
 
 Status EE871::readStatus(uint8_t& status) {
+  OpScope op(*this);
   return readControlByte(cmd::MAIN_STATUS, status);
 }
 
+Status EE871::readStatus(StatusReport& report) {
+  OpScope op(*this);
+  report = StatusReport();
+  Status st = readStatus(report.status);
+  if (!st.ok()) {
+    return st;
+  }
+  return _chainErrorCode(report);
+}
+
+Status EE871::readMeasurement(MeasurementFrame& frame) {
+  OpScope op(*this);
+  frame = MeasurementFrame();
+  Status st = readStatus(frame.status.status);
+  if (!st.ok()) {
+    return st;
+  }
+  if (hasCo2Error(frame.status.status)) {
+    // The value may jump arbitrarily while the sensor reports an error.
+    _mv4Known = false;
+  }
+  st = readCo2Average(frame.co2Average);
+  if (!st.ok()) {
+    return st;
+  }
+  return _chainErrorCode(frame.status);
+}
+
+Status EE871::_chainErrorCode(StatusReport& report) {
+  report.co2Error = hasCo2Error(report.status);
+  if (!report.co2Error || !hasErrorCode()) {
+    return Status::Ok();
+  }
+  Status st = customRead(cmd::CUSTOM_ERROR_CODE, report.errorCode);
+  if (!st.ok()) {
+    return st;
+  }
+  report.errorCodeValid = true;
+  report.errorCodeName = cmd::co2ErrorCodeName(report.errorCode);
+  return Status::Ok();
+}
+
 Status EE871::readErrorCode(uint8_t& code) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -697,11 +1314,66 @@ Status EE871::readErrorCode(uint8_t& code) {
 }
 
 Status EE871::readCo2Fast(uint16_t& ppm) {
-  return readU16(cmd::MAIN_MV3_LO, cmd::MAIN_MV3_HI, ppm);
+  OpScope op(*this);
+  const Status st = readU16(cmd::MAIN_MV3_LO, cmd::MAIN_MV3_HI, ppm);
+  if (st.ok()) {
+    ++_generations.measurement;
+  }
+  return st;
 }
 
 Status EE871::readCo2Average(uint16_t& ppm) {
-  return readU16(cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI, ppm);
+  OpScope op(*this);
+  if (_config.co2HighByteRefresh <= 1) {
+    const Status st = readU16(cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI, ppm);
+    if (st.ok()) {
+      ++_generations.measurement;
+    }
+    return st;
+  }
+  if (!_initialized) {
+    return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
+  }
+
+  uint8_t low = 0;
+  Status st = readControlByte(cmd::MAIN_MV4_LO, low);
+  if (!st.ok()) {
+    _mv4Known = false;
+    return st;
+  }
+
+  // Signed low-byte step, valid as the real change only if it is small.
+  const uint8_t lastLow = static_cast<uint8_t>(_mv4Last & 0xFF);
+  const int16_t step = static_cast<int8_t>(static_cast<uint8_t>(low - lastLow));
+  const int16_t magnitude = (step < 0) ? static_cast<int16_t>(-step) : step;
+  const int16_t landed = static_cast<int16_t>(lastLow + step);
+  const bool noCarry = magnitude <= _config.co2ElisionMaxStep && landed >= 0 && landed <= 0xFF;
+
+  if (_mv4Known && noCarry && _mv4SinceRefresh + 1U < _config.co2HighByteRefresh) {
+    ppm = static_cast<uint16_t>((_mv4Last & 0xFF00) | low);
+    _mv4Last = ppm;
+    ++_mv4SinceRefresh;
+    ++_mv4Elided;
+    _opInfo.cacheHit = true;
+    ++_generations.measurement;
+    return Status::Ok();
+  }
+
+  uint8_t high = 0;
+  st = readControlByte(cmd::MAIN_MV4_HI, high);
+  if (!st.ok()) {
+    _mv4Known = false;
+    return st;
+  }
+  if (_mv4Known && noCarry && high != static_cast<uint8_t>(_mv4Last >> 8)) {
+    ++_mv4Resyncs;
+  }
+  ppm = static_cast<uint16_t>(low | (static_cast<uint16_t>(high) << 8));
+  _mv4Last = ppm;
+  _mv4Known = true;
+  _mv4SinceRefresh = 0;
+  ++_generations.measurement;
+  return Status::Ok();
 }
 
 // ============================================================================
@@ -709,6 +1381,7 @@ Status EE871::readCo2Average(uint16_t& ppm) {
 // ============================================================================
 
 Status EE871::readFirmwareVersion(uint8_t& main, uint8_t& sub) {
+  OpScope op(*this);
   Status st = customRead(cmd::CUSTOM_FW_VERSION_MAIN, main);
   if (!st.ok()) {
     return st;
@@ -717,6 +1390,7 @@ Status EE871::readFirmwareVersion(uint8_t& main, uint8_t& sub) {
 }
 
 Status EE871::readE2SpecVersion(uint8_t& version) {
+  OpScope op(*this);
   return customRead(cmd::CUSTOM_E2_SPEC_VERSION, version);
 }
 
@@ -725,14 +1399,17 @@ Status EE871::readE2SpecVersion(uint8_t& version) {
 // ============================================================================
 
 Status EE871::readOperatingFunctions(uint8_t& bits) {
+  OpScope op(*this);
   return customRead(cmd::CUSTOM_OPERATING_FUNCTIONS, bits);
 }
 
 Status EE871::readOperatingModeSupport(uint8_t& bits) {
+  OpScope op(*this);
   return customRead(cmd::CUSTOM_OPERATING_MODE_SUPPORT, bits);
 }
 
 Status EE871::readSpecialFeatures(uint8_t& bits) {
+  OpScope op(*this);
   return customRead(cmd::CUSTOM_SPECIAL_FEATURES, bits);
 }
 
@@ -741,6 +1418,7 @@ Status EE871::readSpecialFeatures(uint8_t& bits) {
 // ============================================================================
 
 Status EE871::readSerialNumber(uint8_t* buf) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -754,6 +1432,7 @@ Status EE871::readSerialNumber(uint8_t* buf) {
 }
 
 Status EE871::readPartName(uint8_t* buf) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -767,6 +1446,7 @@ Status EE871::readPartName(uint8_t* buf) {
 }
 
 Status EE871::writePartName(const uint8_t* buf) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -794,11 +1474,13 @@ Status EE871::writePartName(const uint8_t* buf) {
 // ============================================================================
 
 Status EE871::readBusAddress(uint8_t& address) {
+  OpScope op(*this);
   // Address can always be read, guard only applies to write
   return customRead(cmd::CUSTOM_BUS_ADDRESS, address);
 }
 
 Status EE871::writeBusAddress(uint8_t address) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -816,6 +1498,7 @@ Status EE871::writeBusAddress(uint8_t address) {
 // ============================================================================
 
 Status EE871::readMeasurementInterval(uint16_t& intervalDeciSeconds) {
+  OpScope op(*this);
   // Interval can always be read, guard only applies to write
   uint8_t low = 0;
   uint8_t high = 0;
@@ -832,6 +1515,7 @@ Status EE871::readMeasurementInterval(uint16_t& intervalDeciSeconds) {
 }
 
 Status EE871::readCo2IntervalFactor(int8_t& factor) {
+  OpScope op(*this);
   // Factor can always be read, guard only applies to write
   uint8_t raw = 0;
   Status st = customRead(cmd::CUSTOM_CO2_INTERVAL_FACTOR, raw);
@@ -843,6 +1527,7 @@ Status EE871::readCo2IntervalFactor(int8_t& factor) {
 }
 
 Status EE871::writeCo2IntervalFactor(int8_t factor) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -857,11 +1542,13 @@ Status EE871::writeCo2IntervalFactor(int8_t factor) {
 // ============================================================================
 
 Status EE871::readCo2Filter(uint8_t& filter) {
+  OpScope op(*this);
   // Filter can always be read, guard only applies to write
   return customRead(cmd::CUSTOM_FILTER_CO2, filter);
 }
 
 Status EE871::writeCo2Filter(uint8_t filter) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -872,11 +1559,13 @@ Status EE871::writeCo2Filter(uint8_t filter) {
 }
 
 Status EE871::readOperatingMode(uint8_t& mode) {
+  OpScope op(*this);
   // Mode can always be read, guard only applies to write
   return customRead(cmd::CUSTOM_OPERATING_MODE, mode);
 }
 
 Status EE871::writeOperatingMode(uint8_t mode) {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -899,6 +1588,7 @@ Status EE871::writeOperatingMode(uint8_t mode) {
 // ============================================================================
 
 Status EE871::readAutoAdjustStatus(bool& running) {
+  OpScope op(*this);
   // Status can always be read, guard only applies to start
   uint8_t raw = 0;
   Status st = customRead(cmd::CUSTOM_AUTO_ADJUST, raw);
@@ -910,6 +1600,7 @@ Status EE871::readAutoAdjustStatus(bool& running) {
 }
 
 Status EE871::startAutoAdjust() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -925,6 +1616,7 @@ Status EE871::startAutoAdjust() {
 // ============================================================================
 
 Status EE871::readCo2Offset(int16_t& offset) {
+  OpScope op(*this);
   uint8_t low = 0;
   uint8_t high = 0;
   Status st = customRead(cmd::CUSTOM_CO2_OFFSET_L, low);
@@ -940,6 +1632,7 @@ Status EE871::readCo2Offset(int16_t& offset) {
 }
 
 Status EE871::writeCo2Offset(int16_t offset) {
+  OpScope op(*this);
   const uint16_t raw = static_cast<uint16_t>(offset);
   bool lowAccepted = false;
   Status st = _customWriteDirect(cmd::CUSTOM_CO2_OFFSET_L,
@@ -959,6 +1652,7 @@ Status EE871::writeCo2Offset(int16_t offset) {
 }
 
 Status EE871::readCo2Gain(uint16_t& gain) {
+  OpScope op(*this);
   uint8_t low = 0;
   uint8_t high = 0;
   Status st = customRead(cmd::CUSTOM_CO2_GAIN_L, low);
@@ -974,6 +1668,7 @@ Status EE871::readCo2Gain(uint16_t& gain) {
 }
 
 Status EE871::writeCo2Gain(uint16_t gain) {
+  OpScope op(*this);
   bool lowAccepted = false;
   Status st = _customWriteDirect(cmd::CUSTOM_CO2_GAIN_L,
                                  static_cast<uint8_t>(gain & 0xFF),
@@ -992,6 +1687,7 @@ Status EE871::writeCo2Gain(uint16_t gain) {
 }
 
 Status EE871::readCo2CalPoints(uint16_t& lower, uint16_t& upper) {
+  OpScope op(*this);
   uint8_t buf[4] = {0};
   Status st = customRead(cmd::CUSTOM_CO2_POINT_L_L, buf, 4);
   if (!st.ok()) {
@@ -1007,47 +1703,22 @@ Status EE871::readCo2CalPoints(uint16_t& lower, uint16_t& upper) {
 // ============================================================================
 
 Status EE871::busReset() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
 
-  // Clock out 9+ pulses with SDA high to reset slave state machine
-  setSda(_config, true);
-  for (uint8_t i = 0; i < cmd::BUS_RESET_CLOCKS; ++i) {
-    setScl(_config, false);
-    delayUs(_config, _config.clockLowUs, nullptr);
-    setScl(_config, true);
-    // Wait for clock to rise (slave might stretch)
-    uint32_t waited = 0;
-    while (!readScl(_config) && waited < _config.bitTimeoutUs) {
-      delayUs(_config, kPollStepUs, nullptr);
-      waited += kPollStepUs;
-    }
-    if (waited >= _config.bitTimeoutUs) {
-      return Status::Error(Err::BUS_STUCK, "SCL stuck during reset");
-    }
-    delayUs(_config, _config.clockHighUs, nullptr);
-  }
-
-  // Generate STOP condition
-  setScl(_config, false);
-  delayUs(_config, _config.clockLowUs, nullptr);
-  setSda(_config, false);
-  delayUs(_config, kDataSetupUs, nullptr);
-  setScl(_config, true);
-  delayUs(_config, _config.stopHoldUs, nullptr);
-  setSda(_config, true);
-  delayUs(_config, _config.stopHoldUs, nullptr);
-
-  // Verify bus is now idle
-  if (!readScl(_config) || !readSda(_config)) {
-    return Status::Error(Err::BUS_STUCK, "Bus stuck after reset");
-  }
-
-  return Status::Ok();
+  // Clocking a half-finished transfer may move the device pointer.
+  _customPtrKnown = false;
+  ActivityScope<Config> activity(_config, _timing.resetUs);
+  Link link(_config, _timing);
+  Status st = busResetLines(link);
+  addLinkCost(_opInfo, link);
+  return st;
 }
 
 Status EE871::checkBusIdle() {
+  OpScope op(*this);
   if (!_initialized) {
     return Status::Error(Err::NOT_INITIALIZED, "Driver not initialized");
   }
@@ -1069,64 +1740,33 @@ Status EE871::checkBusIdle() {
 }
 
 Status EE871::_readControlByteRaw(uint8_t controlByte, uint8_t& data) {
-  Status st = e2Start(_config);
-  if (!st.ok()) {
-    return st;
-  }
-
-  uint32_t elapsedUs = 0;
-  st = writeByte(_config, controlByte, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-
-  bool acked = false;
-  st = readAck(_config, acked, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  if (!acked) {
-    e2Stop(_config);
-    return Status::Error(Err::NACK, "Control byte NACK");
-  }
-
-  elapsedUs = 0;
-  st = readByte(_config, data, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  st = sendAck(_config, true, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-
   uint8_t pec = 0;
-  elapsedUs = 0;
-  st = readByte(_config, pec, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  st = sendAck(_config, false, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
+  Status st;
+  ++_opInfo.transactions;
+  {
+    ActivityScope<Config> activity(_config, _timing.readFrameUs);
+    if (_config.readFrame != nullptr) {
+      st = _config.readFrame(controlByte, data, pec, _config.busUser);
+      // The hook owns the lines; report the nominal frame time instead.
+      _opInfo.busUs += _timing.readFrameUs;
+      if (st.ok()) {
+        _opInfo.bytesTransferred = static_cast<uint16_t>(_opInfo.bytesTransferred + 3U);
+      }
+    } else {
+      Link link(_config, _timing);
+      st = readFrameLines(link, controlByte, data, pec);
+      addLinkCost(_opInfo, link);
+    }
   }
-
-  st = e2Stop(_config);
-  if (!st.ok()) {
-    return st;
+  if (st.ok() && pec != calcPecRead(controlByte, data)) {
+    st = Status::Error(Err::PEC_MISMATCH, "PEC mismatch", pec);
   }
-
-  const uint8_t expected = calcPecRead(controlByte, data);
-  if (pec != expected) {
-    return Status::Error(Err::PEC_MISMATCH, "PEC mismatch", pec);
+  if ((controlByte >> 4) == cmd::MAIN_CUSTOM_PTR) {
+    // Each 0x51 read auto-increments the pointer; a failed one leaves it unknown.
+    _customPtrKnown = _customPtrKnown && st.ok();
+    ++_customPtr;
   }
-  return Status::Ok();
+  return st;
 }
 
 Status EE871::_readControlByteTracked(uint8_t controlByte, uint8_t& data) {
@@ -1136,88 +1776,31 @@ Status EE871::_readControlByteTracked(uint8_t controlByte, uint8_t& data) {
 
 Status EE871::_writeCommandRaw(uint8_t controlByte, uint8_t addressByte, uint8_t dataByte,
                                bool* writeAccepted) {
-  if (writeAccepted != nullptr) {
-    *writeAccepted = false;
-  }
-
-  Status st = e2Start(_config);
-  if (!st.ok()) {
-    return st;
-  }
-
-  uint32_t elapsedUs = 0;
-  st = writeByte(_config, controlByte, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  bool acked = false;
-  st = readAck(_config, acked, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  if (!acked) {
-    e2Stop(_config);
-    return Status::Error(Err::NACK, "Control byte NACK");
-  }
-
-  elapsedUs = 0;
-  st = writeByte(_config, addressByte, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  st = readAck(_config, acked, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  if (!acked) {
-    e2Stop(_config);
-    return Status::Error(Err::NACK, "Address byte NACK");
-  }
-
-  elapsedUs = 0;
-  st = writeByte(_config, dataByte, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  st = readAck(_config, acked, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  if (!acked) {
-    e2Stop(_config);
-    return Status::Error(Err::NACK, "Data byte NACK");
-  }
-
   const uint8_t pec = calcPecWrite(controlByte, addressByte, dataByte);
-  elapsedUs = 0;
-  st = writeByte(_config, pec, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  st = readAck(_config, acked, &elapsedUs);
-  if (!st.ok()) {
-    e2Stop(_config);
-    return st;
-  }
-  if (!acked) {
-    e2Stop(_config);
-    return Status::Error(Err::NACK, "PEC NACK");
+  bool accepted = false;
+  Status st;
+  ++_opInfo.transactions;
+  {
+    ActivityScope<Config> activity(_config, _timing.writeFrameUs);
+    if (_config.writeFrame != nullptr) {
+      st = _config.writeFrame(controlByte, addressByte, dataByte, pec, accepted, _config.busUser);
+      _opInfo.busUs += _timing.writeFrameUs;
+      if (st.ok()) {
+        _opInfo.bytesTransferred = static_cast<uint16_t>(_opInfo.bytesTransferred + 4U);
+      }
+    } else {
+      Link link(_config, _timing);
+      st = writeFrameLines(link, controlByte, addressByte, dataByte, pec, accepted);
+      addLinkCost(_opInfo, link);
+    }
   }
-
   if (writeAccepted != nullptr) {
-    *writeAccepted = true;
+    *writeAccepted = accepted;
   }
-
-  st = e2Stop(_config);
-  if (!st.ok()) {
-    return st;
+  // Only a completed 0x50 pointer write leaves the pointer known.
+  _customPtrKnown = st.ok() && (controlByte >> 4) == cmd::MAIN_CUSTOM_PTR && addressByte == 0;
+  if (_customPtrKnown) {
+    _customPtr = dataByte;
   }
   return st;
 }
@@ -1235,6 +1818,7 @@ Status EE871::_updateHealth(const Status& st) {
   if (st.inProgress()) {
     return st;
   }
+  ++_generations.health;
 
   if (st.ok()) {
     _lastOkMs = _nowMs;
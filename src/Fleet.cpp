@@ -0,0 +1,268 @@
+/// @file Fleet.cpp
+/// @brief Implementation of the fleet state store, poller, and batch kernels
+
+#include "EE871/Fleet.h"
+
+namespace EE871 {
+
+Status FleetStore::begin(const FleetColumns& columns, size_t rows) {
+  end();
+  if (rows == 0 || columns.ppm == nullptr || columns.sampleMs == nullptr ||
+      columns.hasSample == nullptr || columns.statusByte == nullptr ||
+      columns.errorCode == nullptr || columns.lastResult == nullptr ||
+      columns.state == nullptr || columns.consecutiveFailures == nullptr ||
+      columns.totalFailures == nullptr) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid fleet columns");
+  }
+  _c = columns;
+  _rows = rows;
+  clear();
+  return Status::Ok();
+}
+
+void FleetStore::end() {
+  _c = FleetColumns();
+  _rows = 0;
+}
+
+void FleetStore::clear() {
+  for (size_t i = 0; i < _rows; ++i) {
+    _c.ppm[i] = 0;
+    _c.sampleMs[i] = 0;
+    _c.hasSample[i] = 0;
+    _c.statusByte[i] = 0;
+    _c.errorCode[i] = 0;
+    _c.lastResult[i] = static_cast<uint8_t>(Err::OK);
+    _c.state[i] = static_cast<uint8_t>(DriverState::UNINIT);
+    _c.consecutiveFailures[i] = 0;
+    _c.totalFailures[i] = 0;
+  }
+}
+
+void FleetStore::recordSample(size_t row, uint32_t nowMs, uint16_t ppm, uint8_t statusByte,
+                              uint8_t errorCode) {
+  if (row >= _rows) {
+    return;
+  }
+  _c.ppm[row] = ppm;
+  _c.sampleMs[row] = nowMs;
+  _c.hasSample[row] = 1;
+  _c.statusByte[row] = statusByte;
+  _c.errorCode[row] = errorCode;
+  _c.lastResult[row] = static_cast<uint8_t>(Err::OK);
+}
+
+void FleetStore::recordSensorError(size_t row, uint8_t statusByte, uint8_t errorCode) {
+  if (row >= _rows) {
+    return;
+  }
+  _c.statusByte[row] = statusByte;
+  _c.errorCode[row] = errorCode;
+  _c.lastResult[row] = static_cast<uint8_t>(Err::OK);
+}
+
+void FleetStore::recordFailure(size_t row, Err err) {
+  if (row >= _rows) {
+    return;
+  }
+  _c.lastResult[row] = static_cast<uint8_t>(err);
+}
+
+void FleetStore::recordHealth(size_t row, DriverState state, uint8_t consecutiveFailures,
+                              uint32_t totalFailures) {
+  if (row >= _rows) {
+    return;
+  }
+  _c.state[row] = static_cast<uint8_t>(state);
+  _c.consecutiveFailures[row] = consecutiveFailures;
+  _c.totalFailures[row] = totalFailures;
+}
+
+Status FleetPoller::begin(EE871* const* devices, size_t count, FleetStore& store) {
+  end();
+  if (!store.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Fleet store not initialized");
+  }
+  if (devices == nullptr || count == 0 || count > store.size()) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid fleet");
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (devices[i] == nullptr) {
+      return Status::Error(Err::INVALID_PARAM, "Invalid fleet member", static_cast<int32_t>(i));
+    }
+  }
+  _devices = devices;
+  _store = &store;
+  _count = count;
+  return Status::Ok();
+}
+
+void FleetPoller::end() {
+  _devices = nullptr;
+  _store = nullptr;
+  _count = 0;
+  _cursor = 0;
+}
+
+Status FleetPoller::pollNext(uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Fleet poller not initialized");
+  }
+  const size_t row = _cursor;
+  _cursor = (_cursor + 1 < _count) ? (_cursor + 1) : 0;
+  return _poll(row, nowMs);
+}
+
+Status FleetPoller::pollAll(uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Fleet poller not initialized");
+  }
+  int32_t failed = 0;
+  for (size_t i = 0; i < _count; ++i) {
+    if (!_poll(i, nowMs).ok()) {
+      ++failed;
+    }
+  }
+  if (failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Fleet poll failed", failed);
+  }
+  return Status::Ok();
+}
+
+Status FleetPoller::poll(size_t row, uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Fleet poller not initialized");
+  }
+  if (row >= _count) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid fleet row", static_cast<int32_t>(row));
+  }
+  return _poll(row, nowMs);
+}
+
+Status FleetPoller::_poll(size_t row, uint32_t nowMs) {
+  EE871& dev = *_devices[row];
+  MeasurementFrame frame;
+  const Status st = dev.readMeasurement(frame);
+  if (st.ok()) {
+    const uint8_t errorCode = frame.status.errorCodeValid ? frame.status.errorCode : 0;
+    if (frame.status.co2Error) {
+      // MV4 may jump arbitrarily while the sensor reports an error.
+      _store->recordSensorError(row, frame.status.status, errorCode);
+    } else {
+      _store->recordSample(row, nowMs, frame.co2Average, frame.status.status, errorCode);
+    }
+  } else {
+    _store->recordFailure(row, st.code);
+  }
+  _store->recordHealth(row, dev.state(), dev.consecutiveFailures(), dev.totalFailures());
+  return st;
+}
+
+namespace fleet {
+
+// The loops below keep to one pass, no early exit, and conditional moves
+// instead of branches so they vectorize; counts are summed from the 0/1 masks.
+
+PpmStats ppmStats(const uint16_t* ppm, const uint8_t* include, size_t rows) {
+  // Excluded rows are masked to neutral values. Sums run in uint32 blocks of
+  // 65536 rows, which cannot overflow and keep the inner loop vectorizable.
+  static constexpr size_t kBlock = 65536;
+  uint16_t lo = 0xFFFF;
+  uint16_t hi = 0;
+  uint64_t sum = 0;
+  size_t count = 0;
+  for (size_t base = 0; base < rows; base += kBlock) {
+    const size_t end = (rows - base > kBlock) ? (base + kBlock) : rows;
+    uint32_t blockSum = 0;
+    uint32_t blockCount = 0;
+    for (size_t i = base; i < end; ++i) {
+      const uint16_t in = static_cast<uint16_t>(include[i] != 0);
+      const uint16_t mask = static_cast<uint16_t>(0U - in);
+      const uint16_t forMin = static_cast<uint16_t>(ppm[i] | static_cast<uint16_t>(~mask));
+      const uint16_t forMax = static_cast<uint16_t>(ppm[i] & mask);
+      lo = (forMin < lo) ? forMin : lo;
+      hi = (forMax > hi) ? forMax : hi;
+      blockSum += forMax;
+      blockCount += in;
+    }
+    sum += blockSum;
+    count += blockCount;
+  }
+
+  PpmStats stats;
+  if (count == 0) {
+    return stats;
+  }
+  stats.count = count;
+  stats.min = lo;
+  stats.max = hi;
+  stats.sum = sum;
+  stats.mean = static_cast<uint16_t>((sum + count / 2U) / count);
+  return stats;
+}
+
+size_t thresholdMask(const uint16_t* ppm, size_t rows, uint16_t threshold, uint8_t* out) {
+  size_t count = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    const uint8_t m = static_cast<uint8_t>(ppm[i] >= threshold);
+    out[i] = m;
+    count += m;
+  }
+  return count;
+}
+
+size_t staleMask(const uint32_t* sampleMs, const uint8_t* hasSample, size_t rows,
+                 uint32_t nowMs, uint32_t maxAgeMs, uint8_t* out) {
+  size_t count = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    const uint32_t age = nowMs - sampleMs[i];
+    const uint8_t m = static_cast<uint8_t>((hasSample[i] == 0) | (age > maxAgeMs));
+    out[i] = m;
+    count += m;
+  }
+  return count;
+}
+
+size_t stateMask(const uint8_t* state, size_t rows, DriverState match, uint8_t* out) {
+  const uint8_t want = static_cast<uint8_t>(match);
+  size_t count = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    const uint8_t m = static_cast<uint8_t>(state[i] == want);
+    out[i] = m;
+    count += m;
+  }
+  return count;
+}
+
+size_t failureMask(const uint8_t* failures, size_t rows, uint8_t minFailures, uint8_t* out) {
+  size_t count = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    const uint8_t m = static_cast<uint8_t>(failures[i] >= minFailures);
+    out[i] = m;
+    count += m;
+  }
+  return count;
+}
+
+size_t andMask(const uint8_t* a, const uint8_t* b, size_t rows, uint8_t* out) {
+  size_t count = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    const uint8_t m = static_cast<uint8_t>(a[i] & b[i]);
+    out[i] = m;
+    count += m;
+  }
+  return count;
+}
+
+size_t freshMask(const FleetStore& store, uint32_t nowMs, uint32_t maxAgeMs, uint8_t* out) {
+  const size_t rows = store.size();
+  const size_t stale = staleMask(store.sampleMs(), store.hasSample(), rows, nowMs, maxAgeMs, out);
+  for (size_t i = 0; i < rows; ++i) {
+    out[i] ^= 1U;
+  }
+  return rows - stale;
+}
+
+} // namespace fleet
+
+} // namespace EE871
@@ -0,0 +1,219 @@
+/// @file FleetBoot.cpp
+/// @brief Implementation of lockstep fleet bring-up
+
+#include "EE871/FleetBoot.h"
+
+#include "EE871/CommandTable.h"
+
+namespace EE871 {
+namespace {
+
+/// Per-bus state shared by the rounds of one beginFleet() call.
+struct BootBuses {
+  uint32_t dead = 0;                 ///< Buses that timed out or are stuck.
+  Status deadStatus[MULTI_BUS_MAX];  ///< First fatal error per dead bus.
+};
+
+static bool isBusFatal(const Status& st) {
+  return st.code == Err::TIMEOUT || st.code == Err::BUS_STUCK;
+}
+
+static uint8_t popcount(uint32_t mask) {
+  uint8_t n = 0;
+  for (; mask != 0; mask &= mask - 1U) {
+    ++n;
+  }
+  return n;
+}
+
+static void markDead(BootBuses& buses, uint8_t bus, const Status& st) {
+  if ((buses.dead & (1u << bus)) == 0) {
+    buses.dead |= 1u << bus;
+    buses.deadStatus[bus] = st;
+  }
+}
+
+/// Buses of @p mask whose result is Ok; fatal failures mark their bus dead.
+static uint32_t keepOk(uint32_t mask, const Status* st, uint8_t busCount, BootBuses& buses) {
+  for (uint8_t b = 0; b < busCount; ++b) {
+    if ((mask & (1u << b)) != 0 && !st[b].ok()) {
+      mask &= ~(1u << b);
+      if (isBusFatal(st[b])) {
+        markDead(buses, b, st[b]);
+      }
+    }
+  }
+  return mask;
+}
+
+/// Probe one member per bus of @p mask; @p pick maps bus to member index.
+static void runRound(MultiBusEngine& engine, uint32_t mask, const size_t* pick,
+                     const FleetMember* members, Status* results, FleetBootReport& report,
+                     BootBuses& buses) {
+  const uint8_t busCount = engine.getConfig().busCount;
+  uint8_t addresses[MULTI_BUS_MAX] = {};
+  for (uint8_t b = 0; b < busCount; ++b) {
+    if ((mask & (1u << b)) != 0) {
+      addresses[b] = members[pick[b]].config.deviceAddress;
+    }
+  }
+
+  uint16_t groups[MULTI_BUS_MAX] = {};
+  Status identity[MULTI_BUS_MAX];
+  uint32_t before = engine.busUs();
+  (void)engine.readU16(mask, cmd::MAIN_TYPE_LO, cmd::MAIN_TYPE_HI, addresses, groups, identity);
+  const uint32_t identityUs = engine.busUs() - before;
+  report.identityUs += identityUs;
+  report.serialUs += identityUs * popcount(mask);
+
+  DeviceProbe probes[MULTI_BUS_MAX];
+  uint32_t found = 0;
+  for (uint8_t b = 0; b < busCount; ++b) {
+    if ((mask & (1u << b)) == 0) {
+      continue;
+    }
+    if (identity[b].ok()) {
+      probes[b].groupId = groups[b];
+      if (groups[b] == cmd::SENSOR_GROUP_ID) {
+        found |= 1u << b;
+      }
+    } else if (isBusFatal(identity[b])) {
+      markDead(buses, b, identity[b]);
+    }
+  }
+
+  // Feature bytes as in begin(): pointer to 0x07, then three auto-increment reads.
+  // Failures here are non-fatal; the device comes up with all features off.
+  if (found != 0) {
+    uint8_t controls[MULTI_BUS_MAX] = {};
+    uint8_t addressBytes[MULTI_BUS_MAX] = {};
+    uint8_t dataBytes[MULTI_BUS_MAX] = {};
+    for (uint8_t b = 0; b < busCount; ++b) {
+      controls[b] = cmd::makeControlWrite(cmd::MAIN_CUSTOM_PTR, addresses[b]);
+      dataBytes[b] = cmd::CUSTOM_OPERATING_FUNCTIONS;
+    }
+    Status st[MULTI_BUS_MAX];
+    before = engine.busUs();
+    (void)engine.writeCommands(found, controls, addressBytes, dataBytes, st);
+    uint32_t reading = keepOk(found, st, busCount, buses);
+
+    for (uint8_t b = 0; b < busCount; ++b) {
+      controls[b] = cmd::makeControlRead(cmd::MAIN_CUSTOM_PTR, addresses[b]);
+    }
+    uint8_t bytes[3][MULTI_BUS_MAX] = {};
+    for (uint8_t n = 0; n < 3 && reading != 0; ++n) {
+      (void)engine.readControlBytes(reading, controls, bytes[n], st);
+      reading = keepOk(reading, st, busCount, buses);
+    }
+    for (uint8_t b = 0; b < busCount; ++b) {
+      if ((reading & (1u << b)) != 0) {
+        probes[b].featuresValid = true;
+        probes[b].operatingFunctions = bytes[0][b];
+        probes[b].operatingModeSupport = bytes[1][b];
+        probes[b].specialFeatures = bytes[2][b];
+      }
+    }
+    const uint32_t featuresUs = engine.busUs() - before;
+    report.featuresUs += featuresUs;
+    report.serialUs += featuresUs * popcount(found);
+  }
+
+  for (uint8_t b = 0; b < busCount; ++b) {
+    if ((mask & (1u << b)) == 0) {
+      continue;
+    }
+    const FleetMember& member = members[pick[b]];
+    results[pick[b]] = identity[b].ok() ? member.device->beginFromProbe(member.config, probes[b])
+                                        : identity[b];
+  }
+}
+
+} // namespace
+
+Status beginFleet(MultiBusEngine& engine, const FleetMember* members, size_t count,
+                  Status* results, FleetBootReport& report) {
+  report = FleetBootReport();
+  if (!engine.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Engine not initialized");
+  }
+  if (members == nullptr || results == nullptr || count == 0 || count > 0xFFFF) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid fleet");
+  }
+  const uint8_t busCount = engine.getConfig().busCount;
+  for (size_t i = 0; i < count; ++i) {
+    if (members[i].device == nullptr || members[i].bus >= busCount) {
+      return Status::Error(Err::INVALID_PARAM, "Invalid fleet member", static_cast<int32_t>(i));
+    }
+  }
+  report.members = static_cast<uint16_t>(count);
+
+  const Status pending = Status::Error(Err::IN_PROGRESS, "Bring-up pending");
+  for (size_t i = 0; i < count; ++i) {
+    results[i] = members[i].device->isInitialized()
+                     ? Status::Error(Err::ALREADY_INITIALIZED, "Call end() first")
+                     : pending;
+  }
+
+  BootBuses buses;
+  const uint32_t idle = engine.idleBusesMask();
+
+  // Lockstep rounds: the next pending member of every idle, live bus.
+  while (true) {
+    size_t pick[MULTI_BUS_MAX] = {};
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const uint8_t b = members[i].bus;
+      const uint32_t bit = 1u << b;
+      if ((idle & bit) == 0 || (mask & bit) != 0 || results[i].code != Err::IN_PROGRESS) {
+        continue;
+      }
+      if ((buses.dead & bit) != 0) {
+        results[i] = Status::Error(buses.deadStatus[b].code, "Bus failed earlier in bring-up",
+                                   buses.deadStatus[b].detail);
+        ++report.skipped;
+        continue;
+      }
+      pick[b] = i;
+      mask |= bit;
+    }
+    if (mask == 0) {
+      break;
+    }
+    ++report.rounds;
+    runRound(engine, mask, pick, members, results, report, buses);
+  }
+
+  // Buses that were not idle: each member's own begin() resets the bus first.
+  for (size_t i = 0; i < count; ++i) {
+    if (results[i].code != Err::IN_PROGRESS) {
+      continue;
+    }
+    const uint8_t b = members[i].bus;
+    if ((buses.dead & (1u << b)) != 0) {
+      results[i] = Status::Error(buses.deadStatus[b].code, "Bus failed earlier in bring-up",
+                                 buses.deadStatus[b].detail);
+      ++report.skipped;
+      continue;
+    }
+    results[i] = members[i].device->begin(members[i].config);
+    report.fallbackUs += members[i].device->lastOpInfo().busUs;
+    if (isBusFatal(results[i])) {
+      markDead(buses, b, results[i]);
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (results[i].ok()) {
+      ++report.ready;
+    } else {
+      ++report.failed;
+    }
+  }
+  report.totalUs = report.identityUs + report.featuresUs + report.fallbackUs;
+  if (report.failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Fleet bring-up failed", report.failed);
+  }
+  return Status::Ok();
+}
+
+} // namespace EE871
@@ -0,0 +1,512 @@
+/// @file Metrics.cpp
+/// @brief Implementation of the metrics registry, subsystem registration, and exporters
+
+#include "EE871/Metrics.h"
+
+#include <cstring>
+
+namespace EE871 {
+namespace {
+
+/// OpenMetrics name: [a-zA-Z_:][a-zA-Z0-9_:]*, short enough for the binary frame.
+static bool validName(const char* name) {
+  if (name == nullptr || name[0] == '\0' || (name[0] >= '0' && name[0] <= '9')) {
+    return false;
+  }
+  size_t len = 0;
+  for (const char* c = name; *c != '\0'; ++c, ++len) {
+    const bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+                    (*c >= '0' && *c <= '9') || *c == '_' || *c == ':';
+    if (!ok) {
+      return false;
+    }
+  }
+  return len <= 0xFF;
+}
+
+static MetricLabels labelsOf(uint8_t deviceAddress, uint8_t bus, uint8_t instance) {
+  MetricLabels labels;
+  labels.deviceAddress = deviceAddress;
+  labels.bus = bus;
+  labels.instance = instance;
+  return labels;
+}
+
+/// Sampled metric of one group registered by a register*Metrics() helper.
+struct SampledDef {
+  MetricKind kind;
+  const char* name;
+  const char* help;
+  MetricSampleFn sample;
+};
+
+static Status addGroup(MetricsRegistry& registry, const SampledDef* defs, size_t count,
+                       const MetricLabels& labels, const void* source, uint16_t index) {
+  for (size_t i = 0; i < count; ++i) {
+    const Status st = registry.addSampled(defs[i].kind, defs[i].name, defs[i].help, labels,
+                                          defs[i].sample, source, index);
+    if (!st.ok()) {
+      return st;
+    }
+  }
+  return Status::Ok();
+}
+
+static const EE871& driverOf(const void* source) { return *static_cast<const EE871*>(source); }
+
+static const SampledDef kDriverMetrics[] = {
+    {MetricKind::COUNTER, "ee871_success", "Tracked successful driver operations.",
+     [](const void* s, uint16_t) -> int64_t { return driverOf(s).totalSuccess(); }},
+    {MetricKind::COUNTER, "ee871_failures", "Tracked failed driver operations.",
+     [](const void* s, uint16_t) -> int64_t { return driverOf(s).totalFailures(); }},
+    {MetricKind::GAUGE, "ee871_consecutive_failures", "Failures since the last success.",
+     [](const void* s, uint16_t) -> int64_t { return driverOf(s).consecutiveFailures(); }},
+    {MetricKind::GAUGE, "ee871_state", "DriverState (0 uninit, 1 ready, 2 degraded, 3 offline).",
+     [](const void* s, uint16_t) -> int64_t {
+       return static_cast<int64_t>(driverOf(s).state());
+     }},
+    {MetricKind::COUNTER, "ee871_elided_transactions", "MV4 high-byte reads skipped.",
+     [](const void* s, uint16_t) -> int64_t { return driverOf(s).elidedTransactions(); }},
+    {MetricKind::GAUGE, "ee871_last_op_bus_us", "Line time of the most recent driver call.",
+     [](const void* s, uint16_t) -> int64_t { return driverOf(s).lastOpInfo().busUs; }},
+};
+
+static const QuotaStats& quotaOf(const void* source, uint16_t client) {
+  return static_cast<const BusQuota*>(source)->stats(static_cast<uint8_t>(client));
+}
+
+static const SampledDef kQuotaMetrics[] = {
+    {MetricKind::COUNTER, "ee871_quota_admitted", "Quota calls that reached the bus.",
+     [](const void* s, uint16_t i) -> int64_t { return quotaOf(s, i).admitted; }},
+    {MetricKind::COUNTER, "ee871_quota_deferred", "Quota calls refused with BUSY.",
+     [](const void* s, uint16_t i) -> int64_t { return quotaOf(s, i).deferred; }},
+    {MetricKind::COUNTER, "ee871_quota_cache_hits", "Measurements served from the quota cache.",
+     [](const void* s, uint16_t i) -> int64_t { return quotaOf(s, i).cacheHits; }},
+    {MetricKind::COUNTER, "ee871_quota_consumed_us", "Bus time charged to the client.",
+     [](const void* s, uint16_t i) -> int64_t {
+       return static_cast<int64_t>(quotaOf(s, i).consumedUs);
+     }},
+    {MetricKind::GAUGE, "ee871_quota_balance_us", "Token balance; negative is debt.",
+     [](const void* s, uint16_t i) -> int64_t { return quotaOf(s, i).balanceUs; }},
+};
+
+static const CyclicStats& cyclicOf(const void* source) {
+  return static_cast<const CyclicExecutor*>(source)->stats();
+}
+
+static const SampledDef kCyclicMetrics[] = {
+    {MetricKind::COUNTER, "ee871_cyclic_cycles", "Completed major cycles.",
+     [](const void* s, uint16_t) -> int64_t { return cyclicOf(s).cycles; }},
+    {MetricKind::COUNTER, "ee871_cyclic_executed", "Schedule slots polled.",
+     [](const void* s, uint16_t) -> int64_t { return cyclicOf(s).executed; }},
+    {MetricKind::COUNTER, "ee871_cyclic_failed", "Polled slots that failed.",
+     [](const void* s, uint16_t) -> int64_t { return cyclicOf(s).failed; }},
+    {MetricKind::COUNTER, "ee871_cyclic_skipped", "Slots dropped after their minor frame.",
+     [](const void* s, uint16_t) -> int64_t { return cyclicOf(s).skipped; }},
+    {MetricKind::GAUGE, "ee871_cyclic_max_lateness_us", "Worst poll start after release.",
+     [](const void* s, uint16_t) -> int64_t { return cyclicOf(s).maxLatenessUs; }},
+};
+
+template <size_t N>
+static constexpr size_t countOf(const SampledDef (&)[N]) {
+  return N;
+}
+
+/// Byte writer that keeps counting past the end so callers learn the needed size.
+struct ByteSink {
+  uint8_t* out;
+  size_t capacity;
+  size_t len = 0;
+
+  void put(uint8_t b) {
+    if (len < capacity) {
+      out[len] = b;
+    }
+    ++len;
+  }
+  void putLe(uint64_t v, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; ++i) {
+      put(static_cast<uint8_t>(v >> (8U * i)));
+    }
+  }
+};
+
+} // namespace
+
+Status MetricsRegistry::begin(Metric* slots, size_t capacity) {
+  end();
+  if (slots == nullptr || capacity == 0 || capacity > 0xFFFF) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid metric storage");
+  }
+  _slots = slots;
+  _capacity = capacity;
+  return Status::Ok();
+}
+
+void MetricsRegistry::end() {
+  _slots = nullptr;
+  _capacity = 0;
+  _size = 0;
+}
+
+Status MetricsRegistry::_append(MetricKind kind, const char* name, const char* help,
+                                const MetricLabels& labels, Metric*& slot) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Metrics registry not initialized");
+  }
+  if (!validName(name)) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid metric name");
+  }
+  if (_size >= _capacity) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics registry full",
+                         static_cast<int32_t>(_capacity));
+  }
+  slot = &_slots[_size++];
+  *slot = Metric();
+  slot->kind = kind;
+  slot->name = name;
+  slot->help = (help != nullptr) ? help : "";
+  slot->labels = labels;
+  return Status::Ok();
+}
+
+Status MetricsRegistry::addValue(MetricKind kind, const char* name, const char* help,
+                                 const MetricLabels& labels, uint16_t& id) {
+  if (kind == MetricKind::HISTOGRAM) {
+    return Status::Error(Err::INVALID_PARAM, "Use addHistogram()");
+  }
+  Metric* slot = nullptr;
+  const Status st = _append(kind, name, help, labels, slot);
+  if (st.ok()) {
+    id = static_cast<uint16_t>(_size - 1U);
+  }
+  return st;
+}
+
+Status MetricsRegistry::addSampled(MetricKind kind, const char* name, const char* help,
+                                   const MetricLabels& labels, MetricSampleFn sample,
+                                   const void* source, uint16_t index) {
+  if (kind == MetricKind::HISTOGRAM || sample == nullptr) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid sampled metric");
+  }
+  Metric* slot = nullptr;
+  const Status st = _append(kind, name, help, labels, slot);
+  if (st.ok()) {
+    slot->sample = sample;
+    slot->source = source;
+    slot->sourceIndex = index;
+  }
+  return st;
+}
+
+Status MetricsRegistry::addHistogram(const char* name, const char* help,
+                                     const MetricLabels& labels, const uint32_t* bounds,
+                                     uint8_t boundCount, uint16_t& id) {
+  if (bounds == nullptr || boundCount == 0 || boundCount > METRIC_BUCKETS_MAX) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid histogram bounds");
+  }
+  for (uint8_t i = 1; i < boundCount; ++i) {
+    if (bounds[i] <= bounds[i - 1U]) {
+      return Status::Error(Err::INVALID_PARAM, "Histogram bounds not ascending", i);
+    }
+  }
+  Metric* slot = nullptr;
+  const Status st = _append(MetricKind::HISTOGRAM, name, help, labels, slot);
+  if (st.ok()) {
+    slot->bounds = bounds;
+    slot->boundCount = boundCount;
+    id = static_cast<uint16_t>(_size - 1U);
+  }
+  return st;
+}
+
+void MetricsRegistry::add(uint16_t id, int64_t delta) {
+  if (id < _size && _slots[id].kind != MetricKind::HISTOGRAM && _slots[id].sample == nullptr) {
+    _slots[id].value += delta;
+  }
+}
+
+void MetricsRegistry::set(uint16_t id, int64_t value) {
+  if (id < _size && _slots[id].kind == MetricKind::GAUGE && _slots[id].sample == nullptr) {
+    _slots[id].value = value;
+  }
+}
+
+void MetricsRegistry::observe(uint16_t id, uint32_t value) {
+  if (id >= _size || _slots[id].kind != MetricKind::HISTOGRAM) {
+    return;
+  }
+  Metric& m = _slots[id];
+  uint8_t bucket = 0;
+  while (bucket < m.boundCount && value > m.bounds[bucket]) {
+    ++bucket;
+  }
+  ++m.buckets[bucket];
+  m.sum += value;
+}
+
+int64_t MetricsRegistry::value(size_t i) const {
+  const Metric& m = _slots[i];
+  if (m.kind == MetricKind::HISTOGRAM) {
+    int64_t count = 0;
+    for (uint8_t b = 0; b <= m.boundCount; ++b) {
+      count += m.buckets[b];
+    }
+    return count;
+  }
+  return (m.sample != nullptr) ? m.sample(m.source, m.sourceIndex) : m.value;
+}
+
+// ============================================================================
+// Subsystem registration
+// ============================================================================
+
+Status registerDriverMetrics(MetricsRegistry& registry, const EE871& device, uint8_t bus) {
+  if (registry.isInitialized() && registry.remaining() < countOf(kDriverMetrics)) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics registry full",
+                         static_cast<int32_t>(countOf(kDriverMetrics)));
+  }
+  const MetricLabels labels =
+      labelsOf(device.getConfig().deviceAddress, bus, METRIC_LABEL_NONE);
+  return addGroup(registry, kDriverMetrics, countOf(kDriverMetrics), labels, &device, 0);
+}
+
+Status registerQuotaMetrics(MetricsRegistry& registry, const BusQuota& quota, uint8_t bus) {
+  const size_t needed = countOf(kQuotaMetrics) * quota.clientCount();
+  if (registry.isInitialized() && registry.remaining() < needed) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics registry full",
+                         static_cast<int32_t>(needed));
+  }
+  for (uint8_t client = 0; client < quota.clientCount(); ++client) {
+    const Status st = addGroup(registry, kQuotaMetrics, countOf(kQuotaMetrics),
+                               labelsOf(METRIC_LABEL_NONE, bus, client), &quota, client);
+    if (!st.ok()) {
+      return st;
+    }
+  }
+  return Status::Ok();
+}
+
+Status registerCyclicMetrics(MetricsRegistry& registry, const CyclicExecutor& executor) {
+  if (registry.isInitialized() && registry.remaining() < countOf(kCyclicMetrics)) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics registry full",
+                         static_cast<int32_t>(countOf(kCyclicMetrics)));
+  }
+  return addGroup(registry, kCyclicMetrics, countOf(kCyclicMetrics), MetricLabels(), &executor,
+                  0);
+}
+
+// ============================================================================
+// Exporters
+// ============================================================================
+
+Status exportMetricsBinary(const MetricsRegistry& registry, uint8_t* out, size_t capacity,
+                           size_t& written) {
+  written = 0;
+  if (!registry.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Metrics registry not initialized");
+  }
+  ByteSink sink{out, (out != nullptr) ? capacity : 0};
+  sink.put(metrics_frame::MAGIC_0);
+  sink.put(metrics_frame::MAGIC_1);
+  sink.put(metrics_frame::VERSION);
+  sink.putLe(registry.size(), 2);
+  for (size_t i = 0; i < registry.size(); ++i) {
+    const Metric& m = registry.at(i);
+    const size_t nameLen = std::strlen(m.name);
+    sink.put(static_cast<uint8_t>(m.kind));
+    sink.put(m.labels.deviceAddress);
+    sink.put(m.labels.bus);
+    sink.put(m.labels.instance);
+    sink.put(static_cast<uint8_t>(nameLen));
+    for (size_t c = 0; c < nameLen; ++c) {
+      sink.put(static_cast<uint8_t>(m.name[c]));
+    }
+    if (m.kind != MetricKind::HISTOGRAM) {
+      sink.putLe(static_cast<uint64_t>(registry.value(i)), 8);
+      continue;
+    }
+    sink.put(m.boundCount);
+    for (uint8_t b = 0; b < m.boundCount; ++b) {
+      sink.putLe(m.bounds[b], 4);
+    }
+    for (uint8_t b = 0; b <= m.boundCount; ++b) {
+      sink.putLe(m.buckets[b], 4);
+    }
+    sink.putLe(m.sum, 8);
+  }
+  written = sink.len;
+  if (sink.len > sink.capacity) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics buffer too small",
+                         static_cast<int32_t>(sink.len));
+  }
+  return Status::Ok();
+}
+
+#if EE871_METRICS_TEXT
+namespace {
+
+/// Text writer that keeps counting past the end so callers learn the needed size.
+struct TextSink {
+  char* out;
+  size_t capacity;
+  size_t len = 0;
+
+  void put(char c) {
+    if (len < capacity) {
+      out[len] = c;
+    }
+    ++len;
+  }
+  void put(const char* s) {
+    for (; *s != '\0'; ++s) {
+      put(*s);
+    }
+  }
+  void putU(uint64_t v) {
+    char digits[20];
+    uint8_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + (v % 10U));
+      v /= 10U;
+    } while (v != 0);
+    while (n != 0) {
+      put(digits[--n]);
+    }
+  }
+  void putI(int64_t v) {
+    if (v < 0) {
+      put('-');
+      putU(0U - static_cast<uint64_t>(v));
+    } else {
+      putU(static_cast<uint64_t>(v));
+    }
+  }
+};
+
+static void putLabel(TextSink& sink, bool& first, const char* key, uint8_t value) {
+  if (value == METRIC_LABEL_NONE) {
+    return;
+  }
+  sink.put(first ? '{' : ',');
+  first = false;
+  sink.put(key);
+  sink.put("=\"");
+  sink.putU(value);
+  sink.put('"');
+}
+
+/// name + suffix + labels (+ le) + ' '.
+static void putSeries(TextSink& sink, const Metric& m, const char* suffix, const char* le,
+                      uint32_t leValue) {
+  sink.put(m.name);
+  sink.put(suffix);
+  bool first = true;
+  putLabel(sink, first, "device", m.labels.deviceAddress);
+  putLabel(sink, first, "bus", m.labels.bus);
+  putLabel(sink, first, "instance", m.labels.instance);
+  if (le != nullptr) {
+    sink.put(first ? '{' : ',');
+    first = false;
+    sink.put("le=\"");
+    if (le[0] != '\0') {
+      sink.put(le);
+    } else {
+      sink.putU(leValue);
+    }
+    sink.put('"');
+  }
+  if (!first) {
+    sink.put('}');
+  }
+  sink.put(' ');
+}
+
+static void putSamples(TextSink& sink, const MetricsRegistry& registry, size_t i) {
+  const Metric& m = registry.at(i);
+  if (m.kind != MetricKind::HISTOGRAM) {
+    putSeries(sink, m, (m.kind == MetricKind::COUNTER) ? "_total" : "", nullptr, 0);
+    sink.putI(registry.value(i));
+    sink.put('\n');
+    return;
+  }
+  uint64_t cumulative = 0;
+  for (uint8_t b = 0; b <= m.boundCount; ++b) {
+    cumulative += m.buckets[b];
+    putSeries(sink, m, "_bucket", (b < m.boundCount) ? "" : "+Inf",
+              (b < m.boundCount) ? m.bounds[b] : 0);
+    sink.putU(cumulative);
+    sink.put('\n');
+  }
+  putSeries(sink, m, "_count", nullptr, 0);
+  sink.putU(cumulative);
+  sink.put('\n');
+  putSeries(sink, m, "_sum", nullptr, 0);
+  sink.putU(m.sum);
+  sink.put('\n');
+}
+
+static const char* typeName(MetricKind kind) {
+  switch (kind) {
+    case MetricKind::COUNTER:
+      return "counter";
+    case MetricKind::GAUGE:
+      return "gauge";
+    case MetricKind::HISTOGRAM:
+      return "histogram";
+  }
+  return "unknown";
+}
+
+} // namespace
+
+Status exportMetricsText(const MetricsRegistry& registry, char* out, size_t capacity,
+                         size_t& written) {
+  written = 0;
+  if (!registry.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Metrics registry not initialized");
+  }
+  TextSink sink{out, (out != nullptr) ? capacity : 0};
+  // OpenMetrics wants each family contiguous; registration interleaves
+  // families across devices, so each family is emitted at its first slot.
+  for (size_t i = 0; i < registry.size(); ++i) {
+    const Metric& m = registry.at(i);
+    bool seen = false;
+    for (size_t j = 0; j < i && !seen; ++j) {
+      seen = std::strcmp(registry.at(j).name, m.name) == 0;
+    }
+    if (seen) {
+      continue;
+    }
+    sink.put("# TYPE ");
+    sink.put(m.name);
+    sink.put(' ');
+    sink.put(typeName(m.kind));
+    sink.put('\n');
+    if (m.help[0] != '\0') {
+      sink.put("# HELP ");
+      sink.put(m.name);
+      sink.put(' ');
+      sink.put(m.help);
+      sink.put('\n');
+    }
+    for (size_t k = i; k < registry.size(); ++k) {
+      if (std::strcmp(registry.at(k).name, m.name) == 0) {
+        putSamples(sink, registry, k);
+      }
+    }
+  }
+  sink.put("# EOF\n");
+  written = sink.len;
+  if (sink.capacity != 0) {
+    sink.out[(sink.len < sink.capacity) ? sink.len : sink.capacity - 1U] = '\0';
+  }
+  if (sink.len + 1U > sink.capacity) {
+    return Status::Error(Err::OUT_OF_RANGE, "Metrics buffer too small",
+                         static_cast<int32_t>(sink.len + 1U));
+  }
+  return Status::Ok();
+}
+#endif
+
+} // namespace EE871
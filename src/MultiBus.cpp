@@ -0,0 +1,472 @@
+/// @file MultiBus.cpp
+/// @brief Implementation of the lockstep multi-bus E2 bit engine
+
+#include "EE871/MultiBus.h"
+#include "EE871/ConfigBuilder.h"
+#include "EE871/Placement.h"
+
+#include "ActivityScope.h"
+
+#include <limits>
+
+namespace EE871 {
+namespace {
+
+static constexpr uint32_t kPollStepUs = cmd::POLL_STEP_US;
+static constexpr uint32_t kDataSetupUs = cmd::DATA_SETUP_US;
+static constexpr uint32_t kAllLevelsHigh = 0xFFFFFFFFu;
+
+static uint8_t calcPecRead(uint8_t controlByte, uint8_t dataByte) {
+  return static_cast<uint8_t>((controlByte + dataByte) & 0xFF);
+}
+
+static uint8_t calcPecWrite(uint8_t controlByte, uint8_t addressByte, uint8_t dataByte) {
+  return static_cast<uint8_t>((controlByte + addressByte + dataByte) & 0xFF);
+}
+
+} // namespace
+
+/// Per-transaction lockstep state: which buses are still running and their
+/// byte-timeout accounting.
+struct MultiBusEngine::Lockstep {
+  explicit Lockstep(const MultiBusConfig& cfgIn, Status* resultsIn)
+      : cfg(cfgIn), results(resultsIn) {}
+
+  const MultiBusConfig& cfg;
+  Status* results;
+  uint32_t started = 0;  ///< Buses that received START and need STOP.
+  uint32_t active = 0;   ///< Buses still running the transaction.
+  uint32_t failed = 0;   ///< Buses that failed at any phase.
+  uint32_t elapsedUs[MULTI_BUS_MAX] = {};
+  uint32_t wallUs = 0;   ///< All shared delays of this transaction.
+
+  EE871_IRAM_ATTR void setScl(uint32_t mask, uint32_t levels) {
+    if (mask != 0) {
+      cfg.setScl(mask, levels, cfg.portUser);
+    }
+  }
+
+  EE871_IRAM_ATTR void setSda(uint32_t mask, uint32_t levels) {
+    if (mask != 0) {
+      cfg.setSda(mask, levels, cfg.portUser);
+    }
+  }
+
+  EE871_IRAM_ATTR uint32_t readScl() { return cfg.readScl(cfg.portUser); }
+  EE871_IRAM_ATTR uint32_t readSda() { return cfg.readSda(cfg.portUser); }
+
+  EE871_IRAM_ATTR void delay(uint32_t us, uint32_t chargeMask) {
+    cfg.delayUs(us, cfg.portUser);
+    wallUs += us;
+    for (uint8_t i = 0; i < cfg.busCount; ++i) {
+      if ((chargeMask & (1u << i)) == 0) {
+        continue;
+      }
+      const uint32_t room = std::numeric_limits<uint32_t>::max() - elapsedUs[i];
+      elapsedUs[i] = (us > room) ? std::numeric_limits<uint32_t>::max() : (elapsedUs[i] + us);
+    }
+  }
+
+  EE871_IRAM_ATTR void resetByteTimers() {
+    for (uint8_t i = 0; i < MULTI_BUS_MAX; ++i) {
+      elapsedUs[i] = 0;
+    }
+  }
+
+  EE871_IRAM_ATTR void fail(uint32_t mask, const Status& st) {
+    mask &= active;
+    for (uint8_t i = 0; i < cfg.busCount; ++i) {
+      if ((mask & (1u << i)) != 0) {
+        results[i] = st;
+      }
+    }
+    active &= ~mask;
+    failed |= mask;
+  }
+
+  /// Wait for released SCL on @p mask; returns buses still low at timeout.
+  EE871_IRAM_ATTR uint32_t waitSclHigh(uint32_t mask, bool byteTimeout) {
+    uint32_t waitedUs = 0;
+    uint32_t low = mask & ~readScl();
+    while (low != 0) {
+      if (waitedUs >= cfg.bitTimeoutUs) {
+        fail(low, Status::Error(Err::TIMEOUT, "Clock stretch timeout",
+                                static_cast<int32_t>(waitedUs)));
+        return low;
+      }
+      if (byteTimeout) {
+        for (uint8_t i = 0; i < cfg.busCount; ++i) {
+          const uint32_t bit = 1u << i;
+          if ((low & bit) == 0) {
+            continue;
+          }
+          const uint32_t remaining =
+              (elapsedUs[i] < cfg.byteTimeoutUs) ? (cfg.byteTimeoutUs - elapsedUs[i]) : 0U;
+          if (remaining < kPollStepUs) {
+            fail(bit, Status::Error(Err::TIMEOUT, "Byte timeout",
+                                    static_cast<int32_t>(elapsedUs[i])));
+            low &= ~bit;
+          }
+        }
+        if (low == 0) {
+          break;
+        }
+      }
+      delay(kPollStepUs, low);
+      waitedUs += kPollStepUs;
+      low &= ~readScl();
+    }
+    return 0;
+  }
+
+  /// Rise SCL on active buses and park any bus that fails to follow.
+  EE871_IRAM_ATTR void clockHighPhase(bool byteTimeout) {
+    setScl(active, kAllLevelsHigh);
+    const uint32_t before = active;
+    waitSclHigh(active, byteTimeout);
+    setScl(before & ~active, 0);
+  }
+
+  EE871_IRAM_ATTR void start(uint32_t mask) {
+    started = mask;
+    active = mask;
+    setSda(active, kAllLevelsHigh);
+    clockHighPhase(false);
+    delay(cfg.startHoldUs, 0);
+    setSda(active, 0);
+    delay(cfg.startHoldUs, 0);
+    setScl(active, 0);
+    delay(cfg.clockLowUs, 0);
+  }
+
+  EE871_IRAM_ATTR void stop() {
+    setSda(started, 0);
+    delay(kDataSetupUs, 0);
+    setScl(started, kAllLevelsHigh);
+    waitSclHigh(started, false);
+    delay(cfg.stopHoldUs, 0);
+    setSda(started, kAllLevelsHigh);
+    delay(cfg.stopHoldUs, 0);
+  }
+
+  EE871_IRAM_ATTR void writeBit(uint32_t levels) {
+    setSda(active, levels);
+    delay(kDataSetupUs, active);
+    clockHighPhase(true);
+    delay(cfg.clockHighUs, active);
+    setScl(active, 0);
+    delay(cfg.clockLowUs, active);
+  }
+
+  EE871_IRAM_ATTR uint32_t readBit() {
+    setSda(active, kAllLevelsHigh);
+    delay(kDataSetupUs, active);
+    clockHighPhase(true);
+    const uint32_t sampleDelay = cfg.clockHighUs / 2;
+    delay(sampleDelay, active);
+    const uint32_t sample = readSda();
+    delay(cfg.clockHighUs - sampleDelay, active);
+    setScl(active, 0);
+    delay(cfg.clockLowUs, active);
+    return sample;
+  }
+
+  EE871_IRAM_ATTR void writeByte(const uint8_t* values) {
+    resetByteTimers();
+    for (uint8_t bitMask = 0x80; bitMask != 0; bitMask >>= 1) {
+      uint32_t levels = 0;
+      for (uint8_t i = 0; i < cfg.busCount; ++i) {
+        if ((active & (1u << i)) != 0 && (values[i] & bitMask) != 0) {
+          levels |= 1u << i;
+        }
+      }
+      writeBit(levels);
+    }
+  }
+
+  EE871_IRAM_ATTR void readByte(uint8_t* values) {
+    resetByteTimers();
+    for (uint8_t i = 0; i < cfg.busCount; ++i) {
+      if ((active & (1u << i)) != 0) {
+        values[i] = 0;
+      }
+    }
+    for (uint8_t bitMask = 0x80; bitMask != 0; bitMask >>= 1) {
+      const uint32_t sample = readBit();
+      for (uint8_t i = 0; i < cfg.busCount; ++i) {
+        if ((active & sample & (1u << i)) != 0) {
+          values[i] = static_cast<uint8_t>(values[i] | bitMask);
+        }
+      }
+    }
+  }
+
+  EE871_IRAM_ATTR void readAck(const char* nackMessage) {
+    const uint32_t sample = readBit();
+    fail(active & sample, Status::Error(Err::NACK, nackMessage));
+  }
+
+  EE871_IRAM_ATTR void sendAck(bool ack) {
+    setSda(active, ack ? 0 : kAllLevelsHigh);
+    delay(kDataSetupUs, active);
+    clockHighPhase(true);
+    delay(cfg.clockHighUs, active);
+    setScl(active, 0);
+    delay(cfg.clockLowUs, active);
+    setSda(active, kAllLevelsHigh);
+  }
+};
+
+Status MultiBusEngine::begin(const MultiBusConfig& config) {
+  _initialized = false;
+  _config = MultiBusConfig{};
+
+  if (config.setScl == nullptr || config.setSda == nullptr ||
+      config.readScl == nullptr || config.readSda == nullptr ||
+      config.delayUs == nullptr) {
+    return Status::Error(Err::INVALID_CONFIG, "Missing port callbacks");
+  }
+  if (config.busCount == 0 || config.busCount > MULTI_BUS_MAX) {
+    return Status::Error(Err::INVALID_CONFIG, "Invalid bus count", config.busCount);
+  }
+  if (config.clockLowUs < 100 || config.clockHighUs < 100) {
+    return Status::Error(Err::INVALID_CONFIG, "Clock timing below spec");
+  }
+  if (config.startHoldUs < 4 || config.stopHoldUs < 4) {
+    return Status::Error(Err::INVALID_CONFIG, "Start/stop hold below spec");
+  }
+  if (config.bitTimeoutUs == 0 || config.byteTimeoutUs == 0) {
+    return Status::Error(Err::INVALID_CONFIG, "Timeouts must be non-zero");
+  }
+  if (config.byteTimeoutUs < config.bitTimeoutUs) {
+    return Status::Error(Err::INVALID_CONFIG, "byteTimeoutUs must be >= bitTimeoutUs");
+  }
+
+  _config = config;
+  TimingConfig timing;
+  timing.clockLowUs = config.clockLowUs;
+  timing.clockHighUs = config.clockHighUs;
+  timing.startHoldUs = config.startHoldUs;
+  timing.stopHoldUs = config.stopHoldUs;
+  timing.bitTimeoutUs = config.bitTimeoutUs;
+  timing.byteTimeoutUs = config.byteTimeoutUs;
+  const DerivedTiming derived = deriveTiming(timing);
+  _readFrameUs = derived.readFrameUs;
+  _writeFrameUs = derived.writeFrameUs;
+  _busUs = 0;
+  _initialized = true;
+  return Status::Ok();
+}
+
+void MultiBusEngine::end() {
+  _config = MultiBusConfig{};
+  _readFrameUs = 0;
+  _writeFrameUs = 0;
+  _busUs = 0;
+  _initialized = false;
+}
+
+uint32_t MultiBusEngine::idleBusesMask() {
+  if (!_initialized) {
+    return 0;
+  }
+  const uint32_t scl = _config.readScl(_config.portUser);
+  const uint32_t sda = _config.readSda(_config.portUser);
+  return scl & sda & allBusesMask();
+}
+
+uint32_t MultiBusEngine::allBusesMask() const {
+  if (_config.busCount >= MULTI_BUS_MAX) {
+    return kAllLevelsHigh;
+  }
+  return (1u << _config.busCount) - 1u;
+}
+
+Status MultiBusEngine::_checkCall(uint32_t busMask, const void* a, const void* b,
+                                  const void* c) const {
+  if (!_initialized) {
+    return Status::Error(Err::NOT_INITIALIZED, "Engine not initialized");
+  }
+  if (a == nullptr || b == nullptr || c == nullptr) {
+    return Status::Error(Err::INVALID_PARAM, "Null buffer");
+  }
+  if (busMask == 0 || (busMask & ~allBusesMask()) != 0) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid bus mask");
+  }
+  return Status::Ok();
+}
+
+EE871_IRAM_ATTR Status MultiBusEngine::readControlBytes(uint32_t busMask,
+                                                        const uint8_t* controlBytes,
+                                                        uint8_t* data, Status* results) {
+  Status st = _checkCall(busMask, controlBytes, data, results);
+  if (!st.ok()) {
+    return st;
+  }
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    if ((busMask & (1u << i)) != 0) {
+      results[i] = Status::Ok();
+    }
+  }
+
+  uint8_t pec[MULTI_BUS_MAX] = {};
+  Lockstep ls(_config, results);
+  {
+    ActivityScope<MultiBusConfig> activity(_config, _readFrameUs);
+    ls.start(busMask);
+
+    ls.writeByte(controlBytes);
+    ls.readAck("Control byte NACK");
+
+    ls.readByte(data);
+    ls.sendAck(true);
+
+    ls.readByte(pec);
+    ls.sendAck(false);
+
+    ls.stop();
+  }
+  _busUs += ls.wallUs;
+
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    const uint32_t bit = 1u << i;
+    if ((ls.active & bit) != 0 && pec[i] != calcPecRead(controlBytes[i], data[i])) {
+      ls.fail(bit, Status::Error(Err::PEC_MISMATCH, "PEC mismatch", pec[i]));
+    }
+  }
+
+  if (ls.failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Lockstep transfer failed",
+                         static_cast<int32_t>(ls.failed));
+  }
+  return Status::Ok();
+}
+
+Status MultiBusEngine::readCommand(uint32_t busMask, uint8_t mainCommandNibble,
+                                   const uint8_t* deviceAddresses, uint8_t* data,
+                                   Status* results) {
+  Status st = _checkCall(busMask, deviceAddresses, data, results);
+  if (!st.ok()) {
+    return st;
+  }
+  if (mainCommandNibble > 0x0F) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid main command");
+  }
+  if (!cmd::isReadMainCommandSupported(mainCommandNibble)) {
+    return Status::Error(Err::NOT_SUPPORTED, "Unsupported EE871 main command",
+                         mainCommandNibble);
+  }
+
+  uint8_t controls[MULTI_BUS_MAX] = {};
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    if ((busMask & (1u << i)) != 0) {
+      controls[i] = cmd::makeControlRead(mainCommandNibble, deviceAddresses[i]);
+    }
+  }
+  return readControlBytes(busMask, controls, data, results);
+}
+
+Status MultiBusEngine::readU16(uint32_t busMask, uint8_t mainCommandLow,
+                               uint8_t mainCommandHigh, const uint8_t* deviceAddresses,
+                               uint16_t* values, Status* results) {
+  Status st = _checkCall(busMask, deviceAddresses, values, results);
+  if (!st.ok()) {
+    return st;
+  }
+  if (mainCommandLow > 0x0F || mainCommandHigh > 0x0F) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid main command");
+  }
+  if (!cmd::isReadMainCommandSupported(mainCommandLow) ||
+      !cmd::isReadMainCommandSupported(mainCommandHigh)) {
+    return Status::Error(Err::NOT_SUPPORTED, "Unsupported EE871 main command");
+  }
+
+  uint8_t low[MULTI_BUS_MAX] = {};
+  uint8_t high[MULTI_BUS_MAX] = {};
+  (void)readCommand(busMask, mainCommandLow, deviceAddresses, low, results);
+
+  uint32_t lowOk = 0;
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    if ((busMask & (1u << i)) != 0 && results[i].ok()) {
+      lowOk |= 1u << i;
+    }
+  }
+  if (lowOk != 0) {
+    (void)readCommand(lowOk, mainCommandHigh, deviceAddresses, high, results);
+  }
+
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    const uint32_t bit = 1u << i;
+    if ((busMask & bit) == 0) {
+      continue;
+    }
+    if (results[i].ok()) {
+      values[i] = static_cast<uint16_t>(low[i]) | (static_cast<uint16_t>(high[i]) << 8);
+    } else {
+      failed |= bit;
+    }
+  }
+  if (failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Lockstep transfer failed",
+                         static_cast<int32_t>(failed));
+  }
+  return Status::Ok();
+}
+
+EE871_IRAM_ATTR Status MultiBusEngine::writeCommands(uint32_t busMask,
+                                                     const uint8_t* controlBytes,
+                                                     const uint8_t* addressBytes,
+                                                     const uint8_t* dataBytes, Status* results,
+                                                     uint32_t* acceptedMask) {
+  if (acceptedMask != nullptr) {
+    *acceptedMask = 0;
+  }
+  Status st = _checkCall(busMask, controlBytes, addressBytes, results);
+  if (!st.ok()) {
+    return st;
+  }
+  if (dataBytes == nullptr) {
+    return Status::Error(Err::INVALID_PARAM, "Null buffer");
+  }
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    if ((busMask & (1u << i)) != 0) {
+      results[i] = Status::Ok();
+    }
+  }
+
+  uint8_t pec[MULTI_BUS_MAX] = {};
+  for (uint8_t i = 0; i < _config.busCount; ++i) {
+    pec[i] = calcPecWrite(controlBytes[i], addressBytes[i], dataBytes[i]);
+  }
+
+  Lockstep ls(_config, results);
+  {
+    ActivityScope<MultiBusConfig> activity(_config, _writeFrameUs);
+    ls.start(busMask);
+
+    ls.writeByte(controlBytes);
+    ls.readAck("Control byte NACK");
+    ls.writeByte(addressBytes);
+    ls.readAck("Address byte NACK");
+    ls.writeByte(dataBytes);
+    ls.readAck("Data byte NACK");
+    ls.writeByte(pec);
+    ls.readAck("PEC NACK");
+
+    if (acceptedMask != nullptr) {
+      *acceptedMask = ls.active;
+    }
+
+    ls.stop();
+  }
+  _busUs += ls.wallUs;
+
+  if (ls.failed != 0) {
+    return Status::Error(Err::E2_ERROR, "Lockstep transfer failed",
+                         static_cast<int32_t>(ls.failed));
+  }
+  return Status::Ok();
+}
+
+} // namespace EE871
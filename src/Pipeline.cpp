@@ -0,0 +1,106 @@
+/// @file Pipeline.cpp
+/// @brief Implementation of the non-template pipeline stages
+
+#include "EE871/Pipeline.h"
+
+namespace EE871 {
+
+bool EmaFilter::process(PipelineSample& s) {
+  if (!_seeded) {
+    _acc = static_cast<uint32_t>(s.ppm) << _shift;
+    _seeded = true;
+  } else {
+    // acc += ppm - acc / 2^shift, so acc / 2^shift moves 1/2^shift of the way.
+    _acc = _acc - (_acc >> _shift) + s.ppm;
+  }
+  const uint32_t half = (_shift == 0) ? 0 : (1U << (_shift - 1U));
+  s.ppm = static_cast<uint16_t>((_acc + half) >> _shift);
+  return true;
+}
+
+size_t EmaFilter::processBatch(PipelineSample* samples, size_t count) {
+  // The recurrence is serial; the batch form only saves the per-sample dispatch.
+  for (size_t i = 0; i < count; ++i) {
+    (void)process(samples[i]);
+  }
+  return count;
+}
+
+bool PpmStatsStage::process(PipelineSample& s) {
+  _sum += s.ppm;
+  ++_count;
+  _min = (s.ppm < _min) ? s.ppm : _min;
+  _max = (s.ppm > _max) ? s.ppm : _max;
+  return true;
+}
+
+size_t PpmStatsStage::processBatch(PipelineSample* samples, size_t count) {
+  // Local accumulators keep the loop free of stores to members.
+  uint64_t sum = 0;
+  uint16_t lo = _min;
+  uint16_t hi = _max;
+  for (size_t i = 0; i < count; ++i) {
+    const uint16_t ppm = samples[i].ppm;
+    sum += ppm;
+    lo = (ppm < lo) ? ppm : lo;
+    hi = (ppm > hi) ? ppm : hi;
+  }
+  _sum += sum;
+  _count += count;
+  _min = lo;
+  _max = hi;
+  return count;
+}
+
+fleet::PpmStats PpmStatsStage::stats() const {
+  fleet::PpmStats out;
+  if (_count == 0) {
+    return out;
+  }
+  out.count = _count;
+  out.min = _min;
+  out.max = _max;
+  out.sum = _sum;
+  out.mean = static_cast<uint16_t>((_sum + _count / 2U) / _count);
+  return out;
+}
+
+bool ThresholdEvents::process(PipelineSample& s) {
+  PpmEvent event;
+  if (!_above && s.ppm >= _high) {
+    _above = true;
+    event = PpmEvent::ABOVE;
+  } else if (_above && s.ppm <= _low) {
+    _above = false;
+    event = PpmEvent::BELOW;
+  } else {
+    return true;
+  }
+  ++_events;
+  if (_callback != nullptr) {
+    _callback(event, s, _user);
+  }
+  return true;
+}
+
+bool RecordEncoder::process(PipelineSample& s) {
+  if (_buffer == nullptr || _capacity - _size < RECORD_BYTES) {
+    ++_overflow;
+    return true;
+  }
+  uint8_t* out = _buffer + _size;
+  out[0] = static_cast<uint8_t>(s.timestampMs);
+  out[1] = static_cast<uint8_t>(s.timestampMs >> 8);
+  out[2] = static_cast<uint8_t>(s.timestampMs >> 16);
+  out[3] = static_cast<uint8_t>(s.timestampMs >> 24);
+  out[4] = static_cast<uint8_t>(s.source);
+  out[5] = static_cast<uint8_t>(s.source >> 8);
+  out[6] = static_cast<uint8_t>(s.ppm);
+  out[7] = static_cast<uint8_t>(s.ppm >> 8);
+  out[8] = s.statusByte;
+  out[9] = s.co2Error ? 0x01 : 0x00;
+  _size += RECORD_BYTES;
+  return true;
+}
+
+} // namespace EE871
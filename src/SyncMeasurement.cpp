@@ -0,0 +1,195 @@
+/// @file SyncMeasurement.cpp
+/// @brief Implementation of synchronized multi-sensor measurement triggering
+
+#include "EE871/SyncMeasurement.h"
+
+namespace EE871 {
+namespace {
+
+static Status groupResult(uint32_t failedMask, const char* msg) {
+  if (failedMask == 0) {
+    return Status::Ok();
+  }
+  return Status::Error(Err::E2_ERROR, msg, static_cast<int32_t>(failedMask));
+}
+
+} // namespace
+
+Status SyncMeasurementGroup::begin(EE871* const* devices, size_t count, SyncSample* samples,
+                                   uint32_t conversionMs) {
+  end();
+  if (devices == nullptr || samples == nullptr || count == 0 || count > SYNC_GROUP_MAX) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid sync group");
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (devices[i] == nullptr) {
+      return Status::Error(Err::INVALID_PARAM, "Invalid sync group member",
+                           static_cast<int32_t>(i));
+    }
+    if (!devices[i]->isInitialized()) {
+      return Status::Error(Err::NOT_INITIALIZED, "Sync group member not initialized",
+                           static_cast<int32_t>(i));
+    }
+  }
+  _devices = devices;
+  _samples = samples;
+  _count = static_cast<uint8_t>(count);
+  _memberMask = (count == 32) ? 0xFFFFFFFFu : ((1u << count) - 1u);
+  _conversionMs = conversionMs;
+  return Status::Ok();
+}
+
+Status SyncMeasurementGroup::begin(MultiBusEngine& engine, uint32_t busMask,
+                                   const uint8_t* deviceAddresses, SyncSample* samples,
+                                   uint32_t conversionMs) {
+  end();
+  if (!engine.isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Engine not initialized");
+  }
+  if (deviceAddresses == nullptr || samples == nullptr || busMask == 0 ||
+      (busMask & ~engine.allBusesMask()) != 0) {
+    return Status::Error(Err::INVALID_PARAM, "Invalid sync group");
+  }
+  _engine = &engine;
+  _addresses = deviceAddresses;
+  _samples = samples;
+  _count = engine.getConfig().busCount;
+  _memberMask = busMask;
+  _conversionMs = conversionMs;
+  return Status::Ok();
+}
+
+void SyncMeasurementGroup::end() {
+  _devices = nullptr;
+  _engine = nullptr;
+  _addresses = nullptr;
+  _samples = nullptr;
+  _memberMask = 0;
+  _count = 0;
+  _triggeredMask = 0;
+  _spreadUs = 0;
+  _pending = false;
+}
+
+Status SyncMeasurementGroup::trigger(uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Sync group not initialized");
+  }
+  for (uint8_t i = 0; i < _count; ++i) {
+    if ((_memberMask & (1u << i)) != 0) {
+      _samples[i] = SyncSample();
+    }
+  }
+  _triggeredMask = 0;
+  _spreadUs = 0;
+  _triggerMs = nowMs;
+
+  const Status st = (_engine != nullptr) ? _triggerEngine() : _triggerDevices();
+  _pending = (_triggeredMask != 0);
+  return st;
+}
+
+Status SyncMeasurementGroup::_triggerDevices() {
+  // Offsets accumulate the bus time of the preceding status reads; members on
+  // separate buses driven by separate instances are still read one after another.
+  uint32_t offsetUs = 0;
+  uint32_t firstOffsetUs = 0;
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < _count; ++i) {
+    SyncSample& sample = _samples[i];
+    sample.triggerOffsetUs = offsetUs;
+    sample.status = _devices[i]->readStatus(sample.statusByte);
+    if (sample.status.ok()) {
+      if (_triggeredMask == 0) {
+        firstOffsetUs = offsetUs;
+      }
+      _spreadUs = offsetUs - firstOffsetUs;
+      _triggeredMask |= 1u << i;
+    } else {
+      failed |= 1u << i;
+    }
+    offsetUs += _devices[i]->lastOpInfo().busUs;
+  }
+  return groupResult(failed, "Sync trigger failed");
+}
+
+Status SyncMeasurementGroup::_triggerEngine() {
+  uint8_t status[MULTI_BUS_MAX] = {};
+  Status results[MULTI_BUS_MAX];
+  const Status st = _engine->readCommand(_memberMask, cmd::MAIN_STATUS, _addresses, status,
+                                         results);
+  if (st.code == Err::INVALID_PARAM || st.code == Err::NOT_INITIALIZED) {
+    return st;
+  }
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < _count; ++i) {
+    if ((_memberMask & (1u << i)) == 0) {
+      continue;
+    }
+    _samples[i].status = results[i];
+    _samples[i].statusByte = status[i];
+    if (results[i].ok()) {
+      _triggeredMask |= 1u << i;
+    } else {
+      failed |= 1u << i;
+    }
+  }
+  return groupResult(failed, "Sync trigger failed");
+}
+
+Status SyncMeasurementGroup::collect(uint32_t nowMs) {
+  if (!isInitialized()) {
+    return Status::Error(Err::NOT_INITIALIZED, "Sync group not initialized");
+  }
+  if (!_pending) {
+    return Status::Error(Err::INVALID_PARAM, "No sync trigger pending");
+  }
+  if (static_cast<uint32_t>(nowMs - _triggerMs) < _conversionMs) {
+    return Status::Error(Err::IN_PROGRESS, "Conversion window open",
+                         static_cast<int32_t>(_conversionMs - (nowMs - _triggerMs)));
+  }
+  _pending = false;
+  return (_engine != nullptr) ? _collectEngine() : _collectDevices();
+}
+
+Status SyncMeasurementGroup::_collectDevices() {
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < _count; ++i) {
+    if ((_triggeredMask & (1u << i)) == 0) {
+      continue;
+    }
+    SyncSample& sample = _samples[i];
+    sample.status = _devices[i]->readCo2Average(sample.co2Average);
+    sample.collected = sample.status.ok();
+    if (!sample.collected) {
+      failed |= 1u << i;
+    }
+  }
+  return groupResult(failed, "Sync collect failed");
+}
+
+Status SyncMeasurementGroup::_collectEngine() {
+  uint16_t values[MULTI_BUS_MAX] = {};
+  Status results[MULTI_BUS_MAX];
+  const Status st = _engine->readU16(_triggeredMask, cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI,
+                                     _addresses, values, results);
+  if (st.code == Err::INVALID_PARAM || st.code == Err::NOT_INITIALIZED) {
+    return st;
+  }
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < _count; ++i) {
+    if ((_triggeredMask & (1u << i)) == 0) {
+      continue;
+    }
+    SyncSample& sample = _samples[i];
+    sample.status = results[i];
+    sample.co2Average = values[i];
+    sample.collected = results[i].ok();
+    if (!sample.collected) {
+      failed |= 1u << i;
+    }
+  }
+  return groupResult(failed, "Sync collect failed");
+}
+
+} // namespace EE871
@@ -0,0 +1,308 @@
+/// @file TransportRecorder.cpp
+/// @brief Implementation of the E2 transport recorder and replayer
+
+#include "EE871/TransportRecorder.h"
+
+namespace EE871 {
+namespace {
+
+static constexpr size_t kMaxVarintBytes = 5;
+
+static size_t putVarint(uint8_t* out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = static_cast<uint8_t>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(value);
+  return n;
+}
+
+} // namespace
+
+// ============================================================================
+// TransportRecorder
+// ============================================================================
+
+Status TransportRecorder::begin(const Config& inner, uint8_t* buffer, size_t capacity) {
+  _recording = false;
+  if (inner.setScl == nullptr || inner.setSda == nullptr ||
+      inner.readScl == nullptr || inner.readSda == nullptr ||
+      inner.delayUs == nullptr) {
+    return Status::Error(Err::INVALID_CONFIG, "Missing E2 callbacks");
+  }
+  if (buffer == nullptr || capacity == 0) {
+    return Status::Error(Err::INVALID_PARAM, "Recording buffer required");
+  }
+  _inner = inner;
+  _buffer = buffer;
+  _capacity = capacity;
+  clear();
+  _recording = true;
+  return Status::Ok();
+}
+
+void TransportRecorder::end() {
+  flush();
+  _recording = false;
+}
+
+Config TransportRecorder::config() const {
+  Config cfg = _inner;
+  cfg.setScl = &TransportRecorder::_setSclThunk;
+  cfg.setSda = &TransportRecorder::_setSdaThunk;
+  cfg.readScl = &TransportRecorder::_readSclThunk;
+  cfg.readSda = &TransportRecorder::_readSdaThunk;
+  cfg.delayUs = &TransportRecorder::_delayUsThunk;
+  cfg.busUser = const_cast<TransportRecorder*>(this);
+  cfg.readFrame = nullptr;
+  cfg.writeFrame = nullptr;
+  cfg.waitMs = nullptr;
+  return cfg;
+}
+
+void TransportRecorder::clear() {
+  _size = 0;
+  _overflowed = false;
+  _events = 0;
+  _pendingUs = 0;
+  _pendingCount = 0;
+}
+
+void TransportRecorder::flush() {
+  if (_pendingCount == 0) {
+    return;
+  }
+  uint8_t bytes[1 + 2 * kMaxVarintBytes];
+  size_t len = 0;
+  if (_pendingCount > 1) {
+    bytes[len++] = rec::DELAY_REPEAT;
+    len += putVarint(&bytes[len], _pendingCount);
+    len += putVarint(&bytes[len], _pendingUs);
+  } else if (_pendingUs <= rec::DELAY_SHORT_MAX_US) {
+    bytes[len++] = static_cast<uint8_t>(rec::DELAY_SHORT | _pendingUs);
+  } else {
+    bytes[len++] = rec::DELAY;
+    len += putVarint(&bytes[len], _pendingUs);
+  }
+  _pendingCount = 0;
+  _append(bytes, len);
+}
+
+void TransportRecorder::_append(const uint8_t* bytes, size_t len) {
+  if (!_recording || _overflowed) {
+    return;
+  }
+  if (_capacity - _size < len) {
+    _overflowed = true;
+    return;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    _buffer[_size + i] = bytes[i];
+  }
+  _size += len;
+}
+
+void TransportRecorder::_line(uint8_t op, bool level) {
+  if (!_recording) {
+    return;
+  }
+  flush();
+  const uint8_t byte = static_cast<uint8_t>(op | (level ? 1U : 0U));
+  _append(&byte, 1);
+  ++_events;
+}
+
+void TransportRecorder::_delay(uint32_t us) {
+  if (!_recording) {
+    return;
+  }
+  if (_pendingCount > 0 && us != _pendingUs) {
+    flush();
+  }
+  _pendingUs = us;
+  ++_pendingCount;
+  ++_events;
+}
+
+void TransportRecorder::_setSclThunk(bool level, void* user) {
+  auto* self = static_cast<TransportRecorder*>(user);
+  self->_inner.setScl(level, self->_inner.busUser);
+  self->_line(rec::LINE_SET_SCL, level);
+}
+
+void TransportRecorder::_setSdaThunk(bool level, void* user) {
+  auto* self = static_cast<TransportRecorder*>(user);
+  self->_inner.setSda(level, self->_inner.busUser);
+  self->_line(rec::LINE_SET_SDA, level);
+}
+
+bool TransportRecorder::_readSclThunk(void* user) {
+  auto* self = static_cast<TransportRecorder*>(user);
+  const bool level = self->_inner.readScl(self->_inner.busUser);
+  self->_line(rec::LINE_READ_SCL, level);
+  return level;
+}
+
+bool TransportRecorder::_readSdaThunk(void* user) {
+  auto* self = static_cast<TransportRecorder*>(user);
+  const bool level = self->_inner.readSda(self->_inner.busUser);
+  self->_line(rec::LINE_READ_SDA, level);
+  return level;
+}
+
+void TransportRecorder::_delayUsThunk(uint32_t us, void* user) {
+  auto* self = static_cast<TransportRecorder*>(user);
+  self->_inner.delayUs(us, self->_inner.busUser);
+  self->_delay(us);
+}
+
+// ============================================================================
+// TransportReplayer
+// ============================================================================
+
+Status TransportReplayer::begin(const Config& base, const uint8_t* recording, size_t size) {
+  if (recording == nullptr && size != 0) {
+    return Status::Error(Err::INVALID_PARAM, "Recording data required");
+  }
+  _base = base;
+  _data = recording;
+  _size = size;
+  _pos = 0;
+  _repeatLeft = 0;
+  _repeatUs = 0;
+  _divergences = 0;
+  _firstDivergence = SIZE_MAX;
+  _replayedUs = 0;
+  _exhausted = false;
+  _malformed = false;
+  return Status::Ok();
+}
+
+Config TransportReplayer::config() const {
+  Config cfg = _base;
+  cfg.setScl = &TransportReplayer::_setSclThunk;
+  cfg.setSda = &TransportReplayer::_setSdaThunk;
+  cfg.readScl = &TransportReplayer::_readSclThunk;
+  cfg.readSda = &TransportReplayer::_readSdaThunk;
+  cfg.delayUs = &TransportReplayer::_delayUsThunk;
+  cfg.busUser = const_cast<TransportReplayer*>(this);
+  cfg.readFrame = nullptr;
+  cfg.writeFrame = nullptr;
+  cfg.busActivity = nullptr;
+  cfg.waitMs = nullptr;
+  cfg.quietWindow = nullptr;
+  return cfg;
+}
+
+void TransportReplayer::_diverge(size_t offset) {
+  ++_divergences;
+  if (_firstDivergence == SIZE_MAX) {
+    _firstDivergence = offset;
+  }
+}
+
+bool TransportReplayer::_readVarint(size_t& pos, uint32_t& value) const {
+  value = 0;
+  for (size_t i = 0; i < kMaxVarintBytes; ++i) {
+    if (pos >= _size) {
+      return false;
+    }
+    const uint8_t byte = _data[pos++];
+    value |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TransportReplayer::_line(uint8_t op, bool level) {
+  if (_repeatLeft > 0 || _pos >= _size || _malformed) {
+    if (_repeatLeft > 0) {
+      _diverge(_pos);
+    } else {
+      _exhausted = true;
+    }
+    return true;
+  }
+  const uint8_t byte = _data[_pos];
+  if (byte > rec::LINE_MAX || (byte & rec::LINE_MAX & ~1U) != op) {
+    _diverge(_pos);
+    return true;
+  }
+  const bool recorded = (byte & 1U) != 0;
+  const bool isRead = (op == rec::LINE_READ_SCL || op == rec::LINE_READ_SDA);
+  if (!isRead && recorded != level) {
+    _diverge(_pos);
+  }
+  ++_pos;
+  return recorded;
+}
+
+void TransportReplayer::_delay(uint32_t us) {
+  _replayedUs += us;
+  if (_repeatLeft > 0) {
+    if (us != _repeatUs) {
+      _diverge(_pos);
+    }
+    --_repeatLeft;
+    return;
+  }
+  if (_pos >= _size || _malformed) {
+    _exhausted = true;
+    return;
+  }
+
+  const size_t start = _pos;
+  const uint8_t byte = _data[_pos];
+  size_t pos = _pos + 1;
+  uint32_t recordedUs = 0;
+  uint32_t count = 1;
+  if ((byte & 0xC0) == rec::DELAY_SHORT) {
+    recordedUs = byte & rec::DELAY_SHORT_MAX_US;
+  } else if (byte == rec::DELAY) {
+    if (!_readVarint(pos, recordedUs)) {
+      _malformed = true;
+      return;
+    }
+  } else if (byte == rec::DELAY_REPEAT) {
+    if (!_readVarint(pos, count) || !_readVarint(pos, recordedUs) || count < 2) {
+      _malformed = true;
+      return;
+    }
+  } else {
+    // Next record is a line event; leave it for the matching call.
+    _diverge(start);
+    return;
+  }
+
+  _pos = pos;
+  if (recordedUs != us) {
+    _diverge(start);
+  }
+  _repeatUs = recordedUs;
+  _repeatLeft = count - 1;
+}
+
+void TransportReplayer::_setSclThunk(bool level, void* user) {
+  static_cast<TransportReplayer*>(user)->_line(rec::LINE_SET_SCL, level);
+}
+
+void TransportReplayer::_setSdaThunk(bool level, void* user) {
+  static_cast<TransportReplayer*>(user)->_line(rec::LINE_SET_SDA, level);
+}
+
+bool TransportReplayer::_readSclThunk(void* user) {
+  return static_cast<TransportReplayer*>(user)->_line(rec::LINE_READ_SCL, true);
+}
+
+bool TransportReplayer::_readSdaThunk(void* user) {
+  return static_cast<TransportReplayer*>(user)->_line(rec::LINE_READ_SDA, true);
+}
+
+void TransportReplayer::_delayUsThunk(uint32_t us, void* user) {
+  static_cast<TransportReplayer*>(user)->_delay(us);
+}
+
+} // namespace EE871
@@ -0,0 +1,199 @@
+/// @file E2LineModel.h
+/// @brief Optional RC/noise analog model for the lines read back by native E2 fakes.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "EE871/Config.h"
+
+namespace EE871Test {
+
+/// Electrical parameters of one E2 line pair (both lines use the same values).
+struct E2LineParams {
+  double supplyV = 3.3;            ///< Pull-up supply voltage.
+  double pullUpOhms = 4700.0;      ///< Pull-up resistance (rising edge).
+  double driverOhms = 50.0;        ///< Open-drain on-resistance (falling edge).
+  double capacitancePf = 100.0;    ///< Line plus cable capacitance.
+  double thresholdV = 1.65;        ///< Input threshold; above reads HIGH.
+  double noiseSigmaV = 0.0;        ///< Gaussian noise added to every read.
+  double impulseProbability = 0.0; ///< Chance per read of an impulse of +/- impulseV.
+  double impulseV = 0.0;           ///< Impulse amplitude.
+  uint64_t seed = 1;               ///< PRNG seed; same seed gives the same run.
+};
+
+/// Wraps the callbacks of an existing Config and turns the digital line levels
+/// of the inner fake into RC-shaped voltages sampled through a threshold.
+///
+/// Virtual time advances only through the wrapped delayUs() (64-bit clock).
+/// The logical level of each line (wired-AND of master and slave, as reported
+/// by the inner readScl/readSda) is re-evaluated after every callback; the line
+/// voltage then relaxes towards 0 V or supplyV with tau = driverOhms * C or
+/// pullUpOhms * C. Only master read-back is shaped: the inner fake still sees
+/// digital edges. Inner read callbacks must be side-effect free, which holds for
+/// FakeE2Transport and SimulatedE2Bus.
+class E2LineModel {
+public:
+  explicit E2LineModel(const E2LineParams& params = E2LineParams()) { setParams(params); }
+  E2LineModel(const E2LineModel&) = delete;
+  E2LineModel& operator=(const E2LineModel&) = delete;
+
+  /// Change the electrical parameters; line voltages and virtual time are kept.
+  void setParams(const E2LineParams& params) {
+    _params = params;
+    _rng = (params.seed != 0) ? params.seed : 0x9E3779B97F4A7C15ULL;
+    _haveSpare = false;
+  }
+
+  const E2LineParams& params() const { return _params; }
+
+  /// Return a copy of @p inner whose line callbacks pass through this model.
+  EE871::Config wrap(const EE871::Config& inner) {
+    _inner = inner;
+    EE871::Config cfg = inner;
+    cfg.setScl = &E2LineModel::setSclThunk;
+    cfg.setSda = &E2LineModel::setSdaThunk;
+    cfg.readScl = &E2LineModel::readSclThunk;
+    cfg.readSda = &E2LineModel::readSdaThunk;
+    cfg.delayUs = &E2LineModel::delayUsThunk;
+    cfg.busUser = this;
+    _scl.target = inner.readScl(inner.busUser);
+    _sda.target = inner.readSda(inner.busUser);
+    _scl.volts = _scl.target ? _params.supplyV : 0.0;
+    _sda.volts = _sda.target ? _params.supplyV : 0.0;
+    return cfg;
+  }
+
+  /// Rising time constant in microseconds (pull-up * C).
+  double riseTauUs() const { return _params.pullUpOhms * _params.capacitancePf * 1e-6; }
+  /// Falling time constant in microseconds (driver * C).
+  double fallTauUs() const { return _params.driverOhms * _params.capacitancePf * 1e-6; }
+  /// 10-90 % rise time in microseconds.
+  double riseTimeUs() const { return riseTauUs() * std::log(9.0); }
+  /// 90-10 % fall time in microseconds.
+  double fallTimeUs() const { return fallTauUs() * std::log(9.0); }
+  /// Time from release until a settled-low line crosses thresholdV, in microseconds.
+  double riseToThresholdUs() const {
+    return riseTauUs() * std::log(_params.supplyV / (_params.supplyV - _params.thresholdV));
+  }
+
+  uint64_t nowUs() const { return _nowUs; }
+  double sclVolts() const { return _scl.volts; }
+  double sdaVolts() const { return _sda.volts; }
+  uint32_t reads() const { return _reads; }
+  /// Reads whose noisy result differed from the noiseless threshold decision.
+  uint32_t noiseFlips() const { return _noiseFlips; }
+  uint32_t impulses() const { return _impulses; }
+
+private:
+  struct Line {
+    bool target = true;
+    double volts = 0.0;
+  };
+
+  static void setSclThunk(bool level, void* user) {
+    auto* self = static_cast<E2LineModel*>(user);
+    self->_inner.setScl(level, self->_inner.busUser);
+    self->retarget();
+  }
+  static void setSdaThunk(bool level, void* user) {
+    auto* self = static_cast<E2LineModel*>(user);
+    self->_inner.setSda(level, self->_inner.busUser);
+    self->retarget();
+  }
+  static bool readSclThunk(void* user) {
+    auto* self = static_cast<E2LineModel*>(user);
+    return self->sample(self->_scl);
+  }
+  static bool readSdaThunk(void* user) {
+    auto* self = static_cast<E2LineModel*>(user);
+    return self->sample(self->_sda);
+  }
+  static void delayUsThunk(uint32_t us, void* user) {
+    static_cast<E2LineModel*>(user)->advance(us);
+  }
+
+  void retarget() {
+    _scl.target = _inner.readScl(_inner.busUser);
+    _sda.target = _inner.readSda(_inner.busUser);
+  }
+
+  void relax(Line& line, double dtUs) const {
+    const double goal = line.target ? _params.supplyV : 0.0;
+    const double tau = line.target ? riseTauUs() : fallTauUs();
+    if (tau <= 0.0) {
+      line.volts = goal;
+      return;
+    }
+    line.volts = goal + (line.volts - goal) * std::exp(-dtUs / tau);
+  }
+
+  void advance(uint32_t us) {
+    // Level changes made by the inner fake during the delay (e.g. a stretch
+    // ending) take effect from the end of the delay.
+    relax(_scl, static_cast<double>(us));
+    relax(_sda, static_cast<double>(us));
+    _nowUs += us;
+    _inner.delayUs(us, _inner.busUser);
+    retarget();
+  }
+
+  bool sample(const Line& line) {
+    ++_reads;
+    const bool clean = line.volts > _params.thresholdV;
+    double volts = line.volts;
+    if (_params.noiseSigmaV > 0.0) {
+      volts += gaussian() * _params.noiseSigmaV;
+    }
+    if (_params.impulseProbability > 0.0 && uniform() < _params.impulseProbability) {
+      ++_impulses;
+      volts += (uniform() < 0.5) ? -_params.impulseV : _params.impulseV;
+    }
+    const bool level = volts > _params.thresholdV;
+    if (level != clean) {
+      ++_noiseFlips;
+    }
+    return level;
+  }
+
+  uint64_t next() {
+    // xorshift64*
+    _rng ^= _rng >> 12;
+    _rng ^= _rng << 25;
+    _rng ^= _rng >> 27;
+    return _rng * 0x2545F4914F6CDD1DULL;
+  }
+
+  double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  double gaussian() {
+    if (_haveSpare) {
+      _haveSpare = false;
+      return _spare;
+    }
+    double u1 = uniform();
+    if (u1 < 1e-300) {
+      u1 = 1e-300;
+    }
+    const double u2 = uniform();
+    const double radius = std::sqrt(-2.0 * std::log(u1));
+    const double angle = 6.283185307179586 * u2;
+    _spare = radius * std::sin(angle);
+    _haveSpare = true;
+    return radius * std::cos(angle);
+  }
+
+  E2LineParams _params;
+  EE871::Config _inner;
+  Line _scl;
+  Line _sda;
+  uint64_t _nowUs = 0;
+  uint64_t _rng = 1;
+  double _spare = 0.0;
+  bool _haveSpare = false;
+  uint32_t _reads = 0;
+  uint32_t _noiseFlips = 0;
+  uint32_t _impulses = 0;
+};
+
+} // namespace EE871Test
@@ -0,0 +1,253 @@
+/// @file E2TimingChecker.h
+/// @brief Virtual-time E2 spec-timing conformance oracle wrapped around any Config transport.
+#pragma once
+
+#include <cstdint>
+
+#include "EE871/CommandTable.h"
+#include "EE871/Config.h"
+
+namespace EE871Test {
+
+/// Minimum times enforced by E2TimingChecker (E2 specification v4.1).
+struct E2TimingLimits {
+  uint32_t clockLowMinUs = 100;   ///< SCL low between master falling and releasing edges.
+  uint32_t clockHighMinUs = 100;  ///< SCL high of a data/ACK pulse, from observed rise to fall.
+  uint32_t startSetupMinUs = 4;   ///< SCL and SDA high before SDA falls for START.
+  uint32_t startHoldMinUs = 4;    ///< SDA falling (START) to SCL falling.
+  uint32_t stopHoldMinUs = 4;     ///< SCL high before SDA rises for STOP.
+  uint32_t dataSetupMinUs = EE871::cmd::DATA_SETUP_US; ///< SDA change to SCL release.
+};
+
+/// Violation counters, one per rule.
+struct E2TimingViolations {
+  uint32_t clockLow = 0;
+  uint32_t clockHigh = 0;
+  uint32_t startSetup = 0;
+  uint32_t startHold = 0;
+  uint32_t stopHold = 0;
+  uint32_t dataSetup = 0;
+  uint32_t sdaWhileSclHigh = 0; ///< SDA fell while SCL high inside a transaction.
+  uint32_t unexpectedStop = 0;  ///< SDA rose while SCL high inside a transaction, mid-byte.
+
+  uint32_t total() const {
+    return clockLow + clockHigh + startSetup + startHold + stopHold + dataSetup +
+           sdaWhileSclHigh + unexpectedStop;
+  }
+};
+
+/// Interposes on the line callbacks of an existing Config and checks every
+/// master edge against E2TimingLimits.
+///
+/// Virtual time advances only through the wrapped delayUs(), so the checker
+/// works with FakeE2Transport, SimulatedE2Bus, or any other fake. Only level
+/// changes driven by the master are checked. SCL high time starts when the
+/// master first reads SCL back high after releasing it, so slave clock
+/// stretching does not count towards the high time. SDA rising while SCL is
+/// high is a STOP; inside a transaction it must follow whole 9-bit bytes (the
+/// STOP's own SCL pulse comes after them), while from idle it is always
+/// accepted (bus reset ends with one). SDA falling while SCL is high is a
+/// START only when no transaction is open.
+///
+/// Usage:
+/// @code
+///   E2TimingChecker checker;
+///   Config cfg = checker.wrap(fake.makeConfig());
+///   dev.begin(cfg);
+///   ...
+///   TEST_ASSERT_EQUAL_UINT32(0, checker.violations().total());
+/// @endcode
+class E2TimingChecker {
+public:
+  E2TimingChecker() = default;
+  explicit E2TimingChecker(const E2TimingLimits& limits) : _limits(limits) {}
+  E2TimingChecker(const E2TimingChecker&) = delete;
+  E2TimingChecker& operator=(const E2TimingChecker&) = delete;
+
+  /// Return a copy of @p inner whose line callbacks pass through this checker.
+  EE871::Config wrap(const EE871::Config& inner) {
+    _inner = inner;
+    EE871::Config cfg = inner;
+    cfg.setScl = &E2TimingChecker::setSclThunk;
+    cfg.setSda = &E2TimingChecker::setSdaThunk;
+    cfg.readScl = &E2TimingChecker::readSclThunk;
+    cfg.readSda = &E2TimingChecker::readSdaThunk;
+    cfg.delayUs = &E2TimingChecker::delayUsThunk;
+    cfg.busUser = this;
+    return cfg;
+  }
+
+  /// Clear counters; line state and virtual time are kept.
+  void resetCounts() {
+    _violations = E2TimingViolations();
+    _firstViolation = nullptr;
+    _firstViolationUs = 0;
+    _starts = 0;
+    _stops = 0;
+    _sclPulses = 0;
+  }
+
+  /// Clear counters, line state, and virtual time, e.g. before wrapping a
+  /// fresh transport with a reused checker.
+  void reset() {
+    resetCounts();
+    _nowUs = 0;
+    _scl = true;
+    _sda = true;
+    _sclChangedUs = 0;
+    _sclHighUs = 0;
+    _sdaChangedUs = 0;
+    _startUs = 0;
+    _sclAwaitingRise = false;
+    _sdaChangedWhileLow = false;
+    _pulseActive = false;
+    _pulseHasStart = false;
+    _inTransaction = false;
+    _framePulses = 0;
+  }
+
+  const E2TimingViolations& violations() const { return _violations; }
+  const E2TimingLimits& limits() const { return _limits; }
+  /// Rule name of the first violation since resetCounts(), or "none".
+  const char* firstViolation() const {
+    return (_firstViolation != nullptr) ? _firstViolation : "none";
+  }
+  uint64_t firstViolationUs() const { return _firstViolationUs; }
+
+  uint64_t nowUs() const { return _nowUs; }
+  uint32_t starts() const { return _starts; }
+  uint32_t stops() const { return _stops; }
+  uint32_t sclPulses() const { return _sclPulses; }
+
+private:
+  static void setSclThunk(bool level, void* user) {
+    static_cast<E2TimingChecker*>(user)->onSetScl(level);
+  }
+  static void setSdaThunk(bool level, void* user) {
+    static_cast<E2TimingChecker*>(user)->onSetSda(level);
+  }
+  static bool readSclThunk(void* user) { return static_cast<E2TimingChecker*>(user)->onReadScl(); }
+  static bool readSdaThunk(void* user) {
+    auto* self = static_cast<E2TimingChecker*>(user);
+    return self->_inner.readSda(self->_inner.busUser);
+  }
+  static void delayUsThunk(uint32_t us, void* user) {
+    auto* self = static_cast<E2TimingChecker*>(user);
+    self->_nowUs += us;
+    self->_inner.delayUs(us, self->_inner.busUser);
+  }
+
+  void flag(uint32_t& counter, const char* rule) {
+    ++counter;
+    if (_firstViolation == nullptr) {
+      _firstViolation = rule;
+      _firstViolationUs = _nowUs;
+    }
+  }
+
+  bool below(uint64_t sinceUs, uint32_t minUs) const { return (_nowUs - sinceUs) < minUs; }
+
+  void onSetScl(bool level) {
+    if (level != _scl) {
+      if (level) {
+        if (below(_sclChangedUs, _limits.clockLowMinUs)) {
+          flag(_violations.clockLow, "clockLow");
+        }
+        if (_sdaChangedWhileLow && below(_sdaChangedUs, _limits.dataSetupMinUs)) {
+          flag(_violations.dataSetup, "dataSetup");
+        }
+        _sclAwaitingRise = true;
+        _sclHighUs = _nowUs;
+        _pulseActive = true;
+        _pulseHasStart = false;
+        ++_sclPulses;
+        ++_framePulses;
+      } else {
+        if (_pulseHasStart) {
+          if (below(_startUs, _limits.startHoldMinUs)) {
+            flag(_violations.startHold, "startHold");
+          }
+        } else if (_pulseActive && below(_sclHighUs, _limits.clockHighMinUs)) {
+          flag(_violations.clockHigh, "clockHigh");
+        }
+        _pulseActive = false;
+        _sclAwaitingRise = false;
+      }
+      _scl = level;
+      _sclChangedUs = _nowUs;
+      _sdaChangedWhileLow = false;
+    }
+    _inner.setScl(level, _inner.busUser);
+  }
+
+  void onSetSda(bool level) {
+    if (level != _sda) {
+      if (_scl) {
+        if (level) {
+          if (below(_sclHighUs, _limits.stopHoldMinUs)) {
+            flag(_violations.stopHold, "stopHold");
+          }
+          // Data bits and ACKs come in nines, at least one byte per frame;
+          // the STOP adds one more pulse.
+          if (_inTransaction && (_framePulses < 10U || _framePulses % 9U != 1U)) {
+            flag(_violations.unexpectedStop, "unexpectedStop");
+          }
+          _inTransaction = false;
+          _pulseActive = false;
+          ++_stops;
+        } else if (!_inTransaction) {
+          const uint64_t since = (_sdaChangedUs > _sclHighUs) ? _sdaChangedUs : _sclHighUs;
+          if (below(since, _limits.startSetupMinUs)) {
+            flag(_violations.startSetup, "startSetup");
+          }
+          _inTransaction = true;
+          _framePulses = 0;
+          _pulseHasStart = true;
+          _startUs = _nowUs;
+          ++_starts;
+        } else {
+          flag(_violations.sdaWhileSclHigh, "sdaWhileSclHigh");
+        }
+      } else {
+        _sdaChangedWhileLow = true;
+      }
+      _sda = level;
+      _sdaChangedUs = _nowUs;
+    }
+    _inner.setSda(level, _inner.busUser);
+  }
+
+  bool onReadScl() {
+    const bool level = _inner.readScl(_inner.busUser);
+    if (_sclAwaitingRise && level) {
+      _sclAwaitingRise = false;
+      _sclHighUs = _nowUs;
+    }
+    return level;
+  }
+
+  E2TimingLimits _limits;
+  EE871::Config _inner;
+  E2TimingViolations _violations;
+  const char* _firstViolation = nullptr;
+  uint64_t _firstViolationUs = 0;
+
+  uint64_t _nowUs = 0;
+  bool _scl = true;
+  bool _sda = true;
+  uint64_t _sclChangedUs = 0;
+  uint64_t _sclHighUs = 0;
+  uint64_t _sdaChangedUs = 0;
+  uint64_t _startUs = 0;
+  bool _sclAwaitingRise = false;
+  bool _sdaChangedWhileLow = false;
+  bool _pulseActive = false;
+  bool _pulseHasStart = false;
+  bool _inTransaction = false;
+  uint32_t _starts = 0;
+  uint32_t _stops = 0;
+  uint32_t _sclPulses = 0;
+  uint32_t _framePulses = 0;  ///< SCL pulses since the last START.
+};
+
+} // namespace EE871Test
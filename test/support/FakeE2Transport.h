@@ -1,5 +1,10 @@
 /// @file FakeE2Transport.h
 /// @brief Deterministic native E2 callback-boundary fake for runtime fault tests.
+///
+/// makeConfig() exercises the driver's bit engine edge by edge.
+/// makeByteLevelConfig() additionally installs the Config frame hooks, so
+/// register transfers are answered per transaction with the same device model,
+/// fault injection, and elapsed-time accounting, without edge simulation.
 #pragma once
 
 #include <cstddef>
@@ -7,6 +12,7 @@
 
 #include "EE871/CommandTable.h"
 #include "EE871/Config.h"
+#include "EE871/Status.h"
 
 namespace EE871Test {
 
@@ -31,6 +37,7 @@ public:
     _customPointer = 0;
     _elapsedUs = 0;
     _delayCalls = 0;
+    _frames = 0;
     _devicePresent = true;
     _holdSclLow = false;
     _sdaStuckLow = false;
@@ -88,12 +95,28 @@ public:
     return cfg;
   }
 
+  EE871::Config makeByteLevelConfig(uint8_t offlineThreshold = 5) {
+    EE871::Config cfg = makeConfig(offlineThreshold);
+    cfg.readFrame = &FakeE2Transport::readFrameThunk;
+    cfg.writeFrame = &FakeE2Transport::writeFrameThunk;
+    useFrameTiming(cfg);
+    return cfg;
+  }
+
+  /// Timing used to account elapsed time for byte-level frames; call again
+  /// after changing timing fields of a makeByteLevelConfig() result.
+  void useFrameTiming(const EE871::Config& cfg) { _frameTiming = cfg; }
+
+  /// Number of byte-level frames served.
+  uint32_t frames() const { return _frames; }
+
   void resetElapsed() {
     _elapsedUs = 0;
     _delayCalls = 0;
   }
 
   uint32_t elapsedUs() const { return _elapsedUs; }
+  /// Delay callbacks received; a byte-level frame counts as one call.
   uint32_t delayCalls() const { return _delayCalls; }
 
   void setDevicePresent(bool present) { _devicePresent = present; }
@@ -101,6 +124,9 @@ public:
   void setSdaStuckLow(bool stuck) { _sdaStuckLow = stuck; }
   void setSdaStuckHigh(bool stuck) { _sdaStuckHigh = stuck; }
   void setCorruptReadPec(bool corrupt) { _corruptReadPec = corrupt; }
+  void setStatusByte(uint8_t status) { _statusByte = status; }
+  void setMv3(uint16_t value) { _mv3 = value; }
+  void setMv4(uint16_t value) { _mv4 = value; }
 
   void setMemory(uint8_t address, uint8_t value) { _memory[address] = value; }
   uint8_t memory(uint8_t address) const { return _memory[address]; }
@@ -157,6 +183,118 @@ private:
     static_cast<FakeE2Transport*>(user)->delayUs(us);
   }
 
+  static EE871::Status readFrameThunk(uint8_t controlByte, uint8_t& data, uint8_t& pec,
+                                      void* user) {
+    return static_cast<FakeE2Transport*>(user)->readFrame(controlByte, data, pec);
+  }
+
+  static EE871::Status writeFrameThunk(uint8_t controlByte, uint8_t addressByte,
+                                       uint8_t dataByte, uint8_t pec, bool& accepted,
+                                       void* user) {
+    return static_cast<FakeE2Transport*>(user)->writeFrame(controlByte, addressByte, dataByte,
+                                                           pec, accepted);
+  }
+
+  // === Byte-level frames ===
+  // Each frame replays what the edge path would do to the device model, and
+  // accounts the delay the driver's bit engine spends for the same bytes.
+
+  uint32_t frameUs(uint32_t bits) const {
+    const uint32_t bitUs = EE871::cmd::DATA_SETUP_US + _frameTiming.clockHighUs +
+                           _frameTiming.clockLowUs;
+    const uint32_t startUs = 2U * _frameTiming.startHoldUs + _frameTiming.clockLowUs;
+    const uint32_t stopUs = EE871::cmd::DATA_SETUP_US + 2U * _frameTiming.stopHoldUs;
+    return startUs + bits * bitUs + stopUs;
+  }
+
+  EE871::Status startFrame() {
+    ++_frames;
+    ++_delayCalls;
+    if (_holdSclLow) {
+      // START waits in POLL_STEP_US steps until the bit timeout is reached.
+      uint32_t waited = 0;
+      while (waited < _frameTiming.bitTimeoutUs) {
+        waited += EE871::cmd::POLL_STEP_US;
+      }
+      _elapsedUs += waited;
+      return EE871::Status::Error(EE871::Err::TIMEOUT, "Clock stretch timeout",
+                                  static_cast<int32_t>(waited));
+    }
+    beginTransaction();
+    return EE871::Status::Ok();
+  }
+
+  bool masterSeesAck(bool slaveAck) const {
+    if (_sdaStuckLow) {
+      return true;
+    }
+    if (_sdaStuckHigh) {
+      return false;
+    }
+    return slaveAck;
+  }
+
+  EE871::Status nackFrame(uint32_t bytes, const char* msg) {
+    _phase = Phase::IDLE;
+    _elapsedUs += frameUs(9U * bytes);
+    return EE871::Status::Error(EE871::Err::NACK, msg);
+  }
+
+  EE871::Status readFrame(uint8_t controlByte, uint8_t& data, uint8_t& pec) {
+    EE871::Status st = startFrame();
+    if (!st.ok()) {
+      return st;
+    }
+    _control = controlByte;
+    _phase = Phase::ACK_CONTROL;
+    const bool ack = ackForCurrentPhase();
+    if (_devicePresent && controlIsRead()) {
+      prepareReadResponse();
+    }
+    if (!masterSeesAck(ack)) {
+      return nackFrame(1, "Control byte NACK");
+    }
+    data = _sdaStuckLow ? 0x00 : _responseData;
+    pec = _sdaStuckLow ? 0x00 : _responsePec;
+    _phase = Phase::IDLE;
+    _elapsedUs += frameUs(27);
+    return EE871::Status::Ok();
+  }
+
+  EE871::Status writeFrame(uint8_t controlByte, uint8_t addressByte, uint8_t dataByte,
+                           uint8_t pec, bool& accepted) {
+    accepted = false;
+    EE871::Status st = startFrame();
+    if (!st.ok()) {
+      return st;
+    }
+    _control = controlByte;
+    _phase = Phase::ACK_CONTROL;
+    if (!masterSeesAck(ackForCurrentPhase())) {
+      return nackFrame(1, "Control byte NACK");
+    }
+    _address = addressByte;
+    _phase = Phase::ACK_ADDRESS;
+    if (!masterSeesAck(ackForCurrentPhase())) {
+      return nackFrame(2, "Address byte NACK");
+    }
+    _data = dataByte;
+    _phase = Phase::ACK_DATA;
+    if (!masterSeesAck(ackForCurrentPhase())) {
+      return nackFrame(3, "Data byte NACK");
+    }
+    _pec = pec;
+    _phase = Phase::ACK_PEC;
+    if (!masterSeesAck(ackForCurrentPhase())) {
+      return nackFrame(4, "PEC NACK");
+    }
+    applyWriteIfValid();
+    _phase = Phase::IDLE;
+    accepted = true;
+    _elapsedUs += frameUs(36);
+    return EE871::Status::Ok();
+  }
+
   void setScl(bool level) {
     const bool wasHigh = readScl();
     _masterSclReleased = level;
@@ -458,6 +596,8 @@ private:
   uint8_t _customPointer = 0;
   uint32_t _elapsedUs = 0;
   uint32_t _delayCalls = 0;
+  uint32_t _frames = 0;
+  EE871::Config _frameTiming;
   bool _devicePresent = true;
   bool _holdSclLow = false;
   bool _sdaStuckLow = false;
@@ -0,0 +1,262 @@
+/// @file FleetSimulator.h
+/// @brief Discrete-event simulation of a bit-banged EE871 fleet for poll-plan sizing.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/EE871.h"
+#include "EE871/Fleet.h"
+#include "support/SimulatedE2Bus.h"
+
+namespace EE871Test {
+
+/// Line timing of one simulated bus, e.g. slower clocks for a long cable.
+struct SimBusSpec {
+  uint16_t clockLowUs = 100;
+  uint16_t clockHighUs = 100;
+};
+
+/// One sensor of a scenario and its error profile.
+struct SimSensorSpec {
+  uint8_t bus = 0;                 ///< Index into SimScenario::buses.
+  uint8_t address = 0;             ///< E2 address, unique per bus.
+  uint32_t intervalMs = 15000;     ///< Poll period.
+  uint32_t phaseMs = 0;            ///< First due time.
+  uint32_t deadlineMs = 0;         ///< Allowed start lateness; 0 means intervalMs.
+  uint32_t absentPpm = 0;          ///< Per-poll chance (ppm) that the sensor does not answer.
+  uint32_t pecErrorPpm = 0;        ///< Per-poll chance (ppm) of a corrupted read PEC.
+  uint32_t stretchPerByteUs = 0;   ///< Clock stretch after every byte.
+  uint16_t ppm = 650;              ///< MV4 value served.
+};
+
+/// Fleet, duration, and MCU model of one simulation run.
+struct SimScenario {
+  const SimBusSpec* buses = nullptr;
+  uint8_t busCount = 0;
+  const SimSensorSpec* sensors = nullptr;
+  size_t sensorCount = 0;
+  uint64_t durationMs = 0;
+  uint32_t pollOverheadUs = 0;     ///< CPU time per poll outside the line delays.
+  uint32_t seed = 1;               ///< Fault PRNG seed; equal seeds give equal reports.
+};
+
+/// Per-bus result.
+struct SimBusReport {
+  uint64_t busyUs = 0;             ///< Time between START and STOP.
+  uint32_t utilizationPpm = 0;     ///< busyUs per simulated time, in ppm.
+};
+
+/// Scenario result.
+struct SimReport {
+  static constexpr uint8_t MAX_BUSES = 16;
+
+  uint64_t simulatedUs = 0;
+  uint32_t polls = 0;
+  uint32_t failedPolls = 0;
+  uint32_t deadlineMisses = 0;     ///< Late starts plus periods skipped by overruns.
+  uint64_t maxLatenessUs = 0;      ///< Worst start delay after the due time.
+  uint64_t maxDataAgeUs = 0;       ///< Worst time between good samples of one sensor.
+  uint64_t meanDataAgeUs = 0;      ///< Time-averaged sample age over sensors and time; age starts at 0.
+  uint64_t cpuBusyWaitUs = 0;      ///< Line delays busy-waited by the CPU, stretch included.
+  uint32_t cpuBusyPpm = 0;         ///< Busy-wait plus poll overhead per simulated time, in ppm.
+  SimBusReport bus[MAX_BUSES];
+};
+
+/// @brief Runs a fleet in virtual time through the real driver and FleetPoller.
+///
+/// One MCU bit-bangs every bus, so polls never overlap. The simulator keeps
+/// the poll plan: it always polls the sensor with the earliest due time,
+/// jumps over idle time, and advances the clock by the line time the driver
+/// actually spent (from SimulatedE2Bus) plus the per-poll overhead. Periods
+/// are fixed-rate; when a poll overruns a whole deadline, the missed periods
+/// are skipped and counted. Data age is the time since the last good sample.
+///
+/// Capacities are template parameters so instances can be static; the
+/// simulator is large and should not live on the stack.
+template <size_t MaxSensors, uint8_t MaxBuses = 8>
+class FleetSimulator {
+public:
+  static_assert(MaxBuses <= SimReport::MAX_BUSES, "Too many buses for SimReport");
+
+  /// Build buses, slaves, and drivers, then run the whole scenario.
+  /// @return false when the scenario does not fit or a driver fails begin().
+  bool run(const SimScenario& sc, SimReport& out) {
+    out = SimReport();
+    if (!_setup(sc)) {
+      return false;
+    }
+
+    const uint64_t endUs = sc.durationMs * 1000ULL;
+    uint64_t now = 0;
+    uint64_t overheadUs = 0;
+    double ageIntegral = 0.0;
+
+    while (true) {
+      size_t pick = 0;
+      for (size_t i = 1; i < sc.sensorCount; ++i) {
+        if (_dueUs[i] < _dueUs[pick]) {
+          pick = i;
+        }
+      }
+      if (_dueUs[pick] >= endUs) {
+        break;
+      }
+      const SimSensorSpec& spec = sc.sensors[pick];
+      const uint64_t deadlineUs = static_cast<uint64_t>(spec.deadlineMs != 0 ? spec.deadlineMs
+                                                                             : spec.intervalMs) *
+                                  1000ULL;
+      const uint64_t periodUs = static_cast<uint64_t>(spec.intervalMs) * 1000ULL;
+      if (now < _dueUs[pick]) {
+        now = _dueUs[pick];
+      }
+      const uint64_t lateness = now - _dueUs[pick];
+      if (lateness > out.maxLatenessUs) {
+        out.maxLatenessUs = lateness;
+      }
+      if (lateness > deadlineUs) {
+        ++out.deadlineMisses;
+      }
+
+      SimulatedE2Bus& bus = _buses[spec.bus];
+      EmulatedEE871& slave = *_slaves[pick];
+      slave.setPresent(!_chance(spec.absentPpm));
+      slave.setCorruptReadPec(_chance(spec.pecErrorPpm));
+
+      const uint64_t lineBefore = bus.nowUs();
+      const uint32_t nowMs = static_cast<uint32_t>(now / 1000ULL);
+      _devices[pick].tick(nowMs);
+      const EE871::Status st = _poller.poll(pick, nowMs);
+      const uint64_t lineUs = bus.nowUs() - lineBefore;
+      slave.setPresent(true);
+      slave.setCorruptReadPec(false);
+
+      now += lineUs + sc.pollOverheadUs;
+      out.cpuBusyWaitUs += lineUs;
+      overheadUs += sc.pollOverheadUs;
+      ++out.polls;
+      if (st.ok()) {
+        ageIntegral += _closeAge(pick, now, out);
+      } else {
+        ++out.failedPolls;
+      }
+
+      _dueUs[pick] += periodUs;
+      while (_dueUs[pick] + deadlineUs < now) {
+        _dueUs[pick] += periodUs;
+        ++out.deadlineMisses;
+      }
+    }
+
+    if (now < endUs) {
+      now = endUs;
+    }
+    for (size_t i = 0; i < sc.sensorCount; ++i) {
+      ageIntegral += _closeAge(i, now, out);
+    }
+
+    out.simulatedUs = now;
+    if (now != 0) {
+      out.cpuBusyPpm = _ppm(out.cpuBusyWaitUs + overheadUs, now);
+      out.meanDataAgeUs =
+          static_cast<uint64_t>(ageIntegral / (static_cast<double>(now) * sc.sensorCount));
+      for (uint8_t b = 0; b < sc.busCount; ++b) {
+        out.bus[b].busyUs = _buses[b].busyUs() - _busyBaseUs[b];
+        out.bus[b].utilizationPpm = _ppm(out.bus[b].busyUs, now);
+      }
+    }
+    return true;
+  }
+
+  /// Store filled by the last run().
+  const EE871::FleetStore& store() const { return _store; }
+
+  /// Driver of sensor @p i from the last run().
+  const EE871::EE871& device(size_t i) const { return _devices[i]; }
+
+private:
+  bool _setup(const SimScenario& sc) {
+    _poller.end();
+    _store.end();
+    if (sc.buses == nullptr || sc.sensors == nullptr || sc.busCount == 0 ||
+        sc.busCount > MaxBuses || sc.sensorCount == 0 || sc.sensorCount > MaxSensors) {
+      return false;
+    }
+    for (uint8_t b = 0; b < MaxBuses; ++b) {
+      _buses[b].reset();
+    }
+    _rng = (sc.seed != 0) ? sc.seed : 1U;
+
+    for (size_t i = 0; i < sc.sensorCount; ++i) {
+      const SimSensorSpec& spec = sc.sensors[i];
+      if (spec.bus >= sc.busCount || spec.intervalMs == 0 ||
+          _buses[spec.bus].slaveCount() >= SimulatedE2Bus::MAX_SLAVES) {
+        return false;
+      }
+      EmulatedEE871& slave = _buses[spec.bus].attach(spec.address);
+      slave.setMv4(spec.ppm);
+      slave.setStretchPerByteUs(spec.stretchPerByteUs);
+      _slaves[i] = &slave;
+    }
+
+    for (size_t i = 0; i < sc.sensorCount; ++i) {
+      const SimSensorSpec& spec = sc.sensors[i];
+      const SimBusSpec& busSpec = sc.buses[spec.bus];
+      _devices[i].end();
+      EE871::Config cfg = _buses[spec.bus].makeConfig(spec.address);
+      cfg.clockLowUs = busSpec.clockLowUs;
+      cfg.clockHighUs = busSpec.clockHighUs;
+      if (!_devices[i].begin(cfg).ok()) {
+        return false;
+      }
+      _members[i] = &_devices[i];
+      _dueUs[i] = static_cast<uint64_t>(spec.phaseMs) * 1000ULL;
+      _lastGoodUs[i] = 0;
+    }
+    // begin() traffic is setup, not part of the measured schedule.
+    for (uint8_t b = 0; b < sc.busCount; ++b) {
+      _busyBaseUs[b] = _buses[b].busyUs();
+    }
+    return _store.begin(_storage.columns(), sc.sensorCount).ok() &&
+           _poller.begin(_members, sc.sensorCount, _store).ok();
+  }
+
+  /// Close the current age interval of sensor @p i at @p now.
+  /// @return Integral of the sample age over that interval, in us^2.
+  double _closeAge(size_t i, uint64_t now, SimReport& out) {
+    const uint64_t age = now - _lastGoodUs[i];
+    if (age > out.maxDataAgeUs) {
+      out.maxDataAgeUs = age;
+    }
+    _lastGoodUs[i] = now;
+    return 0.5 * static_cast<double>(age) * static_cast<double>(age);
+  }
+
+  bool _chance(uint32_t ppm) {
+    if (ppm == 0) {
+      return false;
+    }
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return (_rng % 1000000U) < ppm;
+  }
+
+  static uint32_t _ppm(uint64_t part, uint64_t whole) {
+    return static_cast<uint32_t>(part * 1000000ULL / whole);
+  }
+
+  SimulatedE2Bus _buses[MaxBuses];
+  EmulatedEE871* _slaves[MaxSensors] = {};
+  EE871::EE871 _devices[MaxSensors];
+  EE871::EE871* _members[MaxSensors] = {};
+  EE871::FleetStorage<MaxSensors> _storage;
+  EE871::FleetStore _store;
+  EE871::FleetPoller _poller;
+  uint64_t _dueUs[MaxSensors] = {};
+  uint64_t _lastGoodUs[MaxSensors] = {};
+  uint64_t _busyBaseUs[MaxBuses] = {};
+  uint32_t _rng = 1;
+};
+
+} // namespace EE871Test
@@ -0,0 +1,36 @@
+/// @file GeneratedCyclicSchedule.h
+/// @brief Generated by tools/cyclic_schedule.py; do not edit.
+/// Command: python tools/cyclic_schedule.py --periods 100,200,200,400,400 --margin-us 460 --namespace ee871_test_schedule --output test/support/GeneratedCyclicSchedule.h
+#pragma once
+
+#include "EE871/ConfigBuilder.h"
+#include "EE871/CyclicSchedule.h"
+
+namespace ee871_test_schedule {
+
+constexpr EE871::ConfigBuilder kTiming = EE871::ConfigBuilder()
+    .clockUs(100, 100)
+    .holdUs(100, 100);
+constexpr uint32_t kSlotCostUs = 19000u;
+static_assert(EE871::measurementCostUs(kTiming.derived(), false) + 460u == kSlotCostUs,
+              "Slot cost no longer matches the driver timing; regenerate this table");
+
+constexpr EE871::CyclicSlot kSlots[] = {
+    {0u, 0u},
+    {19000u, 1u},
+    {38000u, 3u},
+    {100000u, 0u},
+    {119000u, 2u},
+    {138000u, 4u},
+    {200000u, 0u},
+    {219000u, 1u},
+    {300000u, 0u},
+    {319000u, 2u},
+};
+
+constexpr EE871::CyclicSchedule kSchedule = {
+    100000u, 400000u, kSlots, 10u,
+    kSlotCostUs};
+static_assert(EE871::scheduleFits(kSchedule), "Cyclic schedule does not fit its frames");
+
+} // namespace ee871_test_schedule
@@ -0,0 +1,74 @@
+/// @file MockPmApi.h
+/// @brief Host stand-in for esp_pm, esp_timer, and vTaskDelay used by BasicPmBusLock tests.
+#pragma once
+
+#include <cstdint>
+
+#include "idf/common/E2PmLock.h"
+#include "support/FakeE2Transport.h"
+
+namespace EE871Test {
+
+/// Static PM API with per-lock hold state. Time is the fake transport's
+/// elapsed line time plus idleUs, so lock hold time can be compared with the
+/// bus time the driver actually spent.
+struct MockPmApi {
+  using Handle = int;  ///< Lock index + 1; 0 is never handed out.
+
+  struct State {
+    const FakeE2Transport* fake = nullptr;
+    uint64_t idleUs = 0;
+    bool failCreate = false;
+    uint8_t created = 0;
+    uint8_t destroyed = 0;
+    bool held[2] = {false, false};
+    uint32_t acquires[2] = {0, 0};
+    uint32_t sleeps = 0;
+    uint32_t sleptMs = 0;
+    bool sleptWhileHeld = false;
+  };
+
+  static State& state() {
+    static State s;
+    return s;
+  }
+
+  static void reset(const FakeE2Transport* fake) {
+    state() = State();
+    state().fake = fake;
+  }
+
+  static bool anyHeld() { return state().held[0] || state().held[1]; }
+
+  static bool create(ee871_idf::PmLockKind kind, const char*, Handle& out) {
+    if (state().failCreate) {
+      return false;
+    }
+    ++state().created;
+    out = static_cast<int>(kind) + 1;
+    return true;
+  }
+
+  static void destroy(Handle) { ++state().destroyed; }
+
+  static void acquire(Handle h) {
+    state().held[h - 1] = true;
+    ++state().acquires[h - 1];
+  }
+
+  static void release(Handle h) { state().held[h - 1] = false; }
+
+  static uint64_t nowUs() {
+    const State& s = state();
+    return s.idleUs + ((s.fake != nullptr) ? s.fake->elapsedUs() : 0U);
+  }
+
+  static void sleepMs(uint32_t ms) {
+    ++state().sleeps;
+    state().sleptMs += ms;
+    state().idleUs += static_cast<uint64_t>(ms) * 1000U;
+    state().sleptWhileHeld = state().sleptWhileHeld || anyHeld();
+  }
+};
+
+} // namespace EE871Test
@@ -0,0 +1,142 @@
+/// @file MockRadioScheduler.h
+/// @brief Host model of a radio that yields to E2 transactions through Config::quietWindow.
+#pragma once
+
+#include <cstdint>
+
+#include "EE871/Config.h"
+#include "support/FakeE2Transport.h"
+
+namespace EE871Test {
+
+/// Radio with transmit bursts at fixed times, hooked into Config::quietWindow.
+///
+/// Time is the fake transport's elapsed line time plus the time spent waiting
+/// for bursts, so transaction windows line up with the bus time the driver
+/// actually spent. When coordinating, a quiet-window request waits out a
+/// burst already on air and holds bursts that would start inside the
+/// transaction until it ends. Otherwise the hook only watches, and bursts go
+/// out on schedule. Either way, transactions that overlap a burst are counted.
+class MockRadioScheduler {
+public:
+  static constexpr uint8_t BURSTS_MAX = 32;
+
+  MockRadioScheduler(const FakeE2Transport& fake, bool coordinate)
+      : _fake(fake), _coordinate(coordinate) {}
+
+  /// Queue a burst; false when the table is full.
+  bool addBurst(uint64_t startUs, uint32_t durationUs) {
+    if (_burstCount >= BURSTS_MAX) {
+      return false;
+    }
+    _bursts[_burstCount].startUs = startUs;
+    _bursts[_burstCount].durationUs = durationUs;
+    ++_burstCount;
+    return true;
+  }
+
+  /// @p cfg with this scheduler as its quiet-window hook.
+  EE871::Config apply(EE871::Config cfg) {
+    cfg.quietWindow = &MockRadioScheduler::quietWindowThunk;
+    cfg.radioUser = this;
+    return cfg;
+  }
+
+  uint64_t nowUs() const { return _fake.elapsedUs() + _waitedUs; }
+
+  uint32_t windows() const { return _windows; }
+  uint32_t overlaps() const { return _overlaps; }
+  uint32_t waits() const { return _waits; }
+  uint64_t waitedUs() const { return _waitedUs; }
+  uint32_t deferred() const { return _deferred; }
+  uint32_t lastExpectedUs() const { return _lastExpectedUs; }
+  /// Largest |actual - expected| transaction time seen.
+  uint32_t maxDeviationUs() const { return _maxDeviationUs; }
+  bool unbalanced() const { return _unbalanced; }
+
+  static void quietWindowThunk(bool start, uint32_t expectedUs, void* user) {
+    MockRadioScheduler* self = static_cast<MockRadioScheduler*>(user);
+    if (start) {
+      self->_start(expectedUs);
+    } else {
+      self->_end(expectedUs);
+    }
+  }
+
+private:
+  struct Burst {
+    uint64_t startUs = 0;
+    uint32_t durationUs = 0;
+    bool held = false;
+  };
+
+  void _start(uint32_t expectedUs) {
+    _unbalanced = _unbalanced || _open;
+    _open = true;
+    if (_coordinate) {
+      // Wait out bursts already on air, then hold the ones due in the window.
+      for (bool waited = true; waited;) {
+        waited = false;
+        for (uint8_t i = 0; i < _burstCount; ++i) {
+          const Burst& b = _bursts[i];
+          const uint64_t now = nowUs();
+          if (b.startUs <= now && now < b.startUs + b.durationUs) {
+            _waitedUs += b.startUs + b.durationUs - now;
+            ++_waits;
+            waited = true;
+          }
+        }
+      }
+      const uint64_t now = nowUs();
+      for (uint8_t i = 0; i < _burstCount; ++i) {
+        Burst& b = _bursts[i];
+        if (!b.held && b.startUs >= now && b.startUs < now + expectedUs) {
+          b.held = true;
+        }
+      }
+    }
+    _txStartUs = nowUs();
+    _lastExpectedUs = expectedUs;
+  }
+
+  void _end(uint32_t expectedUs) {
+    _unbalanced = _unbalanced || !_open || expectedUs != _lastExpectedUs;
+    _open = false;
+    ++_windows;
+    const uint64_t endUs = nowUs();
+    const uint64_t actualUs = endUs - _txStartUs;
+    const uint64_t deviation = (actualUs > expectedUs) ? actualUs - expectedUs : expectedUs - actualUs;
+    if (deviation > _maxDeviationUs) {
+      _maxDeviationUs = static_cast<uint32_t>(deviation);
+    }
+    bool overlapped = false;
+    for (uint8_t i = 0; i < _burstCount; ++i) {
+      Burst& b = _bursts[i];
+      if (b.held) {
+        b.held = false;
+        b.startUs = endUs;
+        ++_deferred;
+        continue;
+      }
+      overlapped = overlapped || (b.startUs < endUs && _txStartUs < b.startUs + b.durationUs);
+    }
+    _overlaps += overlapped ? 1U : 0U;
+  }
+
+  const FakeE2Transport& _fake;
+  bool _coordinate;
+  Burst _bursts[BURSTS_MAX];
+  uint8_t _burstCount = 0;
+  uint64_t _waitedUs = 0;
+  uint64_t _txStartUs = 0;
+  uint32_t _windows = 0;
+  uint32_t _overlaps = 0;
+  uint32_t _waits = 0;
+  uint32_t _deferred = 0;
+  uint32_t _lastExpectedUs = 0;
+  uint32_t _maxDeviationUs = 0;
+  bool _open = false;
+  bool _unbalanced = false;
+};
+
+} // namespace EE871Test
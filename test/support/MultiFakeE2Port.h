@@ -0,0 +1,118 @@
+/// @file MultiFakeE2Port.h
+/// @brief Port-wide adapter that drives several FakeE2Transport buses for lockstep tests.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/MultiBus.h"
+#include "support/FakeE2Transport.h"
+
+namespace EE871Test {
+
+/// Maps bus n of a MultiBusEngine onto fake n, using each fake's own
+/// single-bus callbacks so the per-bus protocol model is unchanged.
+class MultiFakeE2Port {
+public:
+  static constexpr uint8_t MAX_BUSES = 8;
+
+  explicit MultiFakeE2Port(uint8_t busCount) : _busCount(busCount) {
+    for (uint8_t i = 0; i < _busCount; ++i) {
+      _busCfg[i] = _fakes[i].makeConfig();
+    }
+  }
+
+  MultiFakeE2Port(const MultiFakeE2Port&) = delete;
+  MultiFakeE2Port& operator=(const MultiFakeE2Port&) = delete;
+
+  FakeE2Transport& fake(uint8_t bus) { return _fakes[bus]; }
+
+  uint32_t elapsedUs() const { return _elapsedUs; }
+  uint32_t portWrites() const { return _portWrites; }
+  uint32_t portReads() const { return _portReads; }
+  void resetElapsed() {
+    _elapsedUs = 0;
+    _portWrites = 0;
+    _portReads = 0;
+  }
+
+  EE871::MultiBusConfig makeConfig() {
+    EE871::MultiBusConfig cfg;
+    cfg.setScl = &MultiFakeE2Port::setSclThunk;
+    cfg.setSda = &MultiFakeE2Port::setSdaThunk;
+    cfg.readScl = &MultiFakeE2Port::readSclThunk;
+    cfg.readSda = &MultiFakeE2Port::readSdaThunk;
+    cfg.delayUs = &MultiFakeE2Port::delayUsThunk;
+    cfg.portUser = this;
+    cfg.busCount = _busCount;
+    cfg.clockLowUs = 100;
+    cfg.clockHighUs = 100;
+    cfg.startHoldUs = 4;
+    cfg.stopHoldUs = 4;
+    cfg.bitTimeoutUs = 25;
+    cfg.byteTimeoutUs = 25;
+    return cfg;
+  }
+
+private:
+  static void setSclThunk(uint32_t mask, uint32_t levels, void* user) {
+    auto* self = static_cast<MultiFakeE2Port*>(user);
+    ++self->_portWrites;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if ((mask & (1u << i)) != 0) {
+        self->_busCfg[i].setScl((levels & (1u << i)) != 0, self->_busCfg[i].busUser);
+      }
+    }
+  }
+
+  static void setSdaThunk(uint32_t mask, uint32_t levels, void* user) {
+    auto* self = static_cast<MultiFakeE2Port*>(user);
+    ++self->_portWrites;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if ((mask & (1u << i)) != 0) {
+        self->_busCfg[i].setSda((levels & (1u << i)) != 0, self->_busCfg[i].busUser);
+      }
+    }
+  }
+
+  static uint32_t readSclThunk(void* user) {
+    auto* self = static_cast<MultiFakeE2Port*>(user);
+    ++self->_portReads;
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if (self->_busCfg[i].readScl(self->_busCfg[i].busUser)) {
+        levels |= 1u << i;
+      }
+    }
+    return levels;
+  }
+
+  static uint32_t readSdaThunk(void* user) {
+    auto* self = static_cast<MultiFakeE2Port*>(user);
+    ++self->_portReads;
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if (self->_busCfg[i].readSda(self->_busCfg[i].busUser)) {
+        levels |= 1u << i;
+      }
+    }
+    return levels;
+  }
+
+  static void delayUsThunk(uint32_t us, void* user) {
+    auto* self = static_cast<MultiFakeE2Port*>(user);
+    self->_elapsedUs += us;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      self->_busCfg[i].delayUs(us, self->_busCfg[i].busUser);
+    }
+  }
+
+  uint8_t _busCount = 0;
+  FakeE2Transport _fakes[MAX_BUSES];
+  EE871::Config _busCfg[MAX_BUSES];
+  uint32_t _elapsedUs = 0;
+  uint32_t _portWrites = 0;
+  uint32_t _portReads = 0;
+};
+
+} // namespace EE871Test
@@ -0,0 +1,105 @@
+/// @file MultiSimE2Port.h
+/// @brief Port-wide adapter that drives several SimulatedE2Bus buses for lockstep tests.
+#pragma once
+
+#include <cstdint>
+
+#include "EE871/MultiBus.h"
+#include "support/SimulatedE2Bus.h"
+
+namespace EE871Test {
+
+/// Maps bus n of a MultiBusEngine onto simulated bus n. Unlike
+/// MultiFakeE2Port, each bus can carry several emulated sensors, and the
+/// per-device Configs from config() drive the same lines as the engine.
+class MultiSimE2Port {
+public:
+  static constexpr uint8_t MAX_BUSES = 8;
+
+  explicit MultiSimE2Port(uint8_t busCount) : _busCount(busCount) {
+    for (uint8_t i = 0; i < _busCount; ++i) {
+      _busCfg[i] = _buses[i].makeConfig(0);
+    }
+  }
+
+  MultiSimE2Port(const MultiSimE2Port&) = delete;
+  MultiSimE2Port& operator=(const MultiSimE2Port&) = delete;
+
+  SimulatedE2Bus& bus(uint8_t index) { return _buses[index]; }
+
+  /// Single-device Config for @p address on bus @p index, with the engine's timing.
+  EE871::Config config(uint8_t index, uint8_t address) {
+    EE871::Config cfg = _buses[index].makeConfig(address);
+    cfg.startHoldUs = 100;
+    cfg.stopHoldUs = 100;
+    return cfg;
+  }
+
+  EE871::MultiBusConfig makeConfig() {
+    EE871::MultiBusConfig cfg;
+    cfg.setScl = &MultiSimE2Port::setSclThunk;
+    cfg.setSda = &MultiSimE2Port::setSdaThunk;
+    cfg.readScl = &MultiSimE2Port::readSclThunk;
+    cfg.readSda = &MultiSimE2Port::readSdaThunk;
+    cfg.delayUs = &MultiSimE2Port::delayUsThunk;
+    cfg.portUser = this;
+    cfg.busCount = _busCount;
+    cfg.bitTimeoutUs = 25000;
+    cfg.byteTimeoutUs = 35000;
+    return cfg;
+  }
+
+private:
+  static void setSclThunk(uint32_t mask, uint32_t levels, void* user) {
+    auto* self = static_cast<MultiSimE2Port*>(user);
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if ((mask & (1u << i)) != 0) {
+        self->_busCfg[i].setScl((levels & (1u << i)) != 0, self->_busCfg[i].busUser);
+      }
+    }
+  }
+
+  static void setSdaThunk(uint32_t mask, uint32_t levels, void* user) {
+    auto* self = static_cast<MultiSimE2Port*>(user);
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if ((mask & (1u << i)) != 0) {
+        self->_busCfg[i].setSda((levels & (1u << i)) != 0, self->_busCfg[i].busUser);
+      }
+    }
+  }
+
+  static uint32_t readSclThunk(void* user) {
+    auto* self = static_cast<MultiSimE2Port*>(user);
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if (self->_busCfg[i].readScl(self->_busCfg[i].busUser)) {
+        levels |= 1u << i;
+      }
+    }
+    return levels;
+  }
+
+  static uint32_t readSdaThunk(void* user) {
+    auto* self = static_cast<MultiSimE2Port*>(user);
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      if (self->_busCfg[i].readSda(self->_busCfg[i].busUser)) {
+        levels |= 1u << i;
+      }
+    }
+    return levels;
+  }
+
+  static void delayUsThunk(uint32_t us, void* user) {
+    auto* self = static_cast<MultiSimE2Port*>(user);
+    for (uint8_t i = 0; i < self->_busCount; ++i) {
+      self->_busCfg[i].delayUs(us, self->_busCfg[i].busUser);
+    }
+  }
+
+  uint8_t _busCount = 0;
+  SimulatedE2Bus _buses[MAX_BUSES];
+  EE871::Config _busCfg[MAX_BUSES];
+};
+
+} // namespace EE871Test
@@ -0,0 +1,505 @@
+/// @file SimulatedE2Bus.h
+/// @brief Virtual-time E2 bus with several emulated EE871 slaves on shared wired-AND lines.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EE871/CommandTable.h"
+#include "EE871/Config.h"
+
+namespace EE871Test {
+
+/// One emulated EE871 slave attached to a SimulatedE2Bus.
+///
+/// Unlike FakeE2Transport, the slave only reacts to resolved bus edges and
+/// changes SDA while SCL is low, so several slaves can share one line pair.
+/// It answers only control bytes carrying its own E2 address.
+class EmulatedEE871 {
+public:
+  EmulatedEE871() { reset(0); }
+
+  void reset(uint8_t address) {
+    _address = static_cast<uint8_t>(address & 0x07);
+    _state = State::IDLE;
+    _bitCount = 0;
+    _byte = 0;
+    _byteIndex = 0;
+    _control = 0;
+    _writeAddress = 0;
+    _writeData = 0;
+    _responseData = 0;
+    _responsePec = 0;
+    _masterAcked = false;
+    _sdaOut = true;
+    _stretchUntilUs = 0;
+    _customPointer = 0;
+    _present = true;
+    _holdSdaLow = false;
+    _holdSclLow = false;
+    _corruptReadPec = false;
+    _stretchPerBitUs = 0;
+    _stretchPerByteUs = 0;
+    _statusByte = 0;
+    _mv3 = 600;
+    _mv4 = 650;
+    _addressedTransactions = 0;
+    _stretchEvents = 0;
+
+    for (size_t i = 0; i < EE871::cmd::CUSTOM_MEMORY_SIZE; ++i) {
+      _memory[i] = 0;
+    }
+    _memory[EE871::cmd::CUSTOM_OPERATING_FUNCTIONS] =
+        EE871::cmd::FEATURE_SERIAL_NUMBER |
+        EE871::cmd::FEATURE_PART_NAME |
+        EE871::cmd::FEATURE_ADDRESS_CONFIG |
+        EE871::cmd::FEATURE_GLOBAL_INTERVAL |
+        EE871::cmd::FEATURE_SPECIFIC_INTERVAL |
+        EE871::cmd::FEATURE_FILTER_CONFIG |
+        EE871::cmd::FEATURE_ERROR_CODE;
+    _memory[EE871::cmd::CUSTOM_OPERATING_MODE_SUPPORT] =
+        EE871::cmd::MODE_SUPPORT_LOW_POWER |
+        EE871::cmd::MODE_SUPPORT_E2_PRIORITY;
+    _memory[EE871::cmd::CUSTOM_SPECIAL_FEATURES] =
+        EE871::cmd::SPECIAL_FEATURE_AUTO_ADJUST;
+    _memory[EE871::cmd::CUSTOM_BUS_ADDRESS] = _address;
+    _memory[EE871::cmd::CUSTOM_INTERVAL_L] =
+        static_cast<uint8_t>(EE871::cmd::INTERVAL_MIN_DECISEC & 0xFF);
+    _memory[EE871::cmd::CUSTOM_INTERVAL_H] =
+        static_cast<uint8_t>(EE871::cmd::INTERVAL_MIN_DECISEC >> 8);
+  }
+
+  uint8_t address() const { return _address; }
+
+  // === Fault hooks ===
+  void setPresent(bool present) { _present = present; }
+  void setHoldSdaLow(bool hold) { _holdSdaLow = hold; }
+  void setHoldSclLow(bool hold) { _holdSclLow = hold; }
+  void setCorruptReadPec(bool corrupt) { _corruptReadPec = corrupt; }
+  /// Hold SCL low for @p us after every SCL falling edge of an addressed transaction.
+  void setStretchPerBitUs(uint32_t us) { _stretchPerBitUs = us; }
+  /// Hold SCL low for @p us after every acknowledged byte of an addressed transaction.
+  void setStretchPerByteUs(uint32_t us) { _stretchPerByteUs = us; }
+
+  // === Device model ===
+  void setStatusByte(uint8_t status) { _statusByte = status; }
+  void setMv3(uint16_t value) { _mv3 = value; }
+  void setMv4(uint16_t value) { _mv4 = value; }
+  void setMemory(uint8_t address, uint8_t value) { _memory[address] = value; }
+  uint8_t memory(uint8_t address) const { return _memory[address]; }
+
+  uint32_t addressedTransactions() const { return _addressedTransactions; }
+  uint32_t stretchEvents() const { return _stretchEvents; }
+
+  // === Line outputs (false = pulling the line low) ===
+  bool sdaOut() const { return !_holdSdaLow && _sdaOut; }
+  bool sclOut(uint64_t nowUs) const { return !_holdSclLow && nowUs >= _stretchUntilUs; }
+  /// Virtual time at which an active stretch ends, or 0 when not stretching.
+  uint64_t stretchUntilUs() const { return _stretchUntilUs; }
+
+  // === Bus events ===
+  void onStart() {
+    _state = State::RX_BYTE;
+    _byteIndex = 0;
+    _bitCount = 0;
+    _byte = 0;
+    _sdaOut = true;
+  }
+
+  void onStop() {
+    _state = State::IDLE;
+    _sdaOut = true;
+  }
+
+  void onSclRising(bool sda) {
+    if (_state == State::RX_BYTE) {
+      _byte = static_cast<uint8_t>((_byte << 1) | (sda ? 1U : 0U));
+      ++_bitCount;
+    } else if (_state == State::RX_MASTER_ACK) {
+      _masterAcked = !sda;
+    }
+  }
+
+  void onSclFalling(uint64_t nowUs) {
+    switch (_state) {
+      case State::RX_BYTE:
+        if (_bitCount >= 8) {
+          receiveByte();
+        }
+        break;
+      case State::TX_ACK:
+        _sdaOut = true;
+        stretch(nowUs, _stretchPerByteUs);
+        afterAck();
+        break;
+      case State::TX_BYTE:
+        ++_bitCount;
+        if (_bitCount < 8) {
+          _sdaOut = txBit();
+        } else {
+          _sdaOut = true;
+          _state = State::RX_MASTER_ACK;
+        }
+        break;
+      case State::RX_MASTER_ACK:
+        if (_byteIndex == 1 && _masterAcked) {
+          _byteIndex = 2;
+          _bitCount = 0;
+          _state = State::TX_BYTE;
+          _sdaOut = txBit();
+        } else {
+          _state = State::DONE;
+        }
+        break;
+      case State::IDLE:
+      case State::IGNORE:
+      case State::DONE:
+        break;
+    }
+    if (_state != State::IDLE && _state != State::IGNORE && _state != State::DONE) {
+      stretch(nowUs, _stretchPerBitUs);
+    }
+  }
+
+private:
+  enum class State : uint8_t {
+    IDLE,
+    RX_BYTE,
+    TX_ACK,
+    TX_BYTE,
+    RX_MASTER_ACK,
+    IGNORE,
+    DONE
+  };
+
+  void stretch(uint64_t nowUs, uint32_t us) {
+    if (us == 0) {
+      return;
+    }
+    const uint64_t until = nowUs + us;
+    if (until > _stretchUntilUs) {
+      _stretchUntilUs = until;
+      ++_stretchEvents;
+    }
+  }
+
+  void receiveByte() {
+    const uint8_t value = _byte;
+    _bitCount = 0;
+    _byte = 0;
+    if (_byteIndex == 0) {
+      _control = value;
+      const uint8_t target = static_cast<uint8_t>((value >> EE871::cmd::ADDR_SHIFT) & 0x07);
+      if (!_present || target != _address) {
+        _state = State::IGNORE;
+        return;
+      }
+      ++_addressedTransactions;
+    } else if (_byteIndex == 1) {
+      _writeAddress = value;
+    } else if (_byteIndex == 2) {
+      _writeData = value;
+    } else {
+      const uint8_t expected =
+          static_cast<uint8_t>((_control + _writeAddress + _writeData) & 0xFF);
+      if (value == expected) {
+        applyWrite();
+      }
+    }
+    _state = State::TX_ACK;
+    _sdaOut = false;
+  }
+
+  void afterAck() {
+    if (_byteIndex == 0 && (_control & EE871::cmd::RW_READ) != 0) {
+      _responseData = readValueForControl();
+      _responsePec = static_cast<uint8_t>((_control + _responseData) & 0xFF);
+      if (_corruptReadPec) {
+        _responsePec = static_cast<uint8_t>(_responsePec ^ 0x01);
+      }
+      _byteIndex = 1;
+      _bitCount = 0;
+      _state = State::TX_BYTE;
+      _sdaOut = txBit();
+      return;
+    }
+    ++_byteIndex;
+    _state = (_byteIndex > 3) ? State::DONE : State::RX_BYTE;
+  }
+
+  bool txBit() const {
+    const uint8_t value = (_byteIndex == 1) ? _responseData : _responsePec;
+    return (value & static_cast<uint8_t>(0x80U >> _bitCount)) != 0;
+  }
+
+  uint8_t readValueForControl() {
+    const uint8_t main = static_cast<uint8_t>(_control >> EE871::cmd::MAIN_SHIFT);
+    switch (main) {
+      case EE871::cmd::MAIN_TYPE_LO:
+        return static_cast<uint8_t>(EE871::cmd::SENSOR_GROUP_ID & 0xFF);
+      case EE871::cmd::MAIN_TYPE_HI:
+        return static_cast<uint8_t>(EE871::cmd::SENSOR_GROUP_ID >> 8);
+      case EE871::cmd::MAIN_TYPE_SUB:
+        return EE871::cmd::SENSOR_SUBGROUP_ID;
+      case EE871::cmd::MAIN_AVAIL_MEAS:
+        return EE871::cmd::AVAILABLE_MEAS_MASK;
+      case EE871::cmd::MAIN_STATUS:
+        return _statusByte;
+      case EE871::cmd::MAIN_MV3_LO:
+        return static_cast<uint8_t>(_mv3 & 0xFF);
+      case EE871::cmd::MAIN_MV3_HI:
+        return static_cast<uint8_t>(_mv3 >> 8);
+      case EE871::cmd::MAIN_MV4_LO:
+        return static_cast<uint8_t>(_mv4 & 0xFF);
+      case EE871::cmd::MAIN_MV4_HI:
+        return static_cast<uint8_t>(_mv4 >> 8);
+      case EE871::cmd::MAIN_CUSTOM_PTR: {
+        const uint8_t value = _memory[_customPointer];
+        ++_customPointer;
+        return value;
+      }
+      default:
+        return 0xFF;
+    }
+  }
+
+  void applyWrite() {
+    const uint8_t main = static_cast<uint8_t>(_control >> EE871::cmd::MAIN_SHIFT);
+    if (main == EE871::cmd::MAIN_CUSTOM_PTR) {
+      _customPointer = _writeData;
+    } else if (main == EE871::cmd::MAIN_CUSTOM_WRITE) {
+      _memory[_writeAddress] = _writeData;
+    }
+  }
+
+  uint8_t _address = 0;
+  State _state = State::IDLE;
+  uint8_t _bitCount = 0;
+  uint8_t _byte = 0;
+  uint8_t _byteIndex = 0;
+  uint8_t _control = 0;
+  uint8_t _writeAddress = 0;
+  uint8_t _writeData = 0;
+  uint8_t _responseData = 0;
+  uint8_t _responsePec = 0;
+  bool _masterAcked = false;
+  bool _sdaOut = true;
+  uint64_t _stretchUntilUs = 0;
+  uint8_t _customPointer = 0;
+  bool _present = true;
+  bool _holdSdaLow = false;
+  bool _holdSclLow = false;
+  bool _corruptReadPec = false;
+  uint32_t _stretchPerBitUs = 0;
+  uint32_t _stretchPerByteUs = 0;
+  uint8_t _statusByte = 0;
+  uint16_t _mv3 = 0;
+  uint16_t _mv4 = 0;
+  uint32_t _addressedTransactions = 0;
+  uint32_t _stretchEvents = 0;
+  uint8_t _memory[EE871::cmd::CUSTOM_MEMORY_SIZE] = {};
+};
+
+/// Shared open-drain SCL/SDA pair resolved as wired-AND of the master and all
+/// attached slaves, running in virtual time advanced only by delayUs().
+///
+/// Several EE871 driver instances (one per device address) can share the bus
+/// through makeConfig(). Slave clock stretches end at exact virtual instants;
+/// the resulting SCL rising edge is dispatched at that instant even when it
+/// falls inside a longer master delay.
+class SimulatedE2Bus {
+public:
+  static constexpr uint8_t MAX_SLAVES = 8;
+
+  SimulatedE2Bus() = default;
+  SimulatedE2Bus(const SimulatedE2Bus&) = delete;
+  SimulatedE2Bus& operator=(const SimulatedE2Bus&) = delete;
+
+  /// Detach all slaves and restart virtual time and statistics.
+  void reset() {
+    _slaveCount = 0;
+    _masterScl = true;
+    _masterSda = true;
+    _lastScl = true;
+    _lastSda = true;
+    _nowUs = 0;
+    _starts = 0;
+    _stops = 0;
+    _inTransaction = false;
+    _startUs = 0;
+    _busyUs = 0;
+    _stretchedUs = 0;
+  }
+
+  /// Attach a slave at @p address; returns the existing slave if already attached.
+  EmulatedEE871& attach(uint8_t address) {
+    const uint8_t addr = static_cast<uint8_t>(address & 0x07);
+    for (uint8_t i = 0; i < _slaveCount; ++i) {
+      if (_slaves[i].address() == addr) {
+        return _slaves[i];
+      }
+    }
+    EmulatedEE871& slave = _slaves[_slaveCount++];
+    slave.reset(addr);
+    return slave;
+  }
+
+  EmulatedEE871& slave(uint8_t index) { return _slaves[index]; }
+  uint8_t slaveCount() const { return _slaveCount; }
+
+  EE871::Config makeConfig(uint8_t deviceAddress, uint8_t offlineThreshold = 5) {
+    EE871::Config cfg;
+    cfg.setScl = &SimulatedE2Bus::setSclThunk;
+    cfg.setSda = &SimulatedE2Bus::setSdaThunk;
+    cfg.readScl = &SimulatedE2Bus::readSclThunk;
+    cfg.readSda = &SimulatedE2Bus::readSdaThunk;
+    cfg.delayUs = &SimulatedE2Bus::delayUsThunk;
+    cfg.busUser = this;
+    cfg.deviceAddress = deviceAddress;
+    cfg.clockLowUs = 100;
+    cfg.clockHighUs = 100;
+    cfg.startHoldUs = 4;
+    cfg.stopHoldUs = 4;
+    cfg.bitTimeoutUs = 25000;
+    cfg.byteTimeoutUs = 35000;
+    cfg.writeDelayMs = 0;
+    cfg.intervalWriteDelayMs = 0;
+    cfg.offlineThreshold = offlineThreshold;
+    return cfg;
+  }
+
+  // === Virtual time and statistics ===
+  uint64_t nowUs() const { return _nowUs; }
+  uint32_t starts() const { return _starts; }
+  uint32_t stops() const { return _stops; }
+  /// Total virtual time spent between START and STOP.
+  uint64_t busyUs() const { return _busyUs + (_inTransaction ? (_nowUs - _startUs) : 0U); }
+  /// Virtual time the master waited on SCL held low by a slave.
+  uint64_t stretchedUs() const { return _stretchedUs; }
+
+  /// Resolved SCL level (wired-AND of master and every slave).
+  bool scl() const {
+    bool level = _masterScl;
+    for (uint8_t i = 0; i < _slaveCount; ++i) {
+      level = level && _slaves[i].sclOut(_nowUs);
+    }
+    return level;
+  }
+
+  /// Resolved SDA level (wired-AND of master and every slave).
+  bool sda() const {
+    bool level = _masterSda;
+    for (uint8_t i = 0; i < _slaveCount; ++i) {
+      level = level && _slaves[i].sdaOut();
+    }
+    return level;
+  }
+
+  /// Advance virtual time, dispatching edges caused by stretches ending.
+  void advance(uint32_t us) {
+    const uint64_t target = _nowUs + us;
+    while (_nowUs < target) {
+      uint64_t next = target;
+      for (uint8_t i = 0; i < _slaveCount; ++i) {
+        const uint64_t until = _slaves[i].stretchUntilUs();
+        if (until > _nowUs && until < next) {
+          next = until;
+        }
+      }
+      if (_masterScl && !scl()) {
+        _stretchedUs += next - _nowUs;
+      }
+      _nowUs = next;
+      resolve();
+    }
+  }
+
+private:
+  static void setSclThunk(bool level, void* user) {
+    auto* self = static_cast<SimulatedE2Bus*>(user);
+    self->_masterScl = level;
+    self->resolve();
+  }
+
+  static void setSdaThunk(bool level, void* user) {
+    auto* self = static_cast<SimulatedE2Bus*>(user);
+    self->_masterSda = level;
+    self->resolve();
+  }
+
+  static bool readSclThunk(void* user) { return static_cast<SimulatedE2Bus*>(user)->scl(); }
+
+  static bool readSdaThunk(void* user) { return static_cast<SimulatedE2Bus*>(user)->sda(); }
+
+  static void delayUsThunk(uint32_t us, void* user) {
+    static_cast<SimulatedE2Bus*>(user)->advance(us);
+  }
+
+  /// Re-evaluate the wired-AND lines and dispatch edges until they settle.
+  void resolve() {
+    for (uint8_t guard = 0; guard < 8; ++guard) {
+      const bool scl = this->scl();
+      const bool sda = this->sda();
+      if (scl == _lastScl && sda == _lastSda) {
+        return;
+      }
+      if (scl != _lastScl) {
+        _lastScl = scl;
+        for (uint8_t i = 0; i < _slaveCount; ++i) {
+          if (scl) {
+            _slaves[i].onSclRising(sda);
+          } else {
+            _slaves[i].onSclFalling(_nowUs);
+          }
+        }
+        continue;
+      }
+      _lastSda = sda;
+      if (scl) {
+        if (!sda) {
+          onStart();
+        } else {
+          onStop();
+        }
+      }
+    }
+  }
+
+  void onStart() {
+    ++_starts;
+    if (!_inTransaction) {
+      _inTransaction = true;
+      _startUs = _nowUs;
+    }
+    for (uint8_t i = 0; i < _slaveCount; ++i) {
+      _slaves[i].onStart();
+    }
+  }
+
+  void onStop() {
+    ++_stops;
+    if (_inTransaction) {
+      _inTransaction = false;
+      _busyUs += _nowUs - _startUs;
+    }
+    for (uint8_t i = 0; i < _slaveCount; ++i) {
+      _slaves[i].onStop();
+    }
+  }
+
+  EmulatedEE871 _slaves[MAX_SLAVES];
+  uint8_t _slaveCount = 0;
+  bool _masterScl = true;
+  bool _masterSda = true;
+  bool _lastScl = true;
+  bool _lastSda = true;
+  uint64_t _nowUs = 0;
+  uint32_t _starts = 0;
+  uint32_t _stops = 0;
+  bool _inTransaction = false;
+  uint64_t _startUs = 0;
+  uint64_t _busyUs = 0;
+  uint64_t _stretchedUs = 0;
+};
+
+} // namespace EE871Test
@@ -1,30 +1,105 @@
 /// @file test_basic.cpp
 /// @brief Native contract tests for EE871 validation and lifecycle guards.
 
+#include <cstring>
 #include <type_traits>
 
 #include <unity.h>
 
+#include "EE871/BusQuota.h"
 #include "EE871/Config.h"
+#include "EE871/ConfigBuilder.h"
+#include "EE871/CyclicSchedule.h"
 #include "EE871/EE871.h"
+#include "EE871/Fleet.h"
+#include "EE871/FleetBoot.h"
+#include "EE871/Metrics.h"
+#include "EE871/MultiBus.h"
+#include "EE871/Pipeline.h"
 #include "EE871/Status.h"
+#include "EE871/SyncMeasurement.h"
+#include "EE871/TransportRecorder.h"
+#include "common/E2TriggerCapture.h"
+#include "idf/common/E2PmLock.h"
+#include "support/E2LineModel.h"
+#include "support/E2TimingChecker.h"
 #include "support/FakeE2Transport.h"
+#include "support/FleetSimulator.h"
+#include "support/GeneratedCyclicSchedule.h"
+#include "support/MockPmApi.h"
+#include "support/MockRadioScheduler.h"
+#include "support/MultiFakeE2Port.h"
+#include "support/MultiSimE2Port.h"
+#include "support/SimulatedE2Bus.h"
 
 using namespace EE871;
+using EE871Test::E2LineModel;
+using EE871Test::E2LineParams;
+using EE871Test::E2TimingChecker;
 using EE871Test::FakeE2Transport;
+using EE871Test::FleetSimulator;
+using EE871Test::MockPmApi;
+using EE871Test::MockRadioScheduler;
+using EE871Test::MultiFakeE2Port;
+using EE871Test::MultiSimE2Port;
+using EE871Test::SimulatedE2Bus;
 
 static_assert(!std::is_copy_constructible_v<EE871::EE871>);
 static_assert(!std::is_copy_assignable_v<EE871::EE871>);
 static_assert(!std::is_move_constructible_v<EE871::EE871>);
 static_assert(!std::is_move_assignable_v<EE871::EE871>);
 
-void setUp() {}
-void tearDown() {}
+// ConfigBuilder validation runs at compile time.
+static constexpr ConfigBuilder kSlowE2 =
+    ConfigBuilder().clockUs(120, 150).holdUs(10, 12).writeDelaysMs(0, 0).deviceAddress(3);
+static_assert(kSlowE2.valid());
+static_assert(!ConfigBuilder().clockUs(99, 100).valid());
+static_assert(!ConfigBuilder().holdUs(4, 3).valid());
+static_assert(!ConfigBuilder().timeoutsUs(25000, 24999).valid());
+static_assert(!ConfigBuilder().writeDelaysMs(cmd::WRITE_DELAY_MAX_MS + 1, 0).valid());
+static_assert(!ConfigBuilder().deviceAddress(cmd::DEVICE_ADDRESS_MAX + 1).valid());
+static_assert(kSlowE2.derived().sampleUs == 75 && kSlowE2.derived().sampleRestUs == 75);
+static_assert(ConfigBuilder().clockUs(100, 101).derived().sampleRestUs == 51);
+static_assert(ConfigBuilder().offlineThreshold(0).build().offlineThreshold == 1);
+
+// Line-level fake configs handed out by checkedFakeConfig() run under a
+// timing checker; tearDown() fails the test on any E2 timing violation.
+static constexpr size_t TIMING_CHECKERS_MAX = 8;
+static E2TimingChecker gTimingCheckers[TIMING_CHECKERS_MAX];
+static size_t gTimingCheckersUsed = 0;
+static bool gTimingCheckersExhausted = false;
+
+void setUp() {
+  gTimingCheckersUsed = 0;
+  gTimingCheckersExhausted = false;
+}
+
+void tearDown() {
+  TEST_ASSERT_FALSE(gTimingCheckersExhausted);
+  for (size_t i = 0; i < gTimingCheckersUsed; ++i) {
+    TEST_ASSERT_EQUAL_STRING("none", gTimingCheckers[i].firstViolation());
+    TEST_ASSERT_EQUAL_UINT32(0u, gTimingCheckers[i].violations().total());
+  }
+}
+
+static Config checkedFakeConfig(FakeE2Transport& fake, uint8_t offlineThreshold = 5) {
+  if (gTimingCheckersUsed >= TIMING_CHECKERS_MAX) {
+    gTimingCheckersExhausted = true;
+    return fake.makeConfig(offlineThreshold);
+  }
+  E2TimingChecker& checker = gTimingCheckers[gTimingCheckersUsed++];
+  checker.reset();
+  return checker.wrap(fake.makeConfig(offlineThreshold));
+}
+
+// When set, beginFakeDevice() uses the fake's byte-level frame hooks.
+static bool gByteLevelFake = false;
 
 static Status beginFakeDevice(EE871::EE871& dev,
                               FakeE2Transport& fake,
                               uint8_t offlineThreshold = 5) {
-  Config cfg = fake.makeConfig(offlineThreshold);
+  Config cfg = gByteLevelFake ? fake.makeByteLevelConfig(offlineThreshold)
+                              : checkedFakeConfig(fake, offlineThreshold);
   return dev.begin(cfg);
 }
 
@@ -582,6 +657,2302 @@ void test_dirty_state_survives_offline() {
   assertDirtyWithOriginalError(dev, dirtyCause);
 }
 
+void test_multibus_begin_rejects_invalid_config() {
+  MultiBusEngine engine;
+  MultiFakeE2Port port(2);
+  MultiBusConfig cfg = port.makeConfig();
+  cfg.busCount = 0;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_CONFIG),
+                          static_cast<uint8_t>(engine.begin(cfg).code));
+  cfg = port.makeConfig();
+  cfg.clockHighUs = 99;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_CONFIG),
+                          static_cast<uint8_t>(engine.begin(cfg).code));
+  TEST_ASSERT_FALSE(engine.isInitialized());
+
+  uint8_t addresses[2] = {};
+  uint16_t values[2] = {};
+  Status results[2];
+  Status st = engine.readU16(0x3, cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI, addresses, values, results);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(st.code));
+
+  TEST_ASSERT_TRUE(engine.begin(port.makeConfig()).ok());
+  st = engine.readU16(0x4, cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI, addresses, values, results);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(st.code));
+}
+
+void test_multibus_reads_all_buses_in_single_bus_time() {
+  MultiFakeE2Port port(4);
+  MultiBusEngine engine;
+  TEST_ASSERT_TRUE(engine.begin(port.makeConfig()).ok());
+  for (uint8_t i = 0; i < 4; ++i) {
+    port.fake(i).setMv4(static_cast<uint16_t>(400 + 111 * i));
+  }
+
+  uint8_t addresses[4] = {};
+  uint16_t values[4] = {};
+  Status results[4];
+  port.resetElapsed();
+  Status st = engine.readU16(engine.allBusesMask(), cmd::MAIN_MV4_LO, cmd::MAIN_MV4_HI,
+                             addresses, values, results);
+  TEST_ASSERT_TRUE(st.ok());
+  for (uint8_t i = 0; i < 4; ++i) {
+    TEST_ASSERT_TRUE(results[i].ok());
+    TEST_ASSERT_EQUAL_UINT16(400 + 111 * i, values[i]);
+  }
+
+  FakeE2Transport single;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, single).ok());
+  single.resetElapsed();
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT32(single.elapsedUs(), port.elapsedUs());
+}
+
+void test_multibus_masks_nack_and_stretch_per_bus() {
+  MultiFakeE2Port port(4);
+  MultiBusEngine engine;
+  TEST_ASSERT_TRUE(engine.begin(port.makeConfig()).ok());
+  port.fake(1).setDevicePresent(false);
+  port.fake(2).setHoldSclLow(true);
+  port.fake(3).setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+
+  uint8_t addresses[4] = {};
+  uint8_t data[4] = {};
+  Status results[4];
+  Status st = engine.readCommand(engine.allBusesMask(), cmd::MAIN_STATUS, addresses, data,
+                                 results);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::E2_ERROR),
+                          static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(0x6, st.detail);
+  TEST_ASSERT_TRUE(results[0].ok());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NACK),
+                          static_cast<uint8_t>(results[1].code));
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::TIMEOUT),
+                          static_cast<uint8_t>(results[2].code));
+  TEST_ASSERT_TRUE(results[3].ok());
+  TEST_ASSERT_EQUAL_UINT8(0, data[0]);
+  TEST_ASSERT_EQUAL_UINT8(cmd::STATUS_CO2_ERROR_MASK, data[3]);
+
+  port.fake(1).setDevicePresent(true);
+  port.fake(2).setHoldSclLow(false);
+  st = engine.readCommand(engine.allBusesMask(), cmd::MAIN_STATUS, addresses, data, results);
+  TEST_ASSERT_TRUE(st.ok());
+}
+
+void test_multibus_write_commands_then_read_custom_memory() {
+  MultiFakeE2Port port(3);
+  MultiBusEngine engine;
+  TEST_ASSERT_TRUE(engine.begin(port.makeConfig()).ok());
+  for (uint8_t i = 0; i < 3; ++i) {
+    port.fake(i).setMemory(static_cast<uint8_t>(0x40 + i), static_cast<uint8_t>(0xA0 + i));
+  }
+
+  uint8_t controls[3] = {};
+  uint8_t addressBytes[3] = {};
+  uint8_t pointers[3] = {};
+  for (uint8_t i = 0; i < 3; ++i) {
+    controls[i] = cmd::makeControlWrite(cmd::MAIN_CUSTOM_PTR, 0);
+    pointers[i] = static_cast<uint8_t>(0x40 + i);
+  }
+  Status results[3];
+  uint32_t accepted = 0;
+  TEST_ASSERT_TRUE(engine.writeCommands(0x7, controls, addressBytes, pointers, results,
+                                        &accepted).ok());
+  TEST_ASSERT_EQUAL_UINT32(0x7u, accepted);
+
+  uint8_t addresses[3] = {};
+  uint8_t data[3] = {};
+  TEST_ASSERT_TRUE(engine.readCommand(0x7, cmd::MAIN_CUSTOM_PTR, addresses, data, results).ok());
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_EQUAL_UINT8(0xA0 + i, data[i]);
+  }
+}
+
+struct LockstepHookLog {
+  uint32_t activityStarts = 0;
+  uint32_t activityEnds = 0;
+  uint32_t quietStarts = 0;
+  uint32_t quietEnds = 0;
+  uint32_t lastExpectedUs = 0;
+  bool activeDuringQuietEnd = false;
+  bool active = false;
+};
+
+static void logLockstepActivity(bool active, void* user) {
+  LockstepHookLog* log = static_cast<LockstepHookLog*>(user);
+  log->active = active;
+  if (active) {
+    ++log->activityStarts;
+  } else {
+    ++log->activityEnds;
+  }
+}
+
+static void logLockstepQuietWindow(bool start, uint32_t expectedUs, void* user) {
+  LockstepHookLog* log = static_cast<LockstepHookLog*>(user);
+  log->lastExpectedUs = expectedUs;
+  if (start) {
+    ++log->quietStarts;
+  } else {
+    ++log->quietEnds;
+    log->activeDuringQuietEnd = log->activeDuringQuietEnd || log->active;
+  }
+}
+
+void test_multibus_notifies_activity_and_quiet_window_hooks() {
+  MultiFakeE2Port port(3);
+  MultiBusConfig cfg = port.makeConfig();
+  LockstepHookLog log;
+  cfg.busActivity = logLockstepActivity;
+  cfg.powerUser = &log;
+  cfg.quietWindow = logLockstepQuietWindow;
+  cfg.radioUser = &log;
+  MultiBusEngine engine;
+  TEST_ASSERT_TRUE(engine.begin(cfg).ok());
+
+  TimingConfig timing;
+  timing.clockLowUs = cfg.clockLowUs;
+  timing.clockHighUs = cfg.clockHighUs;
+  timing.startHoldUs = cfg.startHoldUs;
+  timing.stopHoldUs = cfg.stopHoldUs;
+  timing.bitTimeoutUs = cfg.bitTimeoutUs;
+  timing.byteTimeoutUs = cfg.byteTimeoutUs;
+  const DerivedTiming d = deriveTiming(timing);
+
+  // One notification pair per lockstep transaction, not per bus.
+  uint8_t addresses[3] = {};
+  uint8_t data[3] = {};
+  Status results[3];
+  TEST_ASSERT_TRUE(engine.readCommand(0x7, cmd::MAIN_STATUS, addresses, data, results).ok());
+  TEST_ASSERT_EQUAL_UINT32(1u, log.activityStarts);
+  TEST_ASSERT_EQUAL_UINT32(1u, log.activityEnds);
+  TEST_ASSERT_EQUAL_UINT32(1u, log.quietStarts);
+  TEST_ASSERT_EQUAL_UINT32(1u, log.quietEnds);
+  TEST_ASSERT_EQUAL_UINT32(d.readFrameUs, log.lastExpectedUs);
+  TEST_ASSERT_FALSE(log.active);
+
+  uint8_t controls[3] = {};
+  uint8_t addressBytes[3] = {};
+  uint8_t pointers[3] = {};
+  for (uint8_t i = 0; i < 3; ++i) {
+    controls[i] = cmd::makeControlWrite(cmd::MAIN_CUSTOM_PTR, 0);
+  }
+  TEST_ASSERT_TRUE(engine.writeCommands(0x7, controls, addressBytes, pointers, results).ok());
+  TEST_ASSERT_EQUAL_UINT32(2u, log.activityStarts);
+  TEST_ASSERT_EQUAL_UINT32(2u, log.activityEnds);
+  TEST_ASSERT_EQUAL_UINT32(2u, log.quietStarts);
+  TEST_ASSERT_EQUAL_UINT32(2u, log.quietEnds);
+  TEST_ASSERT_EQUAL_UINT32(d.writeFrameUs, log.lastExpectedUs);
+  TEST_ASSERT_FALSE(log.activeDuringQuietEnd);
+
+  // A NACK on every bus still closes both windows.
+  for (uint8_t i = 0; i < 3; ++i) {
+    port.fake(i).setDevicePresent(false);
+  }
+  TEST_ASSERT_FALSE(engine.readCommand(0x7, cmd::MAIN_STATUS, addresses, data, results).ok());
+  TEST_ASSERT_EQUAL_UINT32(3u, log.activityStarts);
+  TEST_ASSERT_EQUAL_UINT32(3u, log.activityEnds);
+  TEST_ASSERT_EQUAL_UINT32(3u, log.quietEnds);
+  TEST_ASSERT_FALSE(log.active);
+}
+
+void test_simbus_devices_at_different_addresses_share_one_bus() {
+  SimulatedE2Bus bus;
+  const uint8_t addresses[3] = {0, 3, 5};
+  for (uint8_t i = 0; i < 3; ++i) {
+    bus.attach(addresses[i]).setMv4(static_cast<uint16_t>(400 + 100 * i));
+  }
+
+  EE871::EE871 devs[3];
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_TRUE(devs[i].begin(bus.makeConfig(addresses[i])).ok());
+  }
+  for (uint8_t i = 0; i < 3; ++i) {
+    uint16_t ppm = 0;
+    TEST_ASSERT_TRUE(devs[i].readCo2Average(ppm).ok());
+    TEST_ASSERT_EQUAL_UINT16(400 + 100 * i, ppm);
+    TEST_ASSERT_TRUE(bus.slave(i).addressedTransactions() > 0);
+  }
+
+  TEST_ASSERT_TRUE(devs[1].customWrite(0x40, 0x5A).ok());
+  TEST_ASSERT_EQUAL_UINT8(0x5A, bus.slave(1).memory(0x40));
+  TEST_ASSERT_EQUAL_UINT8(0x00, bus.slave(0).memory(0x40));
+  TEST_ASSERT_EQUAL_UINT8(0x00, bus.slave(2).memory(0x40));
+
+  TEST_ASSERT_EQUAL_UINT32(bus.starts(), bus.stops());
+  TEST_ASSERT_TRUE(bus.busyUs() > 0);
+  TEST_ASSERT_TRUE(bus.nowUs() >= bus.busyUs());
+  TEST_ASSERT_EQUAL_UINT32(0u, static_cast<uint32_t>(bus.stretchedUs()));
+}
+
+void test_simbus_slave_clock_stretch_is_waited_and_timed() {
+  SimulatedE2Bus bus;
+  bus.attach(0).setMv4(700);
+  EE871Test::EmulatedEE871& slow = bus.attach(2);
+  slow.setMv4(800);
+
+  EE871::EE871 fast;
+  EE871::EE871 stretched;
+  TEST_ASSERT_TRUE(fast.begin(bus.makeConfig(0)).ok());
+  TEST_ASSERT_TRUE(stretched.begin(bus.makeConfig(2)).ok());
+
+  slow.setStretchPerByteUs(500);
+  const uint64_t before = bus.nowUs();
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(stretched.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(800, ppm);
+  // One stretch per acknowledged control byte; SCL low time overlaps the stretch.
+  TEST_ASSERT_EQUAL_UINT32(2u, slow.stretchEvents());
+  TEST_ASSERT_TRUE(bus.stretchedUs() >= 2u * (500u - 100u - cmd::DATA_SETUP_US));
+  TEST_ASSERT_TRUE(bus.nowUs() - before > bus.stretchedUs());
+
+  // A stretch beyond the bit timeout aborts mid-read; the slave still drives
+  // SDA, so the shared bus needs the bus-reset clocks before anyone else talks.
+  slow.setStretchPerByteUs(40000);
+  TEST_ASSERT_FALSE(stretched.readCo2Average(ppm).ok());
+  slow.setStretchPerByteUs(0);
+  TEST_ASSERT_TRUE(stretched.recover().ok());
+  TEST_ASSERT_TRUE(fast.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(700, ppm);
+}
+
+void test_simbus_slave_holding_sda_blocks_every_device_until_released() {
+  SimulatedE2Bus bus;
+  bus.attach(1).setMv4(900);
+  EE871Test::EmulatedEE871& faulty = bus.attach(4);
+
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(bus.makeConfig(1, 1)).ok());
+
+  faulty.setHoldSdaLow(true);
+  uint16_t ppm = 0;
+  TEST_ASSERT_FALSE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL(DriverState::OFFLINE, dev.state());
+  TEST_ASSERT_FALSE(bus.sda());
+
+  faulty.setHoldSdaLow(false);
+  TEST_ASSERT_TRUE(dev.recover().ok());
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(900, ppm);
+  TEST_ASSERT_EQUAL_UINT32(0u, faulty.addressedTransactions());
+}
+
+void test_timing_checker_driver_operations_conform() {
+  FakeE2Transport fake;
+  E2TimingChecker checker;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(checker.wrap(fake.makeConfig())).ok());
+
+  uint16_t ppm = 0;
+  uint8_t status = 0;
+  uint8_t buf[4] = {};
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_TRUE(dev.customRead(0x00, buf, sizeof(buf)).ok());
+  TEST_ASSERT_TRUE(dev.customWrite(0x40, 0x12).ok());
+  TEST_ASSERT_TRUE(dev.busReset().ok());
+  TEST_ASSERT_TRUE(dev.recover().ok());
+  fake.setDevicePresent(false);
+  TEST_ASSERT_FALSE(dev.readCo2Fast(ppm).ok());
+
+  TEST_ASSERT_EQUAL_STRING("none", checker.firstViolation());
+  TEST_ASSERT_EQUAL_UINT32(0u, checker.violations().total());
+  TEST_ASSERT_TRUE(checker.starts() > 0);
+  TEST_ASSERT_EQUAL_UINT32(checker.starts() + 2u, checker.stops());
+  TEST_ASSERT_TRUE(checker.sclPulses() > 0);
+
+  // Stretching slaves on a shared bus must not shorten the observed high time.
+  SimulatedE2Bus bus;
+  bus.attach(0).setStretchPerBitUs(30);
+  bus.attach(6).setStretchPerByteUs(250);
+  E2TimingChecker sharedChecker;
+  EE871::EE871 first;
+  EE871::EE871 second;
+  TEST_ASSERT_TRUE(first.begin(sharedChecker.wrap(bus.makeConfig(0))).ok());
+  TEST_ASSERT_TRUE(second.begin(sharedChecker.wrap(bus.makeConfig(6))).ok());
+  TEST_ASSERT_TRUE(first.readCo2Average(ppm).ok());
+  TEST_ASSERT_TRUE(second.readCo2Average(ppm).ok());
+  TEST_ASSERT_TRUE(bus.stretchedUs() > 0);
+  TEST_ASSERT_EQUAL_STRING("none", sharedChecker.firstViolation());
+  TEST_ASSERT_EQUAL_UINT32(0u, sharedChecker.violations().total());
+}
+
+void test_timing_checker_flags_each_rule() {
+  FakeE2Transport fake;
+  E2TimingChecker checker;
+  const Config cfg = checker.wrap(fake.makeConfig());
+  void* user = cfg.busUser;
+
+  cfg.delayUs(10, user);
+  cfg.setSda(false, user);  // START, setup 10 us
+  cfg.delayUs(2, user);
+  cfg.setScl(false, user);  // start hold 2 us
+  cfg.delayUs(50, user);
+  cfg.setSda(true, user);
+  cfg.delayUs(5, user);
+  cfg.setScl(true, user);   // clock low 55 us, data setup 5 us
+  TEST_ASSERT_TRUE(cfg.readScl(user));
+  cfg.delayUs(50, user);
+  cfg.setSda(false, user);  // SDA change while SCL high inside transaction
+  cfg.delayUs(10, user);
+  cfg.setScl(false, user);  // clock high 60 us
+  cfg.delayUs(100, user);
+  cfg.setScl(true, user);
+  TEST_ASSERT_TRUE(cfg.readScl(user));
+  cfg.delayUs(1, user);
+  cfg.setSda(true, user);   // STOP after 1 us
+  cfg.delayUs(1, user);
+  cfg.setSda(false, user);  // START 1 us after STOP
+
+  const auto& v = checker.violations();
+  TEST_ASSERT_EQUAL_UINT32(1u, v.startHold);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.clockLow);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.dataSetup);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.sdaWhileSclHigh);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.clockHigh);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.stopHold);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.startSetup);
+  TEST_ASSERT_EQUAL_UINT32(1u, v.unexpectedStop);  // The STOP came two pulses in.
+  TEST_ASSERT_EQUAL_UINT32(8u, v.total());
+  TEST_ASSERT_EQUAL_STRING("startHold", checker.firstViolation());
+  TEST_ASSERT_EQUAL_UINT32(12u, static_cast<uint32_t>(checker.firstViolationUs()));
+
+  checker.resetCounts();
+  TEST_ASSERT_EQUAL_UINT32(0u, checker.violations().total());
+  TEST_ASSERT_EQUAL_STRING("none", checker.firstViolation());
+}
+
+void test_timing_checker_flags_misordered_one_bit() {
+  FakeE2Transport fake;
+  E2TimingChecker checker;
+  const Config cfg = checker.wrap(fake.makeConfig());
+  void* user = cfg.busUser;
+
+  cfg.delayUs(10, user);
+  cfg.setSda(false, user);  // START
+  cfg.delayUs(10, user);
+  cfg.setScl(false, user);
+  cfg.delayUs(100, user);
+  // A '1' bit released in the wrong order: SCL first, then SDA.
+  cfg.setScl(true, user);
+  TEST_ASSERT_TRUE(cfg.readScl(user));
+  cfg.delayUs(10, user);
+  cfg.setSda(true, user);
+  cfg.delayUs(90, user);
+  cfg.setScl(false, user);
+
+  TEST_ASSERT_EQUAL_UINT32(1u, checker.violations().unexpectedStop);
+  TEST_ASSERT_EQUAL_UINT32(1u, checker.violations().total());
+  TEST_ASSERT_EQUAL_STRING("unexpectedStop", checker.firstViolation());
+}
+
+void test_begin_rejects_single_frame_hook() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  Config cfg = fake.makeByteLevelConfig();
+  cfg.writeFrame = nullptr;
+  Status st = dev.begin(cfg);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_CONFIG),
+                          static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_STRING("Frame hooks must be set together", st.msg);
+}
+
+void test_byte_level_frames_match_edge_path() {
+  FakeE2Transport edge;
+  FakeE2Transport frames;
+  EE871::EE871 edgeDev;
+  EE871::EE871 frameDev;
+  assertSameStatus(edgeDev.begin(checkedFakeConfig(edge)),
+                   frameDev.begin(frames.makeByteLevelConfig()));
+  TEST_ASSERT_EQUAL_UINT32(edge.elapsedUs(), frames.elapsedUs());
+
+  uint16_t edgePpm = 0;
+  uint16_t framePpm = 0;
+  assertSameStatus(edgeDev.readCo2Average(edgePpm), frameDev.readCo2Average(framePpm));
+  TEST_ASSERT_EQUAL_UINT16(edgePpm, framePpm);
+
+  uint8_t edgeBuf[6] = {};
+  uint8_t frameBuf[6] = {};
+  assertSameStatus(edgeDev.customRead(0x00, edgeBuf, sizeof(edgeBuf)),
+                   frameDev.customRead(0x00, frameBuf, sizeof(frameBuf)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(edgeBuf, frameBuf, sizeof(edgeBuf));
+
+  assertSameStatus(edgeDev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x21),
+                   frameDev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x21));
+  TEST_ASSERT_EQUAL_UINT8(0x21, frames.memory(cmd::CUSTOM_FILTER_CO2));
+
+  edge.failNextWriteToAddress(cmd::CUSTOM_FILTER_CO2);
+  frames.failNextWriteToAddress(cmd::CUSTOM_FILTER_CO2);
+  assertSameStatus(edgeDev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x22),
+                   frameDev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x22));
+
+  uint8_t edgeStatus = 0;
+  uint8_t frameStatus = 0;
+  edge.setCorruptReadPec(true);
+  frames.setCorruptReadPec(true);
+  assertSameStatus(edgeDev.readStatus(edgeStatus), frameDev.readStatus(frameStatus));
+  edge.setCorruptReadPec(false);
+  frames.setCorruptReadPec(false);
+
+  edge.setSdaStuckLow(true);
+  frames.setSdaStuckLow(true);
+  assertSameStatus(edgeDev.readStatus(edgeStatus), frameDev.readStatus(frameStatus));
+  edge.setSdaStuckLow(false);
+  frames.setSdaStuckLow(false);
+
+  edge.setDevicePresent(false);
+  frames.setDevicePresent(false);
+  assertSameStatus(edgeDev.readStatus(edgeStatus), frameDev.readStatus(frameStatus));
+  edge.setDevicePresent(true);
+  frames.setDevicePresent(true);
+
+  edge.setHoldSclLow(true);
+  frames.setHoldSclLow(true);
+  assertSameStatus(edgeDev.readStatus(edgeStatus), frameDev.readStatus(frameStatus));
+
+  TEST_ASSERT_EQUAL_UINT32(edge.elapsedUs(), frames.elapsedUs());
+  TEST_ASSERT_EQUAL_UINT32(edgeDev.totalFailures(), frameDev.totalFailures());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(edgeDev.state()),
+                          static_cast<uint8_t>(frameDev.state()));
+  TEST_ASSERT_TRUE(frames.frames() > 0);
+  TEST_ASSERT_EQUAL_UINT32(frames.frames(), frames.delayCalls());
+  TEST_ASSERT_TRUE(edge.delayCalls() > 50U * frames.delayCalls());
+}
+
+void test_line_model_rc_edges_follow_time_constant() {
+  E2LineParams params;
+  params.pullUpOhms = 10000.0;
+  params.capacitancePf = 10000.0;  // 100 us rise tau, 0.5 us fall tau
+  E2LineModel model(params);
+  FakeE2Transport fake;
+  const Config cfg = model.wrap(fake.makeConfig());
+  void* user = cfg.busUser;
+
+  TEST_ASSERT_TRUE(model.riseTimeUs() > 219.0 && model.riseTimeUs() < 220.0);
+  TEST_ASSERT_TRUE(model.riseToThresholdUs() > 69.0 && model.riseToThresholdUs() < 70.0);
+
+  cfg.setScl(false, user);
+  cfg.delayUs(10, user);
+  TEST_ASSERT_FALSE(cfg.readScl(user));
+  TEST_ASSERT_TRUE(model.sclVolts() < 0.01);
+
+  cfg.setScl(true, user);
+  cfg.delayUs(60, user);
+  TEST_ASSERT_FALSE(cfg.readScl(user));
+  cfg.delayUs(10, user);
+  TEST_ASSERT_TRUE(cfg.readScl(user));
+  TEST_ASSERT_EQUAL_UINT32(80u, static_cast<uint32_t>(model.nowUs()));
+  TEST_ASSERT_EQUAL_UINT32(80u, fake.elapsedUs());
+  TEST_ASSERT_EQUAL_UINT32(0u, model.noiseFlips());
+}
+
+static Status readThroughLineModel(const E2LineParams& params, uint16_t& ppm,
+                                   uint32_t& elapsedUs, uint32_t& noiseFlips) {
+  E2LineModel model(params);
+  FakeE2Transport fake;
+  fake.setMv4(1234);
+  Config cfg = model.wrap(checkedFakeConfig(fake));
+  cfg.bitTimeoutUs = 1000;
+  cfg.byteTimeoutUs = 2000;
+  EE871::EE871 dev;
+  Status st = dev.begin(cfg);
+  if (st.ok()) {
+    fake.resetElapsed();
+    st = dev.readCo2Average(ppm);
+  }
+  elapsedUs = fake.elapsedUs();
+  noiseFlips = model.noiseFlips();
+  return st;
+}
+
+void test_line_model_slow_edges_stretch_and_noise_is_deterministic() {
+  uint16_t ppm = 0;
+  uint32_t cleanUs = 0;
+  uint32_t flips = 0;
+  TEST_ASSERT_TRUE(readThroughLineModel(E2LineParams(), ppm, cleanUs, flips).ok());
+  TEST_ASSERT_EQUAL_UINT16(1234, ppm);
+
+  // 20 us rise tau: every SCL release reads back low for ~14 us like a stretch.
+  E2LineParams cable;
+  cable.pullUpOhms = 10000.0;
+  cable.capacitancePf = 2000.0;
+  uint32_t cableUs = 0;
+  ppm = 0;
+  TEST_ASSERT_TRUE(readThroughLineModel(cable, ppm, cableUs, flips).ok());
+  TEST_ASSERT_EQUAL_UINT16(1234, ppm);
+  TEST_ASSERT_TRUE(cableUs > cleanUs + 50u * 10u);
+
+  E2LineParams noisy;
+  noisy.noiseSigmaV = 1.2;
+  noisy.impulseProbability = 0.01;
+  noisy.impulseV = 3.0;
+  noisy.seed = 42;
+  uint32_t firstUs = 0;
+  uint32_t firstFlips = 0;
+  const Status first = readThroughLineModel(noisy, ppm, firstUs, firstFlips);
+  TEST_ASSERT_FALSE(first.ok());
+  TEST_ASSERT_TRUE(firstFlips > 0);
+
+  uint32_t secondUs = 0;
+  uint32_t secondFlips = 0;
+  assertSameStatus(first, readThroughLineModel(noisy, ppm, secondUs, secondFlips));
+  TEST_ASSERT_EQUAL_UINT32(firstUs, secondUs);
+  TEST_ASSERT_EQUAL_UINT32(firstFlips, secondFlips);
+}
+
+void test_recorder_replay_reproduces_session_without_hardware() {
+  static uint8_t recording[32768];
+  FakeE2Transport fake;
+  fake.setMv4(777);
+  fake.setMemory(cmd::CUSTOM_FILTER_CO2, 0x03);
+  Config fakeCfg = checkedFakeConfig(fake);
+  fakeCfg.writeDelayMs = 5;
+
+  TransportRecorder recorder;
+  TEST_ASSERT_TRUE(recorder.begin(fakeCfg, recording, sizeof(recording)).ok());
+  EE871::EE871 live;
+  TEST_ASSERT_TRUE(live.begin(recorder.config()).ok());
+  uint16_t livePpm = 0;
+  TEST_ASSERT_TRUE(live.readCo2Average(livePpm).ok());
+  TEST_ASSERT_TRUE(live.customWrite(cmd::CUSTOM_FILTER_CO2, 0x07).ok());
+  fake.setCorruptReadPec(true);
+  uint8_t status = 0;
+  const Status liveFault = live.readStatus(status);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::PEC_MISMATCH),
+                          static_cast<uint8_t>(liveFault.code));
+  recorder.end();
+
+  TEST_ASSERT_FALSE(recorder.overflowed());
+  TEST_ASSERT_TRUE(recorder.size() > 0);
+  // Run-length coded flash waits and one-byte line events keep it compact.
+  TEST_ASSERT_TRUE(recorder.size() < recorder.events() * 2u);
+
+  TransportReplayer replayer;
+  TEST_ASSERT_TRUE(replayer.begin(fakeCfg, recorder.data(), recorder.size()).ok());
+  EE871::EE871 replayed;
+  TEST_ASSERT_TRUE(replayed.begin(replayer.config()).ok());
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(replayed.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(livePpm, ppm);
+  TEST_ASSERT_TRUE(replayed.customWrite(cmd::CUSTOM_FILTER_CO2, 0x07).ok());
+  assertSameStatus(liveFault, replayed.readStatus(status));
+
+  TEST_ASSERT_TRUE(replayer.finished());
+  TEST_ASSERT_FALSE(replayer.exhausted());
+  TEST_ASSERT_FALSE(replayer.malformed());
+  TEST_ASSERT_EQUAL_UINT32(0u, replayer.divergences());
+  TEST_ASSERT_EQUAL_UINT32(fake.elapsedUs(), static_cast<uint32_t>(replayer.replayedUs()));
+}
+
+void test_replay_flags_divergence_and_recorder_overflow() {
+  static uint8_t recording[4096];
+  FakeE2Transport fake;
+  Config fakeCfg = checkedFakeConfig(fake);
+  TransportRecorder recorder;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(recorder.begin(fakeCfg, nullptr, 0).code));
+  TEST_ASSERT_TRUE(recorder.begin(fakeCfg, recording, sizeof(recording)).ok());
+  EE871::EE871 live;
+  TEST_ASSERT_TRUE(live.begin(recorder.config()).ok());
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(live.readStatus(status).ok());
+  recorder.end();
+
+  // Replaying a different command diverges from the recording.
+  TransportReplayer replayer;
+  TEST_ASSERT_TRUE(replayer.begin(fakeCfg, recorder.data(), recorder.size()).ok());
+  EE871::EE871 replayed;
+  TEST_ASSERT_TRUE(replayed.begin(replayer.config()).ok());
+  TEST_ASSERT_EQUAL_UINT32(0u, replayer.divergences());
+  uint16_t ppm = 0;
+  replayed.readCo2Fast(ppm);
+  TEST_ASSERT_TRUE(replayer.divergences() > 0);
+  TEST_ASSERT_TRUE(replayer.firstDivergenceOffset() < recorder.size());
+
+  // Replaying past the end reads an idle bus.
+  replayed.readStatus(status);
+  TEST_ASSERT_TRUE(replayer.exhausted());
+
+  uint8_t small[64];
+  TEST_ASSERT_TRUE(recorder.begin(fakeCfg, small, sizeof(small)).ok());
+  EE871::EE871 clipped;
+  TEST_ASSERT_TRUE(clipped.begin(recorder.config()).ok());
+  TEST_ASSERT_TRUE(recorder.overflowed());
+  TEST_ASSERT_TRUE(recorder.size() <= sizeof(small));
+}
+
+void test_op_info_reports_per_call_cost() {
+  FakeE2Transport fake;
+  Config cfg = checkedFakeConfig(fake);
+  cfg.writeDelayMs = 3;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(cfg).ok());
+  TEST_ASSERT_EQUAL_UINT16(6, dev.lastOpInfo().transactions);
+
+  fake.resetElapsed();
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  OpInfo info = dev.lastOpInfo();
+  TEST_ASSERT_EQUAL_UINT16(2, info.transactions);
+  TEST_ASSERT_EQUAL_UINT16(6, info.bytesTransferred);
+  TEST_ASSERT_EQUAL_UINT32(fake.elapsedUs(), info.busUs);
+  TEST_ASSERT_EQUAL_UINT32(0u, info.stretchUs);
+  TEST_ASSERT_EQUAL_UINT32(0u, info.commitWaitUs);
+  TEST_ASSERT_FALSE(info.cacheHit);
+  TEST_ASSERT_FALSE(info.coalesced);
+
+  // Nested public calls (pointer set, write, verify read) add to one record.
+  fake.resetElapsed();
+  TEST_ASSERT_TRUE(dev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x09).ok());
+  info = dev.lastOpInfo();
+  TEST_ASSERT_EQUAL_UINT16(3, info.transactions);
+  TEST_ASSERT_EQUAL_UINT16(11, info.bytesTransferred);
+  TEST_ASSERT_EQUAL_UINT32(3000u, info.commitWaitUs);
+  TEST_ASSERT_EQUAL_UINT32(fake.elapsedUs(), info.busUs + info.commitWaitUs);
+
+  // State-only accessors keep the previous record.
+  (void)dev.state();
+  (void)dev.totalSuccess();
+  TEST_ASSERT_EQUAL_UINT16(3, dev.lastOpInfo().transactions);
+
+  fake.setDevicePresent(false);
+  uint8_t status = 0;
+  TEST_ASSERT_FALSE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().bytesTransferred);
+
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(EE871::EE871().readStatus(status).code));
+}
+
+void test_op_info_separates_stretch_and_frame_hooks() {
+  SimulatedE2Bus bus;
+  bus.attach(0).setStretchPerByteUs(500);
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(bus.makeConfig(0)).ok());
+  const uint64_t before = bus.nowUs();
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(dev.readCo2Fast(ppm).ok());
+  const OpInfo& info = dev.lastOpInfo();
+  TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(bus.nowUs() - before), info.busUs);
+  TEST_ASSERT_TRUE(info.stretchUs >= 2u * (500u - 100u - cmd::DATA_SETUP_US));
+  TEST_ASSERT_TRUE(info.stretchUs < info.busUs);
+
+  TEST_ASSERT_TRUE(dev.busReset().ok());
+  TEST_ASSERT_EQUAL_UINT16(0, dev.lastOpInfo().transactions);
+  TEST_ASSERT_TRUE(dev.lastOpInfo().busUs > 0);
+
+  FakeE2Transport fake;
+  EE871::EE871 fast;
+  TEST_ASSERT_TRUE(fast.begin(fake.makeByteLevelConfig()).ok());
+  TEST_ASSERT_TRUE(fast.readCo2Fast(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(2, fast.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT16(6, fast.lastOpInfo().bytesTransferred);
+  const DerivedTiming nominal = deriveTiming(timingOf(fast.getConfig()));
+  TEST_ASSERT_EQUAL_UINT32(2u * nominal.readFrameUs, fast.lastOpInfo().busUs);
+  TEST_ASSERT_EQUAL_UINT32(0u, fast.lastOpInfo().stretchUs);
+}
+
+void test_execute_merges_custom_reads_with_one_health_pass() {
+  FakeE2Transport fake;
+  fake.setStatusByte(0x00);
+  fake.setMv4(1234);
+  fake.setMemory(cmd::CUSTOM_OPERATING_FUNCTIONS, 0x5A);
+  fake.setMemory(cmd::CUSTOM_SPECIAL_FEATURES, 0x01);
+  fake.setMemory(cmd::CUSTOM_FW_VERSION_MAIN, 3);
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+  const uint32_t successBefore = dev.totalSuccess();
+
+  uint8_t status = 0xFF;
+  uint8_t mvLow = 0;
+  uint8_t mvHigh = 0;
+  uint8_t functions = 0;
+  uint8_t features[2] = {};
+  uint8_t fw = 0;
+  Request reqs[] = {
+      Request::customRead(cmd::CUSTOM_SPECIAL_FEATURES - 1, features, 2),
+      Request::controlRead(cmd::MAIN_STATUS, status),
+      Request::customRead(cmd::CUSTOM_OPERATING_FUNCTIONS, &functions, 1),
+      Request::controlRead(cmd::MAIN_MV4_LO, mvLow),
+      Request::controlRead(cmd::MAIN_MV4_HI, mvHigh),
+      Request::customRead(cmd::CUSTOM_FW_VERSION_MAIN, &fw, 1),
+  };
+  TEST_ASSERT_TRUE(dev.execute(reqs, 6).ok());
+  for (const Request& req : reqs) {
+    TEST_ASSERT_TRUE(req.status.ok());
+  }
+  TEST_ASSERT_EQUAL_UINT8(0x00, status);
+  TEST_ASSERT_EQUAL_UINT16(1234, static_cast<uint16_t>(mvLow | (mvHigh << 8)));
+  TEST_ASSERT_EQUAL_HEX8(0x5A, functions);
+  TEST_ASSERT_EQUAL_HEX8(0x01, features[1]);
+  TEST_ASSERT_EQUAL_UINT8(3, fw);
+
+  // 0x07-0x09 share one pointer write; firmware byte 0x00 needs its own.
+  // Separate calls would take 3 + 4 * 2 = 11 transactions and 7 health updates.
+  const OpInfo& info = dev.lastOpInfo();
+  TEST_ASSERT_TRUE(info.coalesced);
+  TEST_ASSERT_EQUAL_UINT16(3 + 2 + 4, info.transactions);
+  TEST_ASSERT_EQUAL_UINT32(successBefore + 1, dev.totalSuccess());
+}
+
+void test_execute_validates_orders_writes_and_stops_on_failure() {
+  FakeE2Transport fake;
+  fake.setMemory(cmd::CUSTOM_FILTER_CO2, 0x04);
+  EE871::EE871 dev;
+
+  uint8_t before = 0;
+  Request single[] = {Request::customRead(cmd::CUSTOM_FILTER_CO2, &before, 1)};
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(dev.execute(single, 1).code));
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(single[0].status.code));
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+
+  uint8_t ptr = 0;
+  uint8_t wide[2] = {};
+  uint8_t after = 0;
+  const uint8_t value = 0x09;
+  Request reqs[] = {
+      Request::controlRead(cmd::MAIN_CUSTOM_PTR, ptr),
+      Request::customRead(cmd::CUSTOM_FILTER_CO2, &before, 1),
+      Request::customRead(0xFF, wide, 2),
+      Request::customWrite(cmd::CUSTOM_FILTER_CO2, &value, 1),
+      Request::customRead(cmd::CUSTOM_FILTER_CO2, &after, 1),
+  };
+  const uint64_t linesBefore = fake.elapsedUs();
+  const Status st = dev.execute(reqs, 5);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(st.code));
+  assertSameStatus(st, reqs[0].status);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OUT_OF_RANGE),
+                          static_cast<uint8_t>(reqs[2].status.code));
+  const size_t pending[] = {1, 3, 4};
+  for (size_t i : pending) {
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                            static_cast<uint8_t>(reqs[i].status.code));
+    TEST_ASSERT_EQUAL_INT32(0, reqs[i].status.detail);
+    TEST_ASSERT_EQUAL_STRING("Not executed after invalid request", reqs[i].status.msg);
+  }
+  // Rejected as a whole: no write reached the device, no bus time spent.
+  TEST_ASSERT_EQUAL_HEX8(0x04, fake.memory(cmd::CUSTOM_FILTER_CO2));
+  TEST_ASSERT_EQUAL_UINT16(0, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT64(linesBefore, fake.elapsedUs());
+
+  Request valid[] = {reqs[1], reqs[3], reqs[4]};
+  TEST_ASSERT_TRUE(dev.execute(valid, 3).ok());
+  TEST_ASSERT_EQUAL_HEX8(0x04, before);
+  TEST_ASSERT_EQUAL_HEX8(0x09, after);
+  TEST_ASSERT_EQUAL_HEX8(0x09, fake.memory(cmd::CUSTOM_FILTER_CO2));
+
+  fake.setDevicePresent(false);
+  const uint8_t failuresBefore = dev.consecutiveFailures();
+  uint8_t status = 0;
+  Request failing[] = {
+      Request::controlRead(cmd::MAIN_STATUS, status),
+      Request::customRead(cmd::CUSTOM_FILTER_CO2, &after, 1),
+      Request::customWrite(cmd::CUSTOM_FILTER_CO2, &value, 1),
+  };
+  const Status failSt = dev.execute(failing, 3);
+  TEST_ASSERT_FALSE(failSt.ok());
+  assertSameStatus(failSt, failing[0].status);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(failSt.code),
+                          static_cast<uint8_t>(failing[2].status.code));
+  TEST_ASSERT_EQUAL_INT32(0, failing[1].status.detail);
+  TEST_ASSERT_EQUAL_STRING("Not executed after batch failure", failing[2].status.msg);
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT8(failuresBefore + 1, dev.consecutiveFailures());
+}
+
+void test_execute_partial_multibyte_write_marks_dirty() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+
+  const uint8_t name[3] = {'A', 'B', 'C'};
+  fake.failNextWriteToAddress(static_cast<uint8_t>(cmd::CUSTOM_PART_NAME_START + 1));
+  Request reqs[] = {Request::customWrite(cmd::CUSTOM_PART_NAME_START, name, 3)};
+  const Status st = dev.execute(reqs, 1);
+  TEST_ASSERT_FALSE(st.ok());
+  TEST_ASSERT_EQUAL_HEX8('A', fake.memory(cmd::CUSTOM_PART_NAME_START));
+  assertDirtyWithOriginalError(dev, st);
+}
+
+void test_status_report_chains_error_code_on_error_bit() {
+  FakeE2Transport fake;
+  fake.setMv4(812);
+  fake.setMemory(cmd::CUSTOM_ERROR_CODE, cmd::CO2_ERROR_SENSOR_COUNTS_LOW);
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+
+  StatusReport report;
+  TEST_ASSERT_TRUE(dev.readStatus(report).ok());
+  TEST_ASSERT_FALSE(report.co2Error);
+  TEST_ASSERT_FALSE(report.errorCodeValid);
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().transactions);
+
+  fake.setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+  TEST_ASSERT_TRUE(dev.readStatus(report).ok());
+  TEST_ASSERT_TRUE(report.co2Error);
+  TEST_ASSERT_TRUE(report.errorCodeValid);
+  TEST_ASSERT_EQUAL_UINT8(cmd::CO2_ERROR_SENSOR_COUNTS_LOW, report.errorCode);
+  TEST_ASSERT_EQUAL_STRING("sensor counts low", report.errorCodeName);
+  TEST_ASSERT_EQUAL_UINT16(3, dev.lastOpInfo().transactions);
+
+  MeasurementFrame frame;
+  TEST_ASSERT_TRUE(dev.readMeasurement(frame).ok());
+  TEST_ASSERT_EQUAL_UINT16(812, frame.co2Average);
+  TEST_ASSERT_TRUE(frame.status.errorCodeValid);
+  TEST_ASSERT_EQUAL_UINT16(5, dev.lastOpInfo().transactions);
+
+  // Without error-code support the bit is reported but nothing is chained.
+  FakeE2Transport plain;
+  plain.setMemory(cmd::CUSTOM_OPERATING_FUNCTIONS, 0);
+  plain.setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+  EE871::EE871 other;
+  TEST_ASSERT_TRUE(beginFakeDevice(other, plain).ok());
+  TEST_ASSERT_TRUE(other.readMeasurement(frame).ok());
+  TEST_ASSERT_TRUE(frame.status.co2Error);
+  TEST_ASSERT_FALSE(frame.status.errorCodeValid);
+  TEST_ASSERT_EQUAL_STRING("", frame.status.errorCodeName);
+  TEST_ASSERT_EQUAL_UINT16(3, other.lastOpInfo().transactions);
+}
+
+void test_custom_pointer_tracking_skips_redundant_pointer_writes() {
+  FakeE2Transport fake;
+  fake.setMemory(cmd::CUSTOM_FW_VERSION_MAIN, 2);
+  fake.setMemory(cmd::CUSTOM_FW_VERSION_SUB, 7);
+  Config cfg = checkedFakeConfig(fake);
+  cfg.writeDelayMs = 0;
+  uint8_t main = 0;
+  uint8_t sub = 0;
+
+  EE871::EE871 untracked;
+  TEST_ASSERT_TRUE(untracked.begin(cfg).ok());
+  TEST_ASSERT_TRUE(untracked.readFirmwareVersion(main, sub).ok());
+  TEST_ASSERT_EQUAL_UINT16(4, untracked.lastOpInfo().transactions);
+  TEST_ASSERT_FALSE(untracked.lastOpInfo().cacheHit);
+
+  cfg.trackCustomPointer = true;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(cfg).ok());
+  TEST_ASSERT_TRUE(dev.readFirmwareVersion(main, sub).ok());
+  TEST_ASSERT_EQUAL_UINT8(2, main);
+  TEST_ASSERT_EQUAL_UINT8(7, sub);
+  TEST_ASSERT_EQUAL_UINT16(3, dev.lastOpInfo().transactions);
+  TEST_ASSERT_TRUE(dev.lastOpInfo().cacheHit);
+
+  // The pointer now sits at 0x02; a batch run starting there needs no write.
+  uint8_t next = 0;
+  Request req = Request::customRead(cmd::CUSTOM_FW_VERSION_SUB + 1, &next, 1);
+  TEST_ASSERT_TRUE(dev.execute(&req, 1).ok());
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().transactions);
+
+  // A failed read leaves the pointer unknown, so the next read seeks again.
+  fake.setCorruptReadPec(true);
+  TEST_ASSERT_FALSE(dev.customRead(cmd::CUSTOM_FW_VERSION_SUB + 2, next).ok());
+  fake.setCorruptReadPec(false);
+  TEST_ASSERT_TRUE(dev.customRead(cmd::CUSTOM_FW_VERSION_SUB + 3, next).ok());
+  TEST_ASSERT_EQUAL_UINT16(2, dev.lastOpInfo().transactions);
+
+  // The write's verify read leaves the pointer at 0xD4; a bus reset drops it.
+  TEST_ASSERT_TRUE(dev.customWrite(cmd::CUSTOM_FILTER_CO2, 0x03).ok());
+  TEST_ASSERT_TRUE(dev.busReset().ok());
+  TEST_ASSERT_TRUE(dev.customRead(cmd::CUSTOM_FILTER_CO2 + 1, next).ok());
+  TEST_ASSERT_EQUAL_UINT16(2, dev.lastOpInfo().transactions);
+}
+
+void test_config_builder_matches_begin_and_engine_timing() {
+  // Runtime validation shares the constexpr rules and messages.
+  TimingConfig bad;
+  bad.byteTimeoutUs = bad.bitTimeoutUs - 1;
+  FakeE2Transport fake;
+  Config cfg = checkedFakeConfig(fake);
+  cfg.bitTimeoutUs = bad.bitTimeoutUs;
+  cfg.byteTimeoutUs = bad.byteTimeoutUs;
+  EE871::EE871 rejected;
+  assertSameStatus(validateTiming(bad), rejected.begin(cfg));
+
+  EE871::EE871 dev;
+  Config built = kSlowE2.build(checkedFakeConfig(fake));
+  TEST_ASSERT_EQUAL_UINT8(3, built.deviceAddress);
+  TEST_ASSERT_EQUAL_UINT16(150, built.clockHighUs);
+  TEST_ASSERT_TRUE(built.setScl != nullptr);
+  TEST_ASSERT_TRUE(dev.begin(built).ok());
+
+  // Derived frame times are exactly what the line engine spends without stretching.
+  const DerivedTiming timing = kSlowE2.derived();
+  fake.resetElapsed();
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT32(timing.readFrameUs, fake.elapsedUs());
+  fake.resetElapsed();
+  TEST_ASSERT_TRUE(dev.setCustomPointer(cmd::CUSTOM_FILTER_CO2).ok());
+  TEST_ASSERT_EQUAL_UINT32(timing.writeFrameUs, fake.elapsedUs());
+}
+
+void test_sync_group_triggers_devices_back_to_back() {
+  SimulatedE2Bus bus;
+  const uint8_t addresses[3] = {1, 4, 6};
+  EE871::EE871 devs[3];
+  EE871::EE871* members[3] = {&devs[0], &devs[1], &devs[2]};
+  for (uint8_t i = 0; i < 3; ++i) {
+    bus.attach(addresses[i]).setMv4(static_cast<uint16_t>(500 + 10 * i));
+  }
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_TRUE(devs[i].begin(bus.makeConfig(addresses[i])).ok());
+  }
+
+  SyncSample samples[3];
+  SyncMeasurementGroup group;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(group.begin(members, 0, samples, 100).code));
+  TEST_ASSERT_TRUE(group.begin(members, 3, samples, 100).ok());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(group.collect(0).code));
+
+  bus.slave(2).setPresent(false);
+  const Status st = group.trigger(1000);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::E2_ERROR), static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(0x4, st.detail);
+  TEST_ASSERT_EQUAL_UINT32(0x3, group.triggeredMask());
+
+  // Status reads follow each other with exactly one read frame in between.
+  const uint32_t frameUs = deriveTiming(timingOf(bus.makeConfig(0))).readFrameUs;
+  TEST_ASSERT_EQUAL_UINT32(0u, samples[0].triggerOffsetUs);
+  TEST_ASSERT_EQUAL_UINT32(frameUs, samples[1].triggerOffsetUs);
+  TEST_ASSERT_EQUAL_UINT32(frameUs, group.triggerSpreadUs());
+
+  const Status early = group.collect(1099);
+  TEST_ASSERT_TRUE(early.inProgress());
+  TEST_ASSERT_EQUAL_INT32(1, early.detail);
+  TEST_ASSERT_TRUE(group.pending());
+  TEST_ASSERT_TRUE(group.collect(1100).ok());
+  TEST_ASSERT_FALSE(group.pending());
+  TEST_ASSERT_TRUE(samples[0].collected);
+  TEST_ASSERT_EQUAL_UINT16(500, samples[0].co2Average);
+  TEST_ASSERT_EQUAL_UINT16(510, samples[1].co2Average);
+  TEST_ASSERT_FALSE(samples[2].collected);
+}
+
+void test_sync_group_triggers_buses_in_lockstep() {
+  MultiFakeE2Port port(3);
+  MultiBusEngine engine;
+  MultiBusConfig cfg = port.makeConfig();
+  TEST_ASSERT_TRUE(engine.begin(cfg).ok());
+  for (uint8_t i = 0; i < 3; ++i) {
+    port.fake(i).setMv4(static_cast<uint16_t>(700 + i));
+  }
+  port.fake(1).setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+
+  const uint8_t addresses[3] = {};
+  SyncSample samples[3];
+  SyncMeasurementGroup group;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(group.begin(engine, 0x8, addresses, samples, 50).code));
+  TEST_ASSERT_TRUE(group.begin(engine, 0x7, addresses, samples, 50).ok());
+
+  // One lockstep status read triggers all three sensors at the same instant.
+  port.resetElapsed();
+  TEST_ASSERT_TRUE(group.trigger(0xFFFFFFF0u).ok());
+  TimingConfig timing;
+  timing.clockLowUs = cfg.clockLowUs;
+  timing.clockHighUs = cfg.clockHighUs;
+  timing.startHoldUs = cfg.startHoldUs;
+  timing.stopHoldUs = cfg.stopHoldUs;
+  TEST_ASSERT_EQUAL_UINT32(deriveTiming(timing).readFrameUs, port.elapsedUs());
+  TEST_ASSERT_EQUAL_UINT32(0u, group.triggerSpreadUs());
+  TEST_ASSERT_TRUE(EE871::EE871::hasCo2Error(samples[1].statusByte));
+
+  // The conversion window survives millisecond wrap-around.
+  TEST_ASSERT_TRUE(group.collect(0x0000001Fu).inProgress());
+  TEST_ASSERT_TRUE(group.collect(0x00000022u).ok());
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_TRUE(samples[i].collected);
+    TEST_ASSERT_EQUAL_UINT16(700 + i, samples[i].co2Average);
+  }
+}
+
+// Taps a transport like the examples' sniffer hook: every line callback reports
+// the bus levels, timestamped with the fake's or the simulated bus' virtual clock.
+struct CaptureTap {
+  FakeE2Transport* fake = nullptr;
+  SimulatedE2Bus* bus = nullptr;
+  e2diag::TriggerCapture<256>* capture = nullptr;
+  Config inner;
+
+  Config wrap(const Config& transport) {
+    inner = transport;
+    Config cfg = inner;
+    cfg.setScl = [](bool level, void* user) {
+      auto* t = static_cast<CaptureTap*>(user);
+      t->inner.setScl(level, t->inner.busUser);
+      t->tap();
+    };
+    cfg.setSda = [](bool level, void* user) {
+      auto* t = static_cast<CaptureTap*>(user);
+      t->inner.setSda(level, t->inner.busUser);
+      t->tap();
+    };
+    cfg.readScl = [](void* user) {
+      auto* t = static_cast<CaptureTap*>(user);
+      const bool level = t->inner.readScl(t->inner.busUser);
+      t->tap();
+      return level;
+    };
+    cfg.readSda = [](void* user) {
+      auto* t = static_cast<CaptureTap*>(user);
+      const bool level = t->inner.readSda(t->inner.busUser);
+      t->tap();
+      return level;
+    };
+    cfg.delayUs = [](uint32_t us, void* user) {
+      auto* t = static_cast<CaptureTap*>(user);
+      t->inner.delayUs(us, t->inner.busUser);
+    };
+    cfg.busUser = this;
+    return cfg;
+  }
+
+  uint32_t nowUs() const {
+    return (fake != nullptr) ? fake->elapsedUs() : static_cast<uint32_t>(bus->nowUs());
+  }
+
+  void tap() {
+    capture->sample(inner.readScl(inner.busUser), inner.readSda(inner.busUser), nowUs());
+  }
+
+  void arm(const e2diag::TriggerConfig& trigger) {
+    capture->arm(trigger, inner.readScl(inner.busUser), inner.readSda(inner.busUser), nowUs());
+  }
+};
+
+struct CapturedEvents {
+  e2diag::E2Event events[64];
+  size_t count = 0;
+  size_t triggerAt = SIZE_MAX;
+
+  static void sink(const e2diag::E2Event& ev, void* user) {
+    auto* self = static_cast<CapturedEvents*>(user);
+    if (ev.trigger) {
+      self->triggerAt = self->count;
+    }
+    if (self->count < 64) {
+      self->events[self->count++] = ev;
+    }
+  }
+};
+
+void test_trigger_capture_freezes_window_around_nack() {
+  FakeE2Transport fake;
+  e2diag::TriggerCapture<256> capture;
+  CaptureTap tap;
+  tap.fake = &fake;
+  tap.capture = &capture;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(tap.wrap(checkedFakeConfig(fake))).ok());
+
+  e2diag::TriggerConfig trigger;
+  trigger.sources = e2diag::trig::NACK;
+  trigger.postEdges = 40;
+  tap.arm(trigger);
+
+  // A good read ends with the master's PEC NAK, which must not trigger.
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_FALSE(capture.triggered());
+
+  fake.setDevicePresent(false);
+  TEST_ASSERT_FALSE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT8(e2diag::trig::NACK, capture.firedBy());
+  TEST_ASSERT_FALSE(capture.frozen());
+
+  // The buffer freezes after the post-trigger edges and then ignores the bus.
+  fake.setDevicePresent(true);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_TRUE(capture.frozen());
+  const uint32_t seen = capture.edgesSeen();
+  TEST_ASSERT_EQUAL_UINT32(capture.triggerEdge() + trigger.postEdges + 1, seen);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT32(seen, capture.edgesSeen());
+
+  // Decoding the window shows the good frame before and the NAK'd control byte.
+  CapturedEvents decoded;
+  capture.decode(&CapturedEvents::sink, &decoded);
+  TEST_ASSERT_NOT_EQUAL(SIZE_MAX, decoded.triggerAt);
+  const e2diag::E2Event& hit = decoded.events[decoded.triggerAt];
+  const uint8_t control = cmd::makeControlRead(cmd::MAIN_STATUS, 0);
+  TEST_ASSERT_EQUAL_UINT8(control, hit.value);
+  TEST_ASSERT_EQUAL_UINT8(0, hit.index);
+  TEST_ASSERT_FALSE(hit.ack);
+  TEST_ASSERT_TRUE(decoded.triggerAt >= 4);
+  const e2diag::E2Event& pec = decoded.events[decoded.triggerAt - 3];
+  TEST_ASSERT_TRUE(pec.isPec);
+  TEST_ASSERT_TRUE(pec.pecOk);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(e2diag::E2Event::Kind::STOP),
+                          static_cast<uint8_t>(decoded.events[decoded.triggerAt + 1].kind));
+}
+
+void test_trigger_capture_pec_stretch_and_control_sources() {
+  SimulatedE2Bus bus;
+  EE871Test::EmulatedEE871& slave = bus.attach(0);
+  e2diag::TriggerCapture<256> capture;
+  CaptureTap tap;
+  tap.bus = &bus;
+  tap.capture = &capture;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(tap.wrap(bus.makeConfig(0))).ok());
+  uint8_t status = 0;
+  uint16_t co2 = 0;
+
+  e2diag::TriggerConfig trigger;
+  TEST_ASSERT_TRUE(e2diag::parseTriggerSpec("pec post 0", trigger));
+  tap.arm(trigger);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_FALSE(capture.triggered());
+  slave.setCorruptReadPec(true);
+  TEST_ASSERT_FALSE(dev.readStatus(status).ok());
+  slave.setCorruptReadPec(false);
+  TEST_ASSERT_EQUAL_UINT8(e2diag::trig::PEC_MISMATCH, capture.firedBy());
+  TEST_ASSERT_TRUE(capture.frozen());
+  CapturedEvents pecEvents;
+  capture.decode(&CapturedEvents::sink, &pecEvents);
+  TEST_ASSERT_NOT_EQUAL(SIZE_MAX, pecEvents.triggerAt);
+  TEST_ASSERT_TRUE(pecEvents.events[pecEvents.triggerAt].isPec);
+  TEST_ASSERT_FALSE(pecEvents.events[pecEvents.triggerAt].pecOk);
+
+  // Matching on the command nibble only catches the MV4 high byte read.
+  TEST_ASSERT_TRUE(e2diag::parseTriggerSpec("ctrl F0 mask F0 post 8", trigger));
+  TEST_ASSERT_EQUAL_UINT8(0xF0, trigger.controlMask);
+  tap.arm(trigger);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_FALSE(capture.triggered());
+  TEST_ASSERT_TRUE(dev.readCo2Average(co2).ok());
+  TEST_ASSERT_EQUAL_UINT8(e2diag::trig::CONTROL_BYTE, capture.firedBy());
+
+  // Per-byte stretching below the threshold is ignored; above it triggers.
+  TEST_ASSERT_TRUE(e2diag::parseTriggerSpec("stretch 500", trigger));
+  tap.arm(trigger);
+  slave.setStretchPerByteUs(300);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_FALSE(capture.triggered());
+  slave.setStretchPerByteUs(800);
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT8(e2diag::trig::STRETCH, capture.firedBy());
+  // The stretch fires on an SCL falling edge, which completes no event; the
+  // byte clocked out after the stretch carries the mark.
+  CapturedEvents stretchEvents;
+  capture.decode(&CapturedEvents::sink, &stretchEvents);
+  TEST_ASSERT_NOT_EQUAL(SIZE_MAX, stretchEvents.triggerAt);
+  const e2diag::E2Event& stretched = stretchEvents.events[stretchEvents.triggerAt];
+  TEST_ASSERT_TRUE(stretched.edge > capture.triggerEdge());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(e2diag::E2Event::Kind::BYTE),
+                          static_cast<uint8_t>(stretched.kind));
+  TEST_ASSERT_TRUE(stretchEvents.triggerAt == 0 ||
+                   stretchEvents.events[stretchEvents.triggerAt - 1].edge < capture.triggerEdge());
+
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("stretch", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("ctrl 1FF", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("nack later", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("stretch -5", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("stretch\t500", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("stretch500", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("ctrl 0x51", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("pec post -1", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("pec post 65536", trigger));
+  TEST_ASSERT_FALSE(e2diag::parseTriggerSpec("stretch 4294967296", trigger));
+  TEST_ASSERT_TRUE(e2diag::parseTriggerSpec("ctrl  a1  mask f0", trigger));
+  TEST_ASSERT_EQUAL_UINT8(0xA1, trigger.controlByte);
+  TEST_ASSERT_EQUAL_UINT8(0xF0, trigger.controlMask);
+}
+
+// Line delays seen while no PM lock was held.
+static E2DelayUsFn gPmInnerDelay = nullptr;
+static uint32_t gPmUnlockedDelays = 0;
+
+static void pmCheckedDelay(uint32_t us, void* user) {
+  if (!MockPmApi::anyHeld()) {
+    ++gPmUnlockedDelays;
+  }
+  gPmInnerDelay(us, user);
+}
+
+void test_pm_bus_lock_holds_locks_only_during_transactions() {
+  FakeE2Transport fake;
+  MockPmApi::reset(&fake);
+  ee871_idf::BasicPmBusLock<MockPmApi> pm;
+  TEST_ASSERT_TRUE(pm.begin());
+  TEST_ASSERT_EQUAL_UINT8(2, MockPmApi::state().created);
+
+  Config cfg = checkedFakeConfig(fake);
+  gPmInnerDelay = cfg.delayUs;
+  gPmUnlockedDelays = 0;
+  cfg.delayUs = &pmCheckedDelay;
+  pm.attach(cfg);
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(cfg).ok());
+  TEST_ASSERT_EQUAL_UINT32(0u, gPmUnlockedDelays);
+  TEST_ASSERT_FALSE(MockPmApi::anyHeld());
+  TEST_ASSERT_EQUAL_UINT32(dev.lastOpInfo().transactions, pm.acquisitions());
+  TEST_ASSERT_EQUAL_UINT32(pm.acquisitions(), MockPmApi::state().acquires[0]);
+  TEST_ASSERT_EQUAL_UINT32(pm.acquisitions(), MockPmApi::state().acquires[1]);
+
+  // The flash-commit wait runs unlocked through waitMs, not as line delays.
+  fake.resetElapsed();
+  pm.resetStats();
+  TEST_ASSERT_TRUE(dev.writeCo2Filter(3).ok());
+  const OpInfo& info = dev.lastOpInfo();
+  TEST_ASSERT_EQUAL_UINT32(1u, MockPmApi::state().sleeps);
+  TEST_ASSERT_EQUAL_UINT32(cfg.writeDelayMs, pm.waitedMs());
+  TEST_ASSERT_FALSE(MockPmApi::state().sleptWhileHeld);
+  TEST_ASSERT_EQUAL_UINT32(cfg.writeDelayMs * 1000U, info.commitWaitUs);
+  TEST_ASSERT_EQUAL_UINT32(info.transactions, pm.acquisitions());
+  TEST_ASSERT_EQUAL_UINT32(info.busUs, static_cast<uint32_t>(pm.heldUs()));
+  TEST_ASSERT_EQUAL_UINT32(0u, gPmUnlockedDelays);
+
+  // Hold time is reported per hour of the statistics window.
+  MockPmApi::state().idleUs += 3600000000ULL - pm.windowUs();
+  TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(pm.heldUs() / 1000U), pm.heldMsPerHour());
+
+  pm.end();
+  TEST_ASSERT_EQUAL_UINT8(2, MockPmApi::state().destroyed);
+
+  // Without PM support the hooks still account and yield, but take no locks.
+  MockPmApi::reset(&fake);
+  MockPmApi::state().failCreate = true;
+  ee871_idf::BasicPmBusLock<MockPmApi> noPm;
+  TEST_ASSERT_FALSE(noPm.begin());
+  Config plain = checkedFakeConfig(fake);
+  noPm.attach(plain);
+  EE871::EE871 dev2;
+  TEST_ASSERT_TRUE(dev2.begin(plain).ok());
+  TEST_ASSERT_TRUE(noPm.acquisitions() > 0);
+  TEST_ASSERT_EQUAL_UINT32(0u, MockPmApi::state().acquires[0]);
+  TEST_ASSERT_TRUE(dev2.writeCo2Filter(4).ok());
+  TEST_ASSERT_EQUAL_UINT32(1u, MockPmApi::state().sleeps);
+}
+
+void test_fleet_kernels_aggregate_columns() {
+  static FleetStorage<70000> storage;
+  FleetStore store;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(store.begin(FleetColumns(), 4).code));
+  TEST_ASSERT_TRUE(store.begin(storage.columns(), 8).ok());
+
+  const uint16_t ppm[8] = {400, 1200, 800, 0, 650, 2100, 900, 500};
+  for (size_t i = 0; i < 8; ++i) {
+    if (i != 3) {
+      store.recordSample(i, 1000 + static_cast<uint32_t>(i) * 100, ppm[i], 0, 0);
+    }
+  }
+  store.recordFailure(3, Err::NACK);
+  store.recordHealth(3, DriverState::DEGRADED, 2, 2);
+  store.recordHealth(5, DriverState::OFFLINE, 5, 9);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NACK), store.lastResult()[3]);
+
+  // Row 3 never produced a sample; rows 0..2 are older than 400 ms at t=1700.
+  uint8_t stale[8] = {};
+  TEST_ASSERT_EQUAL_UINT32(4u, fleet::staleMask(store.sampleMs(), store.hasSample(), 8, 1700,
+                                                400, stale));
+  TEST_ASSERT_EQUAL_UINT8(1, stale[2]);
+  TEST_ASSERT_EQUAL_UINT8(1, stale[3]);
+  TEST_ASSERT_EQUAL_UINT8(0, stale[4]);
+
+  uint8_t fresh[8] = {};
+  TEST_ASSERT_EQUAL_UINT32(4u, fleet::freshMask(store, 1700, 400, fresh));
+  const fleet::PpmStats stats = fleet::ppmStats(store.ppm(), fresh, 8);
+  TEST_ASSERT_EQUAL_UINT32(4u, stats.count);
+  TEST_ASSERT_EQUAL_UINT16(500, stats.min);
+  TEST_ASSERT_EQUAL_UINT16(2100, stats.max);
+  TEST_ASSERT_EQUAL_UINT16(1038, stats.mean);  // (650+2100+900+500)/4, rounded
+
+  uint8_t high[8] = {};
+  TEST_ASSERT_EQUAL_UINT32(2u, fleet::thresholdMask(store.ppm(), 8, 1000, high));
+  TEST_ASSERT_EQUAL_UINT32(1u, fleet::andMask(high, fresh, 8, high));
+  TEST_ASSERT_EQUAL_UINT8(1, high[5]);
+
+  uint8_t mask[8] = {};
+  TEST_ASSERT_EQUAL_UINT32(1u, fleet::stateMask(store.state(), 8, DriverState::OFFLINE, mask));
+  TEST_ASSERT_EQUAL_UINT32(2u, fleet::failureMask(store.consecutiveFailures(), 8, 1, mask));
+
+  const uint8_t none[8] = {};
+  const fleet::PpmStats empty = fleet::ppmStats(store.ppm(), none, 8);
+  TEST_ASSERT_EQUAL_UINT32(0u, empty.count);
+  TEST_ASSERT_EQUAL_UINT16(0, empty.min);
+
+  // Sums stay exact past one 65536-row accumulation block; wrapped ages still age.
+  TEST_ASSERT_TRUE(store.begin(storage.columns(), storage.capacity()).ok());
+  for (size_t i = 0; i < storage.capacity(); ++i) {
+    store.recordSample(i, 0xFFFFFF00u, 60000, 0, 0);
+  }
+  const fleet::PpmStats all = fleet::ppmStats(store.ppm(), store.hasSample(), store.size());
+  TEST_ASSERT_EQUAL_UINT32(70000u, all.count);
+  TEST_ASSERT_TRUE(all.sum == 70000ull * 60000ull);
+  TEST_ASSERT_EQUAL_UINT16(60000, all.mean);
+  TEST_ASSERT_EQUAL_UINT32(0u, fleet::staleMask(store.sampleMs(), store.hasSample(), store.size(),
+                                                0x100u, 0x200u, storage.errorCode));
+}
+
+void test_fleet_poller_updates_store_rows() {
+  SimulatedE2Bus bus;
+  const uint8_t addresses[3] = {1, 4, 6};
+  EE871::EE871 devs[3];
+  EE871::EE871* members[3] = {&devs[0], &devs[1], &devs[2]};
+  for (uint8_t i = 0; i < 3; ++i) {
+    bus.attach(addresses[i]).setMv4(static_cast<uint16_t>(500 + 10 * i));
+  }
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_TRUE(devs[i].begin(bus.makeConfig(addresses[i])).ok());
+  }
+
+  FleetStorage<4> storage;
+  FleetStore store;
+  FleetPoller poller;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(poller.begin(members, 3, store).code));
+  TEST_ASSERT_TRUE(store.begin(storage.columns(), 4).ok());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(poller.begin(members, 5, store).code));
+  TEST_ASSERT_TRUE(poller.begin(members, 3, store).ok());
+
+  TEST_ASSERT_TRUE(poller.pollNext(100).ok());
+  TEST_ASSERT_EQUAL_UINT32(1u, poller.cursor());
+  TEST_ASSERT_EQUAL_UINT16(500, store.ppm()[0]);
+  TEST_ASSERT_EQUAL_UINT32(100u, store.sampleMs()[0]);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(DriverState::READY), store.state()[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, store.hasSample()[1]);
+
+  bus.slave(1).setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+  bus.slave(2).setPresent(false);
+  const Status st = poller.pollAll(200);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::E2_ERROR), static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(1, st.detail);
+  TEST_ASSERT_EQUAL_UINT8(0, store.hasSample()[1]);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OK), store.lastResult()[1]);
+  TEST_ASSERT_EQUAL_UINT8(cmd::STATUS_CO2_ERROR_MASK, store.statusByte()[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, store.hasSample()[2]);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NACK), store.lastResult()[2]);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(DriverState::DEGRADED), store.state()[2]);
+  TEST_ASSERT_EQUAL_UINT8(devs[2].consecutiveFailures(), store.consecutiveFailures()[2]);
+  TEST_ASSERT_EQUAL_UINT32(devs[2].totalFailures(), store.totalFailures()[2]);
+
+  // Row 3 has no device and keeps its cleared state.
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(DriverState::UNINIT), store.state()[3]);
+}
+
+void test_fleet_poller_keeps_last_good_sample_on_co2_error() {
+  FakeE2Transport fakes[2];
+  EE871::EE871 devs[2];
+  EE871::EE871* members[2] = {&devs[0], &devs[1]};
+  fakes[0].setMv4(600);
+  fakes[1].setMv4(800);
+  for (uint8_t i = 0; i < 2; ++i) {
+    TEST_ASSERT_TRUE(beginFakeDevice(devs[i], fakes[i]).ok());
+  }
+  FleetStorage<2> storage;
+  FleetStore store;
+  FleetPoller poller;
+  TEST_ASSERT_TRUE(store.begin(storage.columns(), 2).ok());
+  TEST_ASSERT_TRUE(poller.begin(members, 2, store).ok());
+  TEST_ASSERT_TRUE(poller.pollAll(100).ok());
+
+  // Row 1 reports a CO2 error with a wild MV4: status updates, sample does not.
+  fakes[1].setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+  fakes[1].setMemory(cmd::CUSTOM_ERROR_CODE, cmd::CO2_ERROR_SENSOR_COUNTS_LOW);
+  fakes[1].setMv4(9000);
+  TEST_ASSERT_TRUE(poller.pollAll(5000).ok());
+  TEST_ASSERT_EQUAL_UINT16(800, store.ppm()[1]);
+  TEST_ASSERT_EQUAL_UINT32(100u, store.sampleMs()[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, store.hasSample()[1]);
+  TEST_ASSERT_EQUAL_UINT8(cmd::STATUS_CO2_ERROR_MASK, store.statusByte()[1]);
+  TEST_ASSERT_EQUAL_UINT8(cmd::CO2_ERROR_SENSOR_COUNTS_LOW, store.errorCode()[1]);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OK), store.lastResult()[1]);
+
+  uint8_t fresh[2] = {};
+  TEST_ASSERT_EQUAL_size_t(1, fleet::freshMask(store, 5000, 1000, fresh));
+  TEST_ASSERT_EQUAL_UINT8(0, fresh[1]);
+  const fleet::PpmStats stats = fleet::ppmStats(store.ppm(), fresh, 2);
+  TEST_ASSERT_EQUAL_size_t(1, stats.count);
+  TEST_ASSERT_EQUAL_UINT16(600, stats.max);
+  uint8_t high[2] = {};
+  TEST_ASSERT_EQUAL_size_t(0, fleet::thresholdMask(store.ppm(), 2, 5000, high));
+}
+
+void test_snapshot_generations_change_only_with_their_section() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  const SnapshotGenerations initial = dev.generations();
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+  SnapshotGenerations seen = dev.generations();
+  TEST_ASSERT_TRUE(seen.config != initial.config);
+  TEST_ASSERT_TRUE(seen.features != initial.features);
+  TEST_ASSERT_TRUE(seen.health != initial.health);
+  TEST_ASSERT_EQUAL_UINT32(initial.measurement, seen.measurement);
+
+  // tick() and snapshot reads change nothing.
+  dev.tick(500);
+  SettingsSnapshot full;
+  TEST_ASSERT_TRUE(dev.getSettings(full).ok());
+  TEST_ASSERT_EQUAL_UINT32(seen.health, full.generations.health);
+  TEST_ASSERT_EQUAL_UINT32(seen.config, dev.generations().config);
+
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_TRUE(dev.generations().health != seen.health);
+  TEST_ASSERT_EQUAL_UINT32(seen.measurement, dev.generations().measurement);
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_TRUE(dev.generations().measurement != seen.measurement);
+  TEST_ASSERT_EQUAL_UINT32(seen.features, dev.generations().features);
+  TEST_ASSERT_EQUAL_UINT32(seen.persistentDirty, dev.generations().persistentDirty);
+
+  fake.setDevicePresent(false);
+  seen = dev.generations();
+  TEST_ASSERT_FALSE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT32(seen.measurement, dev.generations().measurement);
+  const HealthSnapshot health = dev.getHealth();
+  TEST_ASSERT_TRUE(health.generation != seen.health);
+  TEST_ASSERT_EQUAL_UINT32(dev.generations().health, health.generation);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(DriverState::DEGRADED),
+                          static_cast<uint8_t>(health.state));
+  TEST_ASSERT_EQUAL_UINT8(dev.consecutiveFailures(), health.consecutiveFailures);
+  TEST_ASSERT_EQUAL_UINT32(dev.totalSuccess(), health.totalSuccess);
+  assertSameStatus(dev.lastError(), health.lastError);
+
+  // Dirty state counts transitions only.
+  fake.setDevicePresent(true);
+  fake.failNextWriteToAddress(cmd::CUSTOM_INTERVAL_H);
+  seen = dev.generations();
+  TEST_ASSERT_FALSE(dev.writeMeasurementInterval(300).ok());
+  TEST_ASSERT_EQUAL_UINT32(seen.persistentDirty + 1, dev.generations().persistentDirty);
+  fake.failNextWriteToAddress(cmd::CUSTOM_INTERVAL_H);
+  TEST_ASSERT_FALSE(dev.writeMeasurementInterval(300).ok());
+  TEST_ASSERT_EQUAL_UINT32(seen.persistentDirty + 1, dev.generations().persistentDirty);
+
+  // Counters survive end() and keep increasing.
+  seen = dev.generations();
+  dev.end();
+  TEST_ASSERT_TRUE(dev.generations().config != seen.config);
+  TEST_ASSERT_TRUE(dev.generations().health != seen.health);
+}
+
+static FleetSimulator<16, 2> gFleetSim;
+
+void test_fleet_simulator_reports_day_long_schedule() {
+  using EE871Test::SimBusSpec;
+  using EE871Test::SimReport;
+  using EE871Test::SimScenario;
+  using EE871Test::SimSensorSpec;
+
+  // One simulated day: 2 buses x 2 sensors at 60 s, the second bus on a slow cable.
+  SimBusSpec buses[2];
+  buses[1].clockLowUs = 300;
+  buses[1].clockHighUs = 300;
+  SimSensorSpec sensors[4];
+  for (uint8_t i = 0; i < 4; ++i) {
+    sensors[i].bus = static_cast<uint8_t>(i % 2);
+    sensors[i].address = static_cast<uint8_t>(i / 2);
+    sensors[i].intervalMs = 60000;
+    sensors[i].phaseMs = 10U * i;
+  }
+  SimScenario sc;
+  sc.buses = buses;
+  sc.busCount = 2;
+  sc.sensors = sensors;
+  sc.sensorCount = 4;
+  sc.durationMs = 24ULL * 3600ULL * 1000ULL;
+  sc.pollOverheadUs = 200;
+
+  SimReport day;
+  TEST_ASSERT_TRUE(gFleetSim.run(sc, day));
+  TEST_ASSERT_EQUAL_UINT32(4u * 1440u, day.polls);
+  TEST_ASSERT_EQUAL_UINT32(0u, day.failedPolls);
+  TEST_ASSERT_EQUAL_UINT32(0u, day.deadlineMisses);
+  TEST_ASSERT_TRUE(day.maxDataAgeUs >= 59900000ULL && day.maxDataAgeUs <= 60100000ULL);
+  TEST_ASSERT_TRUE(day.bus[1].utilizationPpm > 2 * day.bus[0].utilizationPpm);
+  TEST_ASSERT_TRUE(day.cpuBusyWaitUs >= day.bus[0].busyUs + day.bus[1].busyUs);
+  TEST_ASSERT_TRUE(gFleetSim.store().hasSample()[3] != 0);
+
+  // Overload: eight sensors every 100 ms on one bus cannot all be served.
+  SimSensorSpec busy[8];
+  for (uint8_t i = 0; i < 8; ++i) {
+    busy[i].address = i;
+    busy[i].intervalMs = 100;
+  }
+  sc.busCount = 1;
+  sc.sensors = busy;
+  sc.sensorCount = 8;
+  sc.durationMs = 10000;
+  SimReport overload;
+  TEST_ASSERT_TRUE(gFleetSim.run(sc, overload));
+  TEST_ASSERT_TRUE(overload.deadlineMisses > 0);
+  TEST_ASSERT_TRUE(overload.maxDataAgeUs > 100000ULL);
+  TEST_ASSERT_TRUE(overload.bus[0].utilizationPpm > 900000U);
+
+  // Error profile: a flaky sensor loses samples; equal seeds replay identically.
+  busy[0].intervalMs = 1000;
+  busy[0].absentPpm = 300000;
+  busy[0].pecErrorPpm = 100000;
+  sc.sensors = busy;
+  sc.sensorCount = 1;
+  sc.durationMs = 600000;
+  sc.seed = 7;
+  SimReport flaky;
+  SimReport again;
+  TEST_ASSERT_TRUE(gFleetSim.run(sc, flaky));
+  TEST_ASSERT_TRUE(gFleetSim.run(sc, again));
+  TEST_ASSERT_EQUAL_UINT32(600u, flaky.polls);
+  TEST_ASSERT_TRUE(flaky.failedPolls > 100 && flaky.failedPolls < 300);
+  TEST_ASSERT_TRUE(flaky.maxDataAgeUs >= 2000000ULL);
+  TEST_ASSERT_EQUAL_UINT32(flaky.failedPolls, again.failedPolls);
+  TEST_ASSERT_TRUE(flaky.meanDataAgeUs == again.meanDataAgeUs);
+  TEST_ASSERT_EQUAL_UINT32(flaky.failedPolls, gFleetSim.device(0).totalFailures());
+}
+
+void test_cyclic_executor_runs_generated_table() {
+  static_assert(measurementCostUs(ConfigBuilder().derived()) == 18540u, "Default slot cost");
+  static_assert(measurementCostUs(ConfigBuilder().derived(), true) == 32790u,
+                "Default slot cost with error code");
+  const CyclicSchedule& table = ee871_test_schedule::kSchedule;
+
+  SimulatedE2Bus bus;
+  EE871::EE871 devs[5];
+  EE871::EE871* members[5] = {&devs[0], &devs[1], &devs[2], &devs[3], &devs[4]};
+  for (uint8_t i = 0; i < 5; ++i) {
+    bus.attach(static_cast<uint8_t>(i + 1)).setMv4(static_cast<uint16_t>(600 + i));
+    TEST_ASSERT_TRUE(devs[i].begin(bus.makeConfig(static_cast<uint8_t>(i + 1))).ok());
+  }
+  FleetStorage<5> storage;
+  FleetStore store;
+  FleetPoller poller;
+  CyclicExecutor exec;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(exec.begin(table, poller, 1000).code));
+  TEST_ASSERT_TRUE(store.begin(storage.columns(), 5).ok());
+  TEST_ASSERT_TRUE(poller.begin(members, 5, store).ok());
+
+  CyclicSchedule crossing = table;
+  crossing.slotCostUs = 90000;  // Slot 1 would run past the end of frame 0.
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(exec.begin(crossing, poller, 1000).code));
+  TEST_ASSERT_TRUE(exec.begin(table, poller, 1000).ok());
+  TEST_ASSERT_EQUAL_UINT32(1000u, exec.nextReleaseMs());
+
+  TEST_ASSERT_TRUE(exec.tick(999).ok());
+  TEST_ASSERT_EQUAL_UINT32(0u, exec.stats().executed);
+  TEST_ASSERT_TRUE(exec.tick(1000).ok());
+  TEST_ASSERT_EQUAL_UINT32(1u, exec.stats().executed);
+  TEST_ASSERT_EQUAL_UINT32(1000u, store.sampleMs()[0]);
+  TEST_ASSERT_EQUAL_UINT32(1019u, exec.nextReleaseMs());
+
+  // Slots 19 ms and 38 ms into frame 0 both run from one late tick.
+  TEST_ASSERT_TRUE(exec.tick(1038).ok());
+  TEST_ASSERT_EQUAL_UINT32(3u, exec.stats().executed);
+  TEST_ASSERT_EQUAL_UINT32(19000u, exec.stats().maxLatenessUs);
+  TEST_ASSERT_EQUAL_UINT16(603, store.ppm()[3]);
+  TEST_ASSERT_EQUAL_UINT32(1100u, exec.nextReleaseMs());
+
+  // Frame 1 is missed entirely and dropped; frame 2 runs late but in its frame.
+  TEST_ASSERT_TRUE(exec.tick(1250).ok());
+  TEST_ASSERT_EQUAL_UINT32(5u, exec.stats().executed);
+  TEST_ASSERT_EQUAL_UINT32(3u, exec.stats().skipped);
+  TEST_ASSERT_EQUAL_UINT32(50000u, exec.stats().maxLatenessUs);
+  TEST_ASSERT_EQUAL_UINT32(1250u, store.sampleMs()[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, store.hasSample()[2]);
+
+  // Frame 3 is dropped, then the table wraps into the next major cycle.
+  TEST_ASSERT_TRUE(exec.tick(1400).ok());
+  TEST_ASSERT_EQUAL_UINT32(1u, exec.stats().cycles);
+  TEST_ASSERT_EQUAL_UINT32(6u, exec.stats().executed);
+  TEST_ASSERT_EQUAL_UINT32(5u, exec.stats().skipped);
+
+  // Five cycles behind: whole cycles are dropped in one step.
+  TEST_ASSERT_TRUE(exec.tick(3410).ok());
+  TEST_ASSERT_EQUAL_UINT32(6u, exec.stats().cycles);
+  TEST_ASSERT_EQUAL_UINT32(7u, exec.stats().executed);
+  TEST_ASSERT_EQUAL_UINT32(54u, exec.stats().skipped);
+  TEST_ASSERT_EQUAL_UINT32(3410u, store.sampleMs()[0]);
+
+  bus.slave(1).setPresent(false);
+  const Status st = exec.tick(3419);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::E2_ERROR), static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(1, st.detail);
+  TEST_ASSERT_EQUAL_UINT32(1u, exec.stats().failed);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NACK), store.lastResult()[1]);
+
+  exec.end();
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(exec.tick(3500).code));
+}
+
+void test_begin_fleet_probes_buses_in_lockstep() {
+  static MultiSimE2Port port(4);
+  // Bus 0: three sensors. Bus 1: two. Bus 2: an absent address, then a sensor.
+  // Bus 3: SCL held low, so it is not idle and its second member is never tried.
+  const uint8_t layout[9][2] = {{0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1},
+                                {2, 5}, {2, 3}, {3, 0}, {3, 1}};
+  for (uint8_t b = 0; b < 3; ++b) {
+    port.bus(b).reset();
+  }
+  for (const auto& m : layout) {
+    if (m[0] != 2 || m[1] != 5) {
+      port.bus(m[0]).attach(m[1]).setMv4(static_cast<uint16_t>(400 + 10 * m[0] + m[1]));
+    }
+  }
+  port.bus(3).slave(0).setHoldSclLow(true);
+
+  MultiBusEngine engine;
+  TEST_ASSERT_TRUE(engine.begin(port.makeConfig()).ok());
+  EE871::EE871 devs[9];
+  FleetMember members[9];
+  Status results[9];
+  for (uint8_t i = 0; i < 9; ++i) {
+    members[i].device = &devs[i];
+    members[i].config = port.config(layout[i][0], layout[i][1]);
+    members[i].bus = layout[i][0];
+  }
+  FleetBootReport report;
+
+  members[4].bus = 7;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(beginFleet(engine, members, 9, results,
+                                                          report).code));
+  members[4].bus = 1;
+  TEST_ASSERT_EQUAL_UINT32(0x7u, engine.idleBusesMask());
+
+  const Status st = beginFleet(engine, members, 9, results, report);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::E2_ERROR), static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(3, st.detail);
+  TEST_ASSERT_EQUAL_UINT16(9, report.members);
+  TEST_ASSERT_EQUAL_UINT16(6, report.ready);
+  TEST_ASSERT_EQUAL_UINT16(3, report.failed);
+  TEST_ASSERT_EQUAL_UINT16(1, report.skipped);
+  TEST_ASSERT_EQUAL_UINT8(3, report.rounds);
+
+  const uint8_t readyMembers[6] = {0, 1, 2, 3, 4, 6};
+  for (uint8_t i : readyMembers) {
+    TEST_ASSERT_TRUE(results[i].ok());
+    TEST_ASSERT_TRUE(devs[i].isInitialized());
+    TEST_ASSERT_TRUE(devs[i].hasErrorCode());
+    TEST_ASSERT_TRUE(devs[i].hasLowPowerMode());
+    uint16_t ppm = 0;
+    TEST_ASSERT_TRUE(devs[i].readCo2Average(ppm).ok());
+    TEST_ASSERT_EQUAL_UINT16(400 + 10 * layout[i][0] + layout[i][1], ppm);
+  }
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NACK), static_cast<uint8_t>(results[5].code));
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUS_STUCK),
+                          static_cast<uint8_t>(results[7].code));
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUS_STUCK),
+                          static_cast<uint8_t>(results[8].code));
+  TEST_ASSERT_FALSE(devs[8].isInitialized());
+
+  // Lockstep: the serial equivalent of six probes is well over twice the
+  // rounds' line time. The stuck bus gives up after one clock timeout.
+  TEST_ASSERT_TRUE(report.identityUs > 0);
+  TEST_ASSERT_TRUE(report.featuresUs > report.identityUs);
+  TEST_ASSERT_TRUE(report.serialUs > 2U * (report.identityUs + report.featuresUs));
+  TEST_ASSERT_TRUE(report.fallbackUs >= 25000U);
+  TEST_ASSERT_TRUE(report.fallbackUs < 2U * 25000U);
+  TEST_ASSERT_EQUAL_UINT32(report.identityUs + report.featuresUs + report.fallbackUs,
+                           report.totalUs);
+
+  // Already-initialized members fail without traffic.
+  const uint32_t busBefore = engine.busUs();
+  TEST_ASSERT_FALSE(beginFleet(engine, members, 1, results, report).ok());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::ALREADY_INITIALIZED),
+                          static_cast<uint8_t>(results[0].code));
+  TEST_ASSERT_EQUAL_UINT32(busBefore, engine.busUs());
+
+  DeviceProbe foreign;
+  foreign.groupId = 0x1234;
+  EE871::EE871 other;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::DEVICE_NOT_FOUND),
+                          static_cast<uint8_t>(other.beginFromProbe(members[0].config,
+                                                                    foreign).code));
+  TEST_ASSERT_FALSE(other.isInitialized());
+}
+
+// Forwards every callback of a transport config and fails one read frame by count.
+struct FailingReadFrames {
+  Config inner;
+  uint32_t failAt = 0;
+  uint32_t reads = 0;
+
+  Config wrap(const Config& transport) {
+    inner = transport;
+    Config cfg = inner;
+    cfg.setScl = [](bool level, void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      t->inner.setScl(level, t->inner.busUser);
+    };
+    cfg.setSda = [](bool level, void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      t->inner.setSda(level, t->inner.busUser);
+    };
+    cfg.readScl = [](void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      return t->inner.readScl(t->inner.busUser);
+    };
+    cfg.readSda = [](void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      return t->inner.readSda(t->inner.busUser);
+    };
+    cfg.delayUs = [](uint32_t us, void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      t->inner.delayUs(us, t->inner.busUser);
+    };
+    cfg.readFrame = [](uint8_t controlByte, uint8_t& data, uint8_t& pec, void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      if (++t->reads == t->failAt) {
+        return Status::Error(Err::NACK, "Injected read failure");
+      }
+      return t->inner.readFrame(controlByte, data, pec, t->inner.busUser);
+    };
+    cfg.writeFrame = [](uint8_t controlByte, uint8_t addressByte, uint8_t dataByte, uint8_t pec,
+                        bool& accepted, void* user) {
+      auto* t = static_cast<FailingReadFrames*>(user);
+      return t->inner.writeFrame(controlByte, addressByte, dataByte, pec, accepted,
+                                 t->inner.busUser);
+    };
+    cfg.busUser = this;
+    return cfg;
+  }
+};
+
+void test_begin_feature_read_failure_matches_begin_from_probe() {
+  FakeE2Transport fake;
+  FailingReadFrames hooks;
+  hooks.failAt = 4;  // Type low, type high, 0x07, then 0x08 fails.
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(hooks.wrap(fake.makeByteLevelConfig())).ok());
+  TEST_ASSERT_EQUAL_UINT32(4u, hooks.reads);
+  TEST_ASSERT_FALSE(dev.hasErrorCode());
+  TEST_ASSERT_FALSE(dev.hasLowPowerMode());
+
+  // The same partial probe handed over from a fleet scan gives the same state.
+  DeviceProbe probe;
+  probe.groupId = cmd::SENSOR_GROUP_ID;
+  probe.operatingFunctions = fake.memory(cmd::CUSTOM_OPERATING_FUNCTIONS);
+  probe.featuresValid = false;
+  EE871::EE871 other;
+  TEST_ASSERT_TRUE(other.beginFromProbe(checkedFakeConfig(fake), probe).ok());
+
+  const SettingsSnapshot a = dev.getSettings();
+  const SettingsSnapshot b = other.getSettings();
+  TEST_ASSERT_EQUAL_HEX8(0, a.operatingFunctions);
+  TEST_ASSERT_EQUAL_HEX8(0, a.operatingModeSupport);
+  TEST_ASSERT_EQUAL_HEX8(0, a.specialFeatures);
+  TEST_ASSERT_EQUAL_HEX8(a.operatingFunctions, b.operatingFunctions);
+  TEST_ASSERT_EQUAL_HEX8(a.operatingModeSupport, b.operatingModeSupport);
+  TEST_ASSERT_EQUAL_HEX8(a.specialFeatures, b.specialFeatures);
+}
+
+void test_bus_quota_depletes_under_frame_hooks() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(fake.makeByteLevelConfig()).ok());
+  BusQuota quota;
+  TEST_ASSERT_TRUE(quota.begin(dev, 0).ok());
+  QuotaPolicy policy;
+  policy.rateUsPerSecond = 1000;
+  policy.burstUs = quota.measurementEstimateUs();
+  uint8_t client = 0;
+  TEST_ASSERT_TRUE(quota.addClient(policy, client).ok());
+
+  // The hooks own the lines; the quota still sees the nominal frame time.
+  MeasurementFrame frame;
+  TEST_ASSERT_TRUE(quota.readMeasurement(client, 0, frame).ok());
+  TEST_ASSERT_TRUE(fake.frames() > 0);
+  const DerivedTiming d = deriveTiming(timingOf(dev.getConfig()));
+  TEST_ASSERT_EQUAL_UINT64(3ULL * d.readFrameUs, quota.stats(client).consumedUs);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY),
+                          static_cast<uint8_t>(quota.readMeasurement(client, 0, frame).code));
+  TEST_ASSERT_EQUAL_UINT32(1u, quota.stats(client).deferred);
+}
+
+void test_bus_quota_defers_or_caches_over_quota_clients() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  BusQuota quota;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(quota.begin(dev, 0).code));
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+  TEST_ASSERT_TRUE(quota.begin(dev, 0).ok());
+
+  // Error-code capable device: 3 read frames plus the chained pointer write and read.
+  const DerivedTiming d = deriveTiming(timingOf(dev.getConfig()));
+  TEST_ASSERT_EQUAL_UINT32(4U * d.readFrameUs + d.writeFrameUs, quota.measurementEstimateUs());
+
+  QuotaPolicy control;  // Unlimited.
+  QuotaPolicy ui;
+  ui.rateUsPerSecond = 20000;
+  ui.burstUs = 31000;
+  ui.maxCacheAgeMs = 500;
+  QuotaPolicy small;
+  small.rateUsPerSecond = 10000;
+  small.burstUs = 10000;
+  uint8_t controlId = 0;
+  uint8_t uiId = 0;
+  uint8_t smallId = 0;
+  TEST_ASSERT_TRUE(quota.addClient(control, controlId).ok());
+  TEST_ASSERT_TRUE(quota.addClient(ui, uiId).ok());
+  TEST_ASSERT_TRUE(quota.addClient(small, smallId).ok());
+  QuotaPolicy noBurst;
+  noBurst.rateUsPerSecond = 1000;
+  uint8_t unused = 0;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(quota.addClient(noBurst, unused).code));
+
+  MeasurementFrame frame;
+  bool cached = true;
+  TEST_ASSERT_TRUE(quota.readMeasurement(uiId, 0, frame, &cached).ok());
+  TEST_ASSERT_FALSE(cached);
+  const uint32_t readUs = dev.lastOpInfo().busUs;
+  TEST_ASSERT_EQUAL_UINT32(3U * d.readFrameUs, readUs);
+  TEST_ASSERT_EQUAL_INT64(31000 - static_cast<int64_t>(readUs), quota.stats(uiId).balanceUs);
+
+  // Over quota but the shared sample is fresh enough: no bus traffic.
+  const uint32_t lineUsBefore = fake.elapsedUs();
+  TEST_ASSERT_TRUE(quota.readMeasurement(uiId, 100, frame, &cached).ok());
+  TEST_ASSERT_TRUE(cached);
+  TEST_ASSERT_EQUAL_UINT32(lineUsBefore, fake.elapsedUs());
+
+  // Too stale for the cache: deferred with the wait until the estimate is covered.
+  Status st = quota.readMeasurement(uiId, 700, frame, &cached);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY), static_cast<uint8_t>(st.code));
+  const int64_t balance = 31000 - static_cast<int64_t>(readUs) + 14000;
+  const int64_t missing = static_cast<int64_t>(quota.measurementEstimateUs()) - balance;
+  TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>((missing * 1000 + 19999) / 20000), st.detail);
+  const uint32_t readyMs = 700U + static_cast<uint32_t>(st.detail);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY),
+                          static_cast<uint8_t>(quota.readMeasurement(uiId, readyMs - 1, frame).code));
+  TEST_ASSERT_TRUE(quota.readMeasurement(uiId, readyMs, frame).ok());
+
+  // The control loop polls in a tight loop and is never deferred.
+  for (uint8_t i = 0; i < 20; ++i) {
+    TEST_ASSERT_TRUE(quota.readMeasurement(controlId, readyMs, frame).ok());
+  }
+  TEST_ASSERT_EQUAL_UINT32(20u, quota.stats(controlId).admitted);
+  TEST_ASSERT_EQUAL_UINT32(0u, quota.stats(controlId).deferred);
+  TEST_ASSERT_EQUAL_UINT64(20ULL * readUs, quota.stats(controlId).consumedUs);
+
+  const QuotaStats& uiStats = quota.stats(uiId);
+  TEST_ASSERT_EQUAL_UINT32(2u, uiStats.admitted);
+  TEST_ASSERT_EQUAL_UINT32(2u, uiStats.deferred);
+  TEST_ASSERT_EQUAL_UINT32(1u, uiStats.cacheHits);
+  TEST_ASSERT_EQUAL_UINT64(2ULL * readUs, uiStats.consumedUs);
+
+  // Arbitrary calls: admitted by estimate, charged by actual bus time.
+  auto readStatus = [](EE871::EE871& dev) {
+    uint8_t status = 0;
+    return dev.readStatus(status);
+  };
+  TEST_ASSERT_TRUE(quota.run(uiId, readyMs, d.readFrameUs, readStatus).ok());
+  TEST_ASSERT_EQUAL_UINT64(2ULL * readUs + d.readFrameUs, quota.stats(uiId).consumedUs);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY),
+                          static_cast<uint8_t>(quota.run(uiId, readyMs, 30000, readStatus).code));
+
+  // An estimate above the burst size is admitted from a full bucket and leaves debt.
+  TEST_ASSERT_TRUE(quota.readMeasurement(smallId, readyMs, frame).ok());
+  TEST_ASSERT_EQUAL_INT64(10000 - static_cast<int64_t>(readUs), quota.stats(smallId).balanceUs);
+  st = quota.readMeasurement(smallId, readyMs, frame);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY), static_cast<uint8_t>(st.code));
+  TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>((readUs * 1000U + 9999U) / 10000U), st.detail);
+
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_PARAM),
+                          static_cast<uint8_t>(quota.admit(7, 1, readyMs).code));
+  for (uint8_t i = quota.clientCount(); i < QUOTA_CLIENTS_MAX; ++i) {
+    TEST_ASSERT_TRUE(quota.addClient(control, unused).ok());
+  }
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OUT_OF_RANGE),
+                          static_cast<uint8_t>(quota.addClient(control, unused).code));
+}
+
+struct PpmEventLog {
+  uint8_t count = 0;
+  PpmEvent last = PpmEvent::BELOW;
+  uint16_t lastPpm = 0;
+};
+
+static void recordPpmEvent(PpmEvent event, const PipelineSample& sample, void* user) {
+  PpmEventLog* log = static_cast<PpmEventLog*>(user);
+  ++log->count;
+  log->last = event;
+  log->lastPpm = sample.ppm;
+}
+
+/// Drops every sample, to show a Fanout branch ending without affecting the others.
+struct DropAll {
+  uint32_t seen = 0;
+  bool process(PipelineSample&) {
+    ++seen;
+    return false;
+  }
+};
+
+void test_pipeline_runs_stages_in_one_pass() {
+  static_assert(!std::is_polymorphic<Pipeline<DropCo2Errors, EmaFilter>>::value,
+                "pipeline dispatch must stay static");
+
+  PpmEventLog events;
+  uint8_t records[4 * RecordEncoder::RECORD_BYTES] = {};
+  Pipeline<DropCo2Errors, PpmStatsStage, ThresholdEvents, RecordEncoder, SampleLog<3>> pipe(
+      DropCo2Errors(), PpmStatsStage(), ThresholdEvents(800, 1000, recordPpmEvent, &events),
+      RecordEncoder(records, sizeof(records)), SampleLog<3>());
+
+  const uint16_t ppm[6] = {600, 1200, 900, 4000, 700, 1100};
+  PipelineSample batch[6];
+  for (uint16_t i = 0; i < 6; ++i) {
+    batch[i].timestampMs = 1000U + i;
+    batch[i].source = i;
+    batch[i].ppm = ppm[i];
+    batch[i].rawPpm = ppm[i];
+  }
+  batch[3].co2Error = true;
+  batch[3].statusByte = cmd::STATUS_CO2_ERROR_MASK;
+
+  TEST_ASSERT_EQUAL_UINT32(5u, pipe.pushBatch(batch, 6));
+  TEST_ASSERT_EQUAL_UINT16(700, batch[3].ppm);  // Survivors compacted in order.
+  TEST_ASSERT_EQUAL_UINT16(4, batch[3].source);
+  TEST_ASSERT_EQUAL_UINT32(1u, pipe.stage<0>().dropped());
+  TEST_ASSERT_EQUAL_UINT32(6u, pipe.stats().pushed);
+  TEST_ASSERT_EQUAL_UINT32(5u, pipe.stats().delivered);
+
+  // Same aggregate as the fleet kernel over the delivered values.
+  const uint16_t kept[5] = {600, 1200, 900, 700, 1100};
+  const uint8_t all[5] = {1, 1, 1, 1, 1};
+  const fleet::PpmStats expected = fleet::ppmStats(kept, all, 5);
+  const fleet::PpmStats stats = pipe.stage<1>().stats();
+  TEST_ASSERT_EQUAL_UINT32(expected.count, stats.count);
+  TEST_ASSERT_EQUAL_UINT16(expected.min, stats.min);
+  TEST_ASSERT_EQUAL_UINT16(expected.max, stats.max);
+  TEST_ASSERT_EQUAL_UINT16(expected.mean, stats.mean);
+
+  // 1200 rises, 900 holds (hysteresis), 700 falls, 1100 rises again.
+  TEST_ASSERT_EQUAL_UINT8(3, events.count);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(PpmEvent::ABOVE),
+                          static_cast<uint8_t>(events.last));
+  TEST_ASSERT_EQUAL_UINT16(1100, events.lastPpm);
+  TEST_ASSERT_TRUE(pipe.stage<2>().above());
+
+  // Four records fit, the fifth overflows.
+  TEST_ASSERT_EQUAL_UINT32(4u * RecordEncoder::RECORD_BYTES, pipe.stage<3>().size());
+  TEST_ASSERT_EQUAL_UINT32(1u, pipe.stage<3>().overflow());
+  const uint8_t* second = records + RecordEncoder::RECORD_BYTES;
+  TEST_ASSERT_EQUAL_UINT8(0xE9, second[0]);  // 1001 ms
+  TEST_ASSERT_EQUAL_UINT8(0x03, second[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, second[4]);
+  TEST_ASSERT_EQUAL_UINT8(0xB0, second[6]);  // 1200 ppm
+  TEST_ASSERT_EQUAL_UINT8(0x04, second[7]);
+
+  TEST_ASSERT_EQUAL_UINT32(3u, pipe.stage<4>().size());
+  TEST_ASSERT_EQUAL_UINT16(900, pipe.stage<4>().at(0).ppm);
+  TEST_ASSERT_EQUAL_UINT16(1100, pipe.stage<4>().at(2).ppm);
+
+  // Filtering rewrites ppm only; branches of a Fanout each see the sample.
+  using Branches = Fanout<StageChain<DropAll, PpmStatsStage>, SampleLog<2>>;
+  Pipeline<EmaFilter, Branches> smooth(EmaFilter(1), Branches());
+  PipelineSample s;
+  s.ppm = 400;
+  s.rawPpm = 400;
+  TEST_ASSERT_TRUE(smooth.push(s));
+  TEST_ASSERT_EQUAL_UINT16(400, s.ppm);
+  s.ppm = 800;
+  s.rawPpm = 800;
+  TEST_ASSERT_TRUE(smooth.push(s));
+  TEST_ASSERT_EQUAL_UINT16(600, s.ppm);
+  TEST_ASSERT_EQUAL_UINT16(800, s.rawPpm);
+  TEST_ASSERT_EQUAL_UINT32(2u, smooth.stage<1>().branch<0>().stage<0>().seen);
+  TEST_ASSERT_EQUAL_UINT32(0u, smooth.stage<1>().branch<0>().stage<1>().stats().count);
+  TEST_ASSERT_EQUAL_UINT32(2u, smooth.stage<1>().branch<1>().size());
+
+  // Driver source: one readMeasurement() per push.
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+  fake.setMv4(750);
+  Pipeline<SampleLog<1>> fromDevice;
+  bool delivered = false;
+  TEST_ASSERT_TRUE(readIntoPipeline(dev, 5000, 7, fromDevice, &delivered).ok());
+  TEST_ASSERT_TRUE(delivered);
+  TEST_ASSERT_EQUAL_UINT16(750, fromDevice.stage<0>().at(0).rawPpm);
+  TEST_ASSERT_EQUAL_UINT16(7, fromDevice.stage<0>().at(0).source);
+  TEST_ASSERT_EQUAL_UINT32(5000u, fromDevice.stage<0>().at(0).timestampMs);
+}
+
+static void assertCo2Read(EE871::EE871& dev, FakeE2Transport& fake, uint16_t mv4,
+                          uint16_t expected, uint16_t transactions) {
+  fake.setMv4(mv4);
+  uint16_t ppm = 0;
+  TEST_ASSERT_TRUE(dev.readCo2Average(ppm).ok());
+  TEST_ASSERT_EQUAL_UINT16(expected, ppm);
+  TEST_ASSERT_EQUAL_UINT16(transactions, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL(transactions == 1, dev.lastOpInfo().cacheHit);
+}
+
+void test_co2_high_byte_elision_reads_low_byte_only() {
+  FakeE2Transport fake;
+  Config cfg = checkedFakeConfig(fake);
+  cfg.co2HighByteRefresh = 4;
+  cfg.co2ElisionMaxStep = 0;
+  EE871::EE871 dev;
+  Status st = dev.begin(cfg);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::INVALID_CONFIG), static_cast<uint8_t>(st.code));
+  assertSameStatus(st, ConfigBuilder().co2HighByteElision(4, 0).validate());
+  static_assert(ConfigBuilder().co2HighByteElision(4).valid(), "default step is valid");
+
+  cfg.co2ElisionMaxStep = 64;
+  TEST_ASSERT_TRUE(dev.begin(cfg).ok());
+  assertCo2Read(dev, fake, 650, 650, 2);  // Nothing cached yet.
+  assertCo2Read(dev, fake, 660, 660, 1);
+  assertCo2Read(dev, fake, 700, 700, 1);
+  assertCo2Read(dev, fake, 705, 705, 1);
+  assertCo2Read(dev, fake, 760, 760, 2);  // One refresh per 4 reads.
+  assertCo2Read(dev, fake, 780, 780, 2);  // 0x2F8 -> 0x30C: the low byte wrapped.
+  assertCo2Read(dev, fake, 880, 880, 2);  // Step of 100 exceeds co2ElisionMaxStep.
+  TEST_ASSERT_EQUAL_UINT32(3u, dev.elidedTransactions());
+  TEST_ASSERT_EQUAL_UINT32(0u, dev.elisionResyncs());
+
+  // A jump of 256 + 10 looks like +10 until the next refresh catches it.
+  assertCo2Read(dev, fake, 1146, 890, 1);
+  assertCo2Read(dev, fake, 1146, 890, 1);
+  assertCo2Read(dev, fake, 1146, 890, 1);
+  assertCo2Read(dev, fake, 1146, 1146, 2);
+  TEST_ASSERT_EQUAL_UINT32(1u, dev.elisionResyncs());
+
+  // A failed read or a CO2 error in the status byte forces both bytes.
+  fake.setCorruptReadPec(true);
+  uint16_t ppm = 0;
+  TEST_ASSERT_FALSE(dev.readCo2Average(ppm).ok());
+  fake.setCorruptReadPec(false);
+  assertCo2Read(dev, fake, 1150, 1150, 2);
+  MeasurementFrame frame;
+  fake.setStatusByte(cmd::STATUS_CO2_ERROR_MASK);
+  TEST_ASSERT_TRUE(dev.readMeasurement(frame).ok());
+  TEST_ASSERT_EQUAL_UINT16(1150, frame.co2Average);
+  TEST_ASSERT_EQUAL_UINT32(6u, dev.elidedTransactions());
+  fake.setStatusByte(0);
+  fake.setMv4(1152);
+  TEST_ASSERT_TRUE(dev.readMeasurement(frame).ok());
+  TEST_ASSERT_EQUAL_UINT16(1152, frame.co2Average);
+  TEST_ASSERT_EQUAL_UINT16(2, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT32(7u, dev.elidedTransactions());
+}
+
+struct ReconfigureFromHook {
+  EE871::EE871* dev = nullptr;
+  Status result;
+};
+
+static void reconfigureDuringActivity(bool active, void* user) {
+  ReconfigureFromHook* hook = static_cast<ReconfigureFromHook*>(user);
+  if (active && hook->dev != nullptr) {
+    hook->result = hook->dev->reconfigureTiming(TimingConfig());
+  }
+}
+
+void test_reconfigure_timing_keeps_session_state() {
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(dev.reconfigureTiming(TimingConfig()).code));
+
+  ReconfigureFromHook hook;
+  Config cfg = checkedFakeConfig(fake);
+  cfg.busActivity = reconfigureDuringActivity;
+  cfg.powerUser = &hook;
+  TEST_ASSERT_TRUE(dev.begin(cfg).ok());
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  fake.setCorruptReadPec(true);
+  TEST_ASSERT_FALSE(dev.readStatus(status).ok());
+  fake.setCorruptReadPec(false);
+  const uint32_t successes = dev.totalSuccess();
+  const uint32_t failures = dev.totalFailures();
+  const bool errorCode = dev.hasErrorCode();
+  const DriverState state = dev.state();
+  const SnapshotGenerations before = dev.generations();
+
+  TimingConfig slow = timingOf(dev.getConfig());
+  slow.clockLowUs = 150;
+  slow.clockHighUs = 160;
+  slow.writeDelayMs = 20;
+  TEST_ASSERT_TRUE(dev.reconfigureTiming(slow).ok());
+  TEST_ASSERT_EQUAL_UINT16(150, dev.getConfig().clockLowUs);
+  TEST_ASSERT_EQUAL_UINT16(160, dev.getConfig().clockHighUs);
+  TEST_ASSERT_EQUAL_UINT32(20u, dev.getConfig().writeDelayMs);
+  TEST_ASSERT_EQUAL_UINT32(successes, dev.totalSuccess());
+  TEST_ASSERT_EQUAL_UINT32(failures, dev.totalFailures());
+  TEST_ASSERT_EQUAL(errorCode, dev.hasErrorCode());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(state), static_cast<uint8_t>(dev.state()));
+  TEST_ASSERT_EQUAL_UINT32(before.config + 1U, dev.generations().config);
+  TEST_ASSERT_EQUAL_UINT32(before.health, dev.generations().health);
+  TEST_ASSERT_EQUAL_UINT32(before.features, dev.generations().features);
+
+  // The next transaction runs on the new timing, with no re-probe.
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT16(1, dev.lastOpInfo().transactions);
+  TEST_ASSERT_EQUAL_UINT32(deriveTiming(slow).readFrameUs, dev.lastOpInfo().busUs);
+
+  // Rejected timing leaves the active timing in place.
+  TimingConfig bad = slow;
+  bad.clockLowUs = 50;
+  assertSameStatus(validateTiming(bad), dev.reconfigureTiming(bad));
+  TEST_ASSERT_EQUAL_UINT16(150, dev.getConfig().clockLowUs);
+
+  // Not from inside a transaction.
+  hook.dev = &dev;
+  TEST_ASSERT_TRUE(dev.readStatus(status).ok());
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::BUSY),
+                          static_cast<uint8_t>(hook.result.code));
+  TEST_ASSERT_EQUAL_UINT16(150, dev.getConfig().clockLowUs);
+}
+
+void test_metrics_registry_collects_and_exports() {
+  MetricsStorage<20> storage;
+  MetricsRegistry registry;
+  size_t written = 0;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::NOT_INITIALIZED),
+                          static_cast<uint8_t>(exportMetricsBinary(registry, nullptr, 0, written).code));
+  TEST_ASSERT_TRUE(registry.begin(storage.slots, storage.capacity()).ok());
+
+  FakeE2Transport fake;
+  EE871::EE871 dev;
+  EE871::EE871 idle;
+  TEST_ASSERT_TRUE(beginFakeDevice(dev, fake).ok());
+  TEST_ASSERT_TRUE(registerDriverMetrics(registry, dev, 0).ok());
+  TEST_ASSERT_TRUE(registerDriverMetrics(registry, idle, 1).ok());
+  BusQuota quota;
+  TEST_ASSERT_TRUE(quota.begin(dev, 0).ok());
+  uint8_t client = 0;
+  TEST_ASSERT_TRUE(quota.addClient(QuotaPolicy(), client).ok());
+  TEST_ASSERT_TRUE(registerQuotaMetrics(registry, quota, 0).ok());
+  TEST_ASSERT_EQUAL_UINT32(17u, registry.size());
+
+  static const uint32_t kBounds[2] = {10000, 20000};
+  const uint32_t unordered[2] = {20000, 10000};
+  uint16_t histogram = 0;
+  uint16_t polls = 0;
+  TEST_ASSERT_EQUAL_UINT8(
+      static_cast<uint8_t>(Err::INVALID_PARAM),
+      static_cast<uint8_t>(registry.addHistogram("app_poll_us", "", MetricLabels(), unordered, 2,
+                                                 histogram).code));
+  TEST_ASSERT_EQUAL_UINT8(
+      static_cast<uint8_t>(Err::INVALID_PARAM),
+      static_cast<uint8_t>(
+          registry.addValue(MetricKind::COUNTER, "app-polls", "", MetricLabels(), polls).code));
+  TEST_ASSERT_TRUE(registry.addHistogram("app_poll_us", "Poll line time.", MetricLabels(), kBounds,
+                                         2, histogram).ok());
+  TEST_ASSERT_TRUE(
+      registry.addValue(MetricKind::COUNTER, "app_polls", "", MetricLabels(), polls).ok());
+
+  // Driver and subsystem counters are sampled at collection time.
+  MeasurementFrame frame;
+  for (uint8_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_TRUE(quota.readMeasurement(client, i, frame).ok());
+    registry.observe(histogram, dev.lastOpInfo().busUs);
+    registry.add(polls);
+  }
+  registry.observe(histogram, 5000);
+  TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>(dev.totalSuccess()),
+                          static_cast<int32_t>(registry.value(0)));
+  TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>(dev.lastOpInfo().busUs),
+                          static_cast<int32_t>(registry.value(5)));
+  TEST_ASSERT_EQUAL_UINT8(0, registry.at(0).labels.deviceAddress);
+  TEST_ASSERT_EQUAL_UINT8(1, registry.at(6).labels.bus);
+  TEST_ASSERT_EQUAL_INT32(3, static_cast<int32_t>(registry.value(12)));  // quota admitted
+  TEST_ASSERT_EQUAL_UINT8(0, registry.at(12).labels.instance);
+  TEST_ASSERT_EQUAL_INT32(4, static_cast<int32_t>(registry.value(histogram)));
+  TEST_ASSERT_EQUAL_INT32(3, static_cast<int32_t>(registry.value(polls)));
+  size_t visited = 0;
+  registry.forEach([&](const Metric&, int64_t) { ++visited; });
+  TEST_ASSERT_EQUAL_UINT32(registry.size(), visited);
+
+  // A group that does not fit is not registered at all.
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OUT_OF_RANGE),
+                          static_cast<uint8_t>(registerDriverMetrics(registry, idle, 2).code));
+  TEST_ASSERT_EQUAL_UINT32(19u, registry.size());
+
+  size_t needed = 0;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OUT_OF_RANGE),
+                          static_cast<uint8_t>(exportMetricsBinary(registry, nullptr, 0, needed).code));
+  uint8_t bin[1024] = {};
+  TEST_ASSERT_TRUE(exportMetricsBinary(registry, bin, sizeof(bin), written).ok());
+  TEST_ASSERT_EQUAL_UINT32(needed, written);
+  TEST_ASSERT_EQUAL_UINT8(metrics_frame::MAGIC_0, bin[0]);
+  TEST_ASSERT_EQUAL_UINT8(metrics_frame::MAGIC_1, bin[1]);
+  TEST_ASSERT_EQUAL_UINT8(19, bin[3]);
+  const uint8_t* first = bin + metrics_frame::HEADER_BYTES;
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(MetricKind::COUNTER), first[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, first[1]);
+  TEST_ASSERT_EQUAL_UINT8(0, first[2]);
+  TEST_ASSERT_EQUAL_UINT8(METRIC_LABEL_NONE, first[3]);
+  TEST_ASSERT_EQUAL_UINT8(std::strlen("ee871_success"), first[4]);
+  TEST_ASSERT_EQUAL_UINT8(dev.totalSuccess(), first[5 + std::strlen("ee871_success")]);
+
+  static char text[4096];
+  TEST_ASSERT_TRUE(exportMetricsText(registry, text, sizeof(text), written).ok());
+  TEST_ASSERT_EQUAL_UINT32(std::strlen(text), written);
+  TEST_ASSERT_NOT_NULL(std::strstr(text, "# TYPE ee871_success counter\n"
+                                         "# HELP ee871_success Tracked successful driver operations.\n"
+                                         "ee871_success_total{device=\"0\",bus=\"0\"} "));
+  // Both drivers' series sit under one family header.
+  TEST_ASSERT_NOT_NULL(std::strstr(text, "\nee871_success_total{device=\"0\",bus=\"1\"} 0\n"
+                                         "# TYPE ee871_failures counter\n"));
+  TEST_ASSERT_NOT_NULL(std::strstr(text, "ee871_quota_admitted_total{bus=\"0\",instance=\"0\"} 3\n"));
+  TEST_ASSERT_NOT_NULL(std::strstr(text, "app_poll_us_bucket{le=\"10000\"} 1\n"
+                                         "app_poll_us_bucket{le=\"20000\"} 4\n"
+                                         "app_poll_us_bucket{le=\"+Inf\"} 4\n"
+                                         "app_poll_us_count 4\n"));
+  TEST_ASSERT_NOT_NULL(std::strstr(text, "app_polls_total 3\n# EOF\n"));
+  char small[16];
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(Err::OUT_OF_RANGE),
+                          static_cast<uint8_t>(exportMetricsText(registry, small, sizeof(small), needed).code));
+  TEST_ASSERT_EQUAL_UINT32(written, needed);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(small) - 1U, std::strlen(small));
+}
+
+/// Bring up a fake device behind @p radio and run the same traffic: 2.5 ms
+/// bursts every 15 ms against begin(), eight measurements, and a bus reset.
+static void runRadioTraffic(FakeE2Transport& fake, MockRadioScheduler& radio) {
+  for (uint8_t i = 0; i < MockRadioScheduler::BURSTS_MAX; ++i) {
+    TEST_ASSERT_TRUE(radio.addBurst(1000U + 15000ULL * i, 2500));
+  }
+  EE871::EE871 dev;
+  TEST_ASSERT_TRUE(dev.begin(radio.apply(checkedFakeConfig(fake))).ok());
+  MeasurementFrame frame;
+  for (uint8_t i = 0; i < 8; ++i) {
+    TEST_ASSERT_TRUE(dev.readMeasurement(frame).ok());
+  }
+  TEST_ASSERT_EQUAL_UINT32(deriveTiming(timingOf(dev.getConfig())).readFrameUs,
+                           radio.lastExpectedUs());
+  TEST_ASSERT_TRUE(dev.busReset().ok());
+  TEST_ASSERT_EQUAL_UINT32(deriveTiming(timingOf(dev.getConfig())).resetUs,
+                           radio.lastExpectedUs());
+  TEST_ASSERT_FALSE(radio.unbalanced());
+}
+
+void test_quiet_window_hook_keeps_radio_off_transactions() {
+  FakeE2Transport free;
+  MockRadioScheduler uncoordinated(free, false);
+  runRadioTraffic(free, uncoordinated);
+  TEST_ASSERT_TRUE(uncoordinated.overlaps() > 0);
+
+  FakeE2Transport fake;
+  MockRadioScheduler radio(fake, true);
+  runRadioTraffic(fake, radio);
+  TEST_ASSERT_EQUAL_UINT32(uncoordinated.windows(), radio.windows());
+  TEST_ASSERT_EQUAL_UINT32(0u, radio.overlaps());
+  TEST_ASSERT_TRUE(radio.waits() > 0);
+  TEST_ASSERT_TRUE(radio.deferred() > 0);
+  // Without clock stretching the reported duration is exact.
+  TEST_ASSERT_EQUAL_UINT32(0u, radio.maxDeviationUs());
+}
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_status_ok);
@@ -615,6 +2986,72 @@ int main() {
   RUN_TEST(test_dirty_error_preserves_first_failure);
   RUN_TEST(test_resync_persistent_config_clears_only_when_coherent);
   RUN_TEST(test_dirty_state_survives_offline);
+  RUN_TEST(test_multibus_begin_rejects_invalid_config);
+  RUN_TEST(test_multibus_reads_all_buses_in_single_bus_time);
+  RUN_TEST(test_multibus_masks_nack_and_stretch_per_bus);
+  RUN_TEST(test_multibus_write_commands_then_read_custom_memory);
+  RUN_TEST(test_multibus_notifies_activity_and_quiet_window_hooks);
+  RUN_TEST(test_simbus_devices_at_different_addresses_share_one_bus);
+  RUN_TEST(test_simbus_slave_clock_stretch_is_waited_and_timed);
+  RUN_TEST(test_simbus_slave_holding_sda_blocks_every_device_until_released);
+  RUN_TEST(test_timing_checker_driver_operations_conform);
+  RUN_TEST(test_timing_checker_flags_each_rule);
+  RUN_TEST(test_timing_checker_flags_misordered_one_bit);
+  RUN_TEST(test_begin_rejects_single_frame_hook);
+  RUN_TEST(test_byte_level_frames_match_edge_path);
+  RUN_TEST(test_line_model_rc_edges_follow_time_constant);
+  RUN_TEST(test_line_model_slow_edges_stretch_and_noise_is_deterministic);
+  RUN_TEST(test_recorder_replay_reproduces_session_without_hardware);
+  RUN_TEST(test_replay_flags_divergence_and_recorder_overflow);
+  RUN_TEST(test_op_info_reports_per_call_cost);
+  RUN_TEST(test_op_info_separates_stretch_and_frame_hooks);
+  RUN_TEST(test_execute_merges_custom_reads_with_one_health_pass);
+  RUN_TEST(test_execute_validates_orders_writes_and_stops_on_failure);
+  RUN_TEST(test_execute_partial_multibyte_write_marks_dirty);
+  RUN_TEST(test_status_report_chains_error_code_on_error_bit);
+  RUN_TEST(test_custom_pointer_tracking_skips_redundant_pointer_writes);
+  RUN_TEST(test_config_builder_matches_begin_and_engine_timing);
+  RUN_TEST(test_sync_group_triggers_devices_back_to_back);
+  RUN_TEST(test_sync_group_triggers_buses_in_lockstep);
+  RUN_TEST(test_trigger_capture_freezes_window_around_nack);
+  RUN_TEST(test_trigger_capture_pec_stretch_and_control_sources);
+  RUN_TEST(test_pm_bus_lock_holds_locks_only_during_transactions);
+  RUN_TEST(test_fleet_kernels_aggregate_columns);
+  RUN_TEST(test_fleet_poller_updates_store_rows);
+  RUN_TEST(test_fleet_poller_keeps_last_good_sample_on_co2_error);
+  RUN_TEST(test_snapshot_generations_change_only_with_their_section);
+  RUN_TEST(test_fleet_simulator_reports_day_long_schedule);
+  RUN_TEST(test_cyclic_executor_runs_generated_table);
+  RUN_TEST(test_begin_fleet_probes_buses_in_lockstep);
+  RUN_TEST(test_begin_feature_read_failure_matches_begin_from_probe);
+  RUN_TEST(test_bus_quota_defers_or_caches_over_quota_clients);
+  RUN_TEST(test_bus_quota_depletes_under_frame_hooks);
+  RUN_TEST(test_pipeline_runs_stages_in_one_pass);
+  RUN_TEST(test_co2_high_byte_elision_reads_low_byte_only);
+  RUN_TEST(test_reconfigure_timing_keeps_session_state);
+  RUN_TEST(test_metrics_registry_collects_and_exports);
+  RUN_TEST(test_quiet_window_hook_keeps_radio_off_transactions);
+
+  // Runtime fault tests again through the fake's byte-level frame hooks.
+  gByteLevelFake = true;
+  RUN_TEST(test_fake_transport_begin_succeeds);
+  RUN_TEST(test_clock_stretch_timeout_is_bounded_and_tracked);
+  RUN_TEST(test_pec_mismatch_probe_is_raw_but_tracked_read_updates_health);
+  RUN_TEST(test_device_absent_probe_has_no_health_side_effect_tracked_read_fails);
+  RUN_TEST(test_custom_write_verify_mismatch_returns_precise_error);
+  RUN_TEST(test_offline_threshold_and_recover_after_replug);
+  RUN_TEST(test_interval_low_byte_write_failure_does_not_dirty);
+  RUN_TEST(test_interval_high_byte_write_failure_sets_dirty);
+  RUN_TEST(test_interval_verify_failure_sets_dirty_and_unrelated_read_does_not_clear);
+  RUN_TEST(test_co2_offset_high_byte_failure_sets_dirty);
+  RUN_TEST(test_co2_offset_low_byte_verify_failure_sets_dirty);
+  RUN_TEST(test_co2_gain_high_byte_failure_sets_dirty);
+  RUN_TEST(test_co2_gain_low_byte_verify_failure_sets_dirty);
+  RUN_TEST(test_part_name_first_byte_verify_failure_sets_dirty);
+  RUN_TEST(test_dirty_error_preserves_first_failure);
+  RUN_TEST(test_resync_persistent_config_clears_only_when_coherent);
+  RUN_TEST(test_dirty_state_survives_offline);
+  gByteLevelFake = false;
   return UNITY_END();
 }
 
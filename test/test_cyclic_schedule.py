@@ -0,0 +1,104 @@
+from __future__ import annotations
+
+import contextlib
+import importlib.util
+import io
+import pathlib
+import sys
+import tempfile
+import unittest
+
+
+ROOT = pathlib.Path(__file__).resolve().parents[1]
+MODULE_PATH = ROOT / "tools" / "cyclic_schedule.py"
+SPEC = importlib.util.spec_from_file_location("cyclic_schedule", MODULE_PATH)
+assert SPEC is not None
+cyclic = importlib.util.module_from_spec(SPEC)
+assert SPEC.loader is not None
+sys.modules[SPEC.name] = cyclic
+SPEC.loader.exec_module(cyclic)
+
+
+class CyclicScheduleTest(unittest.TestCase):
+    def test_cost_model_matches_default_config_timing(self) -> None:
+        timing = cyclic.Timing()
+        self.assertEqual(timing.read_frame_us, 6180)
+        self.assertEqual(timing.write_frame_us, 8070)
+        self.assertEqual(cyclic.measurement_cost_us(timing), 18540)
+        self.assertEqual(cyclic.measurement_cost_us(timing, True), 32790)
+
+    def test_schedule_has_fixed_offsets_and_no_overlap(self) -> None:
+        periods = [100, 200, 200, 400, 400, 1000]
+        sched = cyclic.build_schedule(periods, 19000)
+        self.assertTrue(sched.schedulable)
+        self.assertEqual(sched.minor_frame_ms, 100)
+        self.assertEqual(sched.major_cycle_ms, 2000)
+
+        slots = sched.slots()
+        frame_us = sched.minor_frame_ms * 1000
+        for (release, _), (next_release, _) in zip(slots, slots[1:]):
+            self.assertGreaterEqual(next_release, release + 19000)
+        for release, _ in slots:
+            self.assertLessEqual(release % frame_us + 19000, frame_us)
+
+        for row, period in enumerate(periods):
+            releases = [release for release, r in slots if r == row]
+            self.assertEqual(len(releases), sched.major_cycle_ms // period)
+            gaps = {b - a for a, b in zip(releases, releases[1:])}
+            self.assertTrue(gaps <= {period * 1000})
+
+    def test_forced_minor_frame_spreads_sensors_over_phases(self) -> None:
+        sched = cyclic.build_schedule([100, 100], 20000)
+        self.assertEqual(sched.minor_frame_ms, 100)
+        self.assertEqual(sched.offsets_us, [0, 20000])
+        sched = cyclic.build_schedule([100, 100], 20000, minor_frame_ms=50)
+        self.assertTrue(sched.schedulable)
+        self.assertEqual(sched.phases, [0, 1])
+        self.assertEqual(sched.slots(), [(0, 0), (50000, 1)])
+
+    def test_overload_is_reported_unschedulable(self) -> None:
+        sched = cyclic.build_schedule([20, 20], 18540)
+        self.assertFalse(sched.schedulable)
+        self.assertIn("utilization", sched.reason)
+        # 90 % utilization, but the 20 ms sensor cannot share a 10 ms frame with the 10 ms one.
+        sched = cyclic.build_schedule([10, 20], 6000)
+        self.assertFalse(sched.schedulable)
+        self.assertIn("row 1", sched.reason)
+        sched = cyclic.build_schedule([10, 20], 4000)
+        self.assertTrue(sched.schedulable)
+        with self.assertRaises(ValueError):
+            cyclic.build_schedule([100, 200], 19000, minor_frame_ms=30)
+
+    def test_main_writes_header_and_fails_when_unschedulable(self) -> None:
+        with tempfile.TemporaryDirectory() as tmp:
+            out = pathlib.Path(tmp) / "Table.h"
+            with contextlib.redirect_stdout(io.StringIO()):
+                rc = cyclic.main(["--periods", "100,200", "--margin-us", "460",
+                                  "--namespace", "plan", "--output", str(out)])
+            self.assertEqual(rc, 0)
+            text = out.read_text(encoding="utf-8")
+            self.assertIn("namespace plan {", text)
+            self.assertIn("measurementCostUs(kTiming.derived(), false) + 460u", text)
+            self.assertIn("{19000u, 1u},", text)
+
+            with contextlib.redirect_stdout(io.StringIO()) as captured:
+                rc = cyclic.main(["--periods", "20,20"])
+            self.assertEqual(rc, 1)
+            self.assertIn("NOT SCHEDULABLE", captured.getvalue())
+
+    def test_checked_in_test_table_is_current(self) -> None:
+        table = ROOT / "test" / "support" / "GeneratedCyclicSchedule.h"
+        text = table.read_text(encoding="utf-8")
+        command = text.splitlines()[2].split("cyclic_schedule.py ", 1)[1].split()
+        out_index = command.index("--output") + 1
+        with tempfile.TemporaryDirectory() as tmp:
+            regenerated = pathlib.Path(tmp) / table.name
+            command[out_index] = str(regenerated)
+            with contextlib.redirect_stdout(io.StringIO()):
+                self.assertEqual(cyclic.main(command), 0)
+            body = regenerated.read_text(encoding="utf-8").splitlines()[3:]
+        self.assertEqual(body, text.splitlines()[3:])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+from __future__ import annotations
+
+import pathlib
+import re
+import sys
+from typing import Dict, Set
+
+ROOT = pathlib.Path(__file__).resolve().parents[1]
+ATTR = "EE871_IRAM_ATTR"
+PLACEMENT_HEADER = "include/EE871/Placement.h"
+
+# Functions that run between START and STOP, with their definition counts
+# (the line helpers exist for both Config and Link in EE871.cpp).
+HOT_FUNCTIONS: Dict[str, Dict[str, int]] = {
+    "src/EE871.cpp": {
+        "setScl": 2,
+        "setSda": 2,
+        "readScl": 2,
+        "readSda": 2,
+        "delayUs": 2,
+        "waitSclHigh": 1,
+        "e2Start": 1,
+        "e2Stop": 1,
+        "writeBit": 1,
+        "readBit": 1,
+        "writeByte": 1,
+        "readByte": 1,
+        "readAck": 1,
+        "sendAck": 1,
+        "busResetLines": 1,
+        "readFrameLines": 1,
+        "writeFrameLines": 1,
+    },
+    "src/MultiBus.cpp": {
+        "setScl": 1,
+        "setSda": 1,
+        "readScl": 1,
+        "readSda": 1,
+        "delay": 1,
+        "resetByteTimers": 1,
+        "fail": 1,
+        "waitSclHigh": 1,
+        "clockHighPhase": 1,
+        "start": 1,
+        "stop": 1,
+        "writeBit": 1,
+        "readBit": 1,
+        "writeByte": 1,
+        "readByte": 1,
+        "readAck": 1,
+        "sendAck": 1,
+        "readControlBytes": 1,
+        "writeCommands": 1,
+    },
+    "examples/idf/common/E2GpioTransport.h": {
+        "setScl": 1,
+        "setSda": 1,
+        "readScl": 1,
+        "readSda": 1,
+        "delayUs": 1,
+    },
+}
+
+# Flash-resident functions a hot function may call outside START..STOP.
+ALLOWED_COLD_CALLS: Dict[str, Dict[str, Set[str]]] = {
+    "src/MultiBus.cpp": {
+        "readControlBytes": {"_checkCall", "calcPecRead"},
+        "writeCommands": {"_checkCall", "calcPecWrite"},
+    },
+}
+
+BLOCK_COMMENT_RE = re.compile(r"/\*.*?\*/", re.DOTALL)
+LINE_COMMENT_RE = re.compile(r"//[^\n]*")
+STRING_RE = re.compile(r'"(?:\\.|[^"\\])*"|\'(?:\\.|[^\'\\])*\'')
+DEFINITION_RE = re.compile(
+    r"^[ \t]*(?P<decl>(?:[\w:<>*&]+[ \t]+)+)(?:\w+::)?(?P<name>\w+)\s*\([^;{}]*\)\s*(?:const\s*)?\{",
+    re.MULTILINE,
+)
+CALL_RE = re.compile(r"\b(\w+)\s*\(")
+EMPTY_FALLBACK_RE = re.compile(r"^#\s*else\s*\n#\s*define\s+EE871_IRAM_ATTR[ \t]*\n", re.MULTILINE)
+
+
+def strip_non_code(text: str) -> str:
+    text = BLOCK_COMMENT_RE.sub("", text)
+    text = LINE_COMMENT_RE.sub("", text)
+    return STRING_RE.sub('""', text)
+
+
+def body_of(code: str, open_brace: int) -> str:
+    depth = 0
+    for idx in range(open_brace, len(code)):
+        if code[idx] == "{":
+            depth += 1
+        elif code[idx] == "}":
+            depth -= 1
+            if depth == 0:
+                return code[open_brace + 1 : idx]
+    return code[open_brace + 1 :]
+
+
+def check_file(rel: str, hot: Dict[str, int], errors: list[str]) -> None:
+    path = ROOT / rel
+    if not path.exists():
+        errors.append(f"missing file: {rel}")
+        return
+    code = strip_non_code(path.read_text(encoding="utf-8", errors="replace"))
+
+    defined: Set[str] = set()
+    marked: Dict[str, int] = {}
+    hot_bodies: list[tuple[str, str]] = []
+    for match in DEFINITION_RE.finditer(code):
+        name = match.group("name")
+        decl = match.group("decl")
+        defined.add(name)
+        if ATTR not in decl.split():
+            if name in hot:
+                errors.append(f"{rel}: hot function {name}() is missing {ATTR}")
+            continue
+        if name not in hot:
+            errors.append(f"{rel}: {name}() carries {ATTR} but is not listed as hot")
+            continue
+        marked[name] = marked.get(name, 0) + 1
+        hot_bodies.append((name, body_of(code, match.end() - 1)))
+
+    for name, expected in hot.items():
+        observed = marked.get(name, 0)
+        if observed != expected:
+            errors.append(
+                f"{rel}: {ATTR} definitions of {name}() observed={observed}, expected={expected}"
+            )
+
+    allowed = ALLOWED_COLD_CALLS.get(rel, {})
+    for name, body in hot_bodies:
+        for call in CALL_RE.findall(body):
+            if call in defined and call not in hot and call not in allowed.get(name, set()):
+                errors.append(f"{rel}: hot function {name}() calls flash-resident {call}()")
+
+
+def main() -> int:
+    errors: list[str] = []
+
+    header = ROOT / PLACEMENT_HEADER
+    if not header.exists():
+        errors.append(f"missing file: {PLACEMENT_HEADER}")
+    elif not EMPTY_FALLBACK_RE.search(header.read_text(encoding="utf-8", errors="replace")):
+        errors.append(f"{PLACEMENT_HEADER}: {ATTR} must expand to nothing without the build flag")
+
+    for rel, hot in HOT_FUNCTIONS.items():
+        check_file(rel, hot, errors)
+
+    if errors:
+        print("IRAM placement check FAILED:")
+        for err in errors:
+            print(f"- {err}")
+        return 1
+
+    print("IRAM placement check PASSED")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""Generate a static cyclic (time-triggered) poll table for an EE871 fleet.
+
+Sensor periods and the E2 line timing go in; a major/minor frame table comes
+out, together with a schedulability report. Every sensor is polled at the
+same offset of the same minor-frame phase each period, so the table has no
+release jitter. The emitted header holds an EE871::CyclicSchedule for
+EE871::CyclicExecutor and static_asserts that the C++ cost model agrees.
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import sys
+from dataclasses import dataclass, field
+from functools import reduce
+from pathlib import Path
+
+# Mirrors cmd::DATA_SETUP_US and deriveTiming() in include/EE871.
+DATA_SETUP_US = 10
+READ_FRAME_BITS = 27
+WRITE_FRAME_BITS = 36
+
+
+@dataclass(frozen=True)
+class Timing:
+    clock_low_us: int = 100
+    clock_high_us: int = 100
+    start_hold_us: int = 100
+    stop_hold_us: int = 100
+
+    @property
+    def bit_us(self) -> int:
+        return DATA_SETUP_US + self.clock_high_us + self.clock_low_us
+
+    def _frame_us(self, bits: int) -> int:
+        start_us = 2 * self.start_hold_us + self.clock_low_us
+        stop_us = DATA_SETUP_US + 2 * self.stop_hold_us
+        return start_us + bits * self.bit_us + stop_us
+
+    @property
+    def read_frame_us(self) -> int:
+        return self._frame_us(READ_FRAME_BITS)
+
+    @property
+    def write_frame_us(self) -> int:
+        return self._frame_us(WRITE_FRAME_BITS)
+
+
+def measurement_cost_us(timing: Timing, with_error_code: bool = False) -> int:
+    """Same model as EE871::measurementCostUs()."""
+    cost = 3 * timing.read_frame_us
+    if with_error_code:
+        cost += timing.write_frame_us + timing.read_frame_us
+    return cost
+
+
+@dataclass
+class Schedule:
+    periods_ms: list[int]
+    slot_cost_us: int
+    minor_frame_ms: int = 0
+    major_cycle_ms: int = 0
+    offsets_us: list[int] = field(default_factory=list)  # per row, inside the minor frame
+    phases: list[int] = field(default_factory=list)      # per row, first minor frame
+    frame_load_us: list[int] = field(default_factory=list)
+    schedulable: bool = False
+    reason: str = ""
+
+    def slots(self) -> list[tuple[int, int]]:
+        """(releaseUs, row) pairs over one major cycle, sorted by release."""
+        frame_us = self.minor_frame_ms * 1000
+        frames = self.major_cycle_ms // self.minor_frame_ms
+        out = []
+        for row, period in enumerate(self.periods_ms):
+            step = period // self.minor_frame_ms
+            for frame in range(self.phases[row], frames, step):
+                out.append((frame * frame_us + self.offsets_us[row], row))
+        return sorted(out)
+
+    @property
+    def utilization(self) -> float:
+        return sum(self.slot_cost_us / (p * 1000.0) for p in self.periods_ms)
+
+
+def lcm(values: list[int]) -> int:
+    return reduce(lambda a, b: a * b // math.gcd(a, b), values, 1)
+
+
+def divisors_desc(value: int) -> list[int]:
+    small = [d for d in range(1, math.isqrt(value) + 1) if value % d == 0]
+    return sorted(set(small + [value // d for d in small]), reverse=True)
+
+
+def pack(periods_ms: list[int], slot_cost_us: int, minor_frame_ms: int) -> Schedule:
+    """Pack every sensor at one fixed offset and phase inside minor_frame_ms."""
+    sched = Schedule(periods_ms=list(periods_ms), slot_cost_us=slot_cost_us)
+    sched.minor_frame_ms = minor_frame_ms
+    sched.major_cycle_ms = lcm(periods_ms)
+    if sched.major_cycle_ms * 1000 > 0xFFFFFFFF:
+        sched.reason = f"major cycle {sched.major_cycle_ms} ms does not fit uint32 microseconds"
+        return sched
+    frame_us = minor_frame_ms * 1000
+    frames = sched.major_cycle_ms // minor_frame_ms
+    if sum(frames // (p // minor_frame_ms) for p in periods_ms) > 0xFFFF:
+        sched.reason = "more than 65535 slots per major cycle"
+        return sched
+    fill = [0] * frames
+    sched.offsets_us = [0] * len(periods_ms)
+    sched.phases = [0] * len(periods_ms)
+
+    # Shortest period first: those sensors constrain the most frames.
+    for row in sorted(range(len(periods_ms)), key=lambda r: (periods_ms[r], r)):
+        step = periods_ms[row] // minor_frame_ms
+        best_phase, best_offset = 0, None
+        for phase in range(step):
+            offset = max(fill[phase::step])
+            if best_offset is None or offset < best_offset:
+                best_phase, best_offset = phase, offset
+        assert best_offset is not None
+        if best_offset + slot_cost_us > frame_us:
+            sched.reason = f"row {row} (period {periods_ms[row]} ms) does not fit any frame"
+            return sched
+        for frame in range(best_phase, frames, step):
+            fill[frame] = best_offset + slot_cost_us
+        sched.phases[row] = best_phase
+        sched.offsets_us[row] = best_offset
+
+    sched.frame_load_us = fill
+    sched.schedulable = True
+    return sched
+
+
+def build_schedule(periods_ms: list[int], slot_cost_us: int,
+                   minor_frame_ms: int | None = None) -> Schedule:
+    """Try minor frames from the largest divisor of gcd(periods) down."""
+    if not periods_ms or any(p <= 0 for p in periods_ms):
+        raise ValueError("periods must be positive")
+    if len(periods_ms) > 0xFFFF:
+        raise ValueError("too many sensors")
+    gcd = reduce(math.gcd, periods_ms)
+    if minor_frame_ms is not None:
+        if minor_frame_ms <= 0 or gcd % minor_frame_ms != 0:
+            raise ValueError(f"minor frame must divide gcd(periods) = {gcd} ms")
+        candidates = [minor_frame_ms]
+    else:
+        candidates = divisors_desc(gcd)
+
+    last = Schedule(periods_ms=list(periods_ms), slot_cost_us=slot_cost_us)
+    if sum(slot_cost_us / (p * 1000.0) for p in periods_ms) > 1.0:
+        last.reason = "bus utilization exceeds 100 %"
+        return last
+    for frame_ms in candidates:
+        if frame_ms * 1000 < slot_cost_us:
+            last.reason = last.reason or f"minor frame {frame_ms} ms is shorter than one slot"
+            break
+        last = pack(periods_ms, slot_cost_us, frame_ms)
+        if last.schedulable:
+            return last
+    return last
+
+
+def report(sched: Schedule, timing: Timing) -> str:
+    lines = [
+        f"read frame {timing.read_frame_us} us, write frame {timing.write_frame_us} us, "
+        f"slot {sched.slot_cost_us} us",
+        f"sensors {len(sched.periods_ms)}, utilization {sched.utilization * 100.0:.2f} %",
+    ]
+    if not sched.schedulable:
+        lines.append(f"NOT SCHEDULABLE: {sched.reason}")
+        return "\n".join(lines)
+    frame_us = sched.minor_frame_ms * 1000
+    peak = max(sched.frame_load_us)
+    lines += [
+        f"minor frame {sched.minor_frame_ms} ms, major cycle {sched.major_cycle_ms} ms, "
+        f"{sched.major_cycle_ms // sched.minor_frame_ms} frames, {len(sched.slots())} slots",
+        f"peak frame load {peak} us ({peak * 100.0 / frame_us:.1f} %), "
+        f"min slack {frame_us - peak} us",
+        "release jitter 0 us (fixed offset per sensor)",
+        "SCHEDULABLE",
+    ]
+    return "\n".join(lines)
+
+
+def render_header(sched: Schedule, timing: Timing, with_error_code: bool, margin_us: int,
+                  namespace: str, command: str, file_name: str) -> str:
+    chain = "true" if with_error_code else "false"
+    slots = sched.slots()
+    body = "\n".join(f"    {{{release}u, {row}u}}," for release, row in slots)
+    return f"""/// @file {file_name}
+/// @brief Generated by tools/cyclic_schedule.py; do not edit.
+/// Command: {command}
+#pragma once
+
+#include "EE871/ConfigBuilder.h"
+#include "EE871/CyclicSchedule.h"
+
+namespace {namespace} {{
+
+constexpr EE871::ConfigBuilder kTiming = EE871::ConfigBuilder()
+    .clockUs({timing.clock_low_us}, {timing.clock_high_us})
+    .holdUs({timing.start_hold_us}, {timing.stop_hold_us});
+constexpr uint32_t kSlotCostUs = {sched.slot_cost_us}u;
+static_assert(EE871::measurementCostUs(kTiming.derived(), {chain}) + {margin_us}u == kSlotCostUs,
+              "Slot cost no longer matches the driver timing; regenerate this table");
+
+constexpr EE871::CyclicSlot kSlots[] = {{
+{body}
+}};
+
+constexpr EE871::CyclicSchedule kSchedule = {{
+    {sched.minor_frame_ms * 1000}u, {sched.major_cycle_ms * 1000}u, kSlots, {len(slots)}u,
+    kSlotCostUs}};
+static_assert(EE871::scheduleFits(kSchedule), "Cyclic schedule does not fit its frames");
+
+}} // namespace {namespace}
+"""
+
+
+def parse_args(argv: list[str]) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--periods", required=True,
+                        help="comma-separated poll periods in ms, one per store row")
+    parser.add_argument("--clock-us", nargs=2, type=int, default=[100, 100],
+                        metavar=("LOW", "HIGH"), help="E2 clock low/high time")
+    parser.add_argument("--hold-us", nargs=2, type=int, default=[100, 100],
+                        metavar=("START", "STOP"), help="START/STOP hold time")
+    parser.add_argument("--error-code", action="store_true",
+                        help="budget the chained error-code read in every slot (worst case)")
+    parser.add_argument("--margin-us", type=int, default=0,
+                        help="extra budget per slot for call overhead and clock stretching")
+    parser.add_argument("--minor-frame-ms", type=int, default=None,
+                        help="force a minor frame; it must divide gcd(periods)")
+    parser.add_argument("--namespace", default="ee871_schedule",
+                        help="C++ namespace of the generated table")
+    parser.add_argument("--output", type=Path, default=None,
+                        help="write the C++ header here")
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str] | None = None) -> int:
+    argv = sys.argv[1:] if argv is None else argv
+    args = parse_args(argv)
+    try:
+        periods = [int(p) for p in args.periods.split(",") if p.strip()]
+    except ValueError:
+        print("periods must be integers", file=sys.stderr)
+        return 2
+    if args.margin_us < 0:
+        print("margin must not be negative", file=sys.stderr)
+        return 2
+    timing = Timing(args.clock_us[0], args.clock_us[1], args.hold_us[0], args.hold_us[1])
+    slot_cost = measurement_cost_us(timing, args.error_code) + args.margin_us
+    try:
+        sched = build_schedule(periods, slot_cost, args.minor_frame_ms)
+    except ValueError as exc:
+        print(str(exc), file=sys.stderr)
+        return 2
+
+    print(report(sched, timing))
+    if not sched.schedulable:
+        return 1
+    if args.output is not None:
+        command = "python tools/cyclic_schedule.py " + " ".join(argv)
+        args.output.write_text(
+            render_header(sched, timing, args.error_code, args.margin_us, args.namespace,
+                          command, args.output.name),
+            encoding="utf-8",
+            newline="\n",
+        )
+        print(f"wrote {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())